@@ -22,6 +22,9 @@ using ::mcucore::StatusOr;
 
 constexpr uint32_t kReadIntervalMillis = READ_INTERVAL_SECS * 1000;
 
+// The rain sensor is just a digital input, so is cheap to read frequently.
+constexpr uint32_t kRainReadIntervalMillis = 1000;
+
 #define MLX90614_DESCRIPTION "MLX90614 Infrared Thermometer"
 #define RG11_DESCRIPTION "Hydreon RG11 Rain Sensor"
 
@@ -32,12 +35,16 @@ Adafruit_MLX90614 ir_therm;
 AMWeatherBox::AMWeatherBox(alpaca::ServerContext& server_context,
                            const alpaca::DeviceDescription& device_description)
     : ObservingConditionsAdapter(server_context, device_description),
-      ir_therm_initialized_(false) {}
+      ir_therm_initialized_(false),
+      last_log_time_(0) {
+  RegisterSensor(ESensorName::kSkyTemperature, kReadIntervalMillis);
+  RegisterSensor(ESensorName::kTemperature, kReadIntervalMillis);
+  RegisterSensor(ESensorName::kRainRate, kRainReadIntervalMillis);
+}
 
 void AMWeatherBox::InitializeDevice() {
   pinMode(kRg11SensorPin, kRg11SensorPinMode);
   if (IsIrThermInitialized()) {
-    last_read_time_ = millis();
     MCU_VLOG(1) << MCU_PSD("MLX90614 is ready");
   } else {
     MCU_VLOG(1) << MCU_PSD("MLX90614 is not present or ready!");
@@ -45,20 +52,27 @@ void AMWeatherBox::InitializeDevice() {
 }
 
 void AMWeatherBox::MaintainDevice() {
+  ObservingConditionsAdapter::MaintainDevice();
   auto now = millis();
-  if ((now - last_read_time_) >= kReadIntervalMillis) {
-    last_read_time_ = now;
-    if (IsIrThermInitialized()) {
-      MCU_VLOG(3) << MCU_PSD("Sky: ") << GetSkyTemperature().value()
+  if ((now - last_log_time_) >= kReadIntervalMillis) {
+    last_log_time_ = now;
+    auto rain_rate = GetRainRate();
+    if (!rain_rate.ok()) {
+      return;
+    }
+    auto sky_temperature = GetSkyTemperature();
+    auto ambient_temperature = GetTemperature();
+    if (sky_temperature.ok() && ambient_temperature.ok()) {
+      MCU_VLOG(3) << MCU_PSD("Sky: ") << sky_temperature.value()
                   << MCU_PSD(" \xE2\x84\x83, Ambient: ")
-                  << GetTemperature().value()
+                  << ambient_temperature.value()
                   << MCU_PSD(" \xE2\x84\x83, Rain Detected: ")
-                  << (GetRainRate().value() == 0 ? ProgmemStringViews::False()
-                                                 : ProgmemStringViews::True());
+                  << (rain_rate.value() == 0 ? ProgmemStringViews::False()
+                                             : ProgmemStringViews::True());
     } else {
       MCU_VLOG(3) << MCU_PSD("Rain Detected: ")
-                  << (GetRainRate().value() == 0 ? ProgmemStringViews::False()
-                                                 : ProgmemStringViews::True());
+                  << (rain_rate.value() == 0 ? ProgmemStringViews::False()
+                                             : ProgmemStringViews::True());
     }
   }
 }
@@ -81,28 +95,6 @@ mcucore::Status AMWeatherBox::SetAveragePeriod(double hours) {
   }
 }
 
-mcucore::StatusOr<double> AMWeatherBox::GetSkyTemperature() {
-  if (IsIrThermInitialized()) {
-    return ir_therm.readObjectTempC();
-  }
-  return ErrorCodes::NotConnected();
-}
-
-mcucore::StatusOr<double> AMWeatherBox::GetRainRate() {
-  if (digitalRead(kRg11SensorPin) == kRg11DetectsRain) {
-    return 10;
-  } else {
-    return 0;
-  }
-}
-
-mcucore::StatusOr<double> AMWeatherBox::GetTemperature() {
-  if (IsIrThermInitialized()) {
-    return ir_therm.readAmbientTempC();
-  }
-  return ErrorCodes::NotConnected();
-}
-
 mcucore::StatusOr<mcucore::ProgmemStringView>
 AMWeatherBox::GetSensorDescription(ESensorName sensor_name) {
   if (sensor_name == ESensorName::kSkyTemperature ||
@@ -115,20 +107,26 @@ AMWeatherBox::GetSensorDescription(ESensorName sensor_name) {
   return ErrorCodes::InvalidValue();
 }
 
-mcucore::Status AMWeatherBox::Refresh() { return mcucore::OkStatus(); }
-
-mcucore::StatusOr<double> AMWeatherBox::GetTimeSinceLastUpdate(
-    ESensorName sensor_name) {
+StatusOr<double> AMWeatherBox::ReadSensor(ESensorName sensor_name) {
   switch (sensor_name) {
     case ESensorName::kSkyTemperature:
+      if (IsIrThermInitialized()) {
+        return ir_therm.readObjectTempC();
+      }
+      return ErrorCodes::NotConnected();
+
     case ESensorName::kTemperature:
       if (IsIrThermInitialized()) {
-        return 0.0;
+        return ir_therm.readAmbientTempC();
       }
-      break;
+      return ErrorCodes::NotConnected();
 
     case ESensorName::kRainRate:
-      return 0.0;
+      if (digitalRead(kRg11SensorPin) == kRg11DetectsRain) {
+        return 10;
+      } else {
+        return 0;
+      }
 
     default:
       break;
@@ -2,7 +2,9 @@
 #define TINY_ALPACA_SERVER_EXAMPLES_AM_WEATHERBOX_SRC_AM_WEATHER_BOX_H_
 
 // The AMWeatherBox class presents the AstroMakers WeatherBox device as an ASCOM
-// Alpaca ObservingConditions device
+// Alpaca ObservingConditions device. The sensors are registered with the
+// ObservingConditionsAdapter, which reads them periodically (see ReadSensor),
+// so requests are answered from the cached readings.
 //
 // Author: james.synge@gmail.com
 
@@ -20,21 +22,18 @@ class AMWeatherBox : public alpaca::ObservingConditionsAdapter {
   void MaintainDevice() override;
 
   mcucore::StatusOr<double> GetAveragePeriod() override;
-  mcucore::StatusOr<double> GetRainRate() override;
-  mcucore::StatusOr<double> GetSkyTemperature() override;
-  mcucore::StatusOr<double> GetTemperature() override;
   mcucore::StatusOr<mcucore::ProgmemStringView> GetSensorDescription(
       alpaca::ESensorName sensor_name) override;
   mcucore::Status SetAveragePeriod(double hours) override;
-  mcucore::Status Refresh() override;
-  mcucore::StatusOr<double> GetTimeSinceLastUpdate(
+
+  mcucore::StatusOr<double> ReadSensor(
       alpaca::ESensorName sensor_name) override;
 
  private:
   bool IsIrThermInitialized();
 
   bool ir_therm_initialized_;
-  uint32_t last_read_time_;
+  uint32_t last_log_time_;
 };
 
 }  // namespace astro_makers
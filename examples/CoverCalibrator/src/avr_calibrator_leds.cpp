@@ -0,0 +1,75 @@
+#include "avr_calibrator_leds.h"
+
+#include <Arduino.h>
+#include <McuCore.h>
+
+#include "constants.h"
+
+namespace astro_makers {
+
+using ::mcucore::TimerCounterChannel;
+
+AvrCalibratorLeds::AvrCalibratorLeds()
+    : led1_(TimerCounterChannel::B, kLedChannel1EnabledPin),
+      led2_(TimerCounterChannel::C, kLedChannel2EnabledPin),
+      led3_(TimerCounterChannel::A, kLedChannel3EnabledPin),
+      led4_(TimerCounterChannel::A, kLedChannel4EnabledPin) {}
+
+#define VLOG_ENABLEABLE_BY_PIN(level, name, enableable_by_pin)        \
+  MCU_VLOG(level) << MCU_PSD(name)                                    \
+                  << (enableable_by_pin.IsEnabled()                   \
+                          ? MCU_FLASHSTR(" is enabled")               \
+                          : MCU_FLASHSTR(" is not enabled"))          \
+                  << MCU_PSD("; digitalRead(")                        \
+                  << enableable_by_pin.enabled_pin() << MCU_PSD(")=") \
+                  << enableable_by_pin.ReadPin()
+
+void AvrCalibratorLeds::Initialize() {
+  pinMode(kLedChannel1PwmPin, OUTPUT);
+  pinMode(kLedChannel2PwmPin, OUTPUT);
+  pinMode(kLedChannel3PwmPin, OUTPUT);
+  pinMode(kLedChannel4PwmPin, OUTPUT);
+
+  // Fastest clock mode.
+  TimerCounter3Initialize16BitFastPwm(mcucore::ClockPrescaling::kDivideBy1);
+  TimerCounter4Initialize16BitFastPwm(mcucore::ClockPrescaling::kDivideBy1);
+
+  // Announce enablement once only.
+  VLOG_ENABLEABLE_BY_PIN(1, "LED #1", led1_);
+  VLOG_ENABLEABLE_BY_PIN(1, "LED #2", led2_);
+  VLOG_ENABLEABLE_BY_PIN(1, "LED #3", led3_);
+  VLOG_ENABLEABLE_BY_PIN(1, "LED #4", led4_);
+}
+
+bool AvrCalibratorLeds::IsChannelPresent(uint8_t channel) const {
+  switch (channel) {
+    case 0:
+      return led1_.IsEnabled();
+    case 1:
+      return led2_.IsEnabled();
+    case 2:
+      return led3_.IsEnabled();
+    case 3:
+      return led4_.IsEnabled();
+  }
+  return false;
+}
+
+void AvrCalibratorLeds::SetPulseCount(uint8_t channel, uint16_t pulse_count) {
+  switch (channel) {
+    case 0:
+      led1_.set_pulse_count(pulse_count);
+      break;
+    case 1:
+      led2_.set_pulse_count(pulse_count);
+      break;
+    case 2:
+      led3_.set_pulse_count(pulse_count);
+      break;
+    case 3:
+      led4_.set_pulse_count(pulse_count);
+      break;
+  }
+}
+
+}  // namespace astro_makers
@@ -0,0 +1,37 @@
+#ifndef TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_AVR_CALIBRATOR_LEDS_H_
+#define TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_AVR_CALIBRATOR_LEDS_H_
+
+// Drives the LED channels of the calibrator with the 16-bit PWM outputs of
+// Timer/Counters 3 and 4 of the ATmega2560.
+//
+// Author: james.synge@gmail.com
+
+#include <Arduino.h>
+#include <McuCore.h>
+
+#include "calibrator_leds.h"
+
+namespace astro_makers {
+
+class AvrCalibratorLeds : public CalibratorLeds {
+ public:
+  // Uses the pins in constants.h.
+  AvrCalibratorLeds();
+
+  void Initialize() override;
+  bool IsChannelPresent(uint8_t channel) const override;
+  void SetPulseCount(uint8_t channel, uint16_t pulse_count) override;
+
+ private:
+  // TODO(jamessynge): Need something like template specialization to select the
+  // timer/counter number and channel given the kLedChannel1PwmPin macro (and
+  // other such macros). Doing so could avoid linking in unused objects.
+  mcucore::TimerCounter3Pwm16Output led1_;
+  mcucore::TimerCounter3Pwm16Output led2_;
+  mcucore::TimerCounter3Pwm16Output led3_;
+  mcucore::TimerCounter4Pwm16Output led4_;
+};
+
+}  // namespace astro_makers
+
+#endif  // TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_AVR_CALIBRATOR_LEDS_H_
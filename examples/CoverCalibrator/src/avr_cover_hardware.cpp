@@ -0,0 +1,171 @@
+#include "avr_cover_hardware.h"
+
+#include <Arduino.h>
+#include <McuCore.h>
+
+#include "constants.h"
+#include "cover.h"
+
+namespace {
+
+// The rate at which Timer/Counter 5 counts, with the clock divided by 8.
+constexpr uint32_t kStepTimerTicksPerSecond = F_CPU / 8;
+
+void ResetTimer5() {
+  // Disable interrupts first.
+  TIMSK5 = 0;
+
+  // Clear any interrupts that have occurred; only relevant if this method is
+  // called with interrupts disabled because if interrupts are enabled then
+  // clearing TIMSK5 will disable any interrupts, so ICR5 would be zero at this
+  // point.
+  TIFR5 = 0;
+
+  // Clear the registers that configure the behavior of the timer/counter.
+  TCCR5A = 0;
+  TCCR5B = 0;
+  TCCR5C = 0;
+
+  // Clear the 16-bit registers with the counter, match and capture values.
+  TCNT5 = 0;
+  OCR5A = 0;
+  OCR5B = 0;
+  OCR5C = 0;
+  ICR5 = 0;
+}
+
+// Starts Timer/Counter 5 such that the first interrupt occurs after the
+// specified number of ticks (of kStepTimerTicksPerSecond).
+void StartTimer5(uint16_t ticks) {
+  // We use Waveform Generation Mode 4, i.e. Clear Timer on Compare Match (CTC)
+  // Mode; in this mode TCNT5 is incremented by one at each clock tick until it
+  // matches OCR5A, at which point the Output Compare A interrupt occurs and
+  // TCNT5 is reset to zero. OCR5A isn't double buffered in this mode, so the
+  // ISR can set the interval until the next interrupt (i.e. the next step)
+  // by writing to OCR5A, so long as it does so before TCNT5 reaches the new
+  // value, which is easily the case at the speeds of the cover motor. The
+  // clock is divided by 8.
+  uint8_t a = 0;
+  uint8_t b = (1 << WGM52) | (1 << CS51);
+  uint16_t top = ticks - 1;
+
+  MCU_VLOG(4) << mcucore::BaseHex << MCU_PSD("StartTimer5 a=") << a
+              << MCU_PSD(", b=") << b << mcucore::BaseDec << MCU_PSD(", top=")
+              << top;
+
+  noInterrupts();
+  OCR5A = top;
+  TCNT5 = 0;
+  TCCR5A = a;
+  TCCR5B = b;
+  bitWrite(TIMSK5, OCIE5A, 1);
+  bitWrite(TIFR5, OCF5A, 1);
+  interrupts();
+}
+
+}  // namespace
+
+ISR(TIMER5_COMPA_vect) {
+  if (!astro_makers::HandleCoverInterrupt()) {
+    ResetTimer5();
+  }
+}
+
+namespace astro_makers {
+
+AvrCoverHardware::AvrCoverHardware(uint8_t cover_present_pin,
+                                   uint8_t stepper_enable_pin,
+                                   uint8_t step_pin, uint8_t direction_pin,
+                                   uint8_t open_limit_pin,
+                                   uint8_t closed_limit_pin)
+    : mcucore::EnableableByPin(cover_present_pin),
+      stepper_enable_pin_(stepper_enable_pin),
+      step_pin_(step_pin),
+      direction_pin_(direction_pin),
+      open_limit_pin_(open_limit_pin),
+      closed_limit_pin_(closed_limit_pin),
+      limit_pin_(open_limit_pin) {}
+
+AvrCoverHardware::AvrCoverHardware()
+    : AvrCoverHardware(kCoverPresentPin, kCoverMotorEnablePin,
+                       kCoverMotorStepPin, kCoverMotorDirectionPin,
+                       kCoverOpenLimitPin, kCoverCloseLimitPin) {}
+
+void AvrCoverHardware::ResetHardware() {
+  pinMode(stepper_enable_pin_, OUTPUT);
+  DisableMotor();
+}
+
+void AvrCoverHardware::InitializeHardware() {
+  ResetTimer5();
+
+  pinMode(stepper_enable_pin_, OUTPUT);
+  DisableMotor();
+
+  pinMode(step_pin_, OUTPUT);
+  digitalWrite(step_pin_, LOW);
+
+  pinMode(direction_pin_, OUTPUT);
+  digitalWrite(direction_pin_, LOW);  // Initial value doesn't really matter.
+
+  pinMode(open_limit_pin_, kLimitSwitchPinMode);
+  pinMode(closed_limit_pin_, kLimitSwitchPinMode);
+
+#if defined(kMicrostepResolution1)
+  pinMode(kMicrostepResolution1, OUTPUT);
+  pinMode(kMicrostepResolution2, OUTPUT);
+  pinMode(kMicrostepResolution3, OUTPUT);
+  digitalWrite(kMicrostepResolution1, HIGH);
+  digitalWrite(kMicrostepResolution2, HIGH);
+  digitalWrite(kMicrostepResolution3, LOW);
+#endif
+
+  MCU_VLOG(1) << MCU_PSD("Cover Motor")
+              << (IsEnabled() ? MCU_FLASHSTR(" is enabled")
+                              : MCU_FLASHSTR(" is not enabled"))
+              << MCU_PSD("; digitalRead(") << enabled_pin() << MCU_PSD(")=")
+              << ReadPin();
+}
+
+uint32_t AvrCoverHardware::TimerTicksPerSecond() const {
+  return kStepTimerTicksPerSecond;
+}
+
+void AvrCoverHardware::EnableMotor() { digitalWrite(stepper_enable_pin_, LOW); }
+
+void AvrCoverHardware::DisableMotor() {
+  digitalWrite(stepper_enable_pin_, HIGH);
+}
+
+void AvrCoverHardware::SetDirection(bool open) {
+  digitalWrite(direction_pin_, open ? kDirectionOpen : kDirectionClose);
+  limit_pin_ = open ? open_limit_pin_ : closed_limit_pin_;
+}
+
+bool AvrCoverHardware::IsOpenLimitClosed() const {
+  return digitalRead(open_limit_pin_) == kLimitSwitchClosed;
+}
+
+bool AvrCoverHardware::IsClosedLimitClosed() const {
+  return digitalRead(closed_limit_pin_) == kLimitSwitchClosed;
+}
+
+void AvrCoverHardware::Step() {
+  // Note that writing by direct access to the port is much faster, should
+  // performance become an issue.
+  digitalWrite(step_pin_, HIGH);
+  delayMicroseconds(1);
+  digitalWrite(step_pin_, LOW);
+}
+
+bool AvrCoverHardware::IsAtLimit() {
+  return digitalRead(limit_pin_) == kLimitSwitchClosed;
+}
+
+void AvrCoverHardware::StartTimer(uint16_t ticks) { StartTimer5(ticks); }
+
+void AvrCoverHardware::SetTimerInterval(uint16_t ticks) { OCR5A = ticks - 1; }
+
+void AvrCoverHardware::StopTimer() { ResetTimer5(); }
+
+}  // namespace astro_makers
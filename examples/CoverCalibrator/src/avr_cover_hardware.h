@@ -0,0 +1,66 @@
+#ifndef TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_AVR_COVER_HARDWARE_H_
+#define TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_AVR_COVER_HARDWARE_H_
+
+// Implements CoverHardware using digital pins for the stepper driver and the
+// limit switches, and Timer/Counter 5 of the ATmega2560 to time the steps. Only
+// one instance may be used, as there is only one Timer/Counter 5.
+//
+// Author: james.synge@gmail.com
+
+#include <Arduino.h>
+#include <McuCore.h>
+
+#include "cover_hardware.h"
+
+namespace astro_makers {
+
+class AvrCoverHardware : public CoverHardware,
+                         public mcucore::EnableableByPin {
+ public:
+  AvrCoverHardware(uint8_t cover_present_pin, uint8_t stepper_enable_pin,
+                   uint8_t step_pin, uint8_t direction_pin,
+                   uint8_t open_limit_pin, uint8_t closed_limit_pin);
+
+  // Uses the values in constants.h to call the above ctor.
+  AvrCoverHardware();
+
+  bool IsPresent() const override { return IsEnabled(); }
+  void ResetHardware() override;
+  void InitializeHardware() override;
+  uint32_t TimerTicksPerSecond() const override;
+  void EnableMotor() override;
+  void DisableMotor() override;
+  void SetDirection(bool open) override;
+  bool IsOpenLimitClosed() const override;
+  bool IsClosedLimitClosed() const override;
+
+  void Step() override;
+  bool IsAtLimit() override;
+  void StartTimer(uint16_t ticks) override;
+  void SetTimerInterval(uint16_t ticks) override;
+  void StopTimer() override;
+
+ private:
+  // Low to enable the stepper driver.
+  const uint8_t stepper_enable_pin_;
+
+  // Pulse to step the motor.
+  const uint8_t step_pin_;
+
+  // HIGH means close, LOW means the open, though that could be a separate
+  // parameter.
+  const uint8_t direction_pin_;
+
+  // If LOW, the Open Limit switch has been closed (grounded).
+  const uint8_t open_limit_pin_;
+
+  // If LOW, the Closed Limit switch has been closed (grounded).
+  const uint8_t closed_limit_pin_;
+
+  // The limit switch in the direction of motion.
+  uint8_t limit_pin_;
+};
+
+}  // namespace astro_makers
+
+#endif  // TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_AVR_COVER_HARDWARE_H_
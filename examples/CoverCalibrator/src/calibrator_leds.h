@@ -0,0 +1,35 @@
+#ifndef TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_CALIBRATOR_LEDS_H_
+#define TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_CALIBRATOR_LEDS_H_
+
+// Interface to the LED driver of the calibrator, which has 4 channels whose
+// brightness is set with 16-bit PWM. AvrCalibratorLeds implements this with the
+// pins in constants.h and Timer/Counters 3 and 4; a simulation of the driver
+// can be used for testing on a host.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace astro_makers {
+
+class CalibratorLeds {
+ public:
+  static constexpr uint8_t kNumChannels = 4;
+
+  virtual ~CalibratorLeds() {}
+
+  // Prepares the hardware for use.
+  virtual void Initialize() = 0;
+
+  // Returns true if the specified channel (0 through 3) is present, based on
+  // the jumper pin for that channel.
+  virtual bool IsChannelPresent(uint8_t channel) const = 0;
+
+  // Sets the PWM pulse count (i.e. the brightness, 0 through kMaxBrightness) of
+  // the specified channel (0 through 3).
+  virtual void SetPulseCount(uint8_t channel, uint16_t pulse_count) = 0;
+};
+
+}  // namespace astro_makers
+
+#endif  // TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_CALIBRATOR_LEDS_H_
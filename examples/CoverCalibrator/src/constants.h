@@ -139,7 +139,12 @@
 #define kLimitSwitchPinMode INPUT_PULLUP
 #define kLimitSwitchClosed LOW
 
+// The cover accelerates from kStartStepsPerSecond to kStepsPerSecond at a rate
+// of kStepsPerSecondPerSecond, and decelerates as it approaches the end of its
+// travel (once the length of the travel has been measured).
+#define kStartStepsPerSecond 1000
 #define kStepsPerSecond 10000
+#define kStepsPerSecondPerSecond 20000
 #define kMaximumSteps 120000
 #define kMaximumStartSteps 5000
 
@@ -6,7 +6,6 @@
 #include "constants.h"
 
 namespace {
-using ::mcucore::TC16ClockAndTicks;
 
 // The cover instance that is moving. Note that while multiple Cover instances
 // can be created, only a single Timer/Counter is used on the ATmega2560 (number
@@ -33,145 +32,41 @@ void RemoveInterruptHandler(astro_makers::InterruptHandler* old_handler) {
   interrupts();
 }
 
-void ResetTimer5() {
-  // Disable interrupts first.
-  TIMSK5 = 0;
-
-  // Clear any interrupts that have occurred; only relevant if this method is
-  // called with interrupts disabled because if interrupts are enabled then
-  // clearing TIMSK5 will disable any interrupts, so ICR5 would be zero at this
-  // point.
-  TIFR5 = 0;
-
-  // Clear the registers that configure the behavior of the timer/counter.
-  TCCR5A = 0;
-  TCCR5B = 0;
-  TCCR5C = 0;
-
-  // Clear the 16-bit registers with the counter, match and capture values.
-  TCNT5 = 0;
-  OCR5A = 0;
-  OCR5B = 0;
-  OCR5C = 0;
-  ICR5 = 0;
-}
-
-// ct represents 1/2 of the period between Timer/Counter 5 overflow interrupts.
-void StartTimer5(const TC16ClockAndTicks& ct) {
-  MCU_VLOG(4) << MCU_PSD("StartTimer5 ct=") << ct
-              << MCU_PSD(", ct.ClockSelectBits=") << ct.ClockSelectBits();
-
-  // We use Waveform Generation Mode 9, i.e. Phase and Frequency Correct PWM
-  // Mode; in this mode TCNT5 is incremented by one at each clock tick until it
-  // reaches TOP (OCR5A) , then decremented down to BOTTOM (0), at which point
-  // it starts incrementing up again. This dual slope operation means that the
-  // period is 2 * TOP, i.e. 2 * OCR5A. Note that the counter is at TOP for only
-  // one clock cycle (I don't know if that also means that the counter is at
-  // BOTTOM for only one clock cycle, but that seems likely).
-  uint8_t a = 1 << WGM50;
-  uint8_t b = (1 << WGM53) | ct.ClockSelectBits();
-  uint16_t top = ct.clock_ticks;
-
-  MCU_VLOG(4) << mcucore::BaseHex << MCU_PSD("a=") << a << MCU_PSD(", b=") << b
-              << mcucore::BaseDec << MCU_PSD(", top=") << top;
-
-  noInterrupts();
-  OCR5A = top;
-  TCNT5 = 0;
-  TCCR5A = a;
-  TCCR5B = b;
-  bitWrite(TIMSK5, TOIE5, 1);
-  bitWrite(TIFR5, TOV5, 1);
-  interrupts();
-
-  if (MCU_VLOG_IS_ON(4)) {
-    MCU_VLOG(4) << mcucore::BaseHex << MCU_PSD("StartTimer5 TCCR5A: ") << TCCR5A
-                << MCU_PSD(", TCCR5B: ") << TCCR5B;
-    MCU_VLOG(4) << MCU_PSD("StartTimer5 TCNT5: ") << TCNT5
-                << MCU_PSD(", OCR5A: ") << OCR5A << MCU_PSD(", OCR5B: ")
-                << OCR5B << MCU_PSD(", OCR5C: ") << OCR5C;
-
-    // If something goes wrong right away, the interrupt handler will disable
-    // the counter, so log the registers again after a millisecond.
-
-    delay(1);
-    MCU_VLOG(4) << mcucore::BaseHex << MCU_PSD("StartTimer5 TCCR5A: ") << TCCR5A
-                << MCU_PSD(", TCCR5B: ") << TCCR5B;
-    MCU_VLOG(4) << MCU_PSD("StartTimer5 TCNT5: ") << TCNT5
-                << MCU_PSD(", OCR5A: ") << OCR5A << MCU_PSD(", OCR5B: ")
-                << OCR5B << MCU_PSD(", OCR5C: ") << OCR5C;
-  }
-}
-
-void StartTimer5(uint16_t interrupts_per_second) {
-  StartTimer5(
-      TC16ClockAndTicks::FromIntegerEventsPerSecond(interrupts_per_second));
-}
-
 }  // namespace
 
-ISR(TIMER5_OVF_vect) {
-  if (interrupt_handler != nullptr) {
-    interrupt_handler->HandleInterrupt();
-  } else {
-    ResetTimer5();
-  }
-}
-
 namespace astro_makers {
 using ::alpaca::ECoverStatus;
 
-Cover::Cover(uint8_t cover_present_pin, uint8_t stepper_enable_pin,
-             uint8_t step_pin, uint8_t direction_pin, uint8_t open_limit_pin,
-             uint8_t closed_limit_pin, uint32_t allowed_steps,
+bool HandleCoverInterrupt() {
+  if (interrupt_handler == nullptr) {
+    return false;
+  }
+  interrupt_handler->HandleInterrupt();
+  return true;
+}
+
+Cover::Cover(CoverHardware& hardware, uint32_t allowed_steps,
              uint32_t allowed_start_steps)
-    : mcucore::EnableableByPin(cover_present_pin),
-      stepper_enable_pin_(stepper_enable_pin),
-      step_pin_(step_pin),
-      direction_pin_(direction_pin),
-      open_limit_pin_(open_limit_pin),
-      closed_limit_pin_(closed_limit_pin),
+    : hardware_(hardware),
       allowed_steps_(allowed_steps),
       allowed_start_steps_(allowed_start_steps),
+      motion_(hardware),
       motor_status_(kNotMoving) {}
 
-Cover::Cover()
-    : Cover(kCoverPresentPin, kCoverMotorEnablePin, kCoverMotorStepPin,
-            kCoverMotorDirectionPin, kCoverOpenLimitPin, kCoverCloseLimitPin,
-            kMaximumSteps, kMaximumStartSteps) {}
+Cover::Cover(CoverHardware& hardware)
+    : Cover(hardware, kMaximumSteps, kMaximumStartSteps) {}
 
 void Cover::ResetHardware() {
   if (IsEnabled()) {
-    pinMode(stepper_enable_pin_, OUTPUT);
-    DisableStepper();
+    hardware_.ResetHardware();
   }
 }
 
 void Cover::InitializeHardware() {
   // TODO(jamessynge): Consider whether to do this if motor is not present.
-
-  ResetTimer5();
-
-  pinMode(stepper_enable_pin_, OUTPUT);
-  DisableStepper();
-
-  pinMode(step_pin_, OUTPUT);
-  digitalWrite(step_pin_, LOW);
-
-  pinMode(direction_pin_, OUTPUT);
-  digitalWrite(direction_pin_, LOW);  // Initial value doesn't really matter.
-
-  pinMode(open_limit_pin_, kLimitSwitchPinMode);
-  pinMode(closed_limit_pin_, kLimitSwitchPinMode);
-
-#if defined(kMicrostepResolution1)
-  pinMode(kMicrostepResolution1, OUTPUT);
-  pinMode(kMicrostepResolution2, OUTPUT);
-  pinMode(kMicrostepResolution3, OUTPUT);
-  digitalWrite(kMicrostepResolution1, HIGH);
-  digitalWrite(kMicrostepResolution2, HIGH);
-  digitalWrite(kMicrostepResolution3, LOW);
-#endif
+  hardware_.InitializeHardware();
+  motion_.Configure(hardware_.TimerTicksPerSecond(), kStartStepsPerSecond,
+                    kStepsPerSecond, kStepsPerSecondPerSecond);
 }
 
 ECoverStatus Cover::GetCoverStatus() const {
@@ -186,7 +81,7 @@ ECoverStatus Cover::GetCoverStatus() const {
     return ECoverStatus::kOpen;
   } else {
     MCU_VLOG(1) << MCU_PSD("GetCoverStatus -> Unknown; motor_status=")
-                << motor_status_ << MCU_PSD(", step_count=") << step_count_;
+                << motor_status_ << MCU_PSD(", step_count=") << GetStepCount();
     return ECoverStatus::kUnknown;
   }
 }
@@ -196,11 +91,11 @@ bool Cover::IsMoving() const {
 }
 
 bool Cover::IsOpen() const {
-  return digitalRead(open_limit_pin_) == kLimitSwitchClosed && IsEnabled();
+  return hardware_.IsOpenLimitClosed() && IsEnabled();
 }
 
 bool Cover::IsClosed() const {
-  return digitalRead(closed_limit_pin_) == kLimitSwitchClosed && IsEnabled();
+  return hardware_.IsClosedLimitClosed() && IsEnabled();
 }
 
 bool Cover::CanMove() const {
@@ -218,18 +113,7 @@ bool Cover::Open() {
   if (IsOpen()) {
     return false;
   }
-  InterruptHandler* handler = GetInterruptHandler();
-  if (handler == this) {
-    // Are we moving in the requested direction?
-    if (motor_status_ == kOpening) {
-      // Already moving.
-      return true;
-    }
-  } else {
-    MCU_DCHECK_EQ(handler, nullptr);  // CanMove should prevent this failing.
-  }
-  motor_status_ = kOpening;
-  StartMoving(kDirectionOpen);
+  Move(/*open=*/true);
   return true;
 }
 
@@ -240,112 +124,158 @@ bool Cover::Close() {
   if (IsClosed()) {
     return false;
   }
-  InterruptHandler* handler = GetInterruptHandler();
-  if (handler == this) {
-    // Are we moving in the requested direction?
-    if (motor_status_ == kClosing) {
-      // Already moving.
-      return true;
-    }
-  } else {
-    MCU_DCHECK_EQ(handler, nullptr);
-  }
-  motor_status_ = kClosing;
-  StartMoving(kDirectionClose);
+  Move(/*open=*/false);
   return true;
 }
 
-void Cover::EnableStepper() { digitalWrite(stepper_enable_pin_, LOW); }
+uint32_t Cover::GetStepCount() const {
+  noInterrupts();
+  const uint32_t copy = motion_.steps();
+  interrupts();
+  return copy;
+}
+
+uint32_t Cover::GetTravelSteps() const {
+  noInterrupts();
+  const uint32_t copy = travel_steps_;
+  interrupts();
+  return copy;
+}
 
-void Cover::DisableStepper() { digitalWrite(stepper_enable_pin_, HIGH); }
+void Cover::Move(bool open) {
+  const MotorStatus motor_status = open ? kOpening : kClosing;
+  // The ISR may finish the movement at any time, so we check whether we're
+  // moving, and if so update the movement, with interrupts disabled.
+  noInterrupts();
+  const bool moving = interrupt_handler == this && IsMoving();
+  if (moving && motor_status_ != motor_status) {
+    // Moving in the other direction. Rather than stopping abruptly, decelerate
+    // to the start speed, after which HandleInterrupt will reverse.
+    motor_status_ = motor_status;
+    reversing_ = true;
+    motion_.Decelerate();
+  }
+  interrupts();
+  if (!moving) {
+    MCU_DCHECK_EQ(GetInterruptHandler(), nullptr);  // Ensured by CanMove.
+    motor_status_ = motor_status;
+    StartMoving(open);
+  }
+}
 
-void Cover::StartMoving(int direction_pin_value) {
-  EnableStepper();
-  ResetTimer5();
-  step_count_ = 0;
-  digitalWrite(direction_pin_, direction_pin_value);
+void Cover::StartMoving(bool open) {
+  // Stop the timer before changing direction.
+  noInterrupts();
+  motion_.Stop();
+  reversing_ = false;
+  interrupts();
+  hardware_.EnableMotor();
+  hardware_.SetDirection(open);
+  moving_open_ = open;
+  started_at_limit_ = IsStartLimitClosed();
+  const uint32_t travel_steps = GetTravelSteps();
+  noInterrupts();
   interrupt_handler = this;
-  StartTimer5(kStepsPerSecond);
-  delay(1);
+  interrupts();
+  if (!motion_.Start(allowed_steps_, travel_steps)) {
+    // Already at the limit switch.
+    motor_status_ = kNotMoving;
+    RemoveInterruptHandler(this);
+    hardware_.DisableMotor();
+    return;
+  }
 
-  if (MCU_VLOG_IS_ON(2)) {
-    noInterrupts();
-    uint32_t step_count_copy = step_count_;
-    interrupts();
+  if (MCU_VLOG_IS_ON(3)) {
+    delay(1);
     MCU_VLOG(3) << MCU_PSD("StartMoving done, handler=")
                 << GetInterruptHandler() << MCU_PSD(", motor_status_=")
-                << motor_status_ << MCU_PSD(", step_count=") << step_count_copy;
+                << motor_status_ << MCU_PSD(", step_count=") << GetStepCount()
+                << MCU_PSD(", travel_steps=") << travel_steps;
   }
 }
 
 void Cover::Halt() {
-  DisableStepper();
+  hardware_.DisableMotor();
   // Don't change the value of motor_status_ unless it appears we were moving.
   if (IsMoving()) {
     motor_status_ = kNotMoving;
   }
   RemoveInterruptHandler(this);
+  noInterrupts();
+  motion_.Stop();
+  reversing_ = false;
+  interrupts();
+}
+
+bool Cover::IsStartLimitClosed() const {
+  return motor_status_ == kClosing ? hardware_.IsOpenLimitClosed()
+                                   : hardware_.IsClosedLimitClosed();
 }
 
 void Cover::HandleInterrupt() {
-  uint8_t start_pin;
-  uint8_t limit_pin;
-  if (motor_status_ == kClosing) {
-    start_pin = open_limit_pin_;
-    limit_pin = closed_limit_pin_;
-  } else if (motor_status_ == kOpening) {
-    start_pin = closed_limit_pin_;
-    limit_pin = open_limit_pin_;
-  } else {
+  if (!IsMoving()) {
     interrupt_handler = nullptr;
-    DisableStepper();
+    motion_.Stop();
+    hardware_.DisableMotor();
     return;
   }
 
-  // On the assumption that our steps are small and rapid, we check the limit
-  // switches after stepping. Note that writing or reading by direct access to
-  // the port is much faster, should performance become an issue.
-
-  digitalWrite(step_pin_, HIGH);
-  delayMicroseconds(1);
-  digitalWrite(step_pin_, LOW);
-  ++step_count_;
-
-  // Note that we don't debounce the limit pin (e.g. we don't check that it
-  // stays closed for at least one ms or three interrupts).
-  if (digitalRead(limit_pin) == kLimitSwitchClosed) {
-    // Reached the end.
-    motor_status_ = kNotMoving;
-    interrupt_handler = nullptr;
-    DisableStepper();
+  const auto result = motion_.HandleInterrupt();
+  if (result == alpaca::StepperMotion::kStepped && reversing_) {
+    if (motion_.ramp().phase() == alpaca::StepperRamp::EPhase::kCreeping) {
+      // Slow enough to reverse (or to speed up again, if asked to move in the
+      // original direction while decelerating). If the movement started at a
+      // limit switch, we know how far away the limit switches are, so can slow
+      // down before reaching them.
+      reversing_ = false;
+      const bool open = motor_status_ == kOpening;
+      const uint32_t steps = motion_.steps();
+      uint32_t expected_steps = 0;
+      if (started_at_limit_ && open != moving_open_) {
+        expected_steps = steps;
+      } else if (started_at_limit_ && travel_steps_ > steps) {
+        expected_steps = travel_steps_ - steps;
+      }
+      started_at_limit_ = false;
+      moving_open_ = open;
+      hardware_.SetDirection(open);
+      motion_.Restart(allowed_steps_, expected_steps);
+    }
     return;
-  }
-
-  // We only check once for this situation.
-  if (step_count_ == allowed_start_steps_ &&
-      digitalRead(start_pin) == kLimitSwitchClosed) {
+  } else if (result == alpaca::StepperMotion::kStepped) {
+    // We only check once for this situation.
+    if (motion_.steps() != allowed_start_steps_ || !IsStartLimitClosed()) {
+      return;
+    }
     // The other limit switch is still closed, so we must have failed to move
     // far enough.
+    motion_.Stop();
     if (motor_status_ == kClosing) {
       motor_status_ = kStartClosingFailed;
     } else {
       motor_status_ = kStartOpeningFailed;
     }
-    interrupt_handler = nullptr;
-    DisableStepper();
-    return;
-  }
-
-  if (step_count_ > allowed_steps_) {
+  } else if (result == alpaca::StepperMotion::kReachedLimit) {
+    // Reached the end. If we started at the other end, we now know how far it
+    // is, so can slow down before reaching the end next time.
+    if (started_at_limit_) {
+      travel_steps_ = motion_.steps();
+    }
+    motor_status_ = kNotMoving;
+  } else if (result == alpaca::StepperMotion::kExceededAllowedSteps) {
     if (motor_status_ == kClosing) {
       motor_status_ = kClosingFailed;
     } else {
       motor_status_ = kOpeningFailed;
     }
-    interrupt_handler = nullptr;
-    DisableStepper();
-    return;
+  } else {
+    motor_status_ = kNotMoving;
   }
+  // If we reached a limit switch while decelerating in order to reverse, we
+  // stop there; the client can ask again for the cover to be moved.
+  reversing_ = false;
+  interrupt_handler = nullptr;
+  hardware_.DisableMotor();
 }
 
 }  // namespace astro_makers
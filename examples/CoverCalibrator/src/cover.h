@@ -2,7 +2,13 @@
 #define TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_COVER_H_
 
 // Support for opening and closing the cover using the stepper motor and
-// timer/counter interrupts.
+// timer/counter interrupts. The steps are timed by alpaca::StepperMotion, which
+// ramps the speed up and down, so the movement doesn't depend on how often the
+// loop function is called. The hardware is accessed via CoverHardware.
+//
+// If asked to move in the opposite direction while moving, the motor first
+// decelerates to its start speed, then the ISR reverses the direction, rather
+// than the cover being stopped abruptly.
 //
 // Author: james.synge@gmail.com
 
@@ -10,6 +16,8 @@
 #include <McuCore.h>
 #include <TinyAlpacaServer.h>
 
+#include "cover_hardware.h"
+
 namespace astro_makers {
 
 // TODO(jamessynge): Move InterruptHandler into a utility library.
@@ -21,7 +29,12 @@ class InterruptHandler {
   virtual void HandleInterrupt() = 0;
 };
 
-class Cover : public mcucore::EnableableByPin, InterruptHandler {
+// Calls HandleInterrupt on the Cover which is moving and returns true, or
+// returns false if no Cover is moving. Called from the ISR of the step timer,
+// or from a simulation of that timer.
+bool HandleCoverInterrupt();
+
+class Cover : InterruptHandler {
  public:
   enum MotorStatus : uint8_t {
     kNotMoving,
@@ -33,12 +46,11 @@ class Cover : public mcucore::EnableableByPin, InterruptHandler {
     kClosingFailed,
   };
 
-  Cover(uint8_t cover_present_pin, uint8_t stepper_enable_pin, uint8_t step_pin,
-        uint8_t direction_pin, uint8_t open_limit_pin, uint8_t closed_limit_pin,
-        uint32_t allowed_steps, uint32_t allowed_start_steps);
+  Cover(CoverHardware& hardware, uint32_t allowed_steps,
+        uint32_t allowed_start_steps);
 
   // Uses the values in constants.h to call the above ctor.
-  Cover();
+  explicit Cover(CoverHardware& hardware);
 
   // Disables the cover.
   void ResetHardware();
@@ -46,6 +58,9 @@ class Cover : public mcucore::EnableableByPin, InterruptHandler {
   // Prepares the hardware.
   void InitializeHardware();
 
+  // Returns true if the cover motor is present.
+  bool IsEnabled() const { return hardware_.IsPresent(); }
+
   alpaca::ECoverStatus GetCoverStatus() const;
 
   MotorStatus GetMotorStatus() const { return motor_status_; }
@@ -74,31 +89,26 @@ class Cover : public mcucore::EnableableByPin, InterruptHandler {
   // Returns true if it should be possible to move the cover.
   bool CanMove() const;
 
- private:
-  void EnableStepper();
-  void DisableStepper();
-
-  void StartMoving(int direction_pin_value);
-
-  void HandleInterrupt() override;
+  // The number of steps taken during the current or most recent movement.
+  uint32_t GetStepCount() const;
 
-  // bool StartMoving(MotorStatus motor_status,
+  // The number of steps taken by the most recent movement from one limit switch
+  // to the other, or zero if there hasn't been one yet.
+  uint32_t GetTravelSteps() const;
 
-  // Low to enable the stepper driver.
-  const uint8_t stepper_enable_pin_;
+ private:
+  // Starts moving in the specified direction, or if already moving in the
+  // other direction, decelerates and then reverses.
+  void Move(bool open);
 
-  // Pulse to step the motor.
-  const uint8_t step_pin_;
+  void StartMoving(bool open);
 
-  // HIGH means close, LOW means the open, though that could be a separate
-  // parameter.
-  const uint8_t direction_pin_;
+  // Returns true if the limit switch we're moving away from is closed.
+  bool IsStartLimitClosed() const;
 
-  // If LOW, the Open Limit switch has been closed (grounded).
-  const uint8_t open_limit_pin_;
+  void HandleInterrupt() override;
 
-  // If LOW, the Closed Limit switch has been closed (grounded).
-  const uint8_t closed_limit_pin_;
+  CoverHardware& hardware_;
 
   // Maximum number of steps we can take during a single movement. This helps to
   // prevent burning out the motor if something goes wrong.
@@ -109,14 +119,33 @@ class Cover : public mcucore::EnableableByPin, InterruptHandler {
   // detect when the torque isn't sufficient to start the movement.
   const uint32_t allowed_start_steps_;
 
+  // Times the steps of the current or most recent movement, and counts them.
+  // The ISR updates it, so it must be read and updated with interrupts
+  // disabled while the cover is moving.
+  alpaca::StepperMotion motion_;
+
   //////////////////////////////////////////////////////////////////////////////
-  // These two fields are specified as volatile to *allow* for an ISR to access
-  // and update it.
+  // These fields are specified as volatile to *allow* for an ISR to access and
+  // update them. Those larger than a byte must be read with interrupts
+  // disabled.
+
+  // The number of steps taken by the most recent movement from one limit switch
+  // to the other, or zero if there hasn't been one yet; used to decelerate
+  // before reaching the limit switch.
+  volatile uint32_t travel_steps_ = 0;
 
   volatile MotorStatus motor_status_;
 
-  // Number of steps taken during the current or most recent movement.
-  volatile uint32_t step_count_ = 0;
+  // True if the current movement started at the other limit switch.
+  volatile bool started_at_limit_ = false;
+
+  // The direction in which the motor is moving (i.e. true if opening), which
+  // differs from motor_status_ while reversing.
+  volatile bool moving_open_ = false;
+
+  // True if the motor is decelerating in order to reverse direction, i.e. to
+  // move in the direction indicated by motor_status_.
+  volatile bool reversing_ = false;
 };
 
 }  // namespace astro_makers
@@ -9,38 +9,19 @@ namespace astro_makers {
 
 using ::alpaca::ECalibratorStatus;
 using ::mcucore::StatusOr;
-using ::mcucore::TimerCounterChannel;
 
 CoverCalibrator::CoverCalibrator(
     alpaca::ServerContext& server_context,
-    const alpaca::DeviceDescription& device_description)
+    const alpaca::DeviceDescription& device_description,
+    CoverHardware& cover_hardware, CalibratorLeds& leds)
     : CoverCalibratorAdapter(server_context, device_description),
-      led1_(TimerCounterChannel::B, kLedChannel1EnabledPin),
-      led2_(TimerCounterChannel::C, kLedChannel2EnabledPin),
-      led3_(TimerCounterChannel::A, kLedChannel3EnabledPin),
-      led4_(TimerCounterChannel::A, kLedChannel4EnabledPin),
-      cover_() {}
-
-#define VLOG_ENABLEABLE_BY_PIN(level, name, enableable_by_pin)        \
-  MCU_VLOG(level) << MCU_PSD(name)                                    \
-                  << (enableable_by_pin.IsEnabled()                   \
-                          ? MCU_FLASHSTR(" is enabled")               \
-                          : MCU_FLASHSTR(" is not enabled"))          \
-                  << MCU_PSD("; digitalRead(")                        \
-                  << enableable_by_pin.enabled_pin() << MCU_PSD(")=") \
-                  << enableable_by_pin.ReadPin()
+      leds_(leds),
+      cover_(cover_hardware) {}
 
 void CoverCalibrator::ResetHardware() { cover_.ResetHardware(); }
 
 void CoverCalibrator::InitializeDevice() {
-  pinMode(kLedChannel1PwmPin, OUTPUT);
-  pinMode(kLedChannel2PwmPin, OUTPUT);
-  pinMode(kLedChannel3PwmPin, OUTPUT);
-  pinMode(kLedChannel4PwmPin, OUTPUT);
-
-  // Fastest clock mode.
-  TimerCounter3Initialize16BitFastPwm(mcucore::ClockPrescaling::kDivideBy1);
-  TimerCounter4Initialize16BitFastPwm(mcucore::ClockPrescaling::kDivideBy1);
+  leds_.Initialize();
 
   calibrator_on_ = false;
   brightness_ = 0;
@@ -50,14 +31,6 @@ void CoverCalibrator::InitializeDevice() {
   // OR always close it (maybe based on a choice by the end-user stored in
   // EEPROM).
   cover_.InitializeHardware();
-
-  // Announce enablement once only.
-
-  VLOG_ENABLEABLE_BY_PIN(1, "LED #1", led1_);
-  VLOG_ENABLEABLE_BY_PIN(1, "LED #2", led2_);
-  VLOG_ENABLEABLE_BY_PIN(1, "LED #3", led3_);
-  VLOG_ENABLEABLE_BY_PIN(1, "LED #4", led4_);
-  VLOG_ENABLEABLE_BY_PIN(1, "Cover Motor", cover_);
 }
 
 // Returns the current calibrator brightness that has been requested, but only
@@ -96,21 +69,10 @@ mcucore::Status CoverCalibrator::SetCalibratorBrightness(uint32_t brightness) {
   }
   calibrator_on_ = true;
   brightness_ = brightness;
-  if (GetLedChannelEnabled(0)) {
-    MCU_VLOG_IF(1, !led1_.IsEnabled()) << MCU_PSD("led1 not enabled!");
-    led1_.set_pulse_count(brightness_);
-  }
-  if (GetLedChannelEnabled(1)) {
-    MCU_VLOG_IF(1, !led2_.IsEnabled()) << MCU_PSD("led2 not enabled!");
-    led2_.set_pulse_count(brightness_);
-  }
-  if (GetLedChannelEnabled(2)) {
-    MCU_VLOG_IF(1, !led3_.IsEnabled()) << MCU_PSD("led3 not enabled!");
-    led3_.set_pulse_count(brightness_);
-  }
-  if (GetLedChannelEnabled(3)) {
-    MCU_VLOG_IF(1, !led4_.IsEnabled()) << MCU_PSD("led4 not enabled!");
-    led4_.set_pulse_count(brightness_);
+  for (uint8_t channel = 0; channel < CalibratorLeds::kNumChannels; ++channel) {
+    if (GetLedChannelEnabled(channel)) {
+      leds_.SetPulseCount(channel, brightness_);
+    }
   }
   return mcucore::OkStatus();
 }
@@ -119,10 +81,9 @@ mcucore::Status CoverCalibrator::SetCalibratorOff() {
   if (!IsCalibratorHardwareEnabled()) {
     return alpaca::ErrorCodes::NotImplemented();
   }
-  led1_.set_pulse_count(0);
-  led2_.set_pulse_count(0);
-  led3_.set_pulse_count(0);
-  led4_.set_pulse_count(0);
+  for (uint8_t channel = 0; channel < CalibratorLeds::kNumChannels; ++channel) {
+    leds_.SetPulseCount(channel, 0);
+  }
   brightness_ = 0;
   calibrator_on_ = false;
   return mcucore::OkStatus();
@@ -153,8 +114,12 @@ bool CoverCalibrator::SetLedChannelEnabled(int channel, bool enabled) {
 }
 
 bool CoverCalibrator::IsCalibratorHardwareEnabled() const {
-  return led1_.IsEnabled() || led2_.IsEnabled() || led3_.IsEnabled() ||
-         led4_.IsEnabled();
+  for (uint8_t channel = 0; channel < CalibratorLeds::kNumChannels; ++channel) {
+    if (leds_.IsChannelPresent(channel)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 bool CoverCalibrator::GetLedChannelEnabled(int channel) const {
@@ -166,17 +131,8 @@ bool CoverCalibrator::GetLedChannelEnabled(int channel) const {
 }
 
 bool CoverCalibrator::GetLedChannelHardwareEnabled(int channel) const {
-  switch (channel) {
-    case 0:
-      return led1_.IsEnabled();
-    case 1:
-      return led2_.IsEnabled();
-    case 2:
-      return led3_.IsEnabled();
-    case 3:
-      return led4_.IsEnabled();
-  }
-  return false;
+  return 0 <= channel && channel < CalibratorLeds::kNumChannels &&
+         leds_.IsChannelPresent(channel);
 }
 
 mcucore::StatusOr<alpaca::ECoverStatus> CoverCalibrator::GetCoverState() {
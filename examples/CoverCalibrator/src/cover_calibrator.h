@@ -10,14 +10,17 @@
 #include <McuCore.h>
 #include <TinyAlpacaServer.h>
 
+#include "calibrator_leds.h"
 #include "cover.h"
+#include "cover_hardware.h"
 
 namespace astro_makers {
 
 class CoverCalibrator : public alpaca::CoverCalibratorAdapter {
  public:
-  explicit CoverCalibrator(alpaca::ServerContext& server_context,
-                           const alpaca::DeviceDescription& device_description);
+  CoverCalibrator(alpaca::ServerContext& server_context,
+                  const alpaca::DeviceDescription& device_description,
+                  CoverHardware& cover_hardware, CalibratorLeds& leds);
 
   // Disables the stepper motor driver, nothing else.
   void ResetHardware() override;
@@ -66,14 +69,7 @@ class CoverCalibrator : public alpaca::CoverCalibratorAdapter {
  private:
   bool IsCalibratorHardwareEnabled() const;
 
-  // TODO(jamessynge): Need something like template specialization to select the
-  // timer/counter number and channel given the kLedChannel1PwmPin macro (and
-  // other such macros). Doing so could avoid linking in unused objects.
-  mcucore::TimerCounter3Pwm16Output led1_;
-  mcucore::TimerCounter3Pwm16Output led2_;
-  mcucore::TimerCounter3Pwm16Output led3_;
-  mcucore::TimerCounter4Pwm16Output led4_;
-
+  CalibratorLeds& leds_;
   Cover cover_;
 
   bool calibrator_on_;
@@ -0,0 +1,47 @@
+#ifndef TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_COVER_HARDWARE_H_
+#define TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_COVER_HARDWARE_H_
+
+// Interface to the hardware used to move the cover: the stepper motor driver,
+// the limit switches at each end of the travel of the cover, and the timer with
+// which the steps are timed. AvrCoverHardware implements this with the pins in
+// constants.h and Timer/Counter 5; a simulation of the hardware can be used for
+// testing on a host.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+#include <TinyAlpacaServer.h>
+
+namespace astro_makers {
+
+class CoverHardware : public alpaca::StepperHardware {
+ public:
+  // Returns true if the cover motor is present (i.e. its jumper is installed).
+  virtual bool IsPresent() const = 0;
+
+  // Puts the hardware into a safe state (i.e. with the motor disabled), without
+  // otherwise initializing it.
+  virtual void ResetHardware() = 0;
+
+  // Prepares the hardware for use.
+  virtual void InitializeHardware() = 0;
+
+  // The rate of the timer, i.e. the number of ticks per second, where the
+  // arguments to StartTimer and SetTimerInterval are measured in ticks.
+  virtual uint32_t TimerTicksPerSecond() const = 0;
+
+  virtual void EnableMotor() = 0;
+  virtual void DisableMotor() = 0;
+
+  // Selects the direction in which the motor moves, and hence the limit switch
+  // which IsAtLimit checks.
+  virtual void SetDirection(bool open) = 0;
+
+  // Return true if the specified limit switch is closed.
+  virtual bool IsOpenLimitClosed() const = 0;
+  virtual bool IsClosedLimitClosed() const = 0;
+};
+
+}  // namespace astro_makers
+
+#endif  // TINY_ALPACA_SERVER_EXAMPLES_COVERCALIBRATOR_SRC_COVER_HARDWARE_H_
@@ -22,8 +22,9 @@ class LedChannelSwitchGroup : public alpaca::SwitchAdapter {
                         CoverCalibrator& cover_calibrator);
 
   // Overridden methods.
+  // InitializeDevice isn't overridden, so that SwitchAdapter::InitializeDevice
+  // can load the switch names.
   void ResetHardware() override {}
-  void InitializeDevice() override {}
   bool HandleGetSwitchDescription(const alpaca::AlpacaRequest& request,
                                   uint16_t switch_id, Print& out) override;
   bool HandleGetSwitchName(const alpaca::AlpacaRequest& request,
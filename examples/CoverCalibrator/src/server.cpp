@@ -5,6 +5,8 @@
 #include <McuNet.h>
 #include <TinyAlpacaServer.h>
 
+#include "avr_calibrator_leds.h"
+#include "avr_cover_hardware.h"
 #include "cover_calibrator.h"
 #include "led_channel_switch_group.h"
 
@@ -32,8 +34,12 @@ const DeviceDescription kCoverCalibratorDeviceDescription  // NOLINT
         .supported_actions = {},  // No extra actions.
     };
 
+AvrCoverHardware cover_hardware;    // NOLINT
+AvrCalibratorLeds calibrator_leds;  // NOLINT
+
 CoverCalibrator cover_calibrator(  // NOLINT
-    server_context, kCoverCalibratorDeviceDescription);
+    server_context, kCoverCalibratorDeviceDescription, cover_hardware,
+    calibrator_leds);
 
 const DeviceDescription kLedSwitchesDeviceDescription  // NOLINT
     {
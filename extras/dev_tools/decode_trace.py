@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""Decodes a dump of TraceRing (src/trace_ring.h) into readable text.
+
+The dump is produced by calling TraceRing::Global().DumpTo(Serial) on a server
+built with TAS_ENABLE_TRACE_RING. Capture the serial output to a file (it may
+include other log output, which is ignored), then run:
+
+  decode_trace.py [--src_dir=path/to/TinyAlpacaServer/src] [dump_file]
+
+The names of the events, APIs, device methods and decode functions are read
+from the source files, so the dump should be decoded with the same version of
+the source as was used to build the server.
+"""
+
+import argparse
+import os
+import re
+import sys
+from typing import Dict, Optional, Sequence, TextIO
+
+# The names of the decode functions, in the order of their ids, starting at 1.
+# Must match DecodeFunctionTraceId in src/request_decoder.cpp.
+DECODE_FUNCTION_NAMES = [
+    'DecodeApiGroup',
+    'DecodeApiVersion',
+    'DecodeDeviceMethod',
+    'DecodeDeviceNumber',
+    'DecodeDeviceType',
+    'DecodeEndOfPath',
+    'DecodeHeaderLineEnd',
+    'DecodeHeaderLines',
+    'DecodeHeaderName',
+    'DecodeHeaderValue',
+    'DecodeHttpMethod',
+    'DecodeManagementMethod',
+    'DecodeManagementType',
+    'DecodeParamName',
+    'DecodeParamSeparator',
+    'DecodeParamValue',
+    'MatchHttpVersion',
+    'MatchStartOfPath',
+    'SkipHeaderValue',
+    'DecodeAssetPath',
+]
+
+RECORD_RE = re.compile(
+    r'^([0-9A-F]{2}) ([0-9A-F]{2}) ([0-9A-F]{4}) ([0-9A-F]{8})$')
+
+
+def parse_enum(source: str, enum_name: str) -> Dict[int, str]:
+  """Returns the values of the named C++ enum, mapped to their names."""
+  m = re.search(r'enum class ' + enum_name + r'\b[^{]*\{(.*?)\};', source,
+                re.DOTALL)
+  if not m:
+    raise ValueError(f'Unable to find enum {enum_name}')
+  body = re.sub(r'//[^\n]*', '', m.group(1))
+  result: Dict[int, str] = {}
+  next_value = 0
+  for entry in body.split(','):
+    entry = entry.strip()
+    if not entry:
+      continue
+    name, _, value = entry.partition('=')
+    name = name.strip()
+    if value.strip():
+      next_value = int(value.strip(), 0)
+    result[next_value] = name[1:] if name.startswith('k') else name
+    next_value += 1
+  return result
+
+
+class TraceDecoder:
+  """Formats trace records, using names read from the source files."""
+
+  def __init__(self, src_dir: str):
+    with open(os.path.join(src_dir, 'trace_ring.h'), 'r') as f:
+      self.events = parse_enum(f.read(), 'ETraceEvent')
+    with open(os.path.join(src_dir, 'constants.h'), 'r') as f:
+      constants = f.read()
+    self.apis = parse_enum(constants, 'EAlpacaApi')
+    self.device_methods = parse_enum(constants, 'EDeviceMethod')
+    self.deadlines: Dict[int, str] = {}
+    deadlines_path = os.path.join(src_dir, 'connection_deadlines.h')
+    if os.path.exists(deadlines_path):
+      with open(deadlines_path, 'r') as f:
+        self.deadlines = parse_enum(f.read(), 'EConnectionDeadline')
+
+  def format_args(self, event: str, arg0: int, arg1: int) -> str:
+    """Returns the arguments of the event in readable form."""
+    if event in ('Connect', 'Disconnect', 'EventStreamStart', 'RequestParked'):
+      return f'socket={arg0}'
+    if event in ('CloseConnection', 'Decoded'):
+      return f'socket={arg0} status={arg1}'
+    if event == 'DeadlineExpired':
+      return f'socket={arg0} deadline={self.deadlines.get(arg1, arg1)}'
+    if event == 'DecoderReset':
+      return ''
+    if event == 'DecodeFunction':
+      if 0 < arg1 <= len(DECODE_FUNCTION_NAMES):
+        return DECODE_FUNCTION_NAMES[arg1 - 1]
+      return f'unknown function id {arg1}'
+    if event == 'Dispatch':
+      api = self.apis.get(arg0, arg0)
+      method = self.device_methods.get(arg1, arg1)
+      return f'api={api} method={method}'
+    if event in ('ResponseIncomplete', 'ResponseComplete'):
+      return f'socket={arg0} bytes_written={arg1}'
+    return f'arg0={arg0} arg1={arg1}'
+
+  def decode(self, lines: TextIO, out: TextIO) -> None:
+    """Decodes each dump found in lines, writing the result to out."""
+    in_dump = False
+    prev_micros: Optional[int] = None
+    for line in lines:
+      line = line.strip()
+      if line.startswith('TAS_TRACE_END'):
+        in_dump = False
+        continue
+      if line.startswith('TAS_TRACE '):
+        fields = line.split()
+        num_recorded, num_records = int(fields[1]), int(fields[2])
+        out.write(f'Trace of {num_records} records')
+        if num_recorded > num_records:
+          out.write(f' ({num_recorded - num_records} earlier records lost)')
+        out.write('\n')
+        in_dump = True
+        prev_micros = None
+        continue
+      if not in_dump:
+        continue
+      m = RECORD_RE.match(line)
+      if not m:
+        out.write(f'Unable to decode: {line!r}\n')
+        continue
+      event_id, arg0, arg1, micros = (int(v, 16) for v in m.groups())
+      event = self.events.get(event_id, f'Event{event_id}')
+      if prev_micros is None:
+        delta = 0
+      else:
+        delta = (micros - prev_micros) & 0xFFFFFFFF
+      prev_micros = micros
+      args = self.format_args(event, arg0, arg1)
+      out.write(f'{micros:>10} +{delta:<8} {event:<20} {args}\n'.rstrip() +
+                '\n')
+
+
+def main(argv: Sequence[str]) -> None:
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument(
+      '--src_dir',
+      default=os.path.join(os.path.dirname(__file__), '..', '..', 'src'),
+      help='Path of the TinyAlpacaServer src directory.')
+  parser.add_argument(
+      'dump_file', nargs='?', help='File containing the dump; default: stdin.')
+  args = parser.parse_args(argv[1:])
+  decoder = TraceDecoder(args.src_dir)
+  if args.dump_file:
+    with open(args.dump_file, 'r') as f:
+      decoder.decode(f, sys.stdout)
+  else:
+    decoder.decode(sys.stdin, sys.stdout)
+
+
+if __name__ == '__main__':
+  main(sys.argv)
@@ -6,6 +6,7 @@
 //
 // Author: james.synge@gmail.com
 
+#include "config.h"
 #include "constants.h"
 #include "gmock/gmock.h"
 #include "request_listener.h"
@@ -20,9 +21,45 @@ class MockRequestListener : public RequestListener {
   MOCK_METHOD(bool, OnRequestDecoded, (struct AlpacaRequest &, class Print &),
               (override));
 
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+  MOCK_METHOD(bool, ShouldShedRequest, (const struct AlpacaRequest &),
+              (override));
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+
   MOCK_METHOD(void, OnRequestDecodingError,
               (struct AlpacaRequest &, enum EHttpStatusCode, class Print &),
               (override));
+
+  MOCK_METHOD(void, OnRequestAborted, (struct AlpacaRequest &), (override));
+
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  MOCK_METHOD(void, OnRequestCompleted,
+              (const struct AlpacaRequest &, enum EHttpStatusCode,
+               const struct RequestTimings &),
+              (override));
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+
+#if TAS_ENABLE_EVENT_STREAMS
+  MOCK_METHOD(bool, OnEventStreamCanWrite,
+              (const struct AlpacaRequest &, struct EventStreamState &,
+               class Print &),
+              (override));
+
+  MOCK_METHOD(void, OnEventStreamClosed, (const struct AlpacaRequest &),
+              (override));
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+  MOCK_METHOD(bool, OnParkedRequestCanWrite,
+              (struct AlpacaRequest &, class Print &), (override));
+#endif  // TAS_ENABLE_LONG_POLL
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  MOCK_METHOD(void, OnResumableResponseCanWrite,
+              (const struct AlpacaRequest &, struct ResponseCursor &,
+               class Print &),
+              (override));
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
 };
 
 }  // namespace test
@@ -18,6 +18,24 @@ namespace test {
 
 using ::mcunet::test::StringIoConnection;
 
+namespace {
+
+// A StringIoConnection with a fixed amount of space in which to write.
+class LimitedWriteConnection : public StringIoConnection {
+ public:
+  LimitedWriteConnection(uint8_t sock_num, std::string_view input,
+                         int available_for_write)
+      : StringIoConnection(sock_num, input),
+        available_for_write_(available_for_write) {}
+
+  int availableForWrite() override { return available_for_write_; }
+
+ private:
+  const int available_for_write_;
+};
+
+}  // namespace
+
 TestTinyAlpacaServer::TestTinyAlpacaServer(
     ServerContext& server_context, const ServerDescription& server_description,
     mcucore::ArrayView<DeviceInterface*> devices)
@@ -32,7 +50,7 @@ ConnectionResult TestTinyAlpacaServer::AnnounceConnect(std::string_view input,
   MCU_CHECK(!server_connection_.has_socket());
   MCU_CHECK(!connection_is_open_);
   MCU_CHECK(!connection_is_writeable_);
-  StringIoConnection conn(sock_num_, input);
+  LimitedWriteConnection conn(sock_num_, input, available_for_write_);
   server_connection_.OnConnect(conn);
   if (repeat_until_stable) {
     RepeatedlyAnnounceCanRead(conn);
@@ -55,7 +73,7 @@ ConnectionResult TestTinyAlpacaServer::AnnounceCanRead(std::string_view input,
   MCU_CHECK(connection_is_writeable_);
   MCU_CHECK(!(input.empty() && peer_half_closed))
       << MCU_FLASHSTR("Call AnnounceHalfClosed instead");
-  StringIoConnection conn(sock_num_, input);
+  LimitedWriteConnection conn(sock_num_, input, available_for_write_);
   if (repeat_until_stable) {
     RepeatedlyAnnounceCanRead(conn);
   } else {
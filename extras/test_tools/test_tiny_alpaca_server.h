@@ -42,6 +42,10 @@ struct ConnectionResult {
 
 class TestTinyAlpacaServer : public TinyAlpacaDeviceServer {
  public:
+  // The size of each socket's transmit buffer in a W5500 with its default
+  // configuration.
+  static constexpr int kDefaultAvailableForWrite = 2048;
+
   TestTinyAlpacaServer(ServerContext& server_context,
                        const ServerDescription& server_description,
                        mcucore::ArrayView<DeviceInterface*> devices);
@@ -86,6 +90,15 @@ class TestTinyAlpacaServer : public TinyAlpacaDeviceServer {
   // by the client?
   bool connection_is_writeable() const { return connection_is_writeable_; }
 
+  // Sets the value returned by availableForWrite() of the connections passed
+  // to the ServerConnection by the above methods, i.e. the space in the
+  // socket's transmit buffer, as if the client acknowledges all that has been
+  // written between calls to OnCanRead. This limits how much of a resumable
+  // response is written by each call.
+  void set_available_for_write(int available_for_write) {
+    available_for_write_ = available_for_write;
+  }
+
  private:
   void RepeatedlyAnnounceCanRead(mcunet::test::StringIoConnection& conn);
   void RepeatedlyAnnounceHalfClosed(mcunet::test::StringIoConnection& conn);
@@ -94,6 +107,7 @@ class TestTinyAlpacaServer : public TinyAlpacaDeviceServer {
 
   ServerConnection server_connection_;
   uint8_t sock_num_;
+  int available_for_write_{kDefaultAvailableForWrite};
 
   // These are based on the Announce calls that have been made, and on whether
   // the ServerConnection closed the passed in connection.
@@ -7,15 +7,19 @@
 
 #include "absl/log/log.h"
 #include "alpaca_request.h"
+#include "alpaca_response.h"
+#include "config.h"
 #include "constants.h"
 #include "device_description.h"
 #include "device_interface.h"
+#include "event_stream_state.h"
 #include "extras/test_tools/alpaca_response_validator.h"
 #include "extras/test_tools/minimal_device.h"
 #include "extras/test_tools/mock_device_interface.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "mcucore/extras/test_tools/http_response.h"
+#include "mcucore/extras/test_tools/json_decoder.h"
 #include "mcucore/extras/test_tools/print_to_std_string.h"
 #include "mcucore/extras/test_tools/status_test_utils.h"
 #include "mcucore/extras/test_tools/uuid_utils.h"
@@ -32,14 +36,17 @@ namespace {
 using ::mcucore::MakeArrayView;
 using ::mcucore::test::JsonValue;
 using ::mcucore::test::kUuidRegex;
+using ::testing::_;
 using ::testing::EndsWith;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::MatchesRegex;
 using ::testing::NiceMock;
+using ::testing::Not;
 using ::testing::Ref;
 using ::testing::Return;
 using ::testing::ReturnRef;
+using ::testing::StartsWith;
 
 TEST(AlpacaDevicesNoFixtureTest, NoDevices) {
   ServerContext server_context;
@@ -403,6 +410,327 @@ TEST_F(AlpacaDevicesTest, DispatchDeviceRequest) {
   EXPECT_THAT(out.str(), IsEmpty());
 }
 
+#if TAS_ENABLE_BATCH_REQUESTS
+TEST_F(AlpacaDevicesTest, BatchRequest) {
+  MinimalDevice minimal_camera0{server_context_, mock_camera0_description_};
+  DeviceInterface* device_ptrs[] = {&minimal_camera0};
+  AlpacaDevices devices(server_context_, MakeArrayView(device_ptrs));
+
+  AlpacaRequest request;
+  request.http_method = EHttpMethod::GET;
+  request.api_group = EApiGroup::kDevice;
+  request.api = EAlpacaApi::kDeviceApi;
+  request.device_type = EDeviceType::kCamera;
+  request.device_number = 0;
+  request.device_method = EDeviceMethod::kBatch;
+  request.set_client_transaction_id(17);
+  request.set_server_transaction_id(1000001);
+  ASSERT_TRUE(request.add_batch_method(EDeviceMethod::kName));
+  ASSERT_TRUE(request.add_batch_method(EDeviceMethod::kInterfaceVersion));
+  ASSERT_TRUE(request.add_batch_method(EDeviceMethod::kCoverState));
+  ASSERT_FALSE(request.add_batch_method(EDeviceMethod::kBatch));
+  // Methods which may only be used with PUT can't be read by a batch.
+  ASSERT_FALSE(request.add_batch_method(EDeviceMethod::kOpenCover));
+
+  mcucore::test::PrintToStdString out;
+  EXPECT_FALSE(devices.DispatchDeviceRequest(request, out));
+  VLOG(1) << "out:\n\n" << out.str() << "\n\n";
+
+  ASSERT_OK_AND_ASSIGN(auto response,
+                       mcucore::test::HttpResponse::Make(out.str()));
+  EXPECT_EQ(response.status_code, 200);
+  EXPECT_TRUE(response.HasHeaderValue("Connection", "close"));
+  EXPECT_TRUE(response.HasHeaderValue("Content-Type", "application/json"));
+  EXPECT_FALSE(response.HasHeader("Content-Length"));
+
+  ASSERT_OK_AND_ASSIGN(auto body, JsonValue::Parse(response.body_and_beyond));
+  ASSERT_TRUE(body.is_array());
+  ASSERT_EQ(body.size(), 3);
+
+  // Each element is the response to the corresponding method, with the same
+  // transaction ids.
+  for (int ndx = 0; ndx < 3; ++ndx) {
+    auto element = body.GetElement(ndx);
+    ASSERT_TRUE(element.is_object());
+    EXPECT_EQ(element.GetValue("ClientTransactionID"), 17);
+    EXPECT_EQ(element.GetValue("ServerTransactionID"), 1000001);
+  }
+  EXPECT_EQ(body.GetElement(0).GetValue("Value"), "Camera Name");
+  EXPECT_EQ(body.GetElement(0).GetValue("ErrorNumber"), 0);
+  EXPECT_EQ(body.GetElement(1).GetValue("Value"), 1);
+  EXPECT_EQ(body.GetElement(2).GetValue("ErrorNumber"), 1024);
+}
+
+TEST_F(AlpacaDevicesTest, BatchRequestWithHttpError) {
+  AlpacaRequest request;
+  request.http_method = EHttpMethod::GET;
+  request.api_group = EApiGroup::kDevice;
+  request.api = EAlpacaApi::kDeviceApi;
+  request.device_type = EDeviceType::kCamera;
+  request.device_number = 0;
+  request.device_method = EDeviceMethod::kBatch;
+  request.set_client_transaction_id(17);
+  request.set_server_transaction_id(1000001);
+  ASSERT_TRUE(request.add_batch_method(EDeviceMethod::kName));
+  ASSERT_TRUE(request.add_batch_method(EDeviceMethod::kDescription));
+
+  // The first method fails with an HTTP error, whose body isn't JSON; the
+  // second succeeds.
+  EXPECT_CALL(mock_camera0_, HandleDeviceApiRequest(_, _))
+      .WillOnce([](const AlpacaRequest& request, Print& out) {
+        return WriteResponse::HttpErrorResponse(
+            EHttpStatusCode::kHttpBadRequest,
+            mcucore::AnyPrintable(MCU_FLASHSTR("Not JSON")), out);
+      })
+      .WillOnce([](const AlpacaRequest& request, Print& out) {
+        return WriteResponse::AnyPrintableStringResponse(
+            request, mcucore::AnyPrintable(MCU_FLASHSTR("Described")), out);
+      });
+
+  mcucore::test::PrintToStdString out;
+  EXPECT_FALSE(alpaca_devices_.DispatchDeviceRequest(request, out));
+  VLOG(1) << "out:\n\n" << out.str() << "\n\n";
+
+  ASSERT_OK_AND_ASSIGN(auto response,
+                       mcucore::test::HttpResponse::Make(out.str()));
+  EXPECT_EQ(response.status_code, 200);
+  EXPECT_THAT(response.body_and_beyond, Not(HasSubstr("Not JSON")));
+
+  ASSERT_OK_AND_ASSIGN(auto body, JsonValue::Parse(response.body_and_beyond));
+  ASSERT_TRUE(body.is_array());
+  ASSERT_EQ(body.size(), 2);
+  EXPECT_EQ(body.GetElement(0).GetValue("ClientTransactionID"), 17);
+  EXPECT_EQ(body.GetElement(0).GetValue("ErrorNumber"), 0x4FF);
+  EXPECT_EQ(body.GetElement(0).GetValue("ErrorMessage"), "HTTP status 400");
+  EXPECT_EQ(body.GetElement(1).GetValue("ErrorNumber"), 0);
+  EXPECT_EQ(body.GetElement(1).GetValue("Value"), "Described");
+}
+
+TEST_F(AlpacaDevicesTest, PutBatchRequestRejectsMethods) {
+  AlpacaRequest request;
+  request.http_method = EHttpMethod::PUT;
+  request.device_method = EDeviceMethod::kBatch;
+  EXPECT_FALSE(request.add_batch_method(EDeviceMethod::kName));
+  EXPECT_EQ(request.num_batch_methods, 0);
+}
+
+TEST_F(AlpacaDevicesTest, BatchRequestWithoutMethods) {
+  MinimalDevice minimal_camera0{server_context_, mock_camera0_description_};
+  DeviceInterface* device_ptrs[] = {&minimal_camera0};
+  AlpacaDevices devices(server_context_, MakeArrayView(device_ptrs));
+
+  AlpacaRequest request;
+  request.http_method = EHttpMethod::GET;
+  request.api_group = EApiGroup::kDevice;
+  request.api = EAlpacaApi::kDeviceApi;
+  request.device_type = EDeviceType::kCamera;
+  request.device_number = 0;
+  request.device_method = EDeviceMethod::kBatch;
+
+  mcucore::test::PrintToStdString out;
+  EXPECT_FALSE(devices.DispatchDeviceRequest(request, out));
+  EXPECT_THAT(out.str(), HasSubstr("Missing parameter: Method"));
+}
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_EVENT_STREAMS
+TEST_F(AlpacaDevicesTest, EventStream) {
+  MinimalDevice minimal_camera0{server_context_, mock_camera0_description_};
+  DeviceInterface* device_ptrs[] = {&minimal_camera0};
+  AlpacaDevices devices(server_context_, MakeArrayView(device_ptrs));
+
+  AlpacaRequest request;
+  request.http_method = EHttpMethod::GET;
+  request.api_group = EApiGroup::kDevice;
+  request.api = EAlpacaApi::kDeviceApi;
+  request.device_type = EDeviceType::kCamera;
+  request.device_number = 0;
+  request.device_method = EDeviceMethod::kEvents;
+
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(devices.DispatchDeviceRequest(request, out));
+    ASSERT_OK_AND_ASSIGN(auto response,
+                         mcucore::test::HttpResponse::Make(out.str()));
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_TRUE(response.HasHeaderValue("Content-Type", "text/event-stream"));
+    EXPECT_FALSE(response.HasHeader("Content-Length"));
+    EXPECT_THAT(response.body_and_beyond, IsEmpty());
+  }
+
+  // The first write always reports the current state.
+  EventStreamState state;
+  state.Reset();
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(devices.WriteEventStream(request, state, out));
+    EXPECT_THAT(out.str(), StartsWith("event: devicestate\ndata: {"));
+    EXPECT_THAT(out.str(), EndsWith("}\n\n"));
+    EXPECT_TRUE(state.have_state_hash);
+  }
+
+  // Nothing has changed, so nothing more is written.
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(devices.WriteEventStream(request, state, out));
+    EXPECT_THAT(out.str(), IsEmpty());
+  }
+
+  devices.OnEventStreamClosed(request);
+}
+
+TEST_F(AlpacaDevicesTest, TooManyEventStreams) {
+  MinimalDevice minimal_camera0{server_context_, mock_camera0_description_};
+  DeviceInterface* device_ptrs[] = {&minimal_camera0};
+  AlpacaDevices devices(server_context_, MakeArrayView(device_ptrs));
+
+  AlpacaRequest request;
+  request.http_method = EHttpMethod::GET;
+  request.api_group = EApiGroup::kDevice;
+  request.api = EAlpacaApi::kDeviceApi;
+  request.device_type = EDeviceType::kCamera;
+  request.device_number = 0;
+  request.device_method = EDeviceMethod::kEvents;
+
+  for (int ndx = 0; ndx < TAS_MAX_EVENT_STREAMS; ++ndx) {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(devices.DispatchDeviceRequest(request, out));
+    EXPECT_THAT(out.str(), HasSubstr("200 OK"));
+  }
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_FALSE(devices.DispatchDeviceRequest(request, out));
+    EXPECT_THAT(out.str(), StartsWith("HTTP/1.1 503 Service Unavailable"));
+  }
+  devices.OnEventStreamClosed(request);
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(devices.DispatchDeviceRequest(request, out));
+    EXPECT_THAT(out.str(), HasSubstr("200 OK"));
+  }
+}
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+class AlpacaDevicesLongPollTest : public AlpacaDevicesTest {
+ protected:
+  void SetUp() override {
+    AlpacaDevicesTest::SetUp();
+    ON_CALL(mock_camera0_, HandleDeviceApiRequest(_, _))
+        .WillByDefault([this](AlpacaRequest& request, Print& out) {
+          return WriteResponse::IntResponse(request, value_, out);
+        });
+    request_.http_method = EHttpMethod::GET;
+    request_.api_group = EApiGroup::kDevice;
+    request_.api = EAlpacaApi::kDeviceApi;
+    request_.device_type = EDeviceType::kCamera;
+    request_.device_number = 0;
+    request_.device_method = EDeviceMethod::kConnected;
+    request_.set_wait_for_change_ms(10000);
+  }
+
+  // Moves the times recorded in the parked request back by the specified
+  // amount, so that we don't need to wait in real time.
+  void PretendTimePassed(uint32_t ms) {
+    request_.parked_millis -= ms;
+    request_.last_check_millis -= ms;
+  }
+
+  int32_t value_ = 1;
+  AlpacaRequest request_;
+};
+
+TEST_F(AlpacaDevicesLongPollTest, RespondsImmediatelyIfNotEqual) {
+  request_.set_if_not_equal(mcucore::StringView("2"));
+  mcucore::test::PrintToStdString out;
+  EXPECT_TRUE(alpaca_devices_.DispatchDeviceRequest(request_, out));
+  EXPECT_FALSE(request_.is_parked);
+  EXPECT_THAT(out.str(), HasSubstr(R"({"Value": 1, )"));
+}
+
+TEST_F(AlpacaDevicesLongPollTest, ParksUntilChanged) {
+  request_.set_if_not_equal(mcucore::StringView("1"));
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(alpaca_devices_.DispatchDeviceRequest(request_, out));
+    EXPECT_TRUE(request_.is_parked);
+    EXPECT_THAT(out.str(), IsEmpty());
+  }
+
+  // The value hasn't changed.
+  PretendTimePassed(TAS_LONG_POLL_CHECK_INTERVAL_MS);
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(alpaca_devices_.WriteParkedRequest(request_, out));
+    EXPECT_TRUE(request_.is_parked);
+    EXPECT_THAT(out.str(), IsEmpty());
+  }
+
+  // The value has changed, but it is too soon to check again.
+  value_ = 3;
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(alpaca_devices_.WriteParkedRequest(request_, out));
+    EXPECT_TRUE(request_.is_parked);
+    EXPECT_THAT(out.str(), IsEmpty());
+  }
+
+  PretendTimePassed(TAS_LONG_POLL_CHECK_INTERVAL_MS);
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(alpaca_devices_.WriteParkedRequest(request_, out));
+    EXPECT_FALSE(request_.is_parked);
+    EXPECT_THAT(out.str(), HasSubstr(R"({"Value": 3, )"));
+  }
+}
+
+TEST_F(AlpacaDevicesLongPollTest, WaitsForChangeFromCurrentValue) {
+  // Without IfNotEqual, the request waits for the value to change from the
+  // value at the time of the request.
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(alpaca_devices_.DispatchDeviceRequest(request_, out));
+    EXPECT_TRUE(request_.is_parked);
+    EXPECT_THAT(out.str(), IsEmpty());
+  }
+
+  value_ = 2;
+  PretendTimePassed(TAS_LONG_POLL_CHECK_INTERVAL_MS);
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(alpaca_devices_.WriteParkedRequest(request_, out));
+    EXPECT_FALSE(request_.is_parked);
+    EXPECT_THAT(out.str(), HasSubstr(R"({"Value": 2, )"));
+  }
+}
+
+TEST_F(AlpacaDevicesLongPollTest, RespondsWhenWaitExpires) {
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(alpaca_devices_.DispatchDeviceRequest(request_, out));
+    EXPECT_TRUE(request_.is_parked);
+  }
+
+  PretendTimePassed(10000);
+  {
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(alpaca_devices_.WriteParkedRequest(request_, out));
+    EXPECT_FALSE(request_.is_parked);
+    EXPECT_THAT(out.str(), HasSubstr(R"({"Value": 1, )"));
+  }
+}
+
+TEST_F(AlpacaDevicesLongPollTest, ZeroWaitDoesNotPark) {
+  AlpacaRequest request = request_;
+  request.have_wait_for_change_ms = false;
+  request.set_wait_for_change_ms(0);
+  mcucore::test::PrintToStdString out;
+  EXPECT_TRUE(alpaca_devices_.DispatchDeviceRequest(request, out));
+  EXPECT_FALSE(request.is_parked);
+  EXPECT_THAT(out.str(), HasSubstr(R"({"Value": 1, )"));
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
 using AlpacaDevicesDeathTest = AlpacaDevicesTest;
 
 TEST_F(AlpacaDevicesDeathTest, NullDevice) {
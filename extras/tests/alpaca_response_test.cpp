@@ -12,9 +12,11 @@
 #include "absl/strings/str_join.h"
 #include "alpaca_request.h"
 #include "ascom_error_codes.h"
+#include "config.h"
 #include "constants.h"
 #include "gtest/gtest.h"
 #include "literals.h"
+#include "utils/fixed_point.h"
 #include "mcucore/extras/test_tools/json_test_utils.h"
 #include "mcucore/extras/test_tools/print_to_std_string.h"
 #include "mcucore/extras/test_tools/print_value_to_std_string.h"
@@ -112,6 +114,28 @@ TEST(AlpacaResponseTest, OkWithEmptyJsonObject) {
   EXPECT_EQ(out.str(), expected);
 }
 
+#if TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || \
+    TAS_ENABLE_LONG_POLL
+// The header of an embedded response is discarded, so it doesn't need the
+// Content-Length.
+TEST(AlpacaResponseTest, EmbeddedResponseOmitsContentLength) {
+  AlpacaRequest request;
+  request.http_method = EHttpMethod::GET;
+  request.is_embedded = true;
+  PrintToStdString out;
+  EXPECT_TRUE(WriteResponse::BoolResponse(request, true, out));
+  const auto expected_body = absl::StrCat(
+      R"({"Value": true, "ErrorNumber": 0, "ErrorMessage": ""})", kEOL);
+  const auto expected =                                     // Force
+      absl::StrCat("HTTP/1.1 200 OK", kEOL,                 // line
+                   "Server: TinyAlpacaServer", kEOL,        // wrapping
+                   "Connection: close", kEOL,               // right
+                   "Content-Type: application/json", kEOL,  // here.
+                   kEOL, expected_body);
+  EXPECT_EQ(out.str(), expected);
+}
+#endif  // TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || ...
+
 TEST(AlpacaResponseTest, StatusOrBoolResponse) {
   {
     AlpacaRequest request;
@@ -196,6 +220,46 @@ TEST(AlpacaResponseTest, StatusOrDoubleResponse) {
   }
 }
 
+TEST(AlpacaResponseTest, FixedPointResponseMatchesDoubleResponse) {
+  for (const FixedPoint value :
+       {FixedPoint(0, 0), FixedPoint(455, -1), FixedPoint(-1025, -2),
+        FixedPoint(101325, 0), FixedPoint(-3, -3), FixedPoint(123456, -4)}) {
+    for (const bool have_client_transaction_id : {false, true}) {
+      AlpacaRequest request;
+      request.set_server_transaction_id(7);
+      if (have_client_transaction_id) {
+        request.set_client_transaction_id(1234);
+      }
+      PrintToStdString fixed_out, double_out;
+      EXPECT_TRUE(WriteResponse::StatusOrFixedPointResponse(
+          request, mcucore::StatusOr<FixedPoint>(value), fixed_out));
+      EXPECT_TRUE(
+          WriteResponse::DoubleResponse(request, value.ToDouble(), double_out));
+      EXPECT_EQ(fixed_out.str(), double_out.str());
+    }
+  }
+  {
+    AlpacaRequest request;
+    request.set_server_transaction_id(7);
+    request.http_method = EHttpMethod::HEAD;
+    PrintToStdString fixed_out, double_out;
+    EXPECT_TRUE(WriteResponse::FixedPointResponse(request, FixedPoint(455, -1),
+                                                  fixed_out));
+    EXPECT_TRUE(WriteResponse::DoubleResponse(request, 45.5, double_out));
+    EXPECT_EQ(fixed_out.str(), double_out.str());
+  }
+  {
+    AlpacaRequest request;
+    request.set_server_transaction_id(3);
+    PrintToStdString fixed_out, double_out;
+    EXPECT_FALSE(WriteResponse::StatusOrFixedPointResponse(
+        request, ErrorCodes::InvalidWhileSlaved(), fixed_out));
+    EXPECT_FALSE(WriteResponse::StatusOrDoubleResponse(
+        request, ErrorCodes::InvalidWhileSlaved(), double_out));
+    EXPECT_EQ(fixed_out.str(), double_out.str());
+  }
+}
+
 TEST(AlpacaResponseTest, StatusOrFloatResponse) {
   {
     AlpacaRequest request;
@@ -0,0 +1,183 @@
+// Compares the host CPU time taken to serve a full poll cycle of an
+// ObservingConditions device (i.e. reading all of its properties, as a client
+// does every few seconds) as separate GET requests on one connection, against
+// serving a single batch request for the same methods. This measures only the
+// request path on the server; it says nothing about the network round trips
+// saved by the batch request, which are likely to dominate on real hardware.
+
+#include <McuCore.h>
+#include <McuNet.h>
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "config.h"
+#include "device_description.h"
+#include "device_interface.h"
+#include "device_types/observing_conditions/observing_conditions_adapter.h"
+#include "extras/test_tools/test_tiny_alpaca_server.h"
+#include "mcunet/extras/test_tools/mock_platform_network.h"
+#include "server_context.h"
+#include "server_description.h"
+
+MCU_DEFINE_DOMAIN(81);
+
+namespace alpaca {
+namespace test {
+namespace {
+
+const ServerDescription kServerDescription  // NOLINT
+    {
+        .server_name = MCU_FLASHSTR("Batch Benchmark"),
+        .manufacturer = MCU_FLASHSTR("Us"),
+        .manufacturer_version = MCU_FLASHSTR("0.0.1"),
+        .location = MCU_FLASHSTR("Host"),
+    };
+
+const DeviceDescription kDeviceDescription  // NOLINT
+    {
+        .device_type = EDeviceType::kObservingConditions,
+        .device_number = 0,
+        .domain = MCU_DOMAIN(81),
+        .name = MCU_FLASHSTR("Weather"),
+        .description = MCU_FLASHSTR("Fake Weather Station"),
+        .driver_info = MCU_FLASHSTR("BatchRequestBenchmark"),
+        .driver_version = MCU_FLASHSTR("0.1"),
+        .supported_actions = {},
+    };
+
+// The methods read by a client polling the device.
+constexpr std::string_view kPollMethods[] = {
+    "averageperiod", "cloudcover", "connected",      "dewpoint",
+    "humidity",      "pressure",   "rainrate",       "skybrightness",
+    "skyquality",    "starfwhm",   "skytemperature", "temperature",
+    "winddirection", "windgust",   "windspeed",
+};
+
+// Returns a fixed value for each of the sensors, so that the time measured is
+// that of producing the responses, not of reading the sensors.
+class FakeWeather : public ObservingConditionsAdapter {
+ public:
+  using ObservingConditionsAdapter::ObservingConditionsAdapter;
+  void ResetHardware() override {}
+  void InitializeDevice() override {}
+
+  mcucore::StatusOr<double> GetCloudCover() override { return 12.5; }
+  mcucore::StatusOr<double> GetDewPoint() override { return 3.25; }
+  mcucore::StatusOr<double> GetHumidity() override { return 67.5; }
+  mcucore::StatusOr<double> GetPressure() override { return 1013.25; }
+  mcucore::StatusOr<double> GetRainRate() override { return 0; }
+  mcucore::StatusOr<double> GetSkyBrightness() override { return 0.125; }
+  mcucore::StatusOr<double> GetSkyQuality() override { return 21.5; }
+  mcucore::StatusOr<double> GetSkyTemperature() override { return -18.75; }
+  mcucore::StatusOr<double> GetStarFWHM() override { return 2.5; }
+  mcucore::StatusOr<double> GetTemperature() override { return 9.5; }
+  mcucore::StatusOr<double> GetWindDirection() override { return 270; }
+  mcucore::StatusOr<double> GetWindGust() override { return 7.75; }
+  mcucore::StatusOr<double> GetWindSpeed() override { return 4.5; }
+};
+
+class WeatherServer {
+ public:
+  WeatherServer()
+      : mock_platform_network_lifetime_(
+            std::make_unique<mcunet::test::MockPlatformNetwork>()),
+        device_(server_context_, kDeviceDescription),
+        devices_{&device_},
+        server_(server_context_, kServerDescription, devices_) {}
+
+  bool Initialize() {
+    mcucore::EepromTlv::ClearAndInitializeEeprom();
+    if (!server_context_.Initialize().ok()) {
+      return false;
+    }
+    server_.ValidateAndReset();
+    server_.InitializeForServing();
+    return true;
+  }
+
+  // Sends each of the requests on a single connection, closing it at the end
+  // if the server hasn't already done so. Returns false if any of the
+  // responses isn't 200 OK.
+  template <size_t N>
+  bool RoundTrip(const std::string (&requests)[N]) {
+    bool ok = true;
+    server_.AnnounceConnect("");
+    for (const auto& request : requests) {
+      auto result = server_.AnnounceCanRead(request);
+      ok = ok && absl::StartsWith(result.output, "HTTP/1.1 200 OK");
+      benchmark::DoNotOptimize(result);
+    }
+    if (server_.connection_is_open()) {
+      server_.AnnounceDisconnect();
+    }
+    return ok;
+  }
+
+ private:
+  mcunet::PlatformNetworkLifetime<mcunet::test::MockPlatformNetwork>
+      mock_platform_network_lifetime_;
+  ServerContext server_context_;
+  FakeWeather device_;
+  DeviceInterface* devices_[1];
+  TestTinyAlpacaServer server_;
+};
+
+std::string MakeRequest(std::string_view method_and_params) {
+  return absl::StrCat("GET /api/v1/observingconditions/0/", method_and_params,
+                      "ClientID=1&ClientTransactionID=1 HTTP/1.1\r\n\r\n");
+}
+
+// Reads each property with a separate GET request.
+void BM_PollWithIndividualRequests(benchmark::State& state) {
+  WeatherServer server;
+  if (!server.Initialize()) {
+    state.SkipWithError("Initialize failed");
+    return;
+  }
+  std::string requests[std::size(kPollMethods)];
+  for (size_t ndx = 0; ndx < std::size(kPollMethods); ++ndx) {
+    requests[ndx] = MakeRequest(absl::StrCat(kPollMethods[ndx], "?"));
+  }
+  for (auto _ : state) {
+    if (!server.RoundTrip(requests)) {
+      state.SkipWithError("A request failed");
+      break;
+    }
+  }
+}
+BENCHMARK(BM_PollWithIndividualRequests);
+
+#if TAS_ENABLE_BATCH_REQUESTS
+static_assert(std::size(kPollMethods) <= TAS_MAX_BATCH_METHODS);
+
+// Reads all of the properties with a single batch request.
+void BM_PollWithBatchRequest(benchmark::State& state) {
+  WeatherServer server;
+  if (!server.Initialize()) {
+    state.SkipWithError("Initialize failed");
+    return;
+  }
+  std::string method_and_params = "batch?";
+  for (std::string_view method : kPollMethods) {
+    absl::StrAppend(&method_and_params, "Method=", method, "&");
+  }
+  const std::string requests[1] = {MakeRequest(method_and_params)};
+  for (auto _ : state) {
+    if (!server.RoundTrip(requests)) {
+      state.SkipWithError("The batch request failed");
+      break;
+    }
+  }
+}
+BENCHMARK(BM_PollWithBatchRequest);
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
@@ -0,0 +1,137 @@
+#include "connection_deadlines.h"
+
+#include <McuCore.h>
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+constexpr uint32_t kIdleTimeoutMs = 1000;
+constexpr uint32_t kRequestTimeoutMs = 300;
+
+// A clock that only advances when told to.
+class FakeClock {
+ public:
+  explicit FakeClock(uint32_t start_ms) : now_ms_(start_ms) {}
+  uint32_t now() const { return now_ms_; }
+  void Advance(uint32_t ms) { now_ms_ += ms; }
+
+ private:
+  uint32_t now_ms_;
+};
+
+class ConnectionDeadlinesTest : public testing::TestWithParam<uint32_t> {
+ protected:
+  // The parameter is the starting time, so that we test wrap around of the
+  // clock.
+  ConnectionDeadlinesTest()
+      : clock_(GetParam()), deadlines_(kIdleTimeoutMs, kRequestTimeoutMs) {
+    deadlines_.Reset(clock_.now());
+  }
+
+  EConnectionDeadline Check() const { return deadlines_.Check(clock_.now()); }
+
+  FakeClock clock_;
+  ConnectionDeadlines deadlines_;
+};
+
+TEST_P(ConnectionDeadlinesTest, IdleConnection) {
+  EXPECT_FALSE(deadlines_.is_decoding());
+  clock_.Advance(kIdleTimeoutMs - 1);
+  EXPECT_EQ(Check(), EConnectionDeadline::kNone);
+  clock_.Advance(1);
+  EXPECT_EQ(Check(), EConnectionDeadline::kIdle);
+}
+
+TEST_P(ConnectionDeadlinesTest, ActivityExtendsIdleDeadline) {
+  for (int i = 0; i < 10; ++i) {
+    clock_.Advance(kIdleTimeoutMs - 1);
+    EXPECT_EQ(Check(), EConnectionDeadline::kNone);
+    deadlines_.RecordActivity(clock_.now());
+  }
+  clock_.Advance(kIdleTimeoutMs);
+  EXPECT_EQ(Check(), EConnectionDeadline::kIdle);
+}
+
+TEST_P(ConnectionDeadlinesTest, RequestCompletedInTime) {
+  clock_.Advance(kIdleTimeoutMs - 1);
+  deadlines_.RecordActivity(clock_.now());
+  deadlines_.StartRequest(clock_.now());
+  EXPECT_TRUE(deadlines_.is_decoding());
+
+  clock_.Advance(kRequestTimeoutMs - 1);
+  deadlines_.RecordActivity(clock_.now());
+  EXPECT_EQ(Check(), EConnectionDeadline::kNone);
+  deadlines_.EndRequest();
+  EXPECT_FALSE(deadlines_.is_decoding());
+
+  // Now only the idle deadline applies.
+  clock_.Advance(kIdleTimeoutMs - 1);
+  EXPECT_EQ(Check(), EConnectionDeadline::kNone);
+  clock_.Advance(1);
+  EXPECT_EQ(Check(), EConnectionDeadline::kIdle);
+}
+
+TEST_P(ConnectionDeadlinesTest, SlowRequest) {
+  // The client sends a byte every 100ms, which keeps the connection from being
+  // idle, but doesn't complete the request in time.
+  deadlines_.StartRequest(clock_.now());
+  for (uint32_t elapsed = 0; elapsed + 100 < kRequestTimeoutMs;
+       elapsed += 100) {
+    clock_.Advance(100);
+    deadlines_.RecordActivity(clock_.now());
+    // Reading more of the same request doesn't restart the deadline.
+    deadlines_.StartRequest(clock_.now());
+    EXPECT_EQ(Check(), EConnectionDeadline::kNone);
+  }
+  clock_.Advance(100);
+  deadlines_.RecordActivity(clock_.now());
+  EXPECT_EQ(Check(), EConnectionDeadline::kRequest);
+}
+
+TEST_P(ConnectionDeadlinesTest, RequestDeadlineTakesPrecedence) {
+  deadlines_.StartRequest(clock_.now());
+  clock_.Advance(kIdleTimeoutMs + kRequestTimeoutMs);
+  EXPECT_EQ(Check(), EConnectionDeadline::kRequest);
+}
+
+TEST_P(ConnectionDeadlinesTest, ResetForNewConnection) {
+  deadlines_.StartRequest(clock_.now());
+  clock_.Advance(kRequestTimeoutMs);
+  EXPECT_EQ(Check(), EConnectionDeadline::kRequest);
+  deadlines_.RecordExpiration(Check());
+
+  deadlines_.Reset(clock_.now());
+  EXPECT_FALSE(deadlines_.is_decoding());
+  EXPECT_EQ(Check(), EConnectionDeadline::kNone);
+  clock_.Advance(kIdleTimeoutMs);
+  EXPECT_EQ(Check(), EConnectionDeadline::kIdle);
+  deadlines_.RecordExpiration(Check());
+
+  // The counts aren't reset.
+  deadlines_.Reset(clock_.now());
+  EXPECT_EQ(deadlines_.num_idle_timeouts(), 1);
+  EXPECT_EQ(deadlines_.num_request_timeouts(), 1);
+}
+
+TEST_P(ConnectionDeadlinesTest, CountsExpirations) {
+  EXPECT_EQ(deadlines_.num_idle_timeouts(), 0);
+  EXPECT_EQ(deadlines_.num_request_timeouts(), 0);
+  deadlines_.RecordExpiration(EConnectionDeadline::kNone);
+  deadlines_.RecordExpiration(EConnectionDeadline::kIdle);
+  deadlines_.RecordExpiration(EConnectionDeadline::kIdle);
+  deadlines_.RecordExpiration(EConnectionDeadline::kRequest);
+  EXPECT_EQ(deadlines_.num_idle_timeouts(), 2);
+  EXPECT_EQ(deadlines_.num_request_timeouts(), 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(StartTimes, ConnectionDeadlinesTest,
+                         testing::Values(0, 12345, UINT32_MAX - 500));
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
@@ -0,0 +1,256 @@
+#include "connection_scheduler.h"
+
+#include <McuCore.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+TEST(ConnectionSchedulerTest, RotatesStartingConnection) {
+  ConnectionScheduler<4> scheduler(/*budget_micros=*/1000000);
+  uint32_t now = 0;
+  for (int pass = 0; pass < 10; ++pass) {
+    std::vector<uint8_t> order;
+    scheduler.StartPass(now);
+    uint8_t ndx;
+    while (scheduler.NextConnection(now, ndx)) {
+      order.push_back(ndx);
+      now += 10;
+      scheduler.EndService(now);
+    }
+    ASSERT_EQ(order.size(), 4);
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(order[i], (pass + i) % 4);
+    }
+  }
+  for (uint8_t ndx = 0; ndx < 4; ++ndx) {
+    const auto& stats = scheduler.service_stats(ndx);
+    EXPECT_EQ(stats.num_services, 10);
+    EXPECT_EQ(stats.num_deferrals, 0);
+    EXPECT_EQ(stats.total_micros, 100);
+    EXPECT_EQ(stats.max_micros, 10);
+    EXPECT_EQ(stats.mean_micros(), 10);
+  }
+}
+
+TEST(ConnectionSchedulerTest, StopsWhenBudgetUsedUp) {
+  ConnectionScheduler<4> scheduler(/*budget_micros=*/1000);
+  uint32_t now = 0;
+  std::vector<uint8_t> order;
+
+  // Each service takes 600us, so only two connections can be serviced per
+  // pass, and the next pass starts with the first one deferred.
+  for (int pass = 0; pass < 4; ++pass) {
+    scheduler.StartPass(now);
+    uint8_t ndx;
+    int count = 0;
+    while (scheduler.NextConnection(now, ndx)) {
+      order.push_back(ndx);
+      now += 600;
+      scheduler.EndService(now);
+      ++count;
+    }
+    EXPECT_EQ(count, 2);
+    // Further calls don't start servicing again.
+    EXPECT_FALSE(scheduler.NextConnection(now, ndx));
+    now += 100;
+  }
+  EXPECT_EQ(order, std::vector<uint8_t>({0, 1, 2, 3, 0, 1, 2, 3}));
+  for (uint8_t ndx = 0; ndx < 4; ++ndx) {
+    const auto& stats = scheduler.service_stats(ndx);
+    EXPECT_EQ(stats.num_services, 2);
+    EXPECT_EQ(stats.num_deferrals, 2);
+    EXPECT_EQ(stats.max_micros, 600);
+  }
+}
+
+TEST(ConnectionSchedulerTest, AlwaysServicesOneConnection) {
+  ConnectionScheduler<3> scheduler(/*budget_micros=*/0);
+  uint32_t now = 0;
+  std::vector<uint8_t> order;
+  for (int pass = 0; pass < 6; ++pass) {
+    scheduler.StartPass(now);
+    uint8_t ndx;
+    while (scheduler.NextConnection(now, ndx)) {
+      order.push_back(ndx);
+      now += 1;
+      scheduler.EndService(now);
+    }
+  }
+  EXPECT_EQ(order, std::vector<uint8_t>({0, 1, 2, 0, 1, 2}));
+}
+
+TEST(ConnectionSchedulerTest, PrioritizedConnectionsFirst) {
+  ConnectionScheduler<4> scheduler(/*budget_micros=*/1000);
+  uint32_t now = 0;
+  std::vector<uint8_t> order;
+  auto run_pass = [&]() {
+    order.clear();
+    scheduler.StartPass(now);
+    uint8_t ndx;
+    while (scheduler.NextConnection(now, ndx)) {
+      order.push_back(ndx);
+      now += 600;
+      scheduler.EndService(now);
+    }
+  };
+
+  run_pass();
+  EXPECT_EQ(order, std::vector<uint8_t>({0, 1}));
+
+  // Connection 3 is serviced first, and then the rotation continues where it
+  // left off.
+  scheduler.Prioritize(3);
+  run_pass();
+  EXPECT_EQ(order, std::vector<uint8_t>({3, 2}));
+
+  // A prioritized connection is serviced even if it would otherwise be
+  // deferred, and isn't serviced twice in one pass.
+  scheduler.Prioritize(1);
+  scheduler.Prioritize(2);
+  run_pass();
+  EXPECT_EQ(order, std::vector<uint8_t>({1, 2}));
+  EXPECT_EQ(scheduler.service_stats(0).num_deferrals, 2);
+  run_pass();
+  EXPECT_EQ(order, std::vector<uint8_t>({0, 1}));
+  run_pass();
+  EXPECT_EQ(order, std::vector<uint8_t>({2, 3}));
+
+  // With a large enough budget, every connection is serviced once.
+  ConnectionScheduler<4> unlimited(/*budget_micros=*/1000000);
+  unlimited.Prioritize(2);
+  unlimited.StartPass(now);
+  order.clear();
+  uint8_t ndx;
+  while (unlimited.NextConnection(now, ndx)) {
+    order.push_back(ndx);
+    unlimited.EndService(now);
+  }
+  EXPECT_EQ(order, std::vector<uint8_t>({2, 0, 1, 3}));
+  EXPECT_EQ(unlimited.service_stats(2).num_services, 1);
+}
+
+// Simulates a number of clients, each with its own connection, where one
+// client sends a burst of expensive requests while the others occasionally
+// send a cheap request. Servicing a connection handles at most one request,
+// as ServerConnection does. Between passes the loop spends some time in
+// MaintainDevices.
+class ConnectionSchedulerSimulation {
+ public:
+  static constexpr uint8_t kNumClients = 6;
+  static constexpr uint32_t kBudgetMicros = 4000;
+  static constexpr uint32_t kIdleServiceMicros = 20;
+  static constexpr uint32_t kMaintainMicros = 500;
+  static constexpr uint32_t kBurstRequestMicros = 3000;
+  static constexpr uint32_t kBurstRequests = 200;
+  static constexpr uint32_t kOtherRequestMicros = 400;
+  static constexpr int kPassesBetweenOtherRequests = 7;
+
+  ConnectionSchedulerSimulation() : scheduler_(kBudgetMicros) {}
+
+  void Run(int num_passes) {
+    for (uint32_t i = 0; i < kBurstRequests; ++i) {
+      clients_[0].push_back({now_, kBurstRequestMicros});
+    }
+    for (int pass = 0; pass < num_passes; ++pass) {
+      if (pass % kPassesBetweenOtherRequests == 0) {
+        for (uint8_t c = 1; c < kNumClients; ++c) {
+          clients_[c].push_back({now_, kOtherRequestMicros});
+        }
+      }
+      const uint32_t pass_start = now_;
+      scheduler_.StartPass(now_);
+      uint8_t ndx;
+      while (scheduler_.NextConnection(now_, ndx)) {
+        Service(ndx);
+        scheduler_.EndService(now_);
+      }
+      max_pass_micros_ = std::max(max_pass_micros_, now_ - pass_start);
+      now_ += kMaintainMicros;
+      max_maintain_interval_micros_ =
+          std::max(max_maintain_interval_micros_, now_ - last_maintain_end_);
+      last_maintain_end_ = now_;
+    }
+  }
+
+  void Service(uint8_t ndx) {
+    auto& queue = clients_[ndx];
+    if (queue.empty()) {
+      now_ += kIdleServiceMicros;
+      return;
+    }
+    const Request request = queue.front();
+    queue.pop_front();
+    now_ += request.cost;
+    const uint32_t latency = now_ - request.arrival;
+    if (ndx == 0) {
+      ++burst_requests_served_;
+    } else {
+      max_other_latency_micros_ =
+          std::max(max_other_latency_micros_, latency);
+    }
+  }
+
+  struct Request {
+    uint32_t arrival;
+    uint32_t cost;
+  };
+
+  ConnectionScheduler<kNumClients> scheduler_;
+  std::deque<Request> clients_[kNumClients];
+  uint32_t now_ = 0;
+  uint32_t last_maintain_end_ = 0;
+  uint32_t max_pass_micros_ = 0;
+  uint32_t max_maintain_interval_micros_ = 0;
+  uint32_t max_other_latency_micros_ = 0;
+  uint32_t burst_requests_served_ = 0;
+};
+
+TEST(ConnectionSchedulerTest, BurstOnOneConnectionIsFair) {
+  ConnectionSchedulerSimulation sim;
+  sim.Run(500);
+
+  using Sim = ConnectionSchedulerSimulation;
+
+  // The bursting client still gets all of its requests served.
+  EXPECT_EQ(sim.burst_requests_served_, Sim::kBurstRequests);
+
+  // A pass never runs for more than the budget plus the cost of the one
+  // service that was started before the budget was used up.
+  EXPECT_LE(sim.max_pass_micros_,
+            Sim::kBudgetMicros + Sim::kBurstRequestMicros);
+  EXPECT_LE(sim.max_maintain_interval_micros_,
+            Sim::kBudgetMicros + Sim::kBurstRequestMicros +
+                Sim::kMaintainMicros);
+
+  // A request from one of the other clients waits at most one pass longer
+  // than it would without the burst, i.e. it isn't stuck behind the whole
+  // burst.
+  const uint32_t max_pass_with_maintain =
+      Sim::kBudgetMicros + Sim::kBurstRequestMicros + Sim::kMaintainMicros;
+  EXPECT_LE(sim.max_other_latency_micros_, 2 * max_pass_with_maintain);
+
+  // Every connection was serviced, and none was deferred much more often than
+  // the others.
+  uint32_t min_services = UINT32_MAX, max_services = 0;
+  for (uint8_t ndx = 0; ndx < Sim::kNumClients; ++ndx) {
+    const auto& stats = sim.scheduler_.service_stats(ndx);
+    min_services = std::min(min_services, stats.num_services);
+    max_services = std::max(max_services, stats.num_services);
+  }
+  EXPECT_GT(min_services, 0);
+  EXPECT_LE(max_services - min_services, max_services / 10 + 1);
+  EXPECT_EQ(sim.scheduler_.service_stats(0).max_micros,
+            Sim::kBurstRequestMicros);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
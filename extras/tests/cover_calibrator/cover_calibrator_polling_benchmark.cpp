@@ -0,0 +1,106 @@
+// Measures the host CPU time taken to serve Alpaca requests while the cover of
+// the simulated AstroMakers Cover Calibrator is moving back and forth, as
+// happens when a client polls coverstate while waiting for the cover to open or
+// close. This is useful for comparing the cost of the request path before and
+// after a change, but says nothing about the timing on an AVR: the simulated
+// step timer interrupts are delivered between requests, not during them.
+
+#include <stdint.h>
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "extras/tests/cover_calibrator/cover_calibrator_simulator.h"
+#include "mcucore/extras/test_tools/http_request.h"
+
+namespace astro_makers {
+namespace test {
+namespace {
+
+// Starts moving the cover towards the other end if it has stopped. Returns
+// false if the request to do so failed.
+bool KeepCoverMoving(CoverCalibratorSimulator& sim, bool& opening) {
+  if (sim.cover_hardware().timer_running()) {
+    return true;
+  }
+  opening = !opening;
+  return (opening ? sim.OpenCover() : sim.CloseCover()).ok();
+}
+
+// Polls coverstate every state.range(0) microseconds of simulated time, so the
+// work done is the same on each run.
+void BM_PollCoverStateSimulatedTime(benchmark::State& state) {
+  CoverCalibratorSimulator sim;
+  if (!sim.Initialize().ok()) {
+    state.SkipWithError("Initialize failed");
+    return;
+  }
+  const uint64_t poll_micros = state.range(0);
+  bool opening = false;
+  for (auto _ : state) {
+    if (!KeepCoverMoving(sim, opening)) {
+      state.SkipWithError("Moving the cover failed");
+      break;
+    }
+    sim.AdvanceMicros(poll_micros);
+    auto cover_state = sim.GetCoverState();
+    benchmark::DoNotOptimize(cover_state);
+  }
+}
+BENCHMARK(BM_PollCoverStateSimulatedTime)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Polls coverstate as fast as the server can respond, with the simulated time
+// advancing at state.range(0) times the wall clock time. The larger the scale,
+// the more steps are simulated between requests, so the more of the measured
+// time is spent simulating the cover rather than serving requests.
+void BM_PollCoverStateScaledWallTime(benchmark::State& state) {
+  CoverCalibratorSimulator sim;
+  if (!sim.Initialize().ok()) {
+    state.SkipWithError("Initialize failed");
+    return;
+  }
+  sim.set_time_scale(state.range(0));
+  bool opening = false;
+  for (auto _ : state) {
+    if (!KeepCoverMoving(sim, opening)) {
+      state.SkipWithError("Moving the cover failed");
+      break;
+    }
+    sim.AdvanceScaledWallTime();
+    auto cover_state = sim.GetCoverState();
+    benchmark::DoNotOptimize(cover_state);
+  }
+}
+BENCHMARK(BM_PollCoverStateScaledWallTime)->Arg(1)->Arg(10)->Arg(100);
+
+// As above, but alternating between polling coverstate and turning the
+// calibrator on, with a changing brightness, so that PUT requests are also
+// measured.
+void BM_PollAndSetBrightnessWhileMoving(benchmark::State& state) {
+  CoverCalibratorSimulator sim;
+  if (!sim.Initialize().ok()) {
+    state.SkipWithError("Initialize failed");
+    return;
+  }
+  bool opening = false;
+  uint16_t brightness = 0;
+  for (auto _ : state) {
+    if (!KeepCoverMoving(sim, opening)) {
+      state.SkipWithError("Moving the cover failed");
+      break;
+    }
+    sim.AdvanceMicros(1000);
+    auto cover_state = sim.GetCoverState();
+    benchmark::DoNotOptimize(cover_state);
+    auto request = sim.CoverCalibratorRequest("calibratoron");
+    request.method = "PUT";
+    request.SetParameter("Brightness", std::to_string(++brightness));
+    auto status = sim.RoundTripWithValuelessResponse(request);
+    benchmark::DoNotOptimize(status);
+  }
+}
+BENCHMARK(BM_PollAndSetBrightnessWhileMoving);
+
+}  // namespace
+}  // namespace test
+}  // namespace astro_makers
@@ -0,0 +1,225 @@
+#include "extras/tests/cover_calibrator/cover_calibrator_simulator.h"
+
+#include <McuCore.h>
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "device_description.h"
+#include "mcucore/extras/test_tools/http_request.h"
+#include "mcucore/extras/test_tools/json_decoder.h"
+#include "server_description.h"
+#include "util/task/status_macros.h"
+
+MCU_DEFINE_DOMAIN(79);
+MCU_DEFINE_DOMAIN(80);
+
+namespace astro_makers {
+namespace test {
+namespace {
+
+using ::alpaca::DeviceDescription;
+using ::alpaca::ECoverStatus;
+using ::alpaca::EDeviceType;
+using ::mcucore::test::HttpRequest;
+using ::mcucore::test::HttpResponse;
+using ::mcucore::test::JsonValue;
+
+constexpr int kClientId = 3817;
+
+const alpaca::ServerDescription kServerDescription  // NOLINT
+    {
+        .server_name = MCU_FLASHSTR("Simulated Cover Calibrator"),
+        .manufacturer = MCU_FLASHSTR("Us"),
+        .manufacturer_version = MCU_FLASHSTR("0.0.1"),
+        .location = MCU_FLASHSTR("Host"),
+    };
+
+const DeviceDescription kCoverCalibratorDeviceDescription  // NOLINT
+    {
+        .device_type = EDeviceType::kCoverCalibrator,
+        .device_number = 0,
+        .domain = MCU_DOMAIN(79),
+        .name = MCU_FLASHSTR("Cover-Calibrator"),
+        .description = MCU_FLASHSTR("Simulated Cover Calibrator"),
+        .driver_info = MCU_FLASHSTR("CoverCalibratorSimulator"),
+        .driver_version = MCU_FLASHSTR("0.1"),
+        .supported_actions = {},
+    };
+
+const DeviceDescription kLedSwitchesDeviceDescription  // NOLINT
+    {
+        .device_type = EDeviceType::kSwitch,
+        .device_number = 0,
+        .domain = MCU_DOMAIN(80),
+        .name = MCU_FLASHSTR("Cover-Calibrator LED Channel Switches"),
+        .description = MCU_FLASHSTR("Simulated LED Channel Switches"),
+        .driver_info = MCU_FLASHSTR("CoverCalibratorSimulator"),
+        .driver_version = MCU_FLASHSTR("0.1"),
+        .supported_actions = {},
+    };
+
+}  // namespace
+
+CoverCalibratorSimulator::CoverCalibratorSimulator(uint32_t travel_steps)
+    : mock_platform_network_lifetime_(
+          std::make_unique<mcunet::test::MockPlatformNetwork>()),
+      cover_hardware_(travel_steps),
+      cover_calibrator_(server_context_, kCoverCalibratorDeviceDescription,
+                        cover_hardware_, leds_),
+      led_switches_(server_context_, kLedSwitchesDeviceDescription,
+                    cover_calibrator_),
+      devices_{&cover_calibrator_, &led_switches_},
+      server_(server_context_, kServerDescription, devices_),
+      last_wall_time_(std::chrono::steady_clock::now()) {}
+
+CoverCalibratorSimulator::~CoverCalibratorSimulator() {
+  cover_calibrator_.HaltCoverMotion();
+}
+
+absl::Status CoverCalibratorSimulator::Initialize() {
+  mcucore::EepromTlv::ClearAndInitializeEeprom();
+  const auto status = server_context_.Initialize();
+  if (!status.ok()) {
+    return absl::InternalError(
+        absl::StrCat("ServerContext::Initialize failed, code=",
+                     static_cast<int>(status.code())));
+  }
+  server_.ValidateAndReset();
+  server_.InitializeForServing();
+  last_wall_time_ = std::chrono::steady_clock::now();
+  return absl::OkStatus();
+}
+
+HttpRequest CoverCalibratorSimulator::MakeRequest(
+    std::string_view device_type, std::string_view ascom_method) {
+  HttpRequest request(
+      absl::StrCat("/api/v1/", device_type, "/0/", ascom_method));
+  request.SetParameter("ClientID", std::to_string(kClientId));
+  request.SetParameter("ClientTransactionID",
+                       std::to_string(++last_client_transaction_id_));
+  request.AddCommonParts();
+  return request;
+}
+
+HttpRequest CoverCalibratorSimulator::CoverCalibratorRequest(
+    std::string_view ascom_method) {
+  return MakeRequest("covercalibrator", ascom_method);
+}
+
+HttpRequest CoverCalibratorSimulator::LedSwitchesRequest(
+    std::string_view ascom_method) {
+  return MakeRequest("switch", ascom_method);
+}
+
+absl::StatusOr<std::string> CoverCalibratorSimulator::RoundTrip(
+    HttpRequest& request) {
+  if (server_.connection_is_open()) {
+    return absl::InternalError("Connection is still open.");
+  }
+  response_validator_.SetClientTransactionIdFromRequest(request);
+
+  auto result = server_.AnnounceConnect("");
+  if (!result.remaining_input.empty() || result.connection_closed) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("Unexpected response when opening a connection: ",
+                     result.ToDebugString()));
+  }
+  result = server_.AnnounceCanRead(request.ToString(),
+                                   /*repeat_until_stable=*/true);
+  if (!result.remaining_input.empty()) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "Expected all input to be consumed: ", result.ToDebugString()));
+  }
+  if (!result.connection_closed) {
+    server_.AnnounceDisconnect();
+  }
+  return result.output;
+}
+
+absl::StatusOr<JsonValue> CoverCalibratorSimulator::RoundTripWithValueResponse(
+    HttpRequest& request) {
+  ASSIGN_OR_RETURN(auto response_message, RoundTrip(request));
+  return response_validator_.ValidateValueResponse(response_message);
+}
+
+absl::Status CoverCalibratorSimulator::RoundTripWithValuelessResponse(
+    HttpRequest& request) {
+  ASSIGN_OR_RETURN(auto response_message, RoundTrip(request));
+  return response_validator_.ValidateValuelessResponse(response_message)
+      .status();
+}
+
+absl::StatusOr<HttpResponse>
+CoverCalibratorSimulator::RoundTripWithErrorResponse(
+    HttpRequest& request, int expected_error_number) {
+  ASSIGN_OR_RETURN(auto response_message, RoundTrip(request));
+  return response_validator_.ValidateJsonResponseHasError(
+      response_message, expected_error_number);
+}
+
+absl::StatusOr<ECoverStatus> CoverCalibratorSimulator::GetCoverState() {
+  auto request = CoverCalibratorRequest("coverstate");
+  ASSIGN_OR_RETURN(auto value, RoundTripWithValueResponse(request));
+  if (value.type() != JsonValue::kInteger) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Expected an integer: ", value.ToDebugString()));
+  }
+  return static_cast<ECoverStatus>(value.as_integer());
+}
+
+absl::Status CoverCalibratorSimulator::OpenCover() {
+  auto request = CoverCalibratorRequest("opencover");
+  request.method = "PUT";
+  return RoundTripWithValuelessResponse(request);
+}
+
+absl::Status CoverCalibratorSimulator::CloseCover() {
+  auto request = CoverCalibratorRequest("closecover");
+  request.method = "PUT";
+  return RoundTripWithValuelessResponse(request);
+}
+
+absl::Status CoverCalibratorSimulator::HaltCover() {
+  auto request = CoverCalibratorRequest("haltcover");
+  request.method = "PUT";
+  return RoundTripWithValuelessResponse(request);
+}
+
+void CoverCalibratorSimulator::AdvanceMicros(uint64_t micros) {
+  cover_hardware_.AdvanceMicros(micros);
+  server_.MaintainDevices();
+}
+
+void CoverCalibratorSimulator::AdvanceScaledWallTime() {
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsed_micros =
+      std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                            last_wall_time_)
+          .count();
+  last_wall_time_ = now;
+  AdvanceMicros(static_cast<uint64_t>(elapsed_micros * time_scale_));
+}
+
+void CoverCalibratorSimulator::set_time_scale(double time_scale) {
+  MCU_CHECK_GT(time_scale, 0);
+  time_scale_ = time_scale;
+  last_wall_time_ = std::chrono::steady_clock::now();
+}
+
+uint64_t CoverCalibratorSimulator::RunUntilCoverStops(uint64_t step_micros,
+                                                      uint64_t max_micros) {
+  uint64_t elapsed_micros = 0;
+  while (cover_hardware_.timer_running() && elapsed_micros < max_micros) {
+    AdvanceMicros(step_micros);
+    elapsed_micros += step_micros;
+  }
+  return elapsed_micros;
+}
+
+}  // namespace test
+}  // namespace astro_makers
@@ -0,0 +1,127 @@
+#ifndef TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_COVER_CALIBRATOR_SIMULATOR_H_
+#define TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_COVER_CALIBRATOR_SIMULATOR_H_
+
+// Runs the devices of the AstroMakers Cover Calibrator (i.e. CoverCalibrator
+// and LedChannelSwitchGroup) on a host, with simulated hardware, served by a
+// TestTinyAlpacaServer. Tests and benchmarks send Alpaca requests to the server
+// while advancing the simulated time, during which the cover moves as it would
+// on the real hardware. Handling a request takes no simulated time, and the
+// step timer interrupts are only delivered between requests, so the simulation
+// can't show whether handling requests delays the steps of the motor.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+#include <McuNet.h>
+#include <stdint.h>
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <string_view>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "device_interface.h"
+#include "examples/CoverCalibrator/src/cover_calibrator.h"
+#include "examples/CoverCalibrator/src/led_channel_switch_group.h"
+#include "extras/test_tools/alpaca_response_validator.h"
+#include "extras/test_tools/test_tiny_alpaca_server.h"
+#include "extras/tests/cover_calibrator/simulated_calibrator_leds.h"
+#include "extras/tests/cover_calibrator/simulated_cover_hardware.h"
+#include "mcucore/extras/test_tools/http_request.h"
+#include "mcucore/extras/test_tools/http_response.h"
+#include "mcucore/extras/test_tools/json_decoder.h"
+#include "mcunet/extras/test_tools/mock_platform_network.h"
+#include "server_context.h"
+
+namespace astro_makers {
+namespace test {
+
+class CoverCalibratorSimulator {
+ public:
+  // Far enough that the cover reaches full speed when moving.
+  static constexpr uint32_t kDefaultTravelSteps = 40000;
+
+  explicit CoverCalibratorSimulator(
+      uint32_t travel_steps = kDefaultTravelSteps);
+
+  // Stops any movement of the cover, so that the step timer isn't left
+  // pointing at this instance.
+  ~CoverCalibratorSimulator();
+
+  // Clears the EEPROM, then initializes the server and the devices. Call after
+  // modifying the simulated hardware (e.g. removing a jumper), as the real
+  // server would be reset after doing so.
+  absl::Status Initialize();
+
+  // Create requests for the CoverCalibrator and for the LedChannelSwitchGroup
+  // (i.e. Switch device 0), with the standard parameters. Use PUT by setting
+  // the method field of the returned request.
+  mcucore::test::HttpRequest CoverCalibratorRequest(
+      std::string_view ascom_method);
+  mcucore::test::HttpRequest LedSwitchesRequest(std::string_view ascom_method);
+
+  // Connects to the server, sends the request, then disconnects. Returns all of
+  // the output, or an error if the server didn't read the whole request.
+  absl::StatusOr<std::string> RoundTrip(mcucore::test::HttpRequest& request);
+
+  // As above, and validates that the response is an Alpaca response with a
+  // Value (if so, returns the Value), without a Value, or with an error.
+  absl::StatusOr<mcucore::test::JsonValue> RoundTripWithValueResponse(
+      mcucore::test::HttpRequest& request);
+  absl::Status RoundTripWithValuelessResponse(
+      mcucore::test::HttpRequest& request);
+  absl::StatusOr<mcucore::test::HttpResponse> RoundTripWithErrorResponse(
+      mcucore::test::HttpRequest& request, int expected_error_number);
+
+  // Shorthand for GET coverstate, and PUT opencover, closecover or haltcover.
+  absl::StatusOr<alpaca::ECoverStatus> GetCoverState();
+  absl::Status OpenCover();
+  absl::Status CloseCover();
+  absl::Status HaltCover();
+
+  // Advances the simulated time by the specified amount, during which the step
+  // timer interrupts are delivered, then calls MaintainDevices, as the loop
+  // function of the sketch would.
+  void AdvanceMicros(uint64_t micros);
+
+  // Advances the simulated time by time_scale times the wall clock time since
+  // the last call to this method (or to Initialize or set_time_scale). This
+  // allows the simulation to run at a multiple of real time, such as when
+  // measuring how the server performs while the cover is moving.
+  void AdvanceScaledWallTime();
+  void set_time_scale(double time_scale);
+
+  // Advances the simulated time, in increments of step_micros, until the cover
+  // isn't moving or max_micros have passed. Returns the simulated time that
+  // passed. Doesn't send any requests.
+  uint64_t RunUntilCoverStops(uint64_t step_micros, uint64_t max_micros);
+
+  SimulatedCoverHardware& cover_hardware() { return cover_hardware_; }
+  SimulatedCalibratorLeds& leds() { return leds_; }
+  alpaca::test::TestTinyAlpacaServer& server() { return server_; }
+
+ private:
+  mcucore::test::HttpRequest MakeRequest(std::string_view device_type,
+                                         std::string_view ascom_method);
+
+  mcunet::PlatformNetworkLifetime<mcunet::test::MockPlatformNetwork>
+      mock_platform_network_lifetime_;
+  alpaca::ServerContext server_context_;
+  SimulatedCoverHardware cover_hardware_;
+  SimulatedCalibratorLeds leds_;
+  CoverCalibrator cover_calibrator_;
+  LedChannelSwitchGroup led_switches_;
+  alpaca::DeviceInterface* devices_[2];
+  alpaca::test::TestTinyAlpacaServer server_;
+  alpaca::test::AlpacaResponseValidator response_validator_;
+  uint32_t last_client_transaction_id_ = 0;
+
+  double time_scale_ = 1;
+  std::chrono::steady_clock::time_point last_wall_time_;
+};
+
+}  // namespace test
+}  // namespace astro_makers
+
+#endif  // TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_COVER_CALIBRATOR_SIMULATOR_H_
@@ -0,0 +1,274 @@
+// End-to-end tests of the AstroMakers Cover Calibrator, i.e. of the
+// CoverCalibrator and LedChannelSwitchGroup devices with simulated hardware,
+// driven by Alpaca requests to a TestTinyAlpacaServer.
+
+#include "extras/tests/cover_calibrator/cover_calibrator_simulator.h"
+
+#include <McuCore.h>
+#include <stdint.h>
+
+#include "ascom_error_codes.h"
+#include "examples/CoverCalibrator/src/constants.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/json_decoder.h"
+
+namespace astro_makers {
+namespace test {
+namespace {
+
+using ::alpaca::ECoverStatus;
+using ::alpaca::ErrorCodes;
+using ::testing::status::IsOkAndHolds;
+
+// Number of timer ticks between steps when the cover is moving at full speed.
+constexpr uint64_t kCruiseInterval =
+    SimulatedCoverHardware::kTicksPerSecond / kStepsPerSecond;
+
+// Far more than enough time to move the cover from one end to the other.
+constexpr uint64_t kMaxMoveMicros = 20 * 1000 * 1000;
+
+// Advances the simulated time, in increments of poll_micros, polling the cover
+// state after each increment, until the state isn't kMoving. Returns the final
+// state.
+ECoverStatus PollUntilNotMoving(CoverCalibratorSimulator& sim,
+                                uint64_t poll_micros) {
+  ECoverStatus state = ECoverStatus::kMoving;
+  for (uint64_t elapsed = 0; elapsed < kMaxMoveMicros; elapsed += poll_micros) {
+    sim.AdvanceMicros(poll_micros);
+    auto status_or_state = sim.GetCoverState();
+    EXPECT_TRUE(status_or_state.ok()) << status_or_state.status();
+    if (!status_or_state.ok()) {
+      return ECoverStatus::kError;
+    }
+    state = status_or_state.value();
+    if (state != ECoverStatus::kMoving) {
+      break;
+    }
+  }
+  return state;
+}
+
+class CoverCalibratorSimulatorTest : public testing::Test {
+ protected:
+  void SetUp() override { ASSERT_OK(sim_.Initialize()); }
+
+  SimulatedCoverHardware& hw() { return sim_.cover_hardware(); }
+
+  // The position of the carriage when the open limit switch is closed.
+  int32_t open_position() { return static_cast<int32_t>(hw().travel_steps()); }
+
+  CoverCalibratorSimulator sim_;
+};
+
+TEST_F(CoverCalibratorSimulatorTest, OpensAndClosesWhilePolled) {
+  ASSERT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kClosed));
+  EXPECT_FALSE(hw().motor_enabled());
+
+  ASSERT_OK(sim_.OpenCover());
+  EXPECT_TRUE(hw().motor_enabled());
+  EXPECT_TRUE(hw().timer_running());
+  EXPECT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kMoving));
+
+  EXPECT_EQ(PollUntilNotMoving(sim_, 1000), ECoverStatus::kOpen);
+  EXPECT_EQ(hw().position(), open_position());
+  EXPECT_EQ(hw().steps_moved(), hw().travel_steps());
+  EXPECT_EQ(hw().steps_lost(), 0);
+  EXPECT_FALSE(hw().motor_enabled());
+  EXPECT_FALSE(hw().timer_running());
+
+  // The motor never exceeds the maximum speed, allowing for rounding.
+  EXPECT_GE(hw().min_step_interval(), kCruiseInterval - 1);
+
+  hw().ResetStepStats();
+  ASSERT_OK(sim_.CloseCover());
+  EXPECT_EQ(PollUntilNotMoving(sim_, 1000), ECoverStatus::kClosed);
+  EXPECT_EQ(hw().position(), 0);
+  EXPECT_EQ(hw().steps_moved(), hw().travel_steps());
+  EXPECT_EQ(hw().steps_lost(), 0);
+  EXPECT_FALSE(hw().motor_enabled());
+}
+
+TEST_F(CoverCalibratorSimulatorTest, OpeningWhenOpenDoesNotMove) {
+  hw().set_position(open_position());
+  ASSERT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kOpen));
+  ASSERT_OK(sim_.OpenCover());
+  EXPECT_FALSE(hw().timer_running());
+  EXPECT_FALSE(hw().motor_enabled());
+  EXPECT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kOpen));
+}
+
+TEST_F(CoverCalibratorSimulatorTest, DeceleratesOnceTravelIsKnown) {
+  // The first movement from one limit switch to the other runs at full speed
+  // into the limit switch, as the length of the travel isn't yet known.
+  ASSERT_OK(sim_.OpenCover());
+  EXPECT_LT(sim_.RunUntilCoverStops(1000, kMaxMoveMicros), kMaxMoveMicros);
+  ASSERT_EQ(hw().position(), open_position());
+  EXPECT_LE(hw().last_step_interval(), kCruiseInterval + 1);
+
+  // Having learned the length of the travel, the cover slows down before
+  // reaching the other limit switch.
+  ASSERT_OK(sim_.CloseCover());
+  EXPECT_LT(sim_.RunUntilCoverStops(1000, kMaxMoveMicros), kMaxMoveMicros);
+  ASSERT_EQ(hw().position(), 0);
+  EXPECT_GT(hw().last_step_interval(), 4 * kCruiseInterval);
+  EXPECT_GE(hw().min_step_interval(), kCruiseInterval - 1);
+}
+
+TEST_F(CoverCalibratorSimulatorTest, HaltStopsTheCover) {
+  ASSERT_OK(sim_.OpenCover());
+  sim_.AdvanceMicros(1000 * 1000);
+  ASSERT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kMoving));
+
+  ASSERT_OK(sim_.HaltCover());
+  EXPECT_FALSE(hw().motor_enabled());
+  EXPECT_FALSE(hw().timer_running());
+  EXPECT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kUnknown));
+
+  const auto position = hw().position();
+  EXPECT_GT(position, 0);
+  EXPECT_LT(position, open_position());
+  sim_.AdvanceMicros(1000 * 1000);
+  EXPECT_EQ(hw().position(), position);
+  EXPECT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kUnknown));
+
+  // It can then be moved again.
+  ASSERT_OK(sim_.CloseCover());
+  EXPECT_EQ(PollUntilNotMoving(sim_, 1000), ECoverStatus::kClosed);
+  EXPECT_EQ(hw().position(), 0);
+}
+
+TEST_F(CoverCalibratorSimulatorTest, DeceleratesBeforeReversing) {
+  ASSERT_OK(sim_.OpenCover());
+  sim_.AdvanceMicros(1000 * 1000);
+  ASSERT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kMoving));
+  ASSERT_LE(hw().last_step_interval(), kCruiseInterval + 1);
+  const auto position = hw().position();
+
+  // Asked to close, the cover continues opening while slowing down.
+  ASSERT_OK(sim_.CloseCover());
+  EXPECT_TRUE(hw().motor_enabled());
+  EXPECT_TRUE(hw().timer_running());
+  sim_.AdvanceMicros(10 * 1000);
+  EXPECT_GT(hw().position(), position);
+  EXPECT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kMoving));
+
+  // It then reverses, and having started at the closed limit switch, slows
+  // down before reaching it again.
+  EXPECT_EQ(PollUntilNotMoving(sim_, 1000), ECoverStatus::kClosed);
+  EXPECT_EQ(hw().position(), 0);
+  EXPECT_EQ(hw().steps_lost(), 0);
+  EXPECT_GT(hw().last_step_interval(), 4 * kCruiseInterval);
+  EXPECT_FALSE(hw().motor_enabled());
+  EXPECT_FALSE(hw().timer_running());
+}
+
+TEST_F(CoverCalibratorSimulatorTest, StalledMotorFailsToStart) {
+  hw().set_stalled(true);
+  ASSERT_OK(sim_.OpenCover());
+  EXPECT_LT(sim_.RunUntilCoverStops(1000, kMaxMoveMicros), kMaxMoveMicros);
+
+  // The cover gave up once it had taken kMaximumStartSteps without leaving the
+  // closed limit switch.
+  EXPECT_EQ(hw().position(), 0);
+  EXPECT_EQ(hw().steps_moved(), 0);
+  EXPECT_EQ(hw().steps_lost(), kMaximumStartSteps);
+  EXPECT_FALSE(hw().motor_enabled());
+  EXPECT_THAT(sim_.GetCoverState(), IsOkAndHolds(ECoverStatus::kClosed));
+
+  hw().set_stalled(false);
+  ASSERT_OK(sim_.OpenCover());
+  EXPECT_EQ(PollUntilNotMoving(sim_, 1000), ECoverStatus::kOpen);
+}
+
+TEST_F(CoverCalibratorSimulatorTest, CalibratorSetsLedPulseCounts) {
+  auto& leds = sim_.leds();
+  EXPECT_EQ(leds.initialize_count(), 1);
+
+  auto request = sim_.CoverCalibratorRequest("calibratoron");
+  request.method = "PUT";
+  request.SetParameter("Brightness", "1234");
+  ASSERT_OK(sim_.RoundTripWithValuelessResponse(request));
+  for (uint8_t channel = 0; channel < CalibratorLeds::kNumChannels; ++channel) {
+    EXPECT_EQ(leds.pulse_count(channel), 1234) << "channel=" << channel + 0;
+  }
+
+  request = sim_.CoverCalibratorRequest("brightness");
+  EXPECT_THAT(sim_.RoundTripWithValueResponse(request), IsOkAndHolds(1234));
+
+  request = sim_.CoverCalibratorRequest("calibratoroff");
+  request.method = "PUT";
+  ASSERT_OK(sim_.RoundTripWithValuelessResponse(request));
+  for (uint8_t channel = 0; channel < CalibratorLeds::kNumChannels; ++channel) {
+    EXPECT_EQ(leds.pulse_count(channel), 0) << "channel=" << channel + 0;
+  }
+}
+
+TEST_F(CoverCalibratorSimulatorTest, LedSwitchesDisableChannels) {
+  auto request = sim_.LedSwitchesRequest("setswitch");
+  request.method = "PUT";
+  request.SetParameter("Id", "1");
+  request.SetParameter("State", "false");
+  ASSERT_OK(sim_.RoundTripWithValuelessResponse(request));
+
+  request = sim_.CoverCalibratorRequest("calibratoron");
+  request.method = "PUT";
+  request.SetParameter("Brightness", "100");
+  ASSERT_OK(sim_.RoundTripWithValuelessResponse(request));
+
+  EXPECT_EQ(sim_.leds().pulse_count(0), 100);
+  EXPECT_EQ(sim_.leds().pulse_count(1), 0);
+  EXPECT_EQ(sim_.leds().pulse_count(2), 100);
+  EXPECT_EQ(sim_.leds().pulse_count(3), 100);
+}
+
+TEST(CoverCalibratorSimulatorHardwareTest, StopsAfterAllowedSteps) {
+  // If the limit switch isn't reached (e.g. because it is broken, or because
+  // the cover is much longer than expected), the motor stops after taking
+  // kMaximumSteps, rather than running indefinitely.
+  CoverCalibratorSimulator sim(kMaximumSteps + 1000);
+  ASSERT_OK(sim.Initialize());
+  ASSERT_OK(sim.OpenCover());
+  EXPECT_LT(sim.RunUntilCoverStops(10 * 1000, kMaxMoveMicros), kMaxMoveMicros);
+  EXPECT_EQ(sim.cover_hardware().position(), kMaximumSteps);
+  EXPECT_FALSE(sim.cover_hardware().motor_enabled());
+  EXPECT_THAT(sim.GetCoverState(), IsOkAndHolds(ECoverStatus::kUnknown));
+}
+
+TEST(CoverCalibratorSimulatorHardwareTest, MissingLedChannelIsNotLit) {
+  CoverCalibratorSimulator sim;
+  sim.leds().set_channel_present(2, false);
+  ASSERT_OK(sim.Initialize());
+
+  auto request = sim.LedSwitchesRequest("getswitch");
+  request.SetParameter("Id", "2");
+  EXPECT_THAT(sim.RoundTripWithValueResponse(request), IsOkAndHolds(false));
+
+  request = sim.CoverCalibratorRequest("calibratoron");
+  request.method = "PUT";
+  request.SetParameter("Brightness", "1000");
+  ASSERT_OK(sim.RoundTripWithValuelessResponse(request));
+  EXPECT_EQ(sim.leds().pulse_count(0), 1000);
+  EXPECT_EQ(sim.leds().pulse_count(1), 1000);
+  EXPECT_EQ(sim.leds().pulse_count(2), 0);
+  EXPECT_EQ(sim.leds().pulse_count(3), 1000);
+}
+
+TEST(CoverCalibratorSimulatorHardwareTest, MissingCoverIsNotImplemented) {
+  CoverCalibratorSimulator sim;
+  sim.cover_hardware().set_present(false);
+  ASSERT_OK(sim.Initialize());
+
+  EXPECT_THAT(sim.GetCoverState(), IsOkAndHolds(ECoverStatus::kNotPresent));
+
+  auto request = sim.CoverCalibratorRequest("opencover");
+  request.method = "PUT";
+  EXPECT_OK(
+      sim.RoundTripWithErrorResponse(request, ErrorCodes::kNotImplemented));
+  EXPECT_FALSE(sim.cover_hardware().motor_enabled());
+  EXPECT_FALSE(sim.cover_hardware().timer_running());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace astro_makers
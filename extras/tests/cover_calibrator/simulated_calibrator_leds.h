@@ -0,0 +1,58 @@
+#ifndef TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_SIMULATED_CALIBRATOR_LEDS_H_
+#define TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_SIMULATED_CALIBRATOR_LEDS_H_
+
+// Simulates the LED driver of the AstroMakers Cover Calibrator, recording the
+// PWM pulse count (i.e. the brightness) of each channel so that tests can check
+// the effect of requests on the LEDs.
+//
+// Author: james.synge@gmail.com
+
+#include <stdint.h>
+
+#include "examples/CoverCalibrator/src/calibrator_leds.h"
+
+namespace astro_makers {
+namespace test {
+
+class SimulatedCalibratorLeds : public CalibratorLeds {
+ public:
+  void Initialize() override {
+    for (uint8_t channel = 0; channel < kNumChannels; ++channel) {
+      pulse_counts_[channel] = 0;
+    }
+    ++initialize_count_;
+  }
+
+  bool IsChannelPresent(uint8_t channel) const override {
+    return channel < kNumChannels && present_[channel];
+  }
+
+  void SetPulseCount(uint8_t channel, uint16_t pulse_count) override {
+    if (channel < kNumChannels) {
+      pulse_counts_[channel] = pulse_count;
+    }
+  }
+
+  // Simulates installing or removing the jumper of a channel.
+  void set_channel_present(uint8_t channel, bool present) {
+    if (channel < kNumChannels) {
+      present_[channel] = present;
+    }
+  }
+
+  uint16_t pulse_count(uint8_t channel) const {
+    return channel < kNumChannels ? pulse_counts_[channel] : 0;
+  }
+
+  int initialize_count() const { return initialize_count_; }
+
+ private:
+  bool present_[kNumChannels] = {true, true, true, true};
+  uint16_t pulse_counts_[kNumChannels] = {};
+  int initialize_count_ = 0;
+};
+
+}  // namespace test
+}  // namespace astro_makers
+
+#endif  // TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_SIMULATED_CALIBRATOR_LEDS_H_
@@ -0,0 +1,98 @@
+#include "extras/tests/cover_calibrator/simulated_cover_hardware.h"
+
+#include <McuCore.h>
+
+#include "examples/CoverCalibrator/src/cover.h"
+
+namespace astro_makers {
+namespace test {
+
+SimulatedCoverHardware::SimulatedCoverHardware(uint32_t travel_steps)
+    : travel_steps_(travel_steps) {
+  MCU_CHECK_GT(travel_steps, 0);
+}
+
+void SimulatedCoverHardware::ResetHardware() { DisableMotor(); }
+
+void SimulatedCoverHardware::InitializeHardware() {
+  StopTimer();
+  DisableMotor();
+}
+
+bool SimulatedCoverHardware::IsOpenLimitClosed() const {
+  return position_ >= static_cast<int32_t>(travel_steps_);
+}
+
+bool SimulatedCoverHardware::IsClosedLimitClosed() const {
+  return position_ <= 0;
+}
+
+void SimulatedCoverHardware::Step() {
+  if (have_last_step_) {
+    last_step_interval_ = now_ticks_ - last_step_ticks_;
+    if (min_step_interval_ == 0 || last_step_interval_ < min_step_interval_) {
+      min_step_interval_ = last_step_interval_;
+    }
+  }
+  have_last_step_ = true;
+  last_step_ticks_ = now_ticks_;
+
+  const int32_t new_position = position_ + (direction_open_ ? 1 : -1);
+  if (!motor_enabled_ || stalled_ || new_position < -kOvertravelSteps ||
+      new_position > static_cast<int32_t>(travel_steps_) + kOvertravelSteps) {
+    ++steps_lost_;
+    return;
+  }
+  position_ = new_position;
+  ++steps_moved_;
+}
+
+bool SimulatedCoverHardware::IsAtLimit() {
+  return direction_open_ ? IsOpenLimitClosed() : IsClosedLimitClosed();
+}
+
+void SimulatedCoverHardware::StartTimer(uint16_t ticks) {
+  MCU_CHECK_GT(ticks, 0);
+  interval_ticks_ = ticks;
+  next_interrupt_ticks_ = now_ticks_ + ticks;
+  timer_running_ = true;
+  have_last_step_ = false;
+}
+
+void SimulatedCoverHardware::SetTimerInterval(uint16_t ticks) {
+  MCU_CHECK_GT(ticks, 0);
+  interval_ticks_ = ticks;
+}
+
+void SimulatedCoverHardware::StopTimer() { timer_running_ = false; }
+
+void SimulatedCoverHardware::AdvanceTicks(uint64_t ticks) {
+  const uint64_t end_ticks = now_ticks_ + ticks;
+  while (timer_running_ && next_interrupt_ticks_ <= end_ticks) {
+    now_ticks_ = next_interrupt_ticks_;
+    if (!HandleCoverInterrupt()) {
+      // Matches the ISR, which resets the timer if there is no Cover moving.
+      StopTimer();
+    } else if (timer_running_ && next_interrupt_ticks_ == now_ticks_) {
+      // In CTC mode the next interrupt occurs interval_ticks_ after this one,
+      // where the interval may have just been changed by SetTimerInterval.
+      next_interrupt_ticks_ += interval_ticks_;
+    }
+  }
+  now_ticks_ = end_ticks;
+}
+
+void SimulatedCoverHardware::AdvanceMicros(uint64_t micros) {
+  AdvanceTicks(micros * (kTicksPerSecond / 1000000));
+}
+
+void SimulatedCoverHardware::ResetStepStats() {
+  steps_moved_ = 0;
+  steps_lost_ = 0;
+  have_last_step_ = false;
+  min_step_interval_ = 0;
+  last_step_interval_ = 0;
+}
+
+}  // namespace test
+}  // namespace astro_makers
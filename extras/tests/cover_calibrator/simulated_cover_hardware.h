@@ -0,0 +1,122 @@
+#ifndef TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_SIMULATED_COVER_HARDWARE_H_
+#define TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_SIMULATED_COVER_HARDWARE_H_
+
+// Simulates the hardware used to move the cover of the AstroMakers Cover
+// Calibrator: the stepper motor driver (enable, step and direction pins), the
+// carriage which the motor moves, the limit switches at each end of the travel
+// of the carriage, and the timer used to time the steps.
+//
+// Time is simulated: it only advances when AdvanceTicks is called, during which
+// the "interrupts" of the step timer are delivered by calling
+// HandleCoverInterrupt, just as the ISR of Timer/Counter 5 does on the
+// ATmega2560. This makes tests deterministic, and allows them to run much
+// faster than real time.
+//
+// Author: james.synge@gmail.com
+
+#include <stdint.h>
+
+#include "examples/CoverCalibrator/src/cover_hardware.h"
+
+namespace astro_makers {
+namespace test {
+
+class SimulatedCoverHardware : public CoverHardware {
+ public:
+  // The rate of Timer/Counter 5 on a 16MHz ATmega2560, with the clock divided
+  // by 8.
+  static constexpr uint32_t kTicksPerSecond = 2000000;
+
+  // The number of steps which the carriage can move beyond each limit switch
+  // before it reaches a mechanical stop, after which step pulses don't move it.
+  static constexpr int32_t kOvertravelSteps = 200;
+
+  // The carriage starts at position 0, where the closed limit switch is closed;
+  // the open limit switch is closed when the carriage is at travel_steps.
+  explicit SimulatedCoverHardware(uint32_t travel_steps);
+
+  // CoverHardware methods.
+  bool IsPresent() const override { return present_; }
+  void ResetHardware() override;
+  void InitializeHardware() override;
+  uint32_t TimerTicksPerSecond() const override { return kTicksPerSecond; }
+  void EnableMotor() override { motor_enabled_ = true; }
+  void DisableMotor() override { motor_enabled_ = false; }
+  void SetDirection(bool open) override { direction_open_ = open; }
+  bool IsOpenLimitClosed() const override;
+  bool IsClosedLimitClosed() const override;
+
+  // alpaca::StepperHardware methods.
+  void Step() override;
+  bool IsAtLimit() override;
+  void StartTimer(uint16_t ticks) override;
+  void SetTimerInterval(uint16_t ticks) override;
+  void StopTimer() override;
+
+  // Advances the simulated time by the specified number of timer ticks,
+  // delivering any timer interrupts which are due during that time.
+  void AdvanceTicks(uint64_t ticks);
+
+  // As above, with the time specified in microseconds.
+  void AdvanceMicros(uint64_t micros);
+
+  // Clears the step statistics (i.e. those below, other than position).
+  void ResetStepStats();
+
+  // Modifies the hardware, e.g. to simulate a missing jumper or a motor that
+  // can't start moving the cover.
+  void set_present(bool present) { present_ = present; }
+  void set_stalled(bool stalled) { stalled_ = stalled; }
+  void set_position(int32_t position) { position_ = position; }
+
+  uint64_t now_ticks() const { return now_ticks_; }
+  uint32_t travel_steps() const { return travel_steps_; }
+  int32_t position() const { return position_; }
+  bool motor_enabled() const { return motor_enabled_; }
+  bool timer_running() const { return timer_running_; }
+
+  // The number of step pulses which moved the carriage.
+  uint32_t steps_moved() const { return steps_moved_; }
+
+  // The number of step pulses which didn't move the carriage, e.g. because the
+  // motor was disabled or stalled, or the carriage was at a mechanical stop.
+  uint32_t steps_lost() const { return steps_lost_; }
+
+  // The shortest and the most recent interval between consecutive steps, in
+  // timer ticks, or zero if there haven't been two steps since the timer was
+  // last started.
+  uint64_t min_step_interval() const { return min_step_interval_; }
+  uint64_t last_step_interval() const { return last_step_interval_; }
+
+  // The time of the most recent step pulse.
+  uint64_t last_step_ticks() const { return last_step_ticks_; }
+
+ private:
+  const uint32_t travel_steps_;
+  bool present_ = true;
+  bool stalled_ = false;
+
+  // State of the stepper driver and of the carriage.
+  bool motor_enabled_ = false;
+  bool direction_open_ = false;
+  int32_t position_ = 0;
+
+  // State of the emulated timer.
+  uint64_t now_ticks_ = 0;
+  uint64_t next_interrupt_ticks_ = 0;
+  uint16_t interval_ticks_ = 0;
+  bool timer_running_ = false;
+
+  // Step statistics.
+  uint32_t steps_moved_ = 0;
+  uint32_t steps_lost_ = 0;
+  bool have_last_step_ = false;
+  uint64_t last_step_ticks_ = 0;
+  uint64_t min_step_interval_ = 0;
+  uint64_t last_step_interval_ = 0;
+};
+
+}  // namespace test
+}  // namespace astro_makers
+
+#endif  // TINY_ALPACA_SERVER_EXTRAS_TESTS_COVER_CALIBRATOR_SIMULATED_COVER_HARDWARE_H_
@@ -6,10 +6,15 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "ascom_error_codes.h"
+#include "config.h"
 #include "constants.h"
 #include "device_description.h"
 #include "device_interface.h"
+#include "eeprom_ids.h"
 #include "extras/test_tools/decode_and_dispatch_test_base.h"
 #include "extras/test_tools/mock_observing_conditions.h"
 #include "extras/test_tools/test_tiny_alpaca_server.h"
@@ -20,6 +25,7 @@
 #include "mcucore/extras/test_tools/http_response.h"
 #include "mcucore/extras/test_tools/json_decoder.h"
 #include "mcucore/extras/test_tools/uuid_utils.h"
+#include "utils/fixed_point.h"
 
 MCU_DEFINE_NAMED_DOMAIN(FakeDevice, 123);
 
@@ -34,6 +40,7 @@ using ::mcucore::test::JsonValue;
 using ::mcucore::test::JsonValueIsUuid;
 using ::testing::ContainsRegex;
 using ::testing::HasSubstr;
+using ::testing::MatchesRegex;
 using ::testing::Pair;
 using ::testing::Return;
 using ::testing::SizeIs;
@@ -206,6 +213,34 @@ TEST_F(ObservingConditionsAdapterTest, Method_Name) {
   EXPECT_EQ(value_jv, DEVICE_NAME);
 }
 
+#if TAS_ENABLE_SETTINGS_JOURNAL
+TEST_F(ObservingConditionsAdapterTest, Method_Name_SetByUser) {
+  ASSERT_TRUE(server_context_.settings().Set(
+      {.domain = MCU_DOMAIN(FakeDevice), .id = kDeviceNameId},
+      mcucore::StringView("Backyard Weather")));
+
+  auto request = GenerateDeviceApiRequest("name");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  EXPECT_EQ(value_jv, "Backyard Weather");
+
+  HttpRequest configured_devices("/management/v1/configureddevices");
+  ASSERT_OK_AND_ASSIGN(value_jv, RoundTripSoleRequestWithValueResponse(
+                                     configured_devices));
+  ASSERT_THAT(value_jv, SizeIs(1));
+  EXPECT_EQ(value_jv.GetElement(0).GetValue("DeviceName"),
+            "Backyard Weather");
+
+  // Removing the setting restores the name in the DeviceDescription.
+  ASSERT_TRUE(server_context_.settings().Set(
+      {.domain = MCU_DOMAIN(FakeDevice), .id = kDeviceNameId},
+      mcucore::StringView()));
+  ASSERT_OK_AND_ASSIGN(value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  EXPECT_EQ(value_jv, DEVICE_NAME);
+}
+#endif  // TAS_ENABLE_SETTINGS_JOURNAL
+
 TEST_F(ObservingConditionsAdapterTest, Method_SupportedActions) {
   // If the client requests the connection to be kept alive, but also closes the
   // connection for writing, that should result in the connection being closed
@@ -260,6 +295,17 @@ TEST_F(ObservingConditionsAdapterTest, Method_Set_AveragePeriod) {
   EXPECT_FALSE(server_->connection_is_open());
 }
 
+TEST_F(ObservingConditionsAdapterTest, Method_DeviceState) {
+  // None of the DeviceState properties has a default implementation (the
+  // default AveragePeriod is not one of them), so the array is empty.
+  auto request = GenerateDeviceApiRequest("devicestate");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripRequestWithValueResponse(request, false));
+  EXPECT_TRUE(server_->connection_is_open());
+  ASSERT_EQ(value_jv.type(), JsonValue::kArray);
+  EXPECT_THAT(value_jv, SizeIs(0));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // The following methods are defined for observing conditions, but without a
@@ -485,10 +531,10 @@ class MockObservingConditionsTest : public DecodeAndDispatchTestBase {
             .device_type = EDeviceType::kObservingConditions,
             .device_number = kDeviceNumber,
             .domain = MCU_DOMAIN(FakeDevice),
-            .name = MCU_FLASHSTR(DEVICE_NAME),
-            .description = MCU_FLASHSTR(DEVICE_DESCRIPTION),
-            .driver_info = MCU_FLASHSTR(GITHUB_LINK),
-            .driver_version = MCU_FLASHSTR(DEVICE_DRIVER_VERSION),
+            .name = MCU_PSD(DEVICE_NAME),
+            .description = MCU_PSD(DEVICE_DESCRIPTION),
+            .driver_info = MCU_PSD(GITHUB_LINK),
+            .driver_version = MCU_PSD(DEVICE_DRIVER_VERSION),
             .supported_actions =
                 mcucore::ProgmemStringArray{supported_actions_},
         }),
@@ -724,6 +770,53 @@ TEST_F(MockObservingConditionsTest,
   EXPECT_THAT(error_message_jv.as_string(), HasSubstr("SensorName"));
 }
 
+TEST_F(MockObservingConditionsTest, Method_DeviceState) {
+  // The device state is gathered twice, once to compute the Content-Length and
+  // once to write the body.
+  EXPECT_CALL(device_, GetAveragePeriod).Times(0);
+  EXPECT_CALL(device_, GetCloudCover).WillRepeatedly(Return(1.1));
+  EXPECT_CALL(device_, GetDewPoint)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetHumidity).WillRepeatedly(Return(1.3));
+  EXPECT_CALL(device_, GetPressure)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetRainRate)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetSkyBrightness)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetSkyQuality)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetSkyTemperature)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetStarFWHM)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetTemperature).WillRepeatedly(Return(2.1));
+  EXPECT_CALL(device_, GetWindDirection)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetWindGust)
+      .WillRepeatedly(Return(ErrorCodes::NotImplemented()));
+  EXPECT_CALL(device_, GetWindSpeed).WillRepeatedly(Return(2.4));
+
+  auto request = GenerateDeviceApiRequest("devicestate");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  ASSERT_EQ(value_jv.type(), JsonValue::kArray);
+  ASSERT_THAT(value_jv, SizeIs(4));
+
+  const std::vector<std::pair<std::string, double>> expected = {
+      {"CloudCover", 1.1},
+      {"Humidity", 1.3},
+      {"Temperature", 2.1},
+      {"WindSpeed", 2.4},
+  };
+  for (size_t ndx = 0; ndx < expected.size(); ++ndx) {
+    auto item_jv = value_jv.GetElement(ndx);
+    ASSERT_EQ(item_jv.type(), JsonValue::kObject);
+    EXPECT_EQ(item_jv.GetValue("Name"), expected[ndx].first);
+    EXPECT_EQ(item_jv.GetValue("Value"), expected[ndx].second);
+  }
+}
+
 TEST_F(MockObservingConditionsTest, Method_TimeSinceLastUpdate) {
   EXPECT_CALL(device_, GetTimeSinceLastUpdate).WillOnce(Return(10));
   auto request = GenerateDeviceApiRequest("timesincelastupdate");
@@ -733,6 +826,203 @@ TEST_F(MockObservingConditionsTest, Method_TimeSinceLastUpdate) {
   EXPECT_EQ(value_jv, 10);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Tests of a device which registers its sensors for sampling, rather than
+// implementing the GetXyz methods.
+
+class SampledObservingConditions : public ObservingConditionsAdapter {
+ public:
+  SampledObservingConditions(ServerContext& server_context,
+                             const DeviceDescription& device_description)
+      : ObservingConditionsAdapter(server_context, device_description) {
+    RegisterSensor(ESensorName::kTemperature, 1000);
+    RegisterSensor(ESensorName::kHumidity, 5000);
+  }
+  void ResetHardware() override {}
+  void InitializeDevice() override {}
+
+  mcucore::StatusOr<double> ReadSensor(ESensorName sensor_name) override {
+    ++num_reads;
+    if (sensor_name == ESensorName::kTemperature) {
+      return temperature;
+    } else if (sensor_name == ESensorName::kHumidity) {
+      return humidity;
+    }
+    return ErrorCodes::NotImplemented();
+  }
+
+  // Pressure isn't sampled, and is provided as a FixedPoint.
+  mcucore::StatusOr<FixedPoint> GetFixedPointValue(
+      ESensorName sensor_name) override {
+    if (sensor_name == ESensorName::kPressure) {
+      return FixedPoint(pressure_pascals, -2);
+    }
+    return ObservingConditionsAdapter::GetFixedPointValue(sensor_name);
+  }
+
+  double temperature = 12.5;
+  double humidity = 45.0;
+  int32_t pressure_pascals = 101325;
+  int num_reads = 0;
+};
+
+class SampledObservingConditionsTest : public DecodeAndDispatchTestBase {
+ protected:
+  SampledObservingConditionsTest()
+      : device_description_({
+            .device_type = EDeviceType::kObservingConditions,
+            .device_number = kDeviceNumber,
+            .domain = MCU_DOMAIN(FakeDevice),
+            .name = MCU_PSD(DEVICE_NAME),
+            .description = MCU_PSD(DEVICE_DESCRIPTION),
+            .driver_info = MCU_PSD(GITHUB_LINK),
+            .driver_version = MCU_PSD(DEVICE_DRIVER_VERSION),
+            .supported_actions =
+                mcucore::ProgmemStringArray{supported_actions_},
+        }),
+        device_(server_context_, device_description_) {
+    AddDeviceInterface(device_);
+  }
+
+  const mcucore::ProgmemString supported_actions_[1] = {
+      MCU_PSD(SUPPORTED_ACTION)};
+  const DeviceDescription device_description_;
+  SampledObservingConditions device_;
+};
+
+TEST_F(SampledObservingConditionsTest, OneSensorReadPerSample) {
+  EXPECT_EQ(device_.GetTemperature().status().code(),
+            ErrorCodes::kValueNotSetStatusCode);
+
+  device_.SampleSensors(0);
+  EXPECT_EQ(device_.num_reads, 1);
+  EXPECT_EQ(device_.GetTemperature().value(), 12.5);
+  EXPECT_EQ(device_.GetHumidity().status().code(),
+            ErrorCodes::kValueNotSetStatusCode);
+
+  device_.SampleSensors(1);
+  EXPECT_EQ(device_.num_reads, 2);
+  EXPECT_EQ(device_.GetHumidity().value(), 45.0);
+
+  // Neither is due yet.
+  device_.SampleSensors(999);
+  EXPECT_EQ(device_.num_reads, 2);
+
+  // The cached values are returned without reading the sensors.
+  device_.temperature = 13.5;
+  EXPECT_EQ(device_.GetTemperature().value(), 12.5);
+  EXPECT_EQ(device_.num_reads, 2);
+
+  device_.SampleSensors(1000);
+  EXPECT_EQ(device_.num_reads, 3);
+  EXPECT_EQ(device_.GetTemperature().value(), 13.5);
+
+  // Sensors that aren't registered are not implemented.
+  EXPECT_EQ(device_.GetPressure().status().code(),
+            ErrorCodes::kNotImplementedStatusCode);
+}
+
+TEST_F(SampledObservingConditionsTest, RefreshMakesSensorsDue) {
+  device_.SampleSensors(0);
+  device_.SampleSensors(0);
+  EXPECT_EQ(device_.num_reads, 2);
+  device_.SampleSensors(10);
+  EXPECT_EQ(device_.num_reads, 2);
+
+  auto request = GenerateDeviceApiPutRequest("refresh");
+  ASSERT_OK_AND_ASSIGN(auto response_message, RoundTripRequest(request, false));
+  ASSERT_OK(response_validator_.ValidateValuelessResponse(response_message));
+
+  EXPECT_EQ(device_.sensor_sampler().NextDueSensor(10),
+            ESensorName::kTemperature);
+}
+
+TEST_F(SampledObservingConditionsTest, Method_Temperature) {
+  device_.SampleSensors(0);
+  auto request = GenerateDeviceApiRequest("temperature");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  EXPECT_EQ(value_jv, 12.5);
+}
+
+TEST_F(SampledObservingConditionsTest, Method_Pressure_FixedPoint) {
+  auto request = GenerateDeviceApiRequest("pressure");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  EXPECT_EQ(value_jv, 1013.25);
+  EXPECT_EQ(device_.num_reads, 0);
+}
+
+#if TAS_ENABLE_SENSOR_HISTORY
+TEST_F(SampledObservingConditionsTest, Method_SupportedActions) {
+  auto request = GenerateDeviceApiRequest("supportedactions");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  EXPECT_EQ(value_jv, JsonArray().Add(SUPPORTED_ACTION).Add("History"));
+}
+
+TEST_F(SampledObservingConditionsTest, Action_History) {
+  constexpr uint32_t kInterval = TAS_SENSOR_HISTORY_INTERVAL_MILLIS;
+  device_.SampleSensors(0);
+  device_.SampleSensors(1);
+  device_.humidity = 46;
+  device_.SampleSensors(5001);  // Temperature is the most overdue.
+  device_.SampleSensors(5002);  // Humidity.
+  EXPECT_EQ(device_.num_reads, 4);
+  // Ends the first interval.
+  device_.SampleSensors(kInterval);
+
+  auto request = GenerateDeviceApiPutRequest("action");
+  request.SetParameter("Action", "history");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  ASSERT_EQ(value_jv.type(), JsonValue::kString);
+  // The ages depend on the current time.
+  EXPECT_THAT(value_jv.as_string(),
+              MatchesRegex(absl::StrCat("Temperature,", kInterval / 1000,
+                                        ",[0-9]+,12\\.5\n",
+                                        "Humidity,", kInterval / 1000,
+                                        ",[0-9]+,45\\.5")));
+
+  request = GenerateDeviceApiPutRequest("action");
+  request.SetParameter("Action", "History");
+  request.SetParameter("Parameters", "humidity");
+  ASSERT_OK_AND_ASSIGN(value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  ASSERT_EQ(value_jv.type(), JsonValue::kString);
+  EXPECT_THAT(value_jv.as_string(),
+              MatchesRegex(absl::StrCat("Humidity,", kInterval / 1000,
+                                        ",[0-9]+,45\\.5")));
+}
+
+TEST_F(SampledObservingConditionsTest, Action_History_BadParameters) {
+  auto request = GenerateDeviceApiPutRequest("action");
+  request.SetParameter("Action", "History");
+  request.SetParameter("Parameters", "Weather");
+  ASSERT_OK_AND_ASSIGN(auto response_message, RoundTripRequest(request, false));
+  const int kInvalidValue = 1025;
+  ASSERT_OK(response_validator_.ValidateJsonResponseHasError(response_message,
+                                                             kInvalidValue));
+
+  // The sensor name is valid, but the device doesn't have that sensor.
+  request = GenerateDeviceApiPutRequest("action");
+  request.SetParameter("Action", "History");
+  request.SetParameter("Parameters", "Pressure");
+  ASSERT_OK_AND_ASSIGN(response_message, RoundTripRequest(request, false));
+  ASSERT_OK(response_validator_.ValidateJsonResponseHasError(
+      response_message, kAscomNotImplementedError));
+}
+
+TEST_F(SampledObservingConditionsTest, Action_Unknown) {
+  auto request = GenerateDeviceApiPutRequest("action");
+  request.SetParameter("Action", "MakeItSnow");
+  ASSERT_OK_AND_ASSIGN(auto response_message, RoundTripRequest(request, false));
+  const int kActionNotImplemented = 1036;
+  ASSERT_OK(response_validator_.ValidateJsonResponseHasError(
+      response_message, kActionNotImplemented));
+}
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+
 }  // namespace
 }  // namespace test
 }  // namespace alpaca
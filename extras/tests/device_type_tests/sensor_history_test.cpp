@@ -0,0 +1,153 @@
+#include "device_types/observing_conditions/sensor_history.h"
+
+#include <McuCore.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/print_to_std_string.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+using ::mcucore::test::PrintToStdString;
+
+std::string PrintPoints(const SensorHistory& history) {
+  PrintToStdString out;
+  const size_t count = history.PrintPointsTo(out);
+  EXPECT_EQ(count, out.str().size());
+  return out.str();
+}
+
+TEST(SensorHistoryTest, Empty) {
+  SensorHistory history;
+  EXPECT_EQ(history.size(), 0);
+  int32_t value = 123;
+  EXPECT_FALSE(history.GetPoint(0, value));
+  EXPECT_EQ(value, 123);
+  EXPECT_EQ(PrintPoints(history), "");
+}
+
+TEST(SensorHistoryTest, MeanOfEachInterval) {
+  SensorHistory history;
+  history.AddReading(12.0);
+  history.AddReading(13.0);
+  history.EndInterval();
+  history.AddReading(-1.006);
+  history.EndInterval();
+  history.AddReading(1013.25);
+  history.EndInterval();
+
+  EXPECT_EQ(history.size(), 3);
+  int32_t value;
+  EXPECT_TRUE(history.GetPoint(0, value));
+  EXPECT_EQ(value, 1250);
+  EXPECT_TRUE(history.GetPoint(1, value));
+  EXPECT_EQ(value, -101);
+  // The change from -1.01 to 1013.25 is more than a delta can hold.
+  EXPECT_TRUE(history.GetPoint(2, value));
+  EXPECT_EQ(value, -101 + SensorHistory::kMaxDelta);
+  EXPECT_EQ(PrintPoints(history), ",12.5,-1.01,326.66");
+
+  // The history catches up over the following points.
+  for (int i = 0; i < 3; ++i) {
+    history.AddReading(1013.25);
+    history.EndInterval();
+  }
+  EXPECT_EQ(PrintPoints(history), ",12.5,-1.01,326.66,654.33,982,1013.25");
+}
+
+TEST(SensorHistoryTest, Gaps) {
+  SensorHistory history;
+  history.EndInterval();
+  history.AddReading(1013.25);
+  history.EndInterval();
+  history.EndInterval();
+  history.AddReading(1012);
+  history.EndInterval();
+
+  EXPECT_EQ(history.size(), 4);
+  int32_t value = 0;
+  EXPECT_FALSE(history.GetPoint(0, value));
+  EXPECT_TRUE(history.GetPoint(1, value));
+  EXPECT_EQ(value, 101325);
+  EXPECT_FALSE(history.GetPoint(2, value));
+  EXPECT_TRUE(history.GetPoint(3, value));
+  EXPECT_EQ(value, 101200);
+  EXPECT_EQ(PrintPoints(history), ",,1013.25,,1012");
+}
+
+TEST(SensorHistoryTest, DiscardsOldestWhenFull) {
+  SensorHistory history;
+  std::string expected;
+  for (int i = 0; i < SensorHistory::kMaxPoints * 3; ++i) {
+    if (i % 5 != 4) {
+      history.AddReading(i * 0.5 - 10);
+    }
+    history.EndInterval();
+    ASSERT_LE(history.size(), SensorHistory::kMaxPoints);
+  }
+  EXPECT_EQ(history.size(), SensorHistory::kMaxPoints);
+
+  // Compare with the values computed directly.
+  const int first = SensorHistory::kMaxPoints * 2;
+  for (int ndx = 0; ndx < SensorHistory::kMaxPoints; ++ndx) {
+    const int i = first + ndx;
+    int32_t value = 0;
+    if (i % 5 == 4) {
+      EXPECT_FALSE(history.GetPoint(ndx, value)) << ndx;
+      expected += ",";
+    } else {
+      EXPECT_TRUE(history.GetPoint(ndx, value)) << ndx;
+      EXPECT_EQ(value, i * 50 - 1000) << ndx;
+      PrintToStdString out;
+      out.print(',');
+      if (value < 0) {
+        out.print('-');
+      }
+      const int magnitude = value < 0 ? -value : value;
+      out.print(magnitude / 100);
+      if (magnitude % 100 != 0) {
+        out.print('.');
+        out.print((magnitude % 100) / 10);
+      }
+      expected += out.str();
+    }
+  }
+  EXPECT_EQ(PrintPoints(history), expected);
+}
+
+TEST(SensorHistoryTest, OnlyGapsRemain) {
+  SensorHistory history;
+  history.AddReading(20);
+  history.EndInterval();
+  for (int i = 0; i < SensorHistory::kMaxPoints; ++i) {
+    history.EndInterval();
+  }
+  EXPECT_EQ(history.size(), SensorHistory::kMaxPoints);
+  EXPECT_EQ(PrintPoints(history),
+            std::string(SensorHistory::kMaxPoints, ','));
+
+  // The next value needn't be relative to the discarded one.
+  history.AddReading(-40);
+  history.EndInterval();
+  int32_t value = 0;
+  EXPECT_TRUE(history.GetPoint(SensorHistory::kMaxPoints - 1, value));
+  EXPECT_EQ(value, -4000);
+}
+
+TEST(SensorHistoryTest, Reset) {
+  SensorHistory history;
+  history.AddReading(20);
+  history.EndInterval();
+  history.AddReading(21);
+  history.Reset();
+  EXPECT_EQ(history.size(), 0);
+  history.EndInterval();
+  EXPECT_EQ(PrintPoints(history), ",");
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
@@ -0,0 +1,198 @@
+#include "device_types/observing_conditions/sensor_sampler.h"
+
+#include <McuCore.h>
+
+#include <cmath>
+#include <string>
+
+#include "ascom_error_codes.h"
+#include "constants.h"
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/print_to_std_string.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+// Returns the ASCOM error code of the result, or zero if it is OK.
+int ErrorCodeOf(const mcucore::StatusOr<double>& result) {
+  return result.ok() ? 0 : static_cast<int>(result.status().code());
+}
+
+// Returns the value of the result, or NaN if it is not OK.
+double ValueOf(const mcucore::StatusOr<double>& result) {
+  return result.ok() ? result.value() : NAN;
+}
+
+TEST(SensorSamplerTest, Unregistered) {
+  SensorSampler sampler;
+  EXPECT_EQ(sampler.num_sensors(), 0);
+  EXPECT_FALSE(sampler.IsRegistered(ESensorName::kTemperature));
+  EXPECT_EQ(sampler.NextDueSensor(0), ESensorName::kUnknown);
+  EXPECT_EQ(ErrorCodeOf(sampler.GetValue(ESensorName::kTemperature)),
+            ErrorCodes::kNotImplemented);
+  EXPECT_EQ(ErrorCodeOf(
+                sampler.GetTimeSinceLastUpdate(ESensorName::kTemperature, 0)),
+            ErrorCodes::kNotImplemented);
+}
+
+TEST(SensorSamplerTest, RegisterUpToLimit) {
+  const ESensorName kSensors[] = {
+      ESensorName::kCloudCover,  ESensorName::kDewPoint,
+      ESensorName::kHumidity,    ESensorName::kPressure,
+      ESensorName::kRainRate,    ESensorName::kSkyBrightness,
+      ESensorName::kSkyQuality,  ESensorName::kSkyTemperature,
+      ESensorName::kStarFWHM,    ESensorName::kTemperature,
+      ESensorName::kWindGust,    ESensorName::kWindSpeed,
+      ESensorName::kWindDirection,
+  };
+  SensorSampler sampler;
+  for (const auto sensor_name : kSensors) {
+    if (sampler.num_sensors() < SensorSampler::kMaxSensors) {
+      EXPECT_TRUE(sampler.RegisterSensor(sensor_name, 1000));
+      EXPECT_TRUE(sampler.IsRegistered(sensor_name));
+      // Can't register the same sensor twice.
+      EXPECT_FALSE(sampler.RegisterSensor(sensor_name, 1000));
+    } else {
+      EXPECT_FALSE(sampler.RegisterSensor(sensor_name, 1000));
+      EXPECT_FALSE(sampler.IsRegistered(sensor_name));
+    }
+  }
+}
+
+TEST(SensorSamplerTest, NeverReadSensorsAreDueInOrder) {
+  SensorSampler sampler;
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kTemperature, 1000));
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kHumidity, 5000));
+  EXPECT_EQ(ErrorCodeOf(sampler.GetValue(ESensorName::kTemperature)),
+            ErrorCodes::kValueNotSet);
+  EXPECT_EQ(ErrorCodeOf(
+                sampler.GetTimeSinceLastUpdate(ESensorName::kTemperature, 0)),
+            ErrorCodes::kValueNotSet);
+
+  EXPECT_EQ(sampler.NextDueSensor(100), ESensorName::kTemperature);
+  sampler.RecordReading(ESensorName::kTemperature, 20.5, 100);
+  EXPECT_EQ(sampler.NextDueSensor(100), ESensorName::kHumidity);
+  sampler.RecordReading(ESensorName::kHumidity, 45.0, 100);
+  EXPECT_EQ(sampler.NextDueSensor(100), ESensorName::kUnknown);
+
+  EXPECT_EQ(ValueOf(sampler.GetValue(ESensorName::kTemperature)), 20.5);
+  EXPECT_EQ(ValueOf(sampler.GetValue(ESensorName::kHumidity)), 45.0);
+}
+
+TEST(SensorSamplerTest, MostOverdueIsReadFirst) {
+  SensorSampler sampler;
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kTemperature, 1000));
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kHumidity, 5000));
+  sampler.RecordReading(ESensorName::kTemperature, 1, 0);
+  sampler.RecordReading(ESensorName::kHumidity, 2, 0);
+
+  EXPECT_EQ(sampler.NextDueSensor(999), ESensorName::kUnknown);
+  EXPECT_EQ(sampler.NextDueSensor(1000), ESensorName::kTemperature);
+  // Both are due at 5000, but temperature is more overdue.
+  EXPECT_EQ(sampler.NextDueSensor(5000), ESensorName::kTemperature);
+  sampler.RecordReading(ESensorName::kTemperature, 3, 5000);
+  EXPECT_EQ(sampler.NextDueSensor(5000), ESensorName::kHumidity);
+  sampler.RecordReading(ESensorName::kHumidity, 4, 5000);
+  EXPECT_EQ(sampler.NextDueSensor(5999), ESensorName::kUnknown);
+
+  // Humidity is 1500ms overdue at 11500, and temperature 5500ms.
+  EXPECT_EQ(sampler.NextDueSensor(11500), ESensorName::kTemperature);
+  sampler.RecordReading(ESensorName::kTemperature, 5, 11500);
+  EXPECT_EQ(sampler.NextDueSensor(11500), ESensorName::kHumidity);
+}
+
+TEST(SensorSamplerTest, ClockWrapsAround) {
+  SensorSampler sampler;
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kTemperature, 1000));
+  sampler.RecordReading(ESensorName::kTemperature, 1, 0xFFFFFF00);
+  EXPECT_EQ(sampler.NextDueSensor(0xFFFFFFFF), ESensorName::kUnknown);
+  EXPECT_EQ(sampler.NextDueSensor(0x100), ESensorName::kUnknown);
+  EXPECT_EQ(sampler.NextDueSensor(0x2E8), ESensorName::kTemperature);
+}
+
+TEST(SensorSamplerTest, ReadErrors) {
+  SensorSampler sampler;
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kSkyTemperature, 1000));
+  sampler.RecordReading(ESensorName::kSkyTemperature, -10.0, 1000);
+  sampler.RecordReading(ESensorName::kSkyTemperature,
+                        ErrorCodes::NotConnected(), 2000);
+  EXPECT_EQ(ErrorCodeOf(sampler.GetValue(ESensorName::kSkyTemperature)),
+            ErrorCodes::kNotConnected);
+  // Time since the last successful reading.
+  const uint32_t kHalfHourMillis = 30 * 60 * 1000;
+  EXPECT_EQ(ValueOf(sampler.GetTimeSinceLastUpdate(
+                ESensorName::kSkyTemperature, 1000 + kHalfHourMillis)),
+            0.5);
+  // A failed read is not retried until the interval has passed.
+  EXPECT_EQ(sampler.NextDueSensor(2999), ESensorName::kUnknown);
+  EXPECT_EQ(sampler.NextDueSensor(3000), ESensorName::kSkyTemperature);
+
+  sampler.RecordReading(ESensorName::kSkyTemperature, -11.0, 3000);
+  EXPECT_EQ(ValueOf(sampler.GetValue(ESensorName::kSkyTemperature)), -11.0);
+}
+
+TEST(SensorSamplerTest, MakeAllDue) {
+  SensorSampler sampler;
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kTemperature, 60000));
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kHumidity, 60000));
+  sampler.RecordReading(ESensorName::kTemperature, 1, 0);
+  sampler.RecordReading(ESensorName::kHumidity, 2, 0);
+  EXPECT_EQ(sampler.NextDueSensor(10), ESensorName::kUnknown);
+
+  sampler.MakeAllDue();
+  EXPECT_EQ(sampler.NextDueSensor(10), ESensorName::kTemperature);
+  sampler.RecordReading(ESensorName::kTemperature, 3, 10);
+  EXPECT_EQ(sampler.NextDueSensor(10), ESensorName::kHumidity);
+  sampler.RecordReading(ESensorName::kHumidity, 4, 10);
+  EXPECT_EQ(sampler.NextDueSensor(10), ESensorName::kUnknown);
+}
+
+#if TAS_ENABLE_SENSOR_HISTORY
+std::string PrintHistory(const SensorSampler& sampler, ESensorName sensor_name,
+                         uint32_t now_millis) {
+  mcucore::test::PrintToStdString out;
+  const size_t count = sampler.PrintHistoryTo(sensor_name, now_millis, out);
+  EXPECT_EQ(count, out.str().size());
+  return out.str();
+}
+
+TEST(SensorSamplerTest, History) {
+  constexpr uint32_t kInterval = TAS_SENSOR_HISTORY_INTERVAL_MILLIS;
+  const std::string kIntervalSecs = std::to_string(kInterval / 1000);
+  // Start just before the clock wraps around.
+  const uint32_t start = 0 - kInterval / 2;
+
+  SensorSampler sampler;
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kTemperature, 1000));
+  sampler.AdvanceHistory(start);
+  sampler.RecordReading(ESensorName::kTemperature, 10, start);
+  sampler.RecordReading(ESensorName::kTemperature, 11, start + 1000);
+  EXPECT_EQ(PrintHistory(sampler, ESensorName::kUnknown, start + 2000),
+            "Temperature," + kIntervalSecs + ",2");
+
+  sampler.AdvanceHistory(start + kInterval);
+  EXPECT_EQ(PrintHistory(sampler, ESensorName::kUnknown, start + kInterval),
+            "Temperature," + kIntervalSecs + ",0,10.5");
+
+  // A sensor registered later has gaps at the start of its history, so that
+  // the intervals line up.
+  ASSERT_TRUE(sampler.RegisterSensor(ESensorName::kHumidity, 1000));
+  sampler.RecordReading(ESensorName::kHumidity, 50, start + kInterval);
+  sampler.RecordReading(ESensorName::kTemperature, 12, start + kInterval);
+
+  // Two intervals have ended, the second with no readings.
+  sampler.AdvanceHistory(start + 3 * kInterval + 5000);
+  EXPECT_EQ(PrintHistory(sampler, ESensorName::kUnknown,
+                         start + 3 * kInterval + 7000),
+            "Temperature," + kIntervalSecs + ",7,10.5,12,\n" +  //
+                "Humidity," + kIntervalSecs + ",7,,50,");
+  EXPECT_EQ(PrintHistory(sampler, ESensorName::kHumidity,
+                         start + 3 * kInterval + 7000),
+            "Humidity," + kIntervalSecs + ",7,,50,");
+}
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
@@ -6,13 +6,17 @@
 #include <string>
 
 #include "alpaca_request.h"
+#include "config.h"
 #include "constants.h"
 #include "device_description.h"
+#include "device_types/switch/switch_name_cache.h"
+#include "eeprom_ids.h"
 #include "extras/test_tools/decode_and_dispatch_test_base.h"
 #include "extras/test_tools/mock_switch_group.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "mcucore/extras/test_tools/print_to_std_string.h"
+#include "utils/fixed_point.h"
 
 MCU_DEFINE_DOMAIN(75);
 
@@ -20,6 +24,7 @@ namespace alpaca {
 namespace test {
 namespace {
 
+using ::mcucore::test::JsonArray;
 using ::mcucore::test::JsonValue;
 using ::testing::Mock;
 using ::testing::NiceMock;
@@ -39,6 +44,39 @@ constexpr int kAscomValueNotSetError = 1026;
 #define SUPPORTED_ACTION "JiggleSwitch"
 #define DEVICE_DRIVER_VERSION "0.9"
 
+// Extends MockSwitchGroup to provide the value of one method as a FixedPoint,
+// and to use the SwitchAdapter implementation of the switch name methods.
+class TestSwitchGroup : public MockSwitchGroup {
+ public:
+  using MockSwitchGroup::MockSwitchGroup;
+  using SwitchAdapter::WriteSwitchName;
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+  using SwitchAdapter::LoadSwitchNames;
+  using SwitchAdapter::SaveSwitchNamesIfDue;
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
+
+  bool HandleGetSwitchName(const AlpacaRequest& request, uint16_t switch_id,
+                           Print& out) override {
+    return SwitchAdapter::HandleGetSwitchName(request, switch_id, out);
+  }
+
+  bool HandleSetSwitchName(const AlpacaRequest& request, uint16_t switch_id,
+                           Print& out) override {
+    return SwitchAdapter::HandleSetSwitchName(request, switch_id, out);
+  }
+
+  mcucore::StatusOr<FixedPoint> GetFixedPointValue(
+      EDeviceMethod method, uint16_t switch_id) override {
+    if (method == fixed_point_method) {
+      return fixed_point_value;
+    }
+    return MockSwitchGroup::GetFixedPointValue(method, switch_id);
+  }
+
+  EDeviceMethod fixed_point_method = EDeviceMethod::kUnknown;
+  FixedPoint fixed_point_value{0, 0};
+};
+
 class SwitchAdapterTest : public DecodeAndDispatchTestBase {
  protected:
   SwitchAdapterTest()
@@ -80,10 +118,39 @@ class SwitchAdapterTest : public DecodeAndDispatchTestBase {
     request_.set_client_transaction_id(kClientTransactionId);
   }
 
+  std::string GetSwitchName(SwitchAdapter& device, uint16_t switch_id) {
+    InitializeRequest();
+    request_.device_method = EDeviceMethod::kGetSwitchName;
+    request_.set_id(switch_id);
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(device.HandleGetRequest(request_, out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    auto status_or_value = response_validator_.ValidateValueResponse(out.str());
+    if (!status_or_value.ok()) {
+      ADD_FAILURE() << status_or_value.status();
+      return "";
+    }
+    return status_or_value.value().as_string();
+  }
+
+  void SetSwitchName(SwitchAdapter& device, uint16_t switch_id,
+                     const std::string& name) {
+    InitializeRequest();
+    request_.http_method = EHttpMethod::PUT;
+    request_.device_method = EDeviceMethod::kSetSwitchName;
+    request_.set_id(switch_id);
+    ASSERT_TRUE(request_.set_string_value(
+        mcucore::StringView(name.data(), name.size())));
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(device.HandlePutRequest(request_, out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    ASSERT_OK(response_validator_.ValidateValuelessResponse(out.str()));
+  }
+
   const mcucore::ProgmemString supported_actions_[1] = {
       MCU_PSD(SUPPORTED_ACTION)};
   const DeviceDescription device_description_;
-  NiceMock<MockSwitchGroup> device_;
+  NiceMock<TestSwitchGroup> device_;
   AlpacaRequest request_;
 };
 
@@ -325,6 +392,53 @@ TEST_F(SwitchAdapterTest, GetSwitchValue) {
   }
 }
 
+TEST_F(SwitchAdapterTest, DeviceState) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(2));
+  EXPECT_CALL(device_, GetSwitch(0)).WillRepeatedly(Return(false));
+  EXPECT_CALL(device_, GetSwitch(1)).WillRepeatedly(Return(true));
+  EXPECT_CALL(device_, GetSwitchValue(0)).WillRepeatedly(Return(0.0));
+  const char kErrorMessage[] = "Can not get switch as double";
+  mcucore::ProgmemStringView literal_error_message(kErrorMessage);
+  mcucore::Status status(mcucore::StatusCode::kNotFound, literal_error_message);
+  EXPECT_CALL(device_, GetSwitchValue(1)).WillRepeatedly(Return(status));
+
+  request_.device_method = EDeviceMethod::kDeviceState;
+  mcucore::test::PrintToStdString out;
+  ASSERT_TRUE(device_.HandleGetRequest(request_, out));
+  response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       response_validator_.ValidateValueResponse(out.str()));
+  ASSERT_EQ(value_jv.type(), JsonValue::kArray);
+
+  // GetSwitchValue1 is omitted because of the error.
+  ASSERT_EQ(value_jv.size(), 3);
+  EXPECT_EQ(value_jv.GetElement(0).GetValue("Name"), "GetSwitch0");
+  EXPECT_EQ(value_jv.GetElement(0).GetValue("Value"), false);
+  EXPECT_EQ(value_jv.GetElement(1).GetValue("Name"), "GetSwitchValue0");
+  EXPECT_EQ(value_jv.GetElement(1).GetValue("Value"), 0.0);
+  EXPECT_EQ(value_jv.GetElement(2).GetValue("Name"), "GetSwitch1");
+  EXPECT_EQ(value_jv.GetElement(2).GetValue("Value"), true);
+}
+
+TEST_F(SwitchAdapterTest, DeviceStateWithLittleSpaceToWrite) {
+  // Device responses aren't written in parts, so are complete however little
+  // space there is in the socket's transmit buffer.
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(2));
+  EXPECT_CALL(device_, GetSwitch(0)).WillRepeatedly(Return(false));
+  EXPECT_CALL(device_, GetSwitch(1)).WillRepeatedly(Return(true));
+  EXPECT_CALL(device_, GetSwitchValue(0)).WillRepeatedly(Return(0.0));
+  EXPECT_CALL(device_, GetSwitchValue(1)).WillRepeatedly(Return(1.0));
+  server_->set_available_for_write(16);
+
+  auto request = GenerateDeviceApiRequest("devicestate");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  ASSERT_EQ(value_jv.type(), JsonValue::kArray);
+  ASSERT_EQ(value_jv.size(), 4);
+  EXPECT_EQ(value_jv.GetElement(3).GetValue("Name"), "GetSwitchValue1");
+  EXPECT_EQ(value_jv.GetElement(3).GetValue("Value"), 1.0);
+}
+
 TEST_F(SwitchAdapterTest, GetMinSwitchValue) {
   request_.device_method = EDeviceMethod::kMinSwitchValue;
   request_.set_id(0);
@@ -364,6 +478,30 @@ TEST_F(SwitchAdapterTest, GetSwitchStep) {
   EXPECT_EQ(value_jv, 1.0);
 }
 
+TEST_F(SwitchAdapterTest, FixedPointValues) {
+  for (const auto method :
+       {EDeviceMethod::kGetSwitchValue, EDeviceMethod::kMinSwitchValue,
+        EDeviceMethod::kMaxSwitchValue, EDeviceMethod::kSwitchStep}) {
+    device_.fixed_point_method = method;
+    device_.fixed_point_value = FixedPoint(1275, -2);
+    EXPECT_CALL(device_, GetSwitchValue).Times(0);
+    EXPECT_CALL(device_, GetMinSwitchValue).Times(0);
+    EXPECT_CALL(device_, GetMaxSwitchValue).Times(0);
+    EXPECT_CALL(device_, GetSwitchStep).Times(0);
+
+    InitializeRequest();
+    request_.device_method = method;
+    request_.set_id(0);
+    mcucore::test::PrintToStdString out;
+    EXPECT_TRUE(device_.HandleGetRequest(request_, out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    ASSERT_OK_AND_ASSIGN(auto value_jv,
+                         response_validator_.ValidateValueResponse(out.str()));
+    EXPECT_EQ(value_jv, 12.75);
+    Mock::VerifyAndClearExpectations(&device_);
+  }
+}
+
 TEST_F(SwitchAdapterTest, SetSwitch_MissingState) {
   request_.device_method = EDeviceMethod::kSetSwitch;
   request_.set_id(0);
@@ -454,6 +592,267 @@ TEST_F(SwitchAdapterTest, SetSwitchValue) {
   ASSERT_OK(response_validator_.ValidateValuelessResponse(out.str()));
 }
 
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+TEST_F(SwitchAdapterTest, SupportedActions) {
+  request_.device_method = EDeviceMethod::kSupportedActions;
+  {
+    EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(2));
+    mcucore::test::PrintToStdString out;
+    ASSERT_TRUE(device_.HandleGetRequest(request_, out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    ASSERT_OK_AND_ASSIGN(auto value_jv,
+                         response_validator_.ValidateValueResponse(out.str()));
+    EXPECT_EQ(value_jv,
+              JsonArray().Add("GetAllSwitchValues").Add("SetSwitchValues"));
+  }
+  {
+    // Too many switches for all of their values to be held at once.
+    EXPECT_CALL(device_, GetMaxSwitch)
+        .WillRepeatedly(Return(TAS_MAX_SWITCH_VALUES + 1));
+    mcucore::test::PrintToStdString out;
+    ASSERT_TRUE(device_.HandleGetRequest(request_, out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    ASSERT_OK_AND_ASSIGN(auto value_jv,
+                         response_validator_.ValidateValueResponse(out.str()));
+    EXPECT_EQ(value_jv, JsonArray());
+  }
+}
+
+TEST_F(SwitchAdapterTest, GetAllSwitchValues) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(3));
+  // Each switch is read just once.
+  EXPECT_CALL(device_, GetSwitchValue(0)).WillOnce(Return(1.0));
+  EXPECT_CALL(device_, GetSwitchValue(1)).WillOnce(Return(0.5));
+  EXPECT_CALL(device_, GetSwitchValue(2)).WillOnce(Return(0.25));
+
+  request_.http_method = EHttpMethod::PUT;
+  request_.device_method = EDeviceMethod::kAction;
+  request_.action = EDeviceAction::kGetAllSwitchValues;
+  {
+    mcucore::test::PrintToStdString out;
+    ASSERT_TRUE(device_.HandlePutRequest(request_, out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    ASSERT_OK_AND_ASSIGN(auto value_jv,
+                         response_validator_.ValidateValueResponse(out.str()));
+    EXPECT_EQ(value_jv, JsonArray().Add(1.0).Add(0.5).Add(0.25));
+  }
+
+  // FixedPoint values are used where provided.
+  device_.fixed_point_method = EDeviceMethod::kGetSwitchValue;
+  device_.fixed_point_value = FixedPoint(5, -1);
+  EXPECT_CALL(device_, GetSwitchValue).Times(0);
+  {
+    mcucore::test::PrintToStdString out;
+    ASSERT_TRUE(device_.HandlePutRequest(request_, out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    ASSERT_OK_AND_ASSIGN(auto value_jv,
+                         response_validator_.ValidateValueResponse(out.str()));
+    EXPECT_EQ(value_jv, JsonArray().Add(0.5).Add(0.5).Add(0.5));
+  }
+}
+
+TEST_F(SwitchAdapterTest, GetAllSwitchValues_ReadError) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(3));
+  EXPECT_CALL(device_, GetSwitchValue(0)).WillOnce(Return(1.0));
+  mcucore::Status status(mcucore::StatusCode::kNotFound,
+                         mcucore::ProgmemStringView("Unknown"));
+  EXPECT_CALL(device_, GetSwitchValue(1)).WillOnce(Return(status));
+  EXPECT_CALL(device_, GetSwitchValue(2)).Times(0);
+
+  request_.http_method = EHttpMethod::PUT;
+  request_.device_method = EDeviceMethod::kAction;
+  request_.action = EDeviceAction::kGetAllSwitchValues;
+  mcucore::test::PrintToStdString out;
+  device_.HandlePutRequest(request_, out);
+  response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+  ASSERT_OK_AND_ASSIGN(
+      auto response,
+      response_validator_.ValidateJsonResponseHasError(
+          out.str(), static_cast<int>(mcucore::StatusCode::kNotFound)));
+  ASSERT_OK_AND_ASSIGN(
+      auto error_message_jv,
+      response.json_value.GetValueOfType("ErrorMessage", JsonValue::kString));
+  EXPECT_EQ(error_message_jv, "Unknown");
+}
+
+TEST_F(SwitchAdapterTest, GetAllSwitchValuesWithLittleSpaceToWrite) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(3));
+  EXPECT_CALL(device_, GetSwitchValue(0)).WillRepeatedly(Return(1.0));
+  EXPECT_CALL(device_, GetSwitchValue(1)).WillRepeatedly(Return(0.5));
+  EXPECT_CALL(device_, GetSwitchValue(2)).WillRepeatedly(Return(0.25));
+  server_->set_available_for_write(16);
+
+  auto request = GenerateDeviceApiPutRequest("action");
+  request.SetParameter("Action", "GetAllSwitchValues");
+  request.SetParameter("Parameters", "");
+  ASSERT_OK_AND_ASSIGN(auto value_jv,
+                       RoundTripSoleRequestWithValueResponse(request));
+  EXPECT_EQ(value_jv, JsonArray().Add(1.0).Add(0.5).Add(0.25));
+}
+
+TEST_F(SwitchAdapterTest, SetSwitchValues) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(3));
+  EXPECT_CALL(device_, GetCanWrite).WillRepeatedly(Return(true));
+  EXPECT_CALL(device_, GetMinSwitchValue).WillRepeatedly(Return(0.0));
+  EXPECT_CALL(device_, GetMaxSwitchValue).WillRepeatedly(Return(2.0));
+
+  request_.http_method = EHttpMethod::PUT;
+  request_.device_method = EDeviceMethod::kAction;
+  request_.action = EDeviceAction::kSetSwitchValues;
+  ASSERT_TRUE(request_.set_switch_values(mcucore::StringView("1,0,1.5")));
+
+  EXPECT_CALL(device_, SetSwitchValue(0, 1.0))
+      .WillOnce(Return(mcucore::OkStatus()));
+  EXPECT_CALL(device_, SetSwitchValue(1, 0.0))
+      .WillOnce(Return(mcucore::OkStatus()));
+  EXPECT_CALL(device_, SetSwitchValue(2, 1.5))
+      .WillOnce(Return(mcucore::OkStatus()));
+
+  mcucore::test::PrintToStdString out;
+  EXPECT_TRUE(device_.HandlePutRequest(request_, out));
+  response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+  ASSERT_OK(response_validator_.ValidateValuelessResponse(out.str()));
+}
+
+TEST_F(SwitchAdapterTest, SetSwitchValues_InvalidValues) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(3));
+  EXPECT_CALL(device_, GetCanWrite).WillRepeatedly(Return(true));
+  EXPECT_CALL(device_, GetMinSwitchValue).WillRepeatedly(Return(0.0));
+  EXPECT_CALL(device_, GetMaxSwitchValue).WillRepeatedly(Return(2.0));
+  // None of the switches are changed if any of the values is invalid.
+  EXPECT_CALL(device_, SetSwitchValue).Times(0);
+
+  // Too few values, too many values, and a value out of range.
+  for (const char* values : {"1,0", "1,0,1,1", "1,0,2.5"}) {
+    InitializeRequest();
+    request_.http_method = EHttpMethod::PUT;
+    request_.device_method = EDeviceMethod::kAction;
+    request_.action = EDeviceAction::kSetSwitchValues;
+    ASSERT_TRUE(request_.set_switch_values(mcucore::StringView(values)));
+    mcucore::test::PrintToStdString out;
+    EXPECT_FALSE(device_.HandlePutRequest(request_, out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    ASSERT_OK_AND_ASSIGN(auto response,
+                         response_validator_.ValidateJsonResponseHasError(
+                             out.str(), kAscomInvalidValueError));
+    ASSERT_OK_AND_ASSIGN(
+        auto error_message_jv,
+        response.json_value.GetValueOfType("ErrorMessage", JsonValue::kString));
+    EXPECT_EQ(error_message_jv, "Invalid parameter: Parameters");
+  }
+}
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
+TEST_F(SwitchAdapterTest, SetSwitchName_InvalidNames) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(3));
+  const std::string too_long(SwitchAdapter::kMaxNameLength + 1, 'x');
+  for (const auto& name : {std::string(), too_long}) {
+    InitializeRequest();
+    request_.http_method = EHttpMethod::PUT;
+    request_.device_method = EDeviceMethod::kSetSwitchName;
+    request_.set_id(1);
+    mcucore::test::PrintToStdString out;
+    EXPECT_FALSE(device_.WriteSwitchName(
+        request_, 1, mcucore::StringView(name.data(), name.size()), out));
+    response_validator_.SetTransactionIdsFromAlpacaRequest(request_);
+    ASSERT_OK_AND_ASSIGN(auto response,
+                         response_validator_.ValidateJsonResponseHasError(
+                             out.str(), kAscomInvalidValueError));
+    ASSERT_OK_AND_ASSIGN(
+        auto error_message_jv,
+        response.json_value.GetValueOfType("ErrorMessage", JsonValue::kString));
+    EXPECT_EQ(error_message_jv, "Invalid parameter: Name");
+  }
+  EXPECT_EQ(GetSwitchName(device_, 1), "Switch #1");
+}
+
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+TEST_F(SwitchAdapterTest, SwitchNames) {
+  // More switches than could be named when each name had its own EEPROM entry.
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(20));
+  EXPECT_EQ(GetSwitchName(device_, 15), "Switch #15");
+  SetSwitchName(device_, 15, "Focuser Power");
+  SetSwitchName(device_, 3, "Dew Heater");
+  EXPECT_EQ(GetSwitchName(device_, 15), "Focuser Power");
+  EXPECT_EQ(GetSwitchName(device_, 3), "Dew Heater");
+  EXPECT_EQ(GetSwitchName(device_, 14), "Switch #14");
+
+  // The names are written to EEPROM only once the write delay has passed since
+  // the last change.
+  NiceMock<TestSwitchGroup> device2(server_context_, device_description_);
+  ON_CALL(device2, GetMaxSwitch).WillByDefault(Return(20));
+  const uint32_t now = millis();
+  device_.SaveSwitchNamesIfDue(now);
+  device2.LoadSwitchNames();
+  EXPECT_EQ(GetSwitchName(device2, 15), "Switch #15");
+
+  device_.SaveSwitchNamesIfDue(now + TAS_SWITCH_NAME_WRITE_DELAY_MILLIS);
+  device2.LoadSwitchNames();
+  EXPECT_EQ(GetSwitchName(device2, 15), "Focuser Power");
+  EXPECT_EQ(GetSwitchName(device2, 3), "Dew Heater");
+  EXPECT_EQ(GetSwitchName(device2, 14), "Switch #14");
+}
+
+TEST_F(SwitchAdapterTest, ReadsSwitchNamesStoredByEarlierVersions) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(3));
+  const char kName[] = "Legacy Name";
+  ASSERT_OK(server_context_.eeprom_tlv().WriteEntry(
+      device_.MakeTag(kSwitch1NameId), reinterpret_cast<const uint8_t*>(kName),
+      sizeof(kName) - 1));
+  device_.LoadSwitchNames();
+  EXPECT_EQ(GetSwitchName(device_, 1), kName);
+  EXPECT_EQ(GetSwitchName(device_, 2), "Switch #2");
+
+  // The names are then saved as a single entry.
+  device_.SaveSwitchNamesIfDue(millis() + TAS_SWITCH_NAME_WRITE_DELAY_MILLIS);
+  SwitchNameCache cache;
+  ASSERT_OK(cache.ReadFrom(server_context_.eeprom_tlv(),
+                           device_.MakeTag(kSwitchNamesId)));
+  const auto name = cache.GetName(1);
+  EXPECT_EQ(std::string(name.data(), name.size()), kName);
+}
+#else   // !TAS_ENABLE_SWITCH_NAME_CACHE
+TEST_F(SwitchAdapterTest, SwitchNames) {
+  // More switches than could be named when each name had its own EEPROM entry.
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(20));
+  EXPECT_EQ(GetSwitchName(device_, 15), "Switch #15");
+  SetSwitchName(device_, 15, "Focuser Power");
+  SetSwitchName(device_, 3, "Dew Heater");
+  EXPECT_EQ(GetSwitchName(device_, 15), "Focuser Power");
+  EXPECT_EQ(GetSwitchName(device_, 3), "Dew Heater");
+  EXPECT_EQ(GetSwitchName(device_, 14), "Switch #14");
+
+  // The names are written to EEPROM immediately, as a single entry.
+  SwitchNameCache cache;
+  ASSERT_OK(cache.ReadFrom(server_context_.eeprom_tlv(),
+                           device_.MakeTag(kSwitchNamesId)));
+  auto name = cache.GetName(15);
+  EXPECT_EQ(std::string(name.data(), name.size()), "Focuser Power");
+  name = cache.GetName(3);
+  EXPECT_EQ(std::string(name.data(), name.size()), "Dew Heater");
+}
+
+TEST_F(SwitchAdapterTest, ReadsSwitchNamesStoredByEarlierVersions) {
+  EXPECT_CALL(device_, GetMaxSwitch).WillRepeatedly(Return(3));
+  const char kName[] = "Legacy Name";
+  ASSERT_OK(server_context_.eeprom_tlv().WriteEntry(
+      device_.MakeTag(kSwitch1NameId), reinterpret_cast<const uint8_t*>(kName),
+      sizeof(kName) - 1));
+  EXPECT_EQ(GetSwitchName(device_, 1), kName);
+  EXPECT_EQ(GetSwitchName(device_, 2), "Switch #2");
+
+  // Setting a name saves all of the names as a single entry.
+  SetSwitchName(device_, 2, "Dew Heater");
+  SwitchNameCache cache;
+  ASSERT_OK(cache.ReadFrom(server_context_.eeprom_tlv(),
+                           device_.MakeTag(kSwitchNamesId)));
+  auto name = cache.GetName(1);
+  EXPECT_EQ(std::string(name.data(), name.size()), kName);
+  name = cache.GetName(2);
+  EXPECT_EQ(std::string(name.data(), name.size()), "Dew Heater");
+}
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
+
 }  // namespace
 }  // namespace test
 }  // namespace alpaca
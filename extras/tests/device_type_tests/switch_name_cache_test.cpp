@@ -0,0 +1,134 @@
+#include "device_types/switch/switch_name_cache.h"
+
+#include <McuCore.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "eeprom_ids.h"
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/status_test_utils.h"
+
+MCU_DEFINE_DOMAIN(76);
+
+namespace alpaca {
+namespace test {
+namespace {
+
+using ::mcucore::EepromTlv;
+
+mcucore::EepromTag MakeTag() {
+  return {.domain = MCU_DOMAIN(76), .id = kSwitchNamesId};
+}
+
+std::string GetName(const SwitchNameCache& cache, uint16_t switch_id) {
+  const auto name = cache.GetName(switch_id);
+  return std::string(name.data(), name.size());
+}
+
+TEST(SwitchNameCacheTest, Empty) {
+  SwitchNameCache cache;
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(cache.dirty());
+  EXPECT_EQ(GetName(cache, 0), "");
+  EXPECT_EQ(GetName(cache, 1000), "");
+}
+
+TEST(SwitchNameCacheTest, SetAndReplaceNames) {
+  SwitchNameCache cache;
+  EXPECT_TRUE(cache.SetName(0, mcucore::StringView("Dome")));
+  EXPECT_TRUE(cache.dirty());
+  EXPECT_TRUE(cache.SetName(300, mcucore::StringView("Dew Heater")));
+  EXPECT_TRUE(cache.SetName(2, mcucore::StringView("Flat Panel")));
+  EXPECT_EQ(cache.size(), 3 * 3 + 4 + 10 + 10);
+  EXPECT_EQ(GetName(cache, 0), "Dome");
+  EXPECT_EQ(GetName(cache, 1), "");
+  EXPECT_EQ(GetName(cache, 2), "Flat Panel");
+  EXPECT_EQ(GetName(cache, 300), "Dew Heater");
+
+  // Replacing a name moves its entry to the end.
+  EXPECT_TRUE(cache.SetName(0, mcucore::StringView("Roof")));
+  EXPECT_EQ(GetName(cache, 0), "Roof");
+  EXPECT_EQ(GetName(cache, 2), "Flat Panel");
+  EXPECT_EQ(GetName(cache, 300), "Dew Heater");
+  EXPECT_EQ(cache.size(), 3 * 3 + 4 + 10 + 10);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(cache.dirty());
+  EXPECT_EQ(GetName(cache, 2), "");
+}
+
+TEST(SwitchNameCacheTest, RejectsInvalidNames) {
+  SwitchNameCache cache;
+  EXPECT_FALSE(cache.SetName(0, mcucore::StringView("")));
+  const std::string too_long(SwitchNameCache::kMaxNameLength + 1, 'x');
+  EXPECT_FALSE(cache.SetName(
+      0, mcucore::StringView(too_long.data(), too_long.size())));
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(cache.dirty());
+}
+
+TEST(SwitchNameCacheTest, Full) {
+  SwitchNameCache cache;
+  const std::string name(SwitchNameCache::kMaxNameLength, 'n');
+  const mcucore::StringView view(name.data(), name.size());
+  uint16_t switch_id = 0;
+  while (cache.SetName(switch_id, view)) {
+    ++switch_id;
+  }
+  EXPECT_EQ(switch_id, SwitchNameCache::kCapacity / (3 + name.size()));
+  EXPECT_EQ(GetName(cache, switch_id), "");
+
+  // There is still room to replace a name with one of the same length, and to
+  // add a shorter name if there is room for it.
+  EXPECT_TRUE(cache.SetName(0, view));
+  EXPECT_EQ(GetName(cache, 0), name);
+  const uint16_t room = SwitchNameCache::kCapacity - cache.size();
+  if (room > 3) {
+    EXPECT_TRUE(cache.SetName(switch_id, view.prefix(room - 3)));
+  }
+}
+
+TEST(SwitchNameCacheTest, WriteAndRead) {
+  EepromTlv::ClearAndInitializeEeprom();
+  auto tlv = EepromTlv::GetOrDie();
+
+  SwitchNameCache cache;
+  EXPECT_TRUE(mcucore::IsNotFound(cache.ReadFrom(tlv, MakeTag())));
+  EXPECT_EQ(cache.size(), 0);
+
+  EXPECT_TRUE(cache.SetName(1, mcucore::StringView("Telescope")));
+  EXPECT_TRUE(cache.SetName(20, mcucore::StringView("Camera")));
+  EXPECT_TRUE(cache.dirty());
+  ASSERT_STATUS_OK(cache.WriteTo(tlv, MakeTag()));
+  EXPECT_FALSE(cache.dirty());
+
+  SwitchNameCache cache2;
+  ASSERT_STATUS_OK(cache2.ReadFrom(tlv, MakeTag()));
+  EXPECT_FALSE(cache2.dirty());
+  EXPECT_EQ(cache2.size(), cache.size());
+  EXPECT_EQ(GetName(cache2, 1), "Telescope");
+  EXPECT_EQ(GetName(cache2, 20), "Camera");
+}
+
+TEST(SwitchNameCacheTest, ReadMalformed) {
+  EepromTlv::ClearAndInitializeEeprom();
+  auto tlv = EepromTlv::GetOrDie();
+
+  // The second entry is truncated.
+  const uint8_t kEntries[] = {1, 0, 2, 'h', 'i', 2, 0, 5, 'a', 'b'};
+  ASSERT_STATUS_OK(tlv.WriteEntry(MakeTag(), kEntries, sizeof kEntries));
+
+  SwitchNameCache cache;
+  EXPECT_TRUE(cache.SetName(3, mcucore::StringView("Old")));
+  EXPECT_FALSE(cache.ReadFrom(tlv, MakeTag()).ok());
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(cache.dirty());
+  EXPECT_EQ(GetName(cache, 1), "");
+  EXPECT_EQ(GetName(cache, 3), "");
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
@@ -46,6 +46,39 @@ TEST(HttpResponseHeaderTest, Error) {
                    kEOL, "Content-Length: 123", kEOL, kEOL));
 }
 
+TEST(HttpResponseHeaderTest, EventStream) {
+  HttpResponseHeader hrh;
+  hrh.status_code = EHttpStatusCode::kHttpOk;
+  hrh.reason_phrase = ProgmemStrings::OK();
+  hrh.content_type = EContentType::kTextEventStream;
+
+  mcucore::test::PrintToStdString out;
+  hrh.printTo(out);
+  EXPECT_EQ(out.str(), absl::StrCat("HTTP/1.1 200 OK", kEOL,
+                                    "Server: TinyAlpacaServer", kEOL,
+                                    "Connection: close", kEOL,
+                                    "Content-Type: text/event-stream", kEOL,
+                                    kEOL));
+}
+
+TEST(HttpResponseHeaderTest, RetryAfter) {
+  HttpResponseHeader hrh;
+  hrh.status_code = EHttpStatusCode::kHttpServiceUnavailable;
+  hrh.reason_phrase = MCU_PSD("Service Unavailable");
+  hrh.content_type = EContentType::kTextPlain;
+  hrh.content_length = 0;
+  hrh.retry_after_seconds = 7;
+
+  mcucore::test::PrintToStdString out;
+  hrh.printTo(out);
+  EXPECT_EQ(out.str(),
+            absl::StrCat("HTTP/1.1 503 Service Unavailable", kEOL,
+                         "Server: TinyAlpacaServer", kEOL, "Connection: close",
+                         kEOL, "Retry-After: 7", kEOL,
+                         "Content-Type: text/plain", kEOL, "Content-Length: 0",
+                         kEOL, kEOL));
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace alpaca
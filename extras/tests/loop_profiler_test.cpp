@@ -0,0 +1,136 @@
+#include "loop_profiler.h"
+
+#include <McuCore.h>
+
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+TEST(LoopPhaseStatsTest, Empty) {
+  LoopPhaseStats stats;
+  EXPECT_EQ(stats.count(), 0);
+  EXPECT_EQ(stats.window_count(), 0);
+  EXPECT_EQ(stats.min_micros(), 0);
+  EXPECT_EQ(stats.mean_micros(), 0);
+  EXPECT_EQ(stats.max_micros(), 0);
+  EXPECT_EQ(stats.WindowPercentile(99), 0);
+}
+
+TEST(LoopPhaseStatsTest, MinMeanMax) {
+  LoopPhaseStats stats;
+  stats.Record(300);
+  stats.Record(100);
+  stats.Record(200);
+  EXPECT_EQ(stats.count(), 3);
+  EXPECT_EQ(stats.window_count(), 3);
+  EXPECT_EQ(stats.min_micros(), 100);
+  EXPECT_EQ(stats.mean_micros(), 200);
+  EXPECT_EQ(stats.max_micros(), 300);
+  EXPECT_EQ(stats.WindowPercentile(50), 200);
+  EXPECT_EQ(stats.WindowPercentile(99), 300);
+
+  stats.Reset();
+  EXPECT_EQ(stats.count(), 0);
+  EXPECT_EQ(stats.max_micros(), 0);
+  EXPECT_EQ(stats.WindowPercentile(99), 0);
+}
+
+TEST(LoopPhaseStatsTest, PercentileIsOfRecentWindow) {
+  LoopPhaseStats stats;
+  // A slow iteration, followed by enough fast ones to push it out of the
+  // window.
+  stats.Record(50000);
+  for (int i = 0; i < LoopPhaseStats::kWindowSize; ++i) {
+    stats.Record(10 + i);
+  }
+  EXPECT_EQ(stats.count(), LoopPhaseStats::kWindowSize + 1);
+  EXPECT_EQ(stats.window_count(), LoopPhaseStats::kWindowSize);
+  EXPECT_EQ(stats.max_micros(), 50000);
+  EXPECT_EQ(stats.WindowPercentile(100), 10 + LoopPhaseStats::kWindowSize - 1);
+  EXPECT_EQ(stats.WindowPercentile(1), 10);
+
+  // A new slow iteration is the p99 of the window.
+  stats.Record(40000);
+  EXPECT_EQ(stats.WindowPercentile(99), 40000);
+}
+
+TEST(LoopPhaseStatsTest, WindowSaturates) {
+  LoopPhaseStats stats;
+  stats.Record(100000);
+  EXPECT_EQ(stats.max_micros(), 100000);
+  EXPECT_EQ(stats.mean_micros(), 100000);
+  EXPECT_EQ(stats.WindowPercentile(99), 0xFFFF);
+}
+
+TEST(LoopProfilerTest, RecordLoopStart) {
+  LoopProfiler profiler;
+  const auto& loop = profiler.phase(LoopProfiler::kLoopPhase);
+
+  // The first call has nothing to measure.
+  profiler.RecordLoopStart(1000);
+  EXPECT_EQ(loop.count(), 0);
+
+  profiler.RecordLoopStart(1400);
+  EXPECT_EQ(loop.count(), 1);
+  EXPECT_EQ(loop.max_micros(), 400);
+
+  // Handles rollover of micros().
+  profiler.RecordLoopStart(0xFFFFFF00);
+  profiler.RecordLoopStart(0x100);
+  EXPECT_EQ(loop.count(), 3);
+  EXPECT_EQ(loop.min_micros(), 400);
+  EXPECT_EQ(loop.WindowPercentile(1), 400);
+  EXPECT_EQ(loop.WindowPercentile(34), 0x200);
+}
+
+TEST(LoopProfilerTest, RecordPhases) {
+  LoopProfiler profiler;
+  profiler.RecordNetworkIO(123);
+  profiler.RecordMaintainDevice(0, 10);
+  profiler.RecordMaintainDevice(1, 20);
+  profiler.RecordMaintainDevice(1, 40);
+  // Devices beyond the limit are ignored.
+  profiler.RecordMaintainDevice(LoopProfiler::kMaxDevices, 1000);
+
+  EXPECT_EQ(profiler.phase(LoopProfiler::kNetworkIOPhase).max_micros(), 123);
+  EXPECT_EQ(profiler.phase(LoopProfiler::kFirstDevicePhase).count(), 1);
+  EXPECT_EQ(profiler.phase(LoopProfiler::kFirstDevicePhase + 1).count(), 2);
+  EXPECT_EQ(profiler.phase(LoopProfiler::kFirstDevicePhase + 1).mean_micros(),
+            30);
+  for (uint8_t ndx = 0; ndx < LoopProfiler::kNumPhases; ++ndx) {
+    EXPECT_NE(profiler.phase(ndx).max_micros(), 1000);
+  }
+}
+
+TEST(LoopProfilerTest, SnapshotIsStable) {
+  LoopProfiler profiler;
+  profiler.RecordNetworkIO(100);
+  profiler.TakeSnapshot();
+  const auto& summary = profiler.snapshot(LoopProfiler::kNetworkIOPhase);
+  EXPECT_EQ(summary.count, 1);
+  EXPECT_EQ(summary.max_micros, 100);
+  EXPECT_EQ(summary.p99_micros, 100);
+
+  // Not changed until the next snapshot.
+  profiler.RecordNetworkIO(300);
+  EXPECT_EQ(summary.count, 1);
+  EXPECT_EQ(summary.max_micros, 100);
+
+  profiler.TakeSnapshot();
+  EXPECT_EQ(summary.count, 2);
+  EXPECT_EQ(summary.min_micros, 100);
+  EXPECT_EQ(summary.mean_micros, 200);
+  EXPECT_EQ(summary.max_micros, 300);
+  EXPECT_EQ(summary.p99_micros, 300);
+
+  // Reset clears the snapshot too.
+  profiler.Reset();
+  EXPECT_EQ(summary.count, 0);
+  EXPECT_EQ(summary.max_micros, 0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
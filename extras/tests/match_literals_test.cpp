@@ -48,6 +48,7 @@ TEST(MatchLiteralsTest, EApiGroup) {
       {"management", EApiGroup::kManagement},
       {"asset", EApiGroup::kAsset},
       {"setup", EApiGroup::kSetup},
+      {"metrics", EApiGroup::kMetrics},
       {"API", EApiGroup::kUnknown},
       {"Asset", EApiGroup::kUnknown},
       {"managements", EApiGroup::kUnknown},
@@ -74,6 +75,7 @@ TEST(MatchLiteralsTest, MatchManagementMethod) {
   const std::vector<std::pair<std::string, EManagementMethod>> test_cases = {
       {"description", EManagementMethod::kDescription},
       {"configureddevices", EManagementMethod::kConfiguredDevices},
+      {"requestjournal", EManagementMethod::kRequestJournal},
       {"setup", EManagementMethod::kUnknown},
       {"api", EManagementMethod::kUnknown},
       {"Description", EManagementMethod::kUnknown},
@@ -131,13 +133,16 @@ using DeviceMethodTestCases =
 void PrependCommonDeviceMethodTestCases(DeviceMethodTestCases& test_cases) {
   const DeviceMethodTestCases kCommonDeviceMethods = {
       {"action", EDeviceMethod::kAction},
+      {"batch", EDeviceMethod::kBatch},
       {"commandblind", EDeviceMethod::kCommandBlind},
       {"commandbool", EDeviceMethod::kCommandBool},
       {"commandstring", EDeviceMethod::kCommandString},
       {"connected", EDeviceMethod::kConnected},
       {"description", EDeviceMethod::kDescription},
+      {"devicestate", EDeviceMethod::kDeviceState},
       {"driverinfo", EDeviceMethod::kDriverInfo},
       {"driverversion", EDeviceMethod::kDriverVersion},
+      {"events", EDeviceMethod::kEvents},
       {"interfaceversion", EDeviceMethod::kInterfaceVersion},
       {"name", EDeviceMethod::kName},
       {"supportedactions", EDeviceMethod::kSupportedActions},
@@ -396,12 +401,15 @@ TEST(MatchLiteralsTest, MatchParameter) {
       {"Command", EParameter::kCommand},
       {"Connected", EParameter::kConnected},
       {"Id", EParameter::kId},
+      {"IfNotEqual", EParameter::kIfNotEqual},
+      {"Method", EParameter::kMethod},
       {"Name", EParameter::kName},
       {"Parameters", EParameter::kParameters},
       {"Raw", EParameter::kRaw},
       {"SensorName", EParameter::kSensorName},
       {"State", EParameter::kState},
       {"Value", EParameter::kValue},
+      {"WaitForChangeMs", EParameter::kWaitForChangeMs},
       {"", EParameter::kUnknown},
       {"cloudcover", EParameter::kUnknown},
       {"Content-Length", EParameter::kUnknown},
@@ -460,6 +468,35 @@ TEST(MatchLiteralsTest, MatchSensorName) {
   }
 }
 
+TEST(MatchLiteralsTest, MatchDeviceAction) {
+  const std::vector<std::pair<std::string, EDeviceAction>> test_cases = {
+      {"History", EDeviceAction::kHistory},
+      {"HISTORY", EDeviceAction::kHistory},
+      {"history", EDeviceAction::kHistory},
+      {"GetAllSwitchValues", EDeviceAction::kGetAllSwitchValues},
+      {"getallswitchvalues", EDeviceAction::kGetAllSwitchValues},
+      {"SetSwitchValues", EDeviceAction::kSetSwitchValues},
+      {"SETSWITCHVALUES", EDeviceAction::kSetSwitchValues},
+      {"SetSwitchValue", EDeviceAction::kUnknown},
+      {"", EDeviceAction::kUnknown},
+      {"Histories", EDeviceAction::kUnknown},
+      {"MakeItRain", EDeviceAction::kUnknown},
+  };
+  const EDeviceAction kBogusEnum = static_cast<EDeviceAction>(0xff);
+  for (const auto [text, expected_enum] : test_cases) {
+    VLOG(1) << "Matching '" << absl::CHexEscape(text) << "', expecting "
+            << expected_enum;
+    EDeviceAction matched = kBogusEnum;
+    if (expected_enum == EDeviceAction::kUnknown) {
+      EXPECT_FALSE(MatchDeviceAction(MakeStringView(text), matched));
+      EXPECT_EQ(matched, kBogusEnum);
+    } else {
+      EXPECT_TRUE(MatchDeviceAction(MakeStringView(text), matched));
+      EXPECT_EQ(matched, expected_enum);
+    }
+  }
+}
+
 TEST(MatchLiteralsTest, EHttpHeader) {
   const std::vector<std::pair<std::string, EHttpHeader>> test_cases = {
       {"Content-LENGTH", EHttpHeader::kContentLength},
@@ -0,0 +1,71 @@
+#include "memory_usage.h"
+
+#include <McuCore.h>
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "alpaca_request.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/print_to_std_string.h"
+#include "request_decoder.h"
+#include "server_connection.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+TEST(MemoryUsageTest, StackNotMeasuredOnHost) {
+  MemoryUsage memory_usage;
+  memory_usage.Sample();
+  memory_usage.MaybeSample(TAS_MEMORY_USAGE_SAMPLE_MILLIS);
+  memory_usage.TakeSnapshot();
+  EXPECT_EQ(memory_usage.measurements().stack_peak_bytes, 0);
+  EXPECT_EQ(memory_usage.measurements().stack_headroom_bytes, 0);
+  EXPECT_EQ(memory_usage.snapshot().stack_peak_bytes, 0);
+  EXPECT_EQ(memory_usage.snapshot().stack_headroom_bytes, 0);
+}
+
+TEST(MemoryUsageTest, PrintHtml) {
+  MemoryUsage memory_usage;
+  memory_usage.TakeSnapshot();
+  mcucore::test::PrintToStdString out;
+  mcucore::OPrintStream strm(out);
+  memory_usage.PrintHtml(strm);
+  EXPECT_THAT(out.str(), HasSubstr("Memory Usage (bytes)"));
+  EXPECT_THAT(out.str(), HasSubstr(absl::StrCat(
+                             "<tr><td>sizeof(ServerConnection)</td><td>",
+                             sizeof(ServerConnection), "</td></tr>\n")));
+  EXPECT_THAT(out.str(), HasSubstr(absl::StrCat(
+                             "<tr><td>sizeof(AlpacaRequest)</td><td>",
+                             sizeof(AlpacaRequest), "</td></tr>\n")));
+  EXPECT_THAT(out.str(), HasSubstr(absl::StrCat(
+                             "<tr><td>sizeof(RequestDecoderState)</td><td>",
+                             sizeof(RequestDecoderState), "</td></tr>\n")));
+  EXPECT_THAT(out.str(), Not(HasSubstr("Stack Peak")));
+}
+
+TEST(MemoryUsageTest, PrintMetrics) {
+  MemoryUsage memory_usage;
+  memory_usage.TakeSnapshot();
+  mcucore::test::PrintToStdString out;
+  mcucore::OPrintStream strm(out);
+  memory_usage.PrintMetrics(strm);
+  EXPECT_EQ(
+      out.str(),
+      absl::StrCat("# TYPE tas_struct_size_bytes gauge\n",
+                   "tas_struct_size_bytes{struct=\"ServerConnection\"} ",
+                   sizeof(ServerConnection), "\n",
+                   "tas_struct_size_bytes{struct=\"AlpacaRequest\"} ",
+                   sizeof(AlpacaRequest), "\n",
+                   "tas_struct_size_bytes{struct=\"RequestDecoderState\"} ",
+                   sizeof(RequestDecoderState), "\n"));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
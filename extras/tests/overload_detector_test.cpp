@@ -0,0 +1,100 @@
+#include "overload_detector.h"
+
+#include <McuCore.h>
+
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+constexpr uint32_t kEnterMicros = 20000;
+constexpr uint32_t kExitMicros = 10000;
+
+// Records num_loops iterations of the loop, each taking loop_micros.
+void RunLoops(OverloadDetector& detector, uint32_t& now, int num_loops,
+              uint32_t loop_micros) {
+  for (int i = 0; i < num_loops; ++i) {
+    detector.RecordLoopStart(now);
+    now += loop_micros;
+  }
+}
+
+TEST(OverloadDetectorTest, NotOverloadedInitially) {
+  OverloadDetector detector(kEnterMicros, kExitMicros);
+  EXPECT_FALSE(detector.is_overloaded());
+  EXPECT_EQ(detector.mean_loop_micros(), 0);
+
+  // The first call has nothing to measure.
+  detector.RecordLoopStart(123456);
+  EXPECT_FALSE(detector.is_overloaded());
+  EXPECT_EQ(detector.mean_loop_micros(), 0);
+
+  // The first measurement initializes the average.
+  detector.RecordLoopStart(123456 + 500);
+  EXPECT_FALSE(detector.is_overloaded());
+  EXPECT_EQ(detector.mean_loop_micros(), 500);
+}
+
+TEST(OverloadDetectorTest, SingleSlowLoopIsTolerated) {
+  OverloadDetector detector(kEnterMicros, kExitMicros);
+  uint32_t now = 0;
+  RunLoops(detector, now, 100, 1000);
+  RunLoops(detector, now, 1, 100000);
+  RunLoops(detector, now, 1, 1000);
+  EXPECT_FALSE(detector.is_overloaded());
+  EXPECT_EQ(detector.num_overloads(), 0);
+}
+
+TEST(OverloadDetectorTest, Hysteresis) {
+  OverloadDetector detector(kEnterMicros, kExitMicros);
+  uint32_t now = 0;
+  RunLoops(detector, now, 100, 1000);
+  EXPECT_FALSE(detector.is_overloaded());
+
+  // Sustained load makes the server overloaded.
+  RunLoops(detector, now, 100, 30000);
+  EXPECT_TRUE(detector.is_overloaded());
+  EXPECT_EQ(detector.num_overloads(), 1);
+  EXPECT_GT(detector.mean_loop_micros(), kEnterMicros);
+
+  // A loop time between the two thresholds doesn't end the overload...
+  RunLoops(detector, now, 100, 15000);
+  EXPECT_TRUE(detector.is_overloaded());
+  EXPECT_LT(detector.mean_loop_micros(), kEnterMicros);
+
+  // ... but a loop time below the exit threshold does.
+  RunLoops(detector, now, 100, 5000);
+  EXPECT_FALSE(detector.is_overloaded());
+
+  // And the same intermediate loop time doesn't start another.
+  RunLoops(detector, now, 100, 15000);
+  EXPECT_FALSE(detector.is_overloaded());
+  EXPECT_EQ(detector.num_overloads(), 1);
+
+  RunLoops(detector, now, 100, 25000);
+  EXPECT_TRUE(detector.is_overloaded());
+  EXPECT_EQ(detector.num_overloads(), 2);
+}
+
+TEST(OverloadDetectorTest, HandlesMicrosRollover) {
+  OverloadDetector detector(kEnterMicros, kExitMicros);
+  uint32_t now = 0xFFFFFFFF - 20000;
+  RunLoops(detector, now, 10, 4000);
+  EXPECT_EQ(detector.mean_loop_micros(), 4000);
+  EXPECT_FALSE(detector.is_overloaded());
+}
+
+TEST(OverloadDetectorTest, CountsShedRequests) {
+  OverloadDetector detector(kEnterMicros, kExitMicros);
+  EXPECT_EQ(detector.num_shed_requests(), 0);
+  detector.RecordShedRequest();
+  detector.RecordShedRequest();
+  EXPECT_EQ(detector.num_shed_requests(), 2);
+  detector.Reset();
+  EXPECT_EQ(detector.num_shed_requests(), 0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
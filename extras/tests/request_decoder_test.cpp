@@ -556,6 +556,35 @@ TEST_F(RequestDecoderTest, SmallestConfiguredDevicesRequest) {
   }
 }
 
+TEST_F(RequestDecoderTest, RequestJournalRequest) {
+  const std::string full_request(
+      "GET /management/v1/requestjournal?ClientTransactionID=7 HTTP/1.1\r\n"
+      "\r\n");
+
+  for (auto partition : GenerateMultipleRequestPartitions(full_request)) {
+    auto result = DecodePartitionedRequest(decoder_, partition);
+
+    const EHttpStatusCode status = std::get<0>(result);
+    const std::string buffer = std::get<1>(result);
+    const std::string remainder = std::get<2>(result);
+
+    EXPECT_EQ(status, EHttpStatusCode::kHttpOk);
+    EXPECT_THAT(buffer, IsEmpty());
+    EXPECT_THAT(remainder, IsEmpty());
+    EXPECT_EQ(alpaca_request_.http_method, EHttpMethod::GET);
+    EXPECT_EQ(alpaca_request_.api_group, EApiGroup::kManagement);
+    EXPECT_EQ(alpaca_request_.api, EAlpacaApi::kManagementRequestJournal);
+    EXPECT_EQ(alpaca_request_.device_type, EDeviceType::kUnknown);
+    EXPECT_EQ(alpaca_request_.device_method, EDeviceMethod::kUnknown);
+    EXPECT_TRUE(alpaca_request_.have_client_transaction_id);
+    EXPECT_EQ(alpaca_request_.client_transaction_id, 7);
+
+    if (TestHasFailed()) {
+      break;
+    }
+  }
+}
+
 TEST_F(RequestDecoderTest, SmallestServerDescriptionRequest) {
   const std::string full_request(
       "GET /management/v1/description HTTP/1.1\r\n"
@@ -623,6 +652,52 @@ TEST_F(RequestDecoderTest, SmallestServerSetupRequest) {
   }
 }
 
+TEST_F(RequestDecoderTest, ServerMetricsRequest) {
+  const std::string full_request(
+      "GET /metrics HTTP/1.1\r\n"
+      "\r\n");
+
+  for (auto partition : GenerateMultipleRequestPartitions(full_request)) {
+    auto result = DecodePartitionedRequest(decoder_, partition);
+
+    const EHttpStatusCode status = std::get<0>(result);
+    const std::string buffer = std::get<1>(result);
+    const std::string remainder = std::get<2>(result);
+
+    EXPECT_EQ(status, EHttpStatusCode::kHttpOk);
+    EXPECT_THAT(buffer, IsEmpty());
+    EXPECT_THAT(remainder, IsEmpty());
+    EXPECT_EQ(alpaca_request_.http_method, EHttpMethod::GET);
+    EXPECT_EQ(alpaca_request_.api_group, EApiGroup::kMetrics);
+    EXPECT_EQ(alpaca_request_.api, EAlpacaApi::kServerMetrics);
+
+    EXPECT_EQ(alpaca_request_.device_type, EDeviceType::kUnknown);
+    EXPECT_EQ(alpaca_request_.device_number, kResetDeviceNumber);
+    EXPECT_EQ(alpaca_request_.device_method, EDeviceMethod::kUnknown);
+    EXPECT_FALSE(alpaca_request_.have_client_id);
+    EXPECT_FALSE(alpaca_request_.have_client_transaction_id);
+    EXPECT_EQ(GetNumExtraParameters(alpaca_request_), 0);
+
+    if (TestHasFailed()) {
+      break;
+    }
+  }
+}
+
+TEST_F(RequestDecoderTest, ServerMetricsPathTooLong) {
+  const std::string full_request(
+      "GET /metrics/foo HTTP/1.1\r\n"
+      "\r\n");
+
+  for (auto partition : GenerateMultipleRequestPartitions(full_request)) {
+    auto result = DecodePartitionedRequest(decoder_, partition);
+    EXPECT_EQ(std::get<0>(result), EHttpStatusCode::kHttpNotFound);
+    if (TestHasFailed()) {
+      break;
+    }
+  }
+}
+
 TEST_F(RequestDecoderTest, SmallestPutRequest) {
   const std::string full_request(
       "PUT /api/v1/observingconditions/0/refresh"
@@ -896,6 +971,86 @@ TEST_F(RequestDecoderTest, RequestsWithClientTransactionId) {
   }
 }
 
+#if TAS_ENABLE_BATCH_REQUESTS
+TEST_F(RequestDecoderTest, BatchRequestWithRepeatedMethodParameter) {
+  const std::string full_request(
+      "GET /api/v1/observingconditions/0/batch?Method=temperature&"
+      "method=humidity&METHOD=name&ClientTransactionID=9 HTTP/1.1\r\n\r\n");
+  for (auto partition : GenerateMultipleRequestPartitions(full_request)) {
+    auto result = DecodePartitionedRequest(decoder_, partition);
+
+    const EHttpStatusCode status = std::get<0>(result);
+    const std::string remainder = std::get<2>(result);
+    ASSERT_EQ(status, EHttpStatusCode::kHttpOk);
+    EXPECT_THAT(remainder, IsEmpty());
+    EXPECT_EQ(alpaca_request_.api, EAlpacaApi::kDeviceApi);
+    EXPECT_EQ(alpaca_request_.device_type, EDeviceType::kObservingConditions);
+    EXPECT_EQ(alpaca_request_.device_method, EDeviceMethod::kBatch);
+    ASSERT_EQ(alpaca_request_.num_batch_methods, 3);
+    EXPECT_EQ(alpaca_request_.batch_methods[0], EDeviceMethod::kTemperature);
+    EXPECT_EQ(alpaca_request_.batch_methods[1], EDeviceMethod::kHumidity);
+    EXPECT_EQ(alpaca_request_.batch_methods[2], EDeviceMethod::kName);
+    EXPECT_TRUE(alpaca_request_.have_client_transaction_id);
+    EXPECT_EQ(alpaca_request_.client_transaction_id, 9);
+  }
+}
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_LONG_POLL
+TEST_F(RequestDecoderTest, LongPollRequest) {
+  AlpacaRequest expected;
+  ASSERT_TRUE(expected.set_if_not_equal(mcucore::StringView("2")));
+
+  const std::string full_request(
+      "GET /api/v1/covercalibrator/0/coverstate?WaitForChangeMs=5000&"
+      "IfNotEqual=2 HTTP/1.1\r\n\r\n");
+  for (auto partition : GenerateMultipleRequestPartitions(full_request)) {
+    auto result = DecodePartitionedRequest(decoder_, partition);
+
+    const EHttpStatusCode status = std::get<0>(result);
+    const std::string remainder = std::get<2>(result);
+    ASSERT_EQ(status, EHttpStatusCode::kHttpOk);
+    EXPECT_THAT(remainder, IsEmpty());
+    EXPECT_EQ(alpaca_request_.device_method, EDeviceMethod::kCoverState);
+    EXPECT_TRUE(alpaca_request_.have_wait_for_change_ms);
+    EXPECT_EQ(alpaca_request_.wait_for_change_ms, 5000);
+    EXPECT_TRUE(alpaca_request_.have_if_not_equal);
+    EXPECT_EQ(alpaca_request_.if_not_equal_hash, expected.if_not_equal_hash);
+    EXPECT_FALSE(alpaca_request_.is_parked);
+  }
+}
+
+TEST(AlpacaRequestIfNotEqualTest, UrlDecodesValue) {
+  AlpacaRequest expected;
+  ASSERT_TRUE(expected.set_if_not_equal(mcucore::StringView("Open Cover")));
+  for (const auto value :
+       {"Open+Cover", "Open%20Cover", "%22Open%20Cover%22", "%4fpen+Cover"}) {
+    AlpacaRequest request;
+    ASSERT_TRUE(request.set_if_not_equal(mcucore::StringView(value)));
+    EXPECT_EQ(request.if_not_equal_hash, expected.if_not_equal_hash) << value;
+  }
+
+  // %2B is a literal '+', not a space.
+  AlpacaRequest request;
+  ASSERT_TRUE(request.set_if_not_equal(mcucore::StringView("Open%2BCover")));
+  EXPECT_NE(request.if_not_equal_hash, expected.if_not_equal_hash);
+}
+
+TEST_F(RequestDecoderTest, RejectsInvalidIfNotEqual) {
+  for (const std::string value : {"%", "%2", "%G0", "1%2"}) {
+    const std::string request = absl::StrCat(
+        "GET /api/v1/covercalibrator/0/coverstate?IfNotEqual=", value,
+        " HTTP/1.1\r\n\r\n");
+    const auto expected_status = MaybeExpectExtraParameter(
+        EParameter::kIfNotEqual, value, EHttpStatusCode::kHttpBadRequest,
+        EHttpStatusCode::kHttpBadRequest);
+    EXPECT_EQ(ResetAndDecodeFullBuffer(decoder_, request), expected_status)
+        << value;
+    EXPECT_FALSE(alpaca_request_.have_if_not_equal);
+  }
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
 TEST_F(RequestDecoderTest, ParamSeparatorsAtEndOfBody) {
   std::string body = "ClientId=876&&&&&&&&&";
 
@@ -1095,6 +1250,79 @@ TEST_F(RequestDecoderTest, DecodeMaxStringViewBody) {
   }
 }
 
+TEST_F(RequestDecoderTest, DecodesActionAndParameters) {
+  const std::vector<std::pair<std::string, EDeviceAction>> test_cases = {
+      {"History", EDeviceAction::kHistory},
+      {"HISTORY", EDeviceAction::kHistory},
+      {"MakeItRain", EDeviceAction::kUnknown},
+  };
+  for (const auto& [action_name, expected_action] : test_cases) {
+    const auto body =
+        absl::StrCat("Action=", action_name, "&Parameters=Temperature");
+    const auto full_request =
+        absl::StrCat("PUT /api/v1/observingconditions/1/action HTTP/1.1\r\n",
+                     "Content-Length: ", body.size(), "\r\n", "\r\n", body);
+
+    for (auto partition : GenerateMultipleRequestPartitions(full_request)) {
+      auto result = DecodePartitionedRequest(decoder_, partition);
+
+      EXPECT_EQ(std::get<0>(result), EHttpStatusCode::kHttpOk);
+      EXPECT_THAT(std::get<1>(result), IsEmpty());
+      EXPECT_THAT(std::get<2>(result), IsEmpty());
+      EXPECT_EQ(alpaca_request_.device_method, EDeviceMethod::kAction);
+      EXPECT_EQ(alpaca_request_.action, expected_action);
+      EXPECT_TRUE(alpaca_request_.have_string_value);
+      EXPECT_EQ(std::string(alpaca_request_.string_value.data(),
+                            alpaca_request_.string_value.size()),
+                "Temperature");
+    }
+  }
+}
+
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+TEST_F(RequestDecoderTest, DecodesSwitchValuesList) {
+  // The list is too long to fit in string_value.
+  const std::string body =
+      "Action=SetSwitchValues&Parameters=0,1.5,2,3,4,5,6,7,8,9,10,11,12,13,14";
+  const auto full_request =
+      absl::StrCat("PUT /api/v1/switch/0/action HTTP/1.1\r\n",
+                   "Content-Length: ", body.size(), "\r\n", "\r\n", body);
+
+  for (auto partition : GenerateMultipleRequestPartitions(full_request)) {
+    auto result = DecodePartitionedRequest(decoder_, partition);
+
+    EXPECT_EQ(std::get<0>(result), EHttpStatusCode::kHttpOk);
+    EXPECT_EQ(alpaca_request_.action, EDeviceAction::kSetSwitchValues);
+    EXPECT_FALSE(alpaca_request_.have_string_value);
+    ASSERT_EQ(alpaca_request_.num_switch_values, 15);
+    EXPECT_EQ(alpaca_request_.switch_values[0], 0);
+    EXPECT_EQ(alpaca_request_.switch_values[1], 1.5);
+    EXPECT_EQ(alpaca_request_.switch_values[14], 14);
+  }
+}
+
+TEST_F(RequestDecoderTest, RejectsInvalidSwitchValuesList) {
+  for (const std::string parameters : {
+           // Too long for string_value, and not a list of numbers.
+           "0,1,2,3,4,5,6,7,8,9,10,11,12,13,x",
+           "0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,",
+           // Too many values.
+           "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0",
+       }) {
+    const auto body = absl::StrCat("Parameters=", parameters);
+    auto request =
+        absl::StrCat("PUT /api/v1/switch/0/action HTTP/1.1\r\n",
+                     "Content-Length: ", body.size(), "\r\n", "\r\n", body);
+    const auto expected_status = MaybeExpectExtraParameter(
+        EParameter::kParameters, parameters, EHttpStatusCode::kHttpBadRequest,
+        EHttpStatusCode::kHttpBadRequest);
+    EXPECT_EQ(ResetAndDecodeFullBuffer(decoder_, request), expected_status)
+        << parameters;
+    EXPECT_EQ(alpaca_request_.num_switch_values, 0);
+  }
+}
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
 TEST_F(RequestDecoderTest, DetectsPayloadTooLong) {
   std::string request =
       "PUT /api/v1/safetymonitor/1/issafe HTTP/1.1\r\n"
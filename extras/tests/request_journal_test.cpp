@@ -0,0 +1,123 @@
+#include "request_journal.h"
+
+#include <McuCore.h>
+
+#include <string>
+
+#include "alpaca_request.h"
+#include "constants.h"
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/print_to_std_string.h"
+#include "server_metrics.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+RequestTimings MakeTimings(uint32_t decode_micros, uint32_t handle_micros,
+                           uint32_t write_micros) {
+  RequestTimings timings;
+  timings.decode_micros = decode_micros;
+  timings.handle_micros = handle_micros;
+  timings.write_micros = write_micros;
+  return timings;
+}
+
+AlpacaRequest MakeDeviceRequest(uint32_t server_transaction_id) {
+  AlpacaRequest request;
+  request.api = EAlpacaApi::kDeviceApi;
+  request.device_type = EDeviceType::kSwitch;
+  request.device_number = 1;
+  request.device_method = EDeviceMethod::kGetSwitchValue;
+  request.set_server_transaction_id(server_transaction_id);
+  return request;
+}
+
+TEST(ResponseOutcomeTest, RecordAndReset) {
+  ResponseOutcome::Reset();
+  EXPECT_EQ(ResponseOutcome::http_status(), EHttpStatusCode::kHttpOk);
+  EXPECT_EQ(ResponseOutcome::error_number(), 0);
+
+  ResponseOutcome::RecordHttpError(EHttpStatusCode::kHttpNotFound);
+  ResponseOutcome::RecordAscomError(0x401);
+  EXPECT_EQ(ResponseOutcome::http_status(), EHttpStatusCode::kHttpNotFound);
+  EXPECT_EQ(ResponseOutcome::error_number(), 0x401);
+
+  ResponseOutcome::Reset();
+  EXPECT_EQ(ResponseOutcome::http_status(), EHttpStatusCode::kHttpOk);
+  EXPECT_EQ(ResponseOutcome::error_number(), 0);
+}
+
+TEST(RequestJournalTest, RecordsEntry) {
+  RequestJournal journal;
+  EXPECT_EQ(journal.size(), 0);
+
+  AlpacaRequest request = MakeDeviceRequest(10);
+  request.set_client_transaction_id(99);
+  request.device_number = 1000;
+  journal.Record(request, EHttpStatusCode::kHttpOk, 0x402,
+                 MakeTimings(100, 200, 50));
+  ASSERT_EQ(journal.size(), 1);
+
+  const RequestJournalEntry& entry = journal.entry(0);
+  EXPECT_EQ(entry.server_transaction_id, 10);
+  EXPECT_EQ(entry.client_transaction_id, 99);
+  EXPECT_EQ(entry.decode_micros, 100);
+  EXPECT_EQ(entry.handle_micros, 250);
+  EXPECT_EQ(entry.http_status, 200);
+  EXPECT_EQ(entry.error_number, 0x402);
+  EXPECT_EQ(entry.api, EAlpacaApi::kDeviceApi);
+  EXPECT_EQ(entry.device_type, EDeviceType::kSwitch);
+  EXPECT_EQ(entry.device_method, EDeviceMethod::kGetSwitchValue);
+  EXPECT_EQ(entry.device_number, 255);
+
+  journal.Reset();
+  EXPECT_EQ(journal.size(), 0);
+}
+
+TEST(RequestJournalTest, OverwritesOldest) {
+  RequestJournal journal;
+  const uint32_t num_requests = RequestJournal::kSize + 2;
+  for (uint32_t id = 1; id <= num_requests; ++id) {
+    journal.Record(MakeDeviceRequest(id), EHttpStatusCode::kHttpOk, 0,
+                   MakeTimings(1, 2, 0));
+  }
+  ASSERT_EQ(journal.size(), RequestJournal::kSize);
+  for (uint8_t ndx = 0; ndx < journal.size(); ++ndx) {
+    EXPECT_EQ(journal.entry(ndx).server_transaction_id, ndx + 3);
+    // The client didn't provide a ClientTransactionID.
+    EXPECT_EQ(journal.entry(ndx).client_transaction_id, 0);
+  }
+}
+
+TEST(RequestJournalResponseTest, Json) {
+  RequestJournal journal;
+  journal.Record(MakeDeviceRequest(1), EHttpStatusCode::kHttpOk, 0x400,
+                 MakeTimings(10, 20, 0));
+  AlpacaRequest setup_request;
+  setup_request.api = EAlpacaApi::kServerSetup;
+  setup_request.set_server_transaction_id(2);
+  journal.Record(setup_request, EHttpStatusCode::kHttpServiceUnavailable, 0,
+                 MakeTimings(30, 40, 0));
+
+  AlpacaRequest request;
+  request.set_server_transaction_id(3);
+  RequestJournalResponse response(request, journal);
+  mcucore::test::PrintToStdString out;
+  mcucore::JsonObjectEncoder::Encode(response, out);
+  EXPECT_EQ(out.str(),
+            R"({"Value": [{"ServerTransactionID": 1, )"
+            R"("ClientTransactionID": 0, "Api": "DeviceApi", )"
+            R"("DeviceType": "Switch", "DeviceNumber": 1, )"
+            R"("Method": "GetSwitchValue", "HttpStatus": 200, )"
+            R"("ErrorNumber": 1024, "DecodeMicros": 10, "HandleMicros": 20}, )"
+            R"({"ServerTransactionID": 2, "ClientTransactionID": 0, )"
+            R"("Api": "ServerSetup", "HttpStatus": 503, "ErrorNumber": 0, )"
+            R"("DecodeMicros": 30, "HandleMicros": 40}], )"
+            R"("ServerTransactionID": 3, "ErrorNumber": 0, )"
+            R"("ErrorMessage": ""})");
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
@@ -0,0 +1,113 @@
+#include "request_lanes.h"
+
+#include <McuCore.h>
+
+#include <string>
+
+#include "alpaca_request.h"
+#include "constants.h"
+#include "gtest/gtest.h"
+#include "request_decoder.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+AlpacaRequest MakeRequest(EHttpMethod http_method, EDeviceMethod method) {
+  AlpacaRequest request;
+  request.http_method = http_method;
+  request.api_group = EApiGroup::kDevice;
+  request.api = EAlpacaApi::kDeviceApi;
+  request.device_type = EDeviceType::kCoverCalibrator;
+  request.device_number = 0;
+  request.device_method = method;
+  return request;
+}
+
+TEST(ClassifyRequestTest, SafetyMethodsArePriority) {
+  for (auto method :
+       {EDeviceMethod::kCalibratorOff, EDeviceMethod::kCloseCover,
+        EDeviceMethod::kHaltCover}) {
+    EXPECT_EQ(ClassifyRequest(MakeRequest(EHttpMethod::PUT, method)),
+              ERequestLane::kPriority)
+        << static_cast<int>(method);
+    EXPECT_EQ(ClassifyRequest(MakeRequest(EHttpMethod::GET, method)),
+              ERequestLane::kNormal)
+        << static_cast<int>(method);
+  }
+}
+
+TEST(ClassifyRequestTest, OtherRequestsAreNormal) {
+  for (auto method :
+       {EDeviceMethod::kOpenCover, EDeviceMethod::kCalibratorOn,
+        EDeviceMethod::kConnected, EDeviceMethod::kCoverState}) {
+    EXPECT_EQ(ClassifyRequest(MakeRequest(EHttpMethod::PUT, method)),
+              ERequestLane::kNormal)
+        << static_cast<int>(method);
+  }
+
+  AlpacaRequest request;
+  EXPECT_EQ(ClassifyRequest(request), ERequestLane::kNormal);
+}
+
+TEST(ClassifyRequestTest, PagesAndMetadataAreLow) {
+  for (auto api : {EAlpacaApi::kDeviceSetup, EAlpacaApi::kManagementApiVersions,
+                   EAlpacaApi::kManagementDescription,
+                   EAlpacaApi::kManagementConfiguredDevices, EAlpacaApi::kAsset,
+                   EAlpacaApi::kServerSetup, EAlpacaApi::kServerStatus}) {
+    AlpacaRequest request =
+        MakeRequest(EHttpMethod::GET, EDeviceMethod::kUnknown);
+    request.api = api;
+    EXPECT_EQ(ClassifyRequest(request), ERequestLane::kLow)
+        << static_cast<int>(api);
+  }
+
+  for (auto method :
+       {EDeviceMethod::kDescription, EDeviceMethod::kDriverInfo,
+        EDeviceMethod::kDriverVersion, EDeviceMethod::kInterfaceVersion,
+        EDeviceMethod::kName, EDeviceMethod::kSupportedActions}) {
+    EXPECT_EQ(ClassifyRequest(MakeRequest(EHttpMethod::GET, method)),
+              ERequestLane::kLow)
+        << static_cast<int>(method);
+  }
+}
+
+TEST(ClassifyRequestTest, ClassifiedBeforeDecodingIsComplete) {
+  AlpacaRequest request;
+  RequestDecoder decoder(request);
+  decoder.Reset();
+  EXPECT_EQ(ClassifyRequest(request), ERequestLane::kNormal);
+
+  // Just the request line, not the headers nor the body.
+  std::string input("PUT /api/v1/covercalibrator/0/closecover HTTP/1.1\r\n");
+  mcucore::StringView view(input.data(), input.size());
+  EXPECT_EQ(decoder.DecodeBuffer(view, false),
+            EHttpStatusCode::kNeedMoreInput);
+  EXPECT_EQ(ClassifyRequest(request), ERequestLane::kPriority);
+}
+
+TEST(RequestLatencyStatsTest, RecordAndAdd) {
+  RequestLatencyStats a;
+  a.Reset();
+  EXPECT_EQ(a.num_requests, 0);
+  EXPECT_EQ(a.mean_micros(), 0);
+
+  a.RecordRequest(100);
+  a.RecordRequest(300);
+  EXPECT_EQ(a.num_requests, 2);
+  EXPECT_EQ(a.total_micros, 400);
+  EXPECT_EQ(a.max_micros, 300);
+  EXPECT_EQ(a.mean_micros(), 200);
+
+  RequestLatencyStats b;
+  b.Reset();
+  b.RecordRequest(1000);
+  b.Add(a);
+  EXPECT_EQ(b.num_requests, 3);
+  EXPECT_EQ(b.total_micros, 1400);
+  EXPECT_EQ(b.max_micros, 1000);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
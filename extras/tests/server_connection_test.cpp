@@ -0,0 +1,243 @@
+#include "server_connection.h"
+
+#include <McuCore.h>
+
+#include <string>
+#include <string_view>
+
+#include "alpaca_request.h"
+#include "config.h"
+#include "constants.h"
+#include "extras/test_tools/mock_request_listener.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcunet/extras/test_tools/string_io_stream_impl.h"
+#include "response_cursor.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+using ::mcunet::test::StringIoConnection;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::IsEmpty;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::StartsWith;
+
+constexpr uint8_t kSockNum = 1;
+
+constexpr char kRequest[] =
+    "GET /api/v1/covercalibrator/0/coverstate HTTP/1.1\r\n"
+    "\r\n";
+
+class ServerConnectionTest : public testing::Test {
+ protected:
+  ServerConnectionTest() : server_connection_(listener_) {}
+
+  void Connect() {
+    StringIoConnection conn(kSockNum, "");
+    server_connection_.OnConnect(conn);
+    ASSERT_TRUE(server_connection_.has_socket());
+  }
+
+  NiceMock<MockRequestListener> listener_;
+  ServerConnection server_connection_;
+};
+
+#if TAS_ENABLE_LONG_POLL
+// Parks the request, without writing a response.
+bool ParkRequest(AlpacaRequest& request, Print& out) {
+  request.is_parked = true;
+  return true;
+}
+
+// Writes the response to a parked request.
+bool WriteParkedResponse(AlpacaRequest& request, Print& out) {
+  out.print("response");
+  request.is_parked = false;
+  return true;
+}
+
+TEST_F(ServerConnectionTest, ParkedRequestCompletesWhenWritten) {
+  Connect();
+  EXPECT_CALL(listener_, OnRequestDecoded(_, _)).WillOnce(Invoke(ParkRequest));
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  testing::MockFunction<void(int)> check;
+  {
+    testing::InSequence seq;
+    EXPECT_CALL(check, Call(1));
+    EXPECT_CALL(listener_, OnRequestCompleted(_, EHttpStatusCode::kHttpOk, _));
+    EXPECT_CALL(check, Call(2));
+    EXPECT_CALL(listener_, OnRequestCompleted(_, EHttpStatusCode::kHttpOk, _));
+  }
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+
+  StringIoConnection conn(kSockNum, kRequest);
+  server_connection_.OnCanRead(conn);
+  EXPECT_THAT(conn.output(), IsEmpty());
+  EXPECT_THAT(conn.remaining_input(), IsEmpty());
+
+  // The value hasn't changed yet.
+  EXPECT_CALL(listener_, OnParkedRequestCanWrite(_, _)).WillOnce(Return(true));
+  server_connection_.OnCanRead(conn);
+  EXPECT_THAT(conn.output(), IsEmpty());
+
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  check.Call(1);
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  EXPECT_CALL(listener_, OnParkedRequestCanWrite(_, _))
+      .WillOnce(Invoke(WriteParkedResponse));
+  server_connection_.OnCanRead(conn);
+  EXPECT_EQ(conn.output(), "response");
+  EXPECT_TRUE(conn.connected());
+  EXPECT_TRUE(server_connection_.has_socket());
+
+  // The next request is decoded and dispatched as usual.
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  check.Call(2);
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  StringIoConnection conn2(kSockNum, kRequest);
+  EXPECT_CALL(listener_, OnRequestDecoded(_, _)).WillOnce(Return(true));
+  server_connection_.OnCanRead(conn2);
+  EXPECT_THAT(conn2.remaining_input(), IsEmpty());
+}
+
+TEST_F(ServerConnectionTest, ParkedRequestClosedByListener) {
+  Connect();
+  EXPECT_CALL(listener_, OnRequestDecoded(_, _)).WillOnce(Invoke(ParkRequest));
+  StringIoConnection conn(kSockNum, kRequest);
+  server_connection_.OnCanRead(conn);
+
+  EXPECT_CALL(listener_, OnParkedRequestCanWrite(_, _)).WillOnce(Return(false));
+  server_connection_.OnCanRead(conn);
+  EXPECT_FALSE(conn.connected());
+  EXPECT_FALSE(server_connection_.has_socket());
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+// A connection with room for just 25 bytes in its transmit buffer.
+class SmallBufferConnection : public StringIoConnection {
+ public:
+  explicit SmallBufferConnection(std::string_view input)
+      : StringIoConnection(kSockNum, input) {}
+
+  int availableForWrite() override { return 25; }
+};
+
+// Has the response written in parts, by OnResumableResponseCanWrite.
+bool StartResumableResponse(AlpacaRequest& request, Print& out) {
+  request.has_resumable_response = true;
+  return true;
+}
+
+// Writes a response made up of four 10 byte parts.
+void WriteTenBytePart(const AlpacaRequest& request, ResponseCursor& cursor,
+                      Print& out) {
+  out.print("0123456789");
+  cursor.is_complete = ++cursor.item == 4;
+}
+
+TEST_F(ServerConnectionTest, ResumableResponseWrittenAsSpaceAllows) {
+  Connect();
+  EXPECT_CALL(listener_, OnRequestDecoded(_, _))
+      .WillOnce(Invoke(StartResumableResponse));
+  EXPECT_CALL(listener_, OnResumableResponseCanWrite(_, _, _))
+      .WillRepeatedly(Invoke(WriteTenBytePart));
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  testing::MockFunction<void(int)> check;
+  {
+    testing::InSequence seq;
+    EXPECT_CALL(check, Call(1));
+    EXPECT_CALL(listener_, OnRequestCompleted(_, EHttpStatusCode::kHttpOk, _));
+  }
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+
+  // The request is decoded, and the first two parts fit in the space.
+  SmallBufferConnection conn(kRequest);
+  server_connection_.OnCanRead(conn);
+  EXPECT_THAT(conn.remaining_input(), IsEmpty());
+  EXPECT_EQ(conn.output(), "01234567890123456789");
+  EXPECT_TRUE(conn.connected());
+  EXPECT_TRUE(server_connection_.has_socket());
+
+  // The client has acknowledged those, so the last two parts are written, and
+  // the connection is closed, as the response has no Content-Length.
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  check.Call(1);
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  SmallBufferConnection conn2("");
+  server_connection_.OnCanRead(conn2);
+  EXPECT_EQ(conn2.output(), "01234567890123456789");
+  EXPECT_FALSE(conn2.connected());
+  EXPECT_FALSE(server_connection_.has_socket());
+}
+
+// A connection which doesn't report the space in its transmit buffer, i.e.
+// which has Print's default availableForWrite().
+class UnknownSpaceConnection : public StringIoConnection {
+ public:
+  explicit UnknownSpaceConnection(std::string_view input)
+      : StringIoConnection(kSockNum, input) {}
+
+  int availableForWrite() override { return 0; }
+};
+
+TEST_F(ServerConnectionTest, ResumableResponseWrittenIfSpaceUnknown) {
+  static_assert(40 <= TAS_WRITE_BYTES_IF_SPACE_UNKNOWN);
+  Connect();
+  EXPECT_CALL(listener_, OnRequestDecoded(_, _))
+      .WillOnce(Invoke(StartResumableResponse));
+  EXPECT_CALL(listener_, OnResumableResponseCanWrite(_, _, _))
+      .WillRepeatedly(Invoke(WriteTenBytePart));
+
+  UnknownSpaceConnection conn(kRequest);
+  server_connection_.OnCanRead(conn);
+  EXPECT_EQ(conn.output(), "0123456789012345678901234567890123456789");
+  EXPECT_FALSE(conn.connected());
+  EXPECT_FALSE(server_connection_.has_socket());
+}
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+TEST_F(ServerConnectionTest, LowLaneRequestShed) {
+  Connect();
+  EXPECT_CALL(listener_, ShouldShedRequest(_)).WillOnce(Return(true));
+  EXPECT_CALL(listener_, OnRequestDecoded(_, _)).Times(0);
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  EXPECT_CALL(listener_, OnRequestCompleted(_, EHttpStatusCode::kHttpOk, _));
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+
+  StringIoConnection conn(kSockNum, "GET /setup HTTP/1.1\r\n\r\n");
+  server_connection_.OnCanRead(conn);
+  EXPECT_THAT(conn.output(), StartsWith("HTTP/1.1 503 Service Unavailable"));
+  EXPECT_FALSE(conn.connected());
+  EXPECT_FALSE(server_connection_.has_socket());
+}
+
+TEST_F(ServerConnectionTest, LowLaneRequestNotShed) {
+  Connect();
+  EXPECT_CALL(listener_, ShouldShedRequest(_)).WillOnce(Return(false));
+  EXPECT_CALL(listener_, OnRequestDecoded(_, _)).WillOnce(Return(true));
+
+  StringIoConnection conn(kSockNum, "GET /setup HTTP/1.1\r\n\r\n");
+  server_connection_.OnCanRead(conn);
+  EXPECT_TRUE(conn.connected());
+}
+
+TEST_F(ServerConnectionTest, OnlyLowLaneRequestsMayBeShed) {
+  Connect();
+  EXPECT_CALL(listener_, ShouldShedRequest(_)).Times(0);
+  EXPECT_CALL(listener_, OnRequestDecoded(_, _)).WillOnce(Return(true));
+
+  StringIoConnection conn(kSockNum, kRequest);
+  server_connection_.OnCanRead(conn);
+  EXPECT_TRUE(conn.connected());
+}
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
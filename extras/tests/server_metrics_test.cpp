@@ -0,0 +1,178 @@
+#include "server_metrics.h"
+
+#include <McuCore.h>
+
+#include <string>
+
+#include "alpaca_request.h"
+#include "constants.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/print_to_std_string.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+RequestTimings MakeTimings(uint32_t decode_micros, uint32_t handle_micros,
+                           uint32_t write_micros) {
+  RequestTimings timings;
+  timings.decode_micros = decode_micros;
+  timings.handle_micros = handle_micros;
+  timings.write_micros = write_micros;
+  return timings;
+}
+
+AlpacaRequest MakeDeviceApiRequest(EDeviceMethod method) {
+  AlpacaRequest request;
+  request.Reset();
+  request.http_method = EHttpMethod::GET;
+  request.api = EAlpacaApi::kDeviceApi;
+  request.device_method = method;
+  return request;
+}
+
+std::string PrintMetrics(const ServerMetrics& metrics) {
+  mcucore::test::PrintToStdString out;
+  metrics.printTo(out);
+  return out.str();
+}
+
+TEST(Log2HistogramTest, BucketIndex) {
+  EXPECT_EQ(Log2Histogram::BucketIndex(0), 0);
+  EXPECT_EQ(Log2Histogram::BucketIndex(16), 0);
+  EXPECT_EQ(Log2Histogram::BucketIndex(17), 1);
+  EXPECT_EQ(Log2Histogram::BucketIndex(32), 1);
+  EXPECT_EQ(Log2Histogram::BucketIndex(33), 2);
+  EXPECT_EQ(Log2Histogram::BucketIndex(1000), 6);
+  EXPECT_EQ(Log2Histogram::BucketIndex(1024), 6);
+  EXPECT_EQ(Log2Histogram::BucketIndex(1025), 7);
+  EXPECT_EQ(Log2Histogram::BucketIndex(262144), 14);
+  EXPECT_EQ(Log2Histogram::BucketIndex(262145), 15);
+  EXPECT_EQ(Log2Histogram::BucketIndex(0xFFFFFFFF), 15);
+
+  // Each duration is within the bounds of its bucket.
+  for (uint32_t micros = 1; micros < 300000; micros += 7) {
+    const auto ndx = Log2Histogram::BucketIndex(micros);
+    if (ndx + 1 < Log2Histogram::kNumBuckets) {
+      EXPECT_LE(micros, Log2Histogram::BucketUpperBound(ndx)) << micros;
+    }
+    if (ndx > 0) {
+      EXPECT_GT(micros, Log2Histogram::BucketUpperBound(ndx - 1)) << micros;
+    }
+  }
+}
+
+TEST(Log2HistogramTest, Record) {
+  Log2Histogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  histogram.Record(10);
+  histogram.Record(12);
+  histogram.Record(500);
+  histogram.Record(1000000);
+  EXPECT_EQ(histogram.count(), 4);
+  EXPECT_EQ(histogram.sum_micros(), 1000522);
+  EXPECT_EQ(histogram.bucket_count(0), 2);
+  EXPECT_EQ(histogram.bucket_count(5), 1);
+  EXPECT_EQ(histogram.bucket_count(Log2Histogram::kNumBuckets - 1), 1);
+  histogram.Reset();
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.bucket_count(0), 0);
+}
+
+TEST(ServerMetricsTest, CountsRequests) {
+  ServerMetrics metrics;
+  metrics.RecordRequest(MakeDeviceApiRequest(EDeviceMethod::kConnected),
+                        MakeTimings(100, 200, 0));
+  metrics.RecordRequest(MakeDeviceApiRequest(EDeviceMethod::kConnected),
+                        MakeTimings(100, 200, 0));
+  metrics.RecordRequest(MakeDeviceApiRequest(EDeviceMethod::kBrightness),
+                        MakeTimings(100, 200, 3000));
+  AlpacaRequest request;
+  request.Reset();
+  request.api = EAlpacaApi::kServerStatus;
+  metrics.RecordRequest(request, MakeTimings(50, 5000, 20000));
+
+  EXPECT_EQ(metrics.api_count(EAlpacaApi::kDeviceApi), 3);
+  EXPECT_EQ(metrics.api_count(EAlpacaApi::kServerStatus), 1);
+  EXPECT_EQ(metrics.api_count(EAlpacaApi::kServerSetup), 0);
+  EXPECT_EQ(metrics.device_method_count(EDeviceMethod::kConnected), 2);
+  EXPECT_EQ(metrics.device_method_count(EDeviceMethod::kBrightness), 1);
+  EXPECT_EQ(metrics.device_method_count(EDeviceMethod::kUnknown), 0);
+  EXPECT_EQ(metrics.decode_micros().count(), 4);
+  EXPECT_EQ(metrics.handle_micros().sum_micros(), 5600);
+  EXPECT_EQ(metrics.write_micros().sum_micros(), 23000);
+}
+
+TEST(ServerMetricsTest, CountsDecodingErrors) {
+  ServerMetrics metrics;
+  const EHttpStatusCode kStatusCodes[] = {
+      EHttpStatusCode::kHttpBadRequest,
+      EHttpStatusCode::kHttpNotFound,
+      EHttpStatusCode::kHttpMethodNotAllowed,
+      EHttpStatusCode::kHttpNotAcceptable,
+      EHttpStatusCode::kHttpLengthRequired,
+      EHttpStatusCode::kHttpPayloadTooLarge,
+      EHttpStatusCode::kHttpUnsupportedMediaType,
+      EHttpStatusCode::kHttpRequestHeaderFieldsTooLarge,
+  };
+  static_assert(sizeof kStatusCodes / sizeof kStatusCodes[0] >
+                    ServerMetrics::kMaxDecodingErrorCodes,
+                "Need more status codes than are counted separately.");
+  for (const auto status : kStatusCodes) {
+    metrics.RecordDecodingError(status, MakeTimings(10, 10, 0));
+  }
+  metrics.RecordDecodingError(EHttpStatusCode::kHttpBadRequest,
+                              MakeTimings(10, 10, 0));
+
+  EXPECT_EQ(metrics.decoding_error_count(EHttpStatusCode::kHttpBadRequest), 2);
+  EXPECT_EQ(metrics.decoding_error_count(EHttpStatusCode::kHttpNotFound), 1);
+  EXPECT_EQ(metrics.decoding_error_count(
+                EHttpStatusCode::kHttpRequestHeaderFieldsTooLarge),
+            0);
+  EXPECT_EQ(metrics.decode_micros().count(), 9);
+  EXPECT_EQ(metrics.write_micros().count(), 0);
+  EXPECT_EQ(metrics.api_count(EAlpacaApi::kUnknown), 0);
+
+  const auto text = PrintMetrics(metrics);
+  EXPECT_THAT(text, HasSubstr("tas_decoding_errors_total{code=\"400\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("tas_decoding_errors_total{code=\"404\"} 1\n"));
+  EXPECT_THAT(text, HasSubstr("tas_decoding_errors_total{code=\"other\"} 2\n"));
+}
+
+TEST(ServerMetricsTest, PrometheusTextFormat) {
+  ServerMetrics metrics;
+  metrics.RecordRequest(MakeDeviceApiRequest(EDeviceMethod::kConnected),
+                        MakeTimings(20, 100, 0));
+  metrics.RecordRequest(MakeDeviceApiRequest(EDeviceMethod::kConnected),
+                        MakeTimings(40, 5000, 0));
+
+  const auto text = PrintMetrics(metrics);
+  EXPECT_THAT(text, HasSubstr("# TYPE tas_request_micros histogram\n"));
+  EXPECT_THAT(text, HasSubstr("tas_request_micros_bucket{phase=\"decode\","
+                              "le=\"16\"} 0\n"));
+  EXPECT_THAT(text, HasSubstr("tas_request_micros_bucket{phase=\"decode\","
+                              "le=\"32\"} 1\n"));
+  EXPECT_THAT(text, HasSubstr("tas_request_micros_bucket{phase=\"decode\","
+                              "le=\"64\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("tas_request_micros_bucket{phase=\"decode\","
+                              "le=\"+Inf\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("tas_request_micros_sum{phase=\"decode\"} 60\n"));
+  EXPECT_THAT(text,
+              HasSubstr("tas_request_micros_count{phase=\"handle\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("tas_request_micros_bucket{phase=\"write\","
+                              "le=\"16\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE tas_requests_total counter\n"
+                              "tas_requests_total{api=\"DeviceApi\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("tas_device_method_requests_total"
+                              "{method=\"Connected\"} 2\n"));
+  EXPECT_THAT(text, Not(HasSubstr("\r")));
+  EXPECT_THAT(text, Not(HasSubstr("ServerStatus")));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
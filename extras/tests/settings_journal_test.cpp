@@ -0,0 +1,274 @@
+#include "settings_journal.h"
+
+#include <McuCore.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "config.h"
+#include "eeprom_ids.h"
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/status_test_utils.h"
+
+MCU_DEFINE_DOMAIN(78);
+
+namespace alpaca {
+namespace test {
+namespace {
+
+using ::mcucore::EepromTlv;
+
+constexpr uint32_t kDelay = TAS_SETTINGS_WRITE_DELAY_MILLIS;
+
+mcucore::EepromTag MakeTag(uint8_t id) {
+  return {.domain = MCU_DOMAIN(78), .id = id};
+}
+
+std::string Get(const SettingsJournal& journal, uint8_t id) {
+  const auto value = journal.Get(MakeTag(id));
+  return std::string(value.data(), value.size());
+}
+
+bool Set(SettingsJournal& journal, uint8_t id, const std::string& value) {
+  return journal.Set(MakeTag(id),
+                     mcucore::StringView(value.data(), value.size()));
+}
+
+class SettingsJournalTest : public testing::Test {
+ protected:
+  void SetUp() override { EepromTlv::ClearAndInitializeEeprom(); }
+
+  // Calls Maintain, advancing the time, until there is nothing left to write.
+  void WriteAll(SettingsJournal& journal) {
+    for (int i = 0; i < 100 && journal.pending(); ++i) {
+      journal.Maintain(EepromTlv::GetOrDie(), now_);
+      now_ += kDelay;
+      journal.Maintain(EepromTlv::GetOrDie(), now_);
+    }
+    EXPECT_FALSE(journal.pending());
+  }
+
+  // Loads the journal from EEPROM.
+  void Reload(SettingsJournal& journal) {
+    EXPECT_STATUS_OK(journal.Load(EepromTlv::GetOrDie()));
+    EXPECT_FALSE(journal.pending());
+  }
+
+  uint32_t now_ = 1000;
+};
+
+TEST_F(SettingsJournalTest, SetAndGet) {
+  SettingsJournal journal;
+  EXPECT_EQ(journal.size(), 0);
+  EXPECT_FALSE(journal.pending());
+  EXPECT_EQ(Get(journal, 1), "");
+
+  EXPECT_TRUE(Set(journal, 1, "Backyard"));
+  EXPECT_TRUE(Set(journal, 2, "Weather Station"));
+  EXPECT_TRUE(journal.pending());
+  EXPECT_EQ(Get(journal, 1), "Backyard");
+  EXPECT_EQ(Get(journal, 2), "Weather Station");
+  EXPECT_EQ(Get(journal, 3), "");
+
+  EXPECT_TRUE(Set(journal, 1, "Roof"));
+  EXPECT_EQ(Get(journal, 1), "Roof");
+  EXPECT_EQ(journal.size(), 2 * 3 + 4 + 15);
+
+  // Removing a setting.
+  EXPECT_TRUE(Set(journal, 2, ""));
+  EXPECT_EQ(Get(journal, 2), "");
+
+  // Too long.
+  EXPECT_FALSE(
+      Set(journal, 3, std::string(SettingsJournal::kMaxValueLength + 1, 'x')));
+  EXPECT_EQ(Get(journal, 3), "");
+}
+
+TEST_F(SettingsJournalTest, Full) {
+  SettingsJournal journal;
+  const std::string value(SettingsJournal::kMaxValueLength, 'v');
+  uint8_t id = 0;
+  while (Set(journal, id, value)) {
+    ++id;
+  }
+  EXPECT_EQ(id, SettingsJournal::kCapacity / (3 + value.size()));
+  EXPECT_EQ(Get(journal, id), "");
+
+  // A setting can still be replaced by one of the same length.
+  EXPECT_TRUE(Set(journal, 0, std::string(value.size(), 'w')));
+}
+
+TEST_F(SettingsJournalTest, WritesAfterDelay) {
+  SettingsJournal journal;
+  EXPECT_TRUE(Set(journal, 1, "One"));
+
+  // The first call notes the time of the change, and no write is made until
+  // there have been no changes for the delay.
+  journal.Maintain(EepromTlv::GetOrDie(), now_);
+  journal.Maintain(EepromTlv::GetOrDie(), now_ + kDelay - 1);
+  EXPECT_TRUE(journal.pending());
+  {
+    SettingsJournal loaded;
+    Reload(loaded);
+    EXPECT_EQ(Get(loaded, 1), "");
+  }
+
+  // Another change restarts the delay.
+  EXPECT_TRUE(Set(journal, 2, "Two"));
+  journal.Maintain(EepromTlv::GetOrDie(), now_ + kDelay);
+  journal.Maintain(EepromTlv::GetOrDie(), now_ + kDelay + 1);
+  EXPECT_TRUE(journal.pending());
+
+  // One setting is written per call.
+  journal.Maintain(EepromTlv::GetOrDie(), now_ + 2 * kDelay);
+  EXPECT_TRUE(journal.pending());
+  {
+    SettingsJournal loaded;
+    Reload(loaded);
+    EXPECT_EQ(Get(loaded, 1), "One");
+    EXPECT_EQ(Get(loaded, 2), "");
+  }
+  journal.Maintain(EepromTlv::GetOrDie(), now_ + 2 * kDelay);
+  EXPECT_FALSE(journal.pending());
+  {
+    SettingsJournal loaded;
+    Reload(loaded);
+    EXPECT_EQ(Get(loaded, 1), "One");
+    EXPECT_EQ(Get(loaded, 2), "Two");
+  }
+}
+
+TEST_F(SettingsJournalTest, ChangesSurviveCompaction) {
+  SettingsJournal journal;
+  // Make many more changes than there are records in the journal, so that it
+  // is compacted several times.
+  for (int round = 0; round < 5 * SettingsJournal::kNumRecords; ++round) {
+    const std::string value = "value " + std::to_string(round);
+    EXPECT_TRUE(Set(journal, round % 3, value));
+    if (round % 2) {
+      EXPECT_TRUE(Set(journal, 10, ""));
+    } else {
+      EXPECT_TRUE(Set(journal, 10, value));
+    }
+    WriteAll(journal);
+
+    SettingsJournal loaded;
+    Reload(loaded);
+    for (uint8_t id : {0, 1, 2, 10}) {
+      EXPECT_EQ(Get(loaded, id), Get(journal, id))
+          << "round " << round << ", id " << static_cast<int>(id);
+    }
+    EXPECT_EQ(loaded.size(), journal.size());
+  }
+}
+
+TEST_F(SettingsJournalTest, UnchangedValuesAreNotWritten) {
+  SettingsJournal journal;
+  EXPECT_TRUE(Set(journal, 1, "Same"));
+  WriteAll(journal);
+  EXPECT_TRUE(Set(journal, 1, "Same"));
+  EXPECT_TRUE(Set(journal, 2, ""));
+  EXPECT_FALSE(journal.pending());
+}
+
+// Steps through writing a change to EEPROM one call at a time, checking after
+// each call that EEPROM holds either the old or the new value, including while
+// the snapshot is part way through being written.
+TEST_F(SettingsJournalTest, SnapshotIsWrittenInChunks) {
+  SettingsJournal journal;
+  const std::string value(25, 'v');
+  for (uint8_t id = 1; id <= 3; ++id) {
+    EXPECT_TRUE(Set(journal, id, value));
+  }
+  WriteAll(journal);
+
+  // Change the setting until the ring of records is full, and the change is
+  // written as a snapshot.
+  bool wrote_snapshot = false;
+  for (int round = 0; round <= SettingsJournal::kNumRecords && !wrote_snapshot;
+       ++round) {
+    const std::string old_value = Get(journal, 1);
+    const std::string new_value(25, 'a' + round);
+    EXPECT_TRUE(Set(journal, 1, new_value));
+    journal.Maintain(EepromTlv::GetOrDie(), now_);
+    now_ += kDelay;
+    int writes = 0;
+    while (journal.pending() && writes < 10) {
+      journal.Maintain(EepromTlv::GetOrDie(), now_);
+      ++writes;
+      SettingsJournal loaded;
+      Reload(loaded);
+      EXPECT_EQ(Get(loaded, 1), journal.pending() ? old_value : new_value);
+      EXPECT_EQ(Get(loaded, 2), value);
+      EXPECT_EQ(Get(loaded, 3), value);
+    }
+    EXPECT_FALSE(journal.pending());
+    if (writes > 1) {
+      wrote_snapshot = true;
+      EXPECT_EQ(writes, (journal.size() + SettingsJournal::kSnapshotChunkSize -
+                         1) / SettingsJournal::kSnapshotChunkSize);
+    }
+  }
+  EXPECT_TRUE(wrote_snapshot);
+}
+
+TEST_F(SettingsJournalTest, ChangeRestartsSnapshot) {
+  SettingsJournal journal;
+  const std::string value(25, 'v');
+  for (uint8_t id = 1; id <= 3; ++id) {
+    EXPECT_TRUE(Set(journal, id, value));
+  }
+  WriteAll(journal);
+
+  // Change the setting until a snapshot is part way through being written.
+  bool in_snapshot = false;
+  for (int round = 0; round <= SettingsJournal::kNumRecords && !in_snapshot;
+       ++round) {
+    EXPECT_TRUE(Set(journal, 1, std::string(25, 'a' + round)));
+    journal.Maintain(EepromTlv::GetOrDie(), now_);
+    now_ += kDelay;
+    journal.Maintain(EepromTlv::GetOrDie(), now_);
+    in_snapshot = journal.pending();
+  }
+  ASSERT_TRUE(in_snapshot);
+
+  // Another change while the snapshot is being written.
+  EXPECT_TRUE(Set(journal, 2, "Changed"));
+  journal.Maintain(EepromTlv::GetOrDie(), now_);
+  now_ += kDelay;
+  journal.Maintain(EepromTlv::GetOrDie(), now_);
+  {
+    // The chunks of the abandoned snapshot aren't mistaken for the new one.
+    SettingsJournal loaded;
+    Reload(loaded);
+    EXPECT_EQ(Get(loaded, 2), value);
+  }
+  WriteAll(journal);
+
+  SettingsJournal loaded;
+  Reload(loaded);
+  for (uint8_t id = 1; id <= 3; ++id) {
+    EXPECT_EQ(Get(loaded, id), Get(journal, id));
+  }
+  EXPECT_EQ(Get(loaded, 2), "Changed");
+  EXPECT_EQ(loaded.size(), journal.size());
+}
+
+TEST_F(SettingsJournalTest, LoadMalformedSnapshot) {
+  // The sequence number and size of the snapshot, then the entries, of which
+  // the second is truncated.
+  const uint8_t kSnapshot[] = {0, 0, 9, 0, 78, 1, 2, 'h', 'i', 78, 2, 5, 'a'};
+  ASSERT_STATUS_OK(EepromTlv::GetOrDie().WriteEntry(
+      {.domain = SettingsJournal::ServerDomain(),
+       .id = kSettingsSnapshotFirstId},
+      kSnapshot, sizeof kSnapshot));
+
+  SettingsJournal journal;
+  EXPECT_FALSE(journal.Load(EepromTlv::GetOrDie()).ok());
+  EXPECT_EQ(journal.size(), 0);
+  EXPECT_EQ(Get(journal, 1), "");
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
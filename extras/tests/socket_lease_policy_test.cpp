@@ -0,0 +1,116 @@
+#include "socket_lease_policy.h"
+
+#include <McuCore.h>
+
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+SocketPoolState MakeState(uint8_t num_listening, uint8_t num_connected,
+                          uint8_t num_unleased) {
+  SocketPoolState state;
+  state.num_listening = num_listening;
+  state.num_connected = num_connected;
+  state.num_unleased = num_unleased;
+  return state;
+}
+
+TEST(SocketLeasePolicyTest, LeasesFirstListeningSocket) {
+  SocketLeasePolicy policy(/*min_listening=*/1, /*max_leased=*/3);
+  EXPECT_EQ(policy.Decide(MakeState(0, 0, 4)), ESocketPoolAction::kLease);
+  // Even if that exceeds the maximum, so that a client can always connect.
+  EXPECT_EQ(policy.Decide(MakeState(0, 3, 1)), ESocketPoolAction::kLease);
+  // But not if there are no connections to lease for.
+  EXPECT_EQ(policy.Decide(MakeState(0, 4, 0)), ESocketPoolAction::kNone);
+}
+
+TEST(SocketLeasePolicyTest, RespectsMaxLeased) {
+  SocketLeasePolicy policy(/*min_listening=*/2, /*max_leased=*/3);
+  EXPECT_EQ(policy.Decide(MakeState(1, 1, 2)), ESocketPoolAction::kLease);
+  EXPECT_EQ(policy.Decide(MakeState(1, 2, 1)), ESocketPoolAction::kNone);
+  EXPECT_EQ(policy.Decide(MakeState(2, 1, 1)), ESocketPoolAction::kNone);
+}
+
+TEST(SocketLeasePolicyTest, SteadyState) {
+  SocketLeasePolicy policy(/*min_listening=*/1, /*max_leased=*/6);
+  EXPECT_EQ(policy.Decide(MakeState(1, 0, 3)), ESocketPoolAction::kNone);
+  EXPECT_EQ(policy.Decide(MakeState(1, 3, 0)), ESocketPoolAction::kNone);
+}
+
+TEST(SocketLeasePolicyTest, KeepsListeningSocketsAfterDisconnects) {
+  SocketLeasePolicy policy(/*min_listening=*/1, /*max_leased=*/6);
+  // E.g. after two clients have disconnected.
+  EXPECT_EQ(policy.Decide(MakeState(3, 0, 1)), ESocketPoolAction::kNone);
+  EXPECT_EQ(policy.Decide(MakeState(2, 0, 2)), ESocketPoolAction::kNone);
+}
+
+TEST(SocketLeasePolicyTest, LeasesAllByDefault) {
+  // With the default configuration, every connection is leased a socket, as
+  // when each connection had a dedicated socket.
+  SocketLeasePolicy policy(/*min_listening=*/3, /*max_leased=*/7);
+  EXPECT_EQ(policy.Decide(MakeState(0, 0, 3)), ESocketPoolAction::kLease);
+  EXPECT_EQ(policy.Decide(MakeState(2, 0, 1)), ESocketPoolAction::kLease);
+  EXPECT_EQ(policy.Decide(MakeState(3, 0, 0)), ESocketPoolAction::kNone);
+  // A connection that couldn't be leased a socket is leased one later.
+  EXPECT_EQ(policy.Decide(MakeState(1, 1, 1)), ESocketPoolAction::kLease);
+}
+
+// Simulates clients connecting to and disconnecting from a server with 4
+// connections which may lease at most 3 hardware sockets, applying the policy's
+// decisions after each event.
+TEST(SocketLeasePolicyTest, SimulatedClients) {
+  constexpr uint8_t kNumConnections = 4;
+  SocketLeasePolicy policy(/*min_listening=*/1, /*max_leased=*/3);
+  SocketPoolState state = MakeState(0, 0, kNumConnections);
+
+  auto apply_policy = [&]() {
+    while (true) {
+      const auto action = policy.Decide(state);
+      if (action == ESocketPoolAction::kLease) {
+        --state.num_unleased;
+        ++state.num_listening;
+      } else {
+        return;
+      }
+    }
+  };
+  auto connect = [&]() {
+    ASSERT_GT(state.num_listening, 0);
+    --state.num_listening;
+    ++state.num_connected;
+    apply_policy();
+  };
+  auto disconnect = [&]() {
+    ASSERT_GT(state.num_connected, 0);
+    --state.num_connected;
+    ++state.num_listening;
+    apply_policy();
+  };
+
+  apply_policy();
+  EXPECT_EQ(state.num_listening, 1);
+
+  // Up to kNumConnections clients can connect; there is always a listening
+  // socket until every connection is in use, even though that is more sockets
+  // than max_leased.
+  for (uint8_t n = 1; n <= kNumConnections; ++n) {
+    connect();
+    EXPECT_EQ(state.num_connected, n);
+    EXPECT_EQ(state.num_listening, n < kNumConnections ? 1 : 0);
+  }
+  EXPECT_EQ(state.num_unleased, 0);
+
+  // As clients disconnect, the sockets listen again, and are kept.
+  for (uint8_t n = kNumConnections; n > 0; --n) {
+    disconnect();
+    EXPECT_EQ(state.num_connected, n - 1);
+    EXPECT_EQ(state.num_listening, kNumConnections - n + 1);
+  }
+  EXPECT_EQ(state.num_unleased, 0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
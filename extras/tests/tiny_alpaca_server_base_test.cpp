@@ -26,6 +26,8 @@ namespace {
 using ::alpaca::ServerDescription;
 using ::mcucore::test::HttpRequest;
 using ::mcucore::test::HttpResponse;
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::StartsWith;
 
@@ -119,6 +121,68 @@ TEST_F(TinyAlpacaServerBaseTest, ServerStatus) {
             << response.body_and_beyond << "\n\n";
 }
 
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+TEST_F(TinyAlpacaServerBaseTest, ServerStatusWrittenInParts) {
+  // At first the connection doesn't report the space in the socket's transmit
+  // buffer (i.e. Print::availableForWrite's default of zero), so only the first
+  // TAS_WRITE_BYTES_IF_SPACE_UNKNOWN bytes (or the first part) are written.
+  server_->set_available_for_write(0);
+  auto result = server_->AnnounceConnect("GET / HTTP/1.1\r\n\r\n");
+  EXPECT_THAT(result.remaining_input, IsEmpty());
+  EXPECT_FALSE(result.output.empty());
+  EXPECT_FALSE(result.connection_closed);
+  std::string response_str = result.output;
+
+  // Once the space is known, and small, the page is written a part per pass,
+  // until it is complete, and then the connection is closed.
+  server_->set_available_for_write(64);
+  int passes = 0;
+  while (!result.connection_closed && passes < 1000) {
+    result = server_->AnnounceCanRead("", /*repeat_until_stable=*/false);
+    EXPECT_FALSE(result.output.empty());
+    response_str += result.output;
+    ++passes;
+  }
+  EXPECT_TRUE(result.connection_closed);
+  EXPECT_GT(passes, 5);
+#if TAS_ENABLE_METRICS
+  EXPECT_EQ(server_->metrics().api_count(EAlpacaApi::kServerStatus), 1);
+#endif  // TAS_ENABLE_METRICS
+
+  ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+  EXPECT_EQ(response.status_code, 200);
+  EXPECT_FALSE(response.HasHeader("CONTENT-LENGTH"));
+  EXPECT_THAT(response.body_and_beyond, StartsWith("<html>"));
+  EXPECT_THAT(response.body_and_beyond, HasSubstr("Tiny Alpaca Server</a>"));
+  EXPECT_THAT(response.body_and_beyond, HasSubstr("Configured Devices"));
+  EXPECT_THAT(response.body_and_beyond, EndsWith("\n</body></html>"));
+}
+
+TEST_F(TinyAlpacaServerBaseTest, ServerStatusWithLittleSpaceToWrite) {
+  // The page is the same as when it can be written all at once, other than
+  // the loop profile and memory usage, which change from request to request.
+  ASSERT_OK_AND_ASSIGN(auto whole_str,
+                       RoundTripSoleRequest("GET / HTTP/1.1\r\n\r\n"));
+  server_->set_available_for_write(32);
+  ASSERT_OK_AND_ASSIGN(auto parts_str,
+                       RoundTripSoleRequest("GET / HTTP/1.1\r\n\r\n"));
+  ASSERT_OK_AND_ASSIGN(auto whole, HttpResponse::Make(whole_str));
+  ASSERT_OK_AND_ASSIGN(auto parts, HttpResponse::Make(parts_str));
+  EXPECT_EQ(parts.status_code, whole.status_code);
+  const std::string_view kDevices = "<div class=d>";
+  const auto whole_devices = whole.body_and_beyond.find(kDevices);
+  const auto parts_devices = parts.body_and_beyond.find(kDevices);
+  ASSERT_NE(whole_devices, std::string::npos);
+  ASSERT_NE(parts_devices, std::string::npos);
+  const auto server_end = whole.body_and_beyond.find("</table>\n</div>\n");
+  ASSERT_NE(server_end, std::string::npos);
+  EXPECT_EQ(parts.body_and_beyond.substr(0, server_end),
+            whole.body_and_beyond.substr(0, server_end));
+  EXPECT_EQ(parts.body_and_beyond.substr(parts_devices),
+            whole.body_and_beyond.substr(whole_devices));
+}
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+
 TEST_F(TinyAlpacaServerBaseTest, Setup) {
   // We include two unsupported (ignored) headers, including one with a very
   // large value, to verify that they are ignored, including skipping over a
@@ -138,6 +202,166 @@ TEST_F(TinyAlpacaServerBaseTest, Setup) {
   EXPECT_THAT(response.body_and_beyond, StartsWith("<html>"));
 }
 
+#if TAS_ENABLE_METRICS
+TEST_F(TinyAlpacaServerBaseTest, Metrics) {
+  ASSERT_OK(RoundTripSoleRequest("GET /setup HTTP/1.1\r\n\r\n").status());
+  ASSERT_OK(RoundTripSoleRequest("GET /setup HTTP/1.1\r\n\r\n").status());
+  ASSERT_OK(RoundTripSoleRequest("GET /bogus HTTP/1.1\r\n\r\n").status());
+  EXPECT_EQ(server_->metrics().api_count(EAlpacaApi::kServerSetup), 2);
+  EXPECT_EQ(
+      server_->metrics().decoding_error_count(EHttpStatusCode::kHttpBadRequest),
+      1);
+
+  ASSERT_OK_AND_ASSIGN(auto response_str,
+                       RoundTripSoleRequest("GET /metrics HTTP/1.1\r\n\r\n"));
+  ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+  EXPECT_EQ(response.status_code, 200);
+  EXPECT_TRUE(response.HasHeaderValue("content-Type", "text/plain"));
+  EXPECT_THAT(response.body_and_beyond,
+              HasSubstr("tas_requests_total{api=\"ServerSetup\"} 2\n"));
+  EXPECT_THAT(response.body_and_beyond,
+              HasSubstr("tas_decoding_errors_total{code=\"400\"} 1\n"));
+  EXPECT_THAT(response.body_and_beyond,
+              HasSubstr("tas_request_micros_count{phase=\"decode\"} 3\n"));
+
+  // The metrics request is counted once it has been written.
+  EXPECT_EQ(server_->metrics().api_count(EAlpacaApi::kServerMetrics), 1);
+}
+#endif  // TAS_ENABLE_METRICS
+
+#if TAS_ENABLE_LOOP_PROFILER
+TEST_F(TinyAlpacaServerBaseTest, LoopProfile) {
+  // Note that handling a request also calls MaintainDevices, so we can't
+  // predict the exact values recorded.
+  auto& profiler = server_->loop_profiler();
+  profiler.RecordLoopStart(1000);
+  profiler.RecordLoopStart(1250);
+
+  {
+    ASSERT_OK_AND_ASSIGN(auto response_str,
+                         RoundTripSoleRequest("GET / HTTP/1.1\r\n\r\n"));
+    ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_THAT(response.body_and_beyond, HasSubstr("Loop Profile"));
+    EXPECT_THAT(response.body_and_beyond, HasSubstr("<tr><td>Whole Loop</td>"));
+    EXPECT_THAT(response.body_and_beyond, HasSubstr("<tr><td>Network IO</td>"));
+  }
+#if TAS_ENABLE_METRICS
+  {
+    const std::string request = "GET /metrics HTTP/1.1\r\n\r\n";
+    ASSERT_OK_AND_ASSIGN(auto response_str, RoundTripSoleRequest(request));
+    ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_THAT(
+        response.body_and_beyond,
+        HasSubstr("tas_loop_phase_micros{phase=\"loop\",stat=\"p99\"} "));
+    EXPECT_THAT(response.body_and_beyond,
+                HasSubstr("tas_loop_phase_iterations_total{phase=\"loop\"} "));
+  }
+#endif  // TAS_ENABLE_METRICS
+}
+#endif  // TAS_ENABLE_LOOP_PROFILER
+
+#if TAS_ENABLE_MEMORY_USAGE
+TEST_F(TinyAlpacaServerBaseTest, MemoryUsage) {
+  {
+    ASSERT_OK_AND_ASSIGN(auto response_str,
+                         RoundTripSoleRequest("GET / HTTP/1.1\r\n\r\n"));
+    ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_THAT(response.body_and_beyond, HasSubstr("Memory Usage (bytes)"));
+    EXPECT_THAT(response.body_and_beyond,
+                HasSubstr("<tr><td>sizeof(ServerConnection)</td><td>"));
+  }
+#if TAS_ENABLE_METRICS
+  {
+    const std::string request = "GET /metrics HTTP/1.1\r\n\r\n";
+    ASSERT_OK_AND_ASSIGN(auto response_str, RoundTripSoleRequest(request));
+    ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_THAT(
+        response.body_and_beyond,
+        HasSubstr("tas_struct_size_bytes{struct=\"AlpacaRequest\"} "));
+  }
+#endif  // TAS_ENABLE_METRICS
+}
+#endif  // TAS_ENABLE_MEMORY_USAGE
+
+#if TAS_ENABLE_REQUEST_JOURNAL
+TEST_F(TinyAlpacaServerBaseTest, RequestJournal) {
+  ASSERT_OK(RoundTripSoleRequest("GET /setup HTTP/1.1\r\n\r\n").status());
+  ASSERT_OK(RoundTripSoleRequest("GET /bogus HTTP/1.1\r\n\r\n").status());
+
+  const std::string request =
+      "GET /management/v1/requestjournal HTTP/1.1\r\n\r\n";
+  ASSERT_OK_AND_ASSIGN(auto response_str, RoundTripSoleRequest(request));
+  ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+  EXPECT_EQ(response.status_code, 200);
+  EXPECT_THAT(response.body_and_beyond,
+              HasSubstr(R"("Api": "ServerSetup", "HttpStatus": 200, )"));
+  EXPECT_THAT(response.body_and_beyond, HasSubstr(R"("HttpStatus": 400, )"));
+}
+
+#if !TAS_ENABLE_METRICS
+// The journal is filled by OnRequestCompleted, which must be called even if
+// the metrics, which also need it, are disabled.
+TEST_F(TinyAlpacaServerBaseTest, RequestJournalWithoutMetrics) {
+  EXPECT_EQ(server_->request_journal().size(), 0);
+  ASSERT_OK(RoundTripSoleRequest("GET /setup HTTP/1.1\r\n\r\n").status());
+  EXPECT_EQ(server_->request_journal().size(), 1);
+  ASSERT_OK(RoundTripSoleRequest("GET /bogus HTTP/1.1\r\n\r\n").status());
+  ASSERT_EQ(server_->request_journal().size(), 2);
+  EXPECT_EQ(server_->request_journal().entry(0).api, EAlpacaApi::kServerSetup);
+  EXPECT_EQ(server_->request_journal().entry(1).http_status, 400);
+
+  ASSERT_OK_AND_ASSIGN(
+      auto response_str,
+      RoundTripSoleRequest("GET /metrics HTTP/1.1\r\n\r\n"));
+  ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+  EXPECT_EQ(response.status_code, 404);
+}
+#endif  // !TAS_ENABLE_METRICS
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
+
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+TEST_F(TinyAlpacaServerBaseTest, ShedsSetupWhenOverloaded) {
+  const std::string request = "GET /setup HTTP/1.1\r\n\r\n";
+
+  // Simulate a loop that is taking far too long.
+  auto& detector = server_->overload_detector();
+  uint32_t now = 0;
+  for (int i = 0; i < 10; ++i) {
+    detector.RecordLoopStart(now);
+    now += 2 * TAS_OVERLOAD_LOOP_MICROS;
+  }
+  ASSERT_TRUE(detector.is_overloaded());
+
+  {
+    ASSERT_OK_AND_ASSIGN(auto response_str, RoundTripSoleRequest(request));
+    ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+    EXPECT_EQ(response.status_code, 503);
+    EXPECT_TRUE(response.HasHeaderValue(
+        "Retry-After", absl::StrCat(TAS_OVERLOAD_RETRY_AFTER_SECONDS)));
+    EXPECT_TRUE(response.HasHeaderValue("Content-Length", "0"));
+    EXPECT_THAT(response.body_and_beyond, IsEmpty());
+    EXPECT_EQ(detector.num_shed_requests(), 1);
+  }
+
+  // Once the loop is fast again, the request is served.
+  for (int i = 0; i < 100 && detector.is_overloaded(); ++i) {
+    detector.RecordLoopStart(now);
+    now += 100;
+  }
+  ASSERT_FALSE(detector.is_overloaded());
+  {
+    ASSERT_OK_AND_ASSIGN(auto response_str, RoundTripSoleRequest(request));
+    ASSERT_OK_AND_ASSIGN(auto response, HttpResponse::Make(response_str));
+    EXPECT_EQ(response.status_code, 200);
+    EXPECT_EQ(detector.num_shed_requests(), 1);
+  }
+}
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+
 TEST_F(TinyAlpacaServerBaseTest, KnownHeaderTooLarge) {
   const auto full_request =
       absl::StrCat("GET /setup HTTP/1.1\r\n",  // Line break
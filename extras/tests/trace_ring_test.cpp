@@ -0,0 +1,80 @@
+#include "trace_ring.h"
+
+#include <McuCore.h>
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/print_to_std_string.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+using ::testing::EndsWith;
+using ::testing::StartsWith;
+
+TEST(TraceRingTest, Empty) {
+  TraceRing ring;
+  EXPECT_EQ(ring.size(), 0);
+  EXPECT_EQ(ring.num_recorded(), 0);
+
+  mcucore::test::PrintToStdString out;
+  ring.DumpTo(out);
+  EXPECT_EQ(out.str(), "TAS_TRACE 0 0\r\nTAS_TRACE_END\r\n");
+}
+
+TEST(TraceRingTest, RecordAndDump) {
+  TraceRing ring;
+  ring.Record(ETraceEvent::kConnect, 0x12D687, 3, 0);
+  ring.Record(ETraceEvent::kDecodeFunction, 0xFFFFFFFF, 0, 0xABC);
+  EXPECT_EQ(ring.size(), 2);
+  EXPECT_EQ(ring.num_recorded(), 2);
+
+  EXPECT_EQ(ring.record(0).event, ETraceEvent::kConnect);
+  EXPECT_EQ(ring.record(0).micros, 0x12D687);
+  EXPECT_EQ(ring.record(0).arg0, 3);
+  EXPECT_EQ(ring.record(1).event, ETraceEvent::kDecodeFunction);
+  EXPECT_EQ(ring.record(1).arg1, 0xABC);
+
+  mcucore::test::PrintToStdString out;
+  ring.DumpTo(out);
+  EXPECT_EQ(out.str(),
+            "TAS_TRACE 2 2\r\n"
+            "01 03 0000 0012D687\r\n"
+            "06 00 0ABC FFFFFFFF\r\n"
+            "TAS_TRACE_END\r\n");
+
+  ring.Reset();
+  EXPECT_EQ(ring.size(), 0);
+  EXPECT_EQ(ring.num_recorded(), 0);
+}
+
+TEST(TraceRingTest, OverwritesOldest) {
+  TraceRing ring;
+  const uint32_t num_events = TraceRing::kSize + 3;
+  for (uint32_t i = 0; i < num_events; ++i) {
+    ring.Record(ETraceEvent::kDispatch, 1000 + i, 0, i);
+  }
+  EXPECT_EQ(ring.size(), TraceRing::kSize);
+  EXPECT_EQ(ring.num_recorded(), num_events);
+
+  // The first 3 events have been lost.
+  for (uint16_t ndx = 0; ndx < ring.size(); ++ndx) {
+    EXPECT_EQ(ring.record(ndx).micros, 1003 + ndx);
+    EXPECT_EQ(ring.record(ndx).arg1, 3 + ndx);
+  }
+
+  mcucore::test::PrintToStdString out;
+  ring.DumpTo(out);
+  EXPECT_THAT(out.str(), StartsWith(absl::StrCat("TAS_TRACE ", num_events, " ",
+                                                 TraceRing::kSize, "\r\n",
+                                                 "08 00 0003 000003EB\r\n")));
+  EXPECT_THAT(out.str(), EndsWith("TAS_TRACE_END\r\n"));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
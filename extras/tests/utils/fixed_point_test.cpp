@@ -0,0 +1,71 @@
+#include "utils/fixed_point.h"
+
+#include <McuCore.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "mcucore/extras/test_tools/print_to_std_string.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+using ::mcucore::test::PrintToStdString;
+
+std::string PrintFixedPoint(FixedPoint value) {
+  PrintToStdString out;
+  const size_t count = value.PrintTo(out);
+  EXPECT_EQ(count, out.str().size());
+  return out.str();
+}
+
+std::string PrintDouble(double value) {
+  PrintToStdString out;
+  out.print(value);
+  return out.str();
+}
+
+TEST(FixedPointTest, Print) {
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(0, 0)), "0.00");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(125, -1)), "12.50");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(1250, -2)), "12.50");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(-5, -2)), "-0.05");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(101325, 0)), "101325.00");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(12345, -3)), "12.35");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(-12345, -3)), "-12.35");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(-1, -3)), "-0.00");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(999999999, -9)), "1.00");
+  EXPECT_EQ(PrintFixedPoint(FixedPoint(INT32_MIN, 0)), "-2147483648.00");
+}
+
+TEST(FixedPointTest, ToDouble) {
+  EXPECT_EQ(FixedPoint(0, 0).ToDouble(), 0);
+  EXPECT_EQ(FixedPoint(125, -1).ToDouble(), 12.5);
+  EXPECT_EQ(FixedPoint(-1025, -2).ToDouble(), -10.25);
+  EXPECT_EQ(FixedPoint(101325, 0).ToDouble(), 101325);
+}
+
+// Values which are exactly representable as doubles are printed the same way
+// whichever type is used.
+TEST(FixedPointTest, PrintsSameAsDouble) {
+  for (int32_t quarters = -20000; quarters <= 20000; quarters += 7) {
+    const double value = quarters / 4.0;
+    EXPECT_EQ(PrintFixedPoint(FixedPoint(quarters * 25, -2)),
+              PrintDouble(value));
+    EXPECT_EQ(PrintFixedPoint(FixedPoint(quarters * 25000, -5)),
+              PrintDouble(value));
+    if (quarters % 2 == 0) {
+      EXPECT_EQ(PrintFixedPoint(FixedPoint(quarters * 5 / 2, -1)),
+                PrintDouble(value));
+    }
+    if (quarters % 4 == 0) {
+      EXPECT_EQ(PrintFixedPoint(FixedPoint(quarters / 4, 0)),
+                PrintDouble(value));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
@@ -0,0 +1,65 @@
+#include "utils/hashing_print.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+uint32_t HashOf(const std::string& str) {
+  HashingPrint hasher;
+  hasher.print(str.c_str());
+  return hasher.hash();
+}
+
+uint32_t HashOfFirstProperty(const std::string& json) {
+  JsonPropertyHashingPrint hasher;
+  hasher.print(json.c_str());
+  return hasher.hash();
+}
+
+TEST(HashingPrintTest, EmptyIsOffsetBasis) {
+  HashingPrint hasher;
+  EXPECT_EQ(hasher.hash(), 2166136261UL);
+}
+
+TEST(HashingPrintTest, DiffersWithInput) {
+  EXPECT_EQ(HashOf("abc"), HashOf("abc"));
+  EXPECT_NE(HashOf("abc"), HashOf("abd"));
+  EXPECT_NE(HashOf("abc"), HashOf("ab"));
+}
+
+TEST(JsonPropertyHashingPrintTest, IgnoresLaterProperties) {
+  EXPECT_EQ(HashOfFirstProperty(R"({"Value": 3, "ErrorNumber": 0})"),
+            HashOfFirstProperty(R"({"Value": 3})"));
+  EXPECT_EQ(HashOfFirstProperty(R"({"Value": 3, "ErrorNumber": 0})"),
+            HashOfFirstProperty(R"({"Value": 3, "ErrorNumber": 1024})"));
+  EXPECT_NE(HashOfFirstProperty(R"({"Value": 3, "ErrorNumber": 0})"),
+            HashOfFirstProperty(R"({"Value": 4, "ErrorNumber": 0})"));
+  EXPECT_NE(HashOfFirstProperty(R"({"Value": 3})"),
+            HashOfFirstProperty(R"({"ErrorNumber": 3})"));
+}
+
+TEST(JsonPropertyHashingPrintTest, IgnoresQuotesAroundStrings) {
+  EXPECT_EQ(HashOfFirstProperty(R"({"Value": "abc", "ErrorNumber": 0})"),
+            HashOfFirstProperty(R"({"Value": abc})"));
+  EXPECT_NE(HashOfFirstProperty(R"({"Value": "abc"})"),
+            HashOfFirstProperty(R"({"Value": "abd"})"));
+}
+
+TEST(JsonPropertyHashingPrintTest, IncludesNestedValues) {
+  EXPECT_EQ(HashOfFirstProperty(R"({"Value": [1, "a,b"], "ErrorNumber": 0})"),
+            HashOfFirstProperty(R"({"Value": [1, "a,b"]})"));
+  EXPECT_NE(HashOfFirstProperty(R"({"Value": [1, "a,b"]})"),
+            HashOfFirstProperty(R"({"Value": [1, "a,c"]})"));
+  EXPECT_NE(HashOfFirstProperty(R"({"Value": {"x": 1}, "y": 2})"),
+            HashOfFirstProperty(R"({"Value": {"x": 2}, "y": 2})"));
+  EXPECT_NE(HashOfFirstProperty(R"({"Value": "a\",b", "y": 2})"),
+            HashOfFirstProperty(R"({"Value": "a\",c", "y": 2})"));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
@@ -0,0 +1,178 @@
+#include "utils/stepper_motion.h"
+
+#include <McuCore.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+constexpr uint32_t kTicksPerSecond = 2000000;
+
+// Emulates a motor driving a carriage towards a limit switch, and the timer
+// which interrupts the processor in order to step the motor.
+class EmulatedStepper : public StepperHardware {
+ public:
+  explicit EmulatedStepper(uint32_t limit_position)
+      : limit_position_(limit_position) {}
+
+  void Step() override {
+    ++position_;
+    step_times_.push_back(now_);
+  }
+  bool IsAtLimit() override { return position_ >= limit_position_; }
+  void StartTimer(uint16_t ticks) override {
+    EXPECT_FALSE(timer_running_);
+    timer_running_ = true;
+    next_interrupt_ = now_ + ticks;
+  }
+  void SetTimerInterval(uint16_t ticks) override {
+    EXPECT_TRUE(timer_running_);
+    next_interrupt_ = now_ + ticks;
+  }
+  void StopTimer() override { timer_running_ = false; }
+
+  // Advances time to each interrupt in turn, calling HandleInterrupt, until the
+  // timer is stopped or max_ticks have passed. Returns the last result.
+  StepperMotion::EResult Run(StepperMotion& motion, uint64_t max_ticks) {
+    const uint64_t end = now_ + max_ticks;
+    StepperMotion::EResult result = StepperMotion::kNotMoving;
+    while (timer_running_ && next_interrupt_ <= end) {
+      now_ = next_interrupt_;
+      result = motion.HandleInterrupt();
+    }
+    if (timer_running_) {
+      now_ = end;
+    }
+    return result;
+  }
+
+  uint32_t position() const { return position_; }
+  bool timer_running() const { return timer_running_; }
+  const std::vector<uint64_t>& step_times() const { return step_times_; }
+
+ private:
+  const uint32_t limit_position_;
+  uint32_t position_ = 0;
+  bool timer_running_ = false;
+  uint64_t now_ = 0;
+  uint64_t next_interrupt_ = 0;
+  std::vector<uint64_t> step_times_;
+};
+
+void Configure(StepperMotion& motion) {
+  motion.Configure(kTicksPerSecond, 1000, 10000, 20000);
+}
+
+TEST(StepperMotionTest, StopsAtLimit) {
+  EmulatedStepper stepper(50000);
+  StepperMotion motion(stepper);
+  Configure(motion);
+  ASSERT_TRUE(motion.Start(120000, 0));
+  EXPECT_TRUE(motion.IsMoving());
+  EXPECT_TRUE(stepper.timer_running());
+
+  EXPECT_EQ(stepper.Run(motion, 100 * kTicksPerSecond),
+            StepperMotion::kReachedLimit);
+  EXPECT_FALSE(motion.IsMoving());
+  EXPECT_FALSE(stepper.timer_running());
+  EXPECT_EQ(stepper.position(), 50000);
+  EXPECT_EQ(motion.steps(), 50000);
+
+  // At full speed, the steps were 100us apart.
+  const auto& times = stepper.step_times();
+  EXPECT_EQ(times.back() - times[times.size() - 2], kTicksPerSecond / 10000);
+
+  // A ramp of about 2.5K steps in 0.45 seconds, then the remaining 47.5K steps
+  // at 10K steps per second.
+  EXPECT_NEAR(times.back(), 5.2 * kTicksPerSecond, 0.05 * kTicksPerSecond);
+}
+
+TEST(StepperMotionTest, CreepsToLimitAfterDecelerating) {
+  EmulatedStepper stepper(50100);
+  StepperMotion motion(stepper);
+  Configure(motion);
+  ASSERT_TRUE(motion.Start(120000, 50000));
+  EXPECT_EQ(stepper.Run(motion, 100 * kTicksPerSecond),
+            StepperMotion::kReachedLimit);
+  EXPECT_EQ(stepper.position(), 50100);
+
+  // The last steps were taken at the start speed.
+  const auto& times = stepper.step_times();
+  EXPECT_EQ(motion.ramp().phase(), StepperRamp::EPhase::kCreeping);
+  EXPECT_NEAR(times.back() - times[times.size() - 2],
+              motion.ramp().start_interval(), 1);
+}
+
+TEST(StepperMotionTest, ExceedsAllowedSteps) {
+  EmulatedStepper stepper(50000);
+  StepperMotion motion(stepper);
+  Configure(motion);
+  ASSERT_TRUE(motion.Start(1000, 0));
+  EXPECT_EQ(stepper.Run(motion, 100 * kTicksPerSecond),
+            StepperMotion::kExceededAllowedSteps);
+  EXPECT_FALSE(motion.IsMoving());
+  EXPECT_FALSE(stepper.timer_running());
+  EXPECT_EQ(stepper.position(), 1000);
+}
+
+TEST(StepperMotionTest, AlreadyAtLimit) {
+  EmulatedStepper stepper(0);
+  StepperMotion motion(stepper);
+  Configure(motion);
+  EXPECT_FALSE(motion.Start(1000, 0));
+  EXPECT_FALSE(motion.IsMoving());
+  EXPECT_FALSE(stepper.timer_running());
+}
+
+TEST(StepperMotionTest, Stop) {
+  EmulatedStepper stepper(50000);
+  StepperMotion motion(stepper);
+  Configure(motion);
+  ASSERT_TRUE(motion.Start(120000, 0));
+  EXPECT_EQ(stepper.Run(motion, kTicksPerSecond), StepperMotion::kStepped);
+  EXPECT_TRUE(motion.IsMoving());
+  const uint32_t position = stepper.position();
+  EXPECT_GT(position, 0);
+
+  motion.Stop();
+  EXPECT_FALSE(motion.IsMoving());
+  EXPECT_FALSE(stepper.timer_running());
+
+  // An interrupt which was already pending doesn't cause a step.
+  EXPECT_EQ(motion.HandleInterrupt(), StepperMotion::kNotMoving);
+  EXPECT_EQ(stepper.position(), position);
+}
+
+TEST(StepperMotionTest, RestartAfterDecelerating) {
+  EmulatedStepper stepper(50000);
+  StepperMotion motion(stepper);
+  Configure(motion);
+  ASSERT_TRUE(motion.Start(120000, 0));
+  EXPECT_EQ(stepper.Run(motion, kTicksPerSecond), StepperMotion::kStepped);
+  motion.Decelerate();
+  while (motion.ramp().phase() != StepperRamp::EPhase::kCreeping) {
+    ASSERT_EQ(stepper.Run(motion, kTicksPerSecond / 100),
+              StepperMotion::kStepped);
+  }
+
+  // The ramp starts again, without the timer being restarted (which
+  // EmulatedStepper::StartTimer would have reported).
+  const uint32_t position = stepper.position();
+  motion.Restart(1000, 0);
+  EXPECT_TRUE(motion.IsMoving());
+  EXPECT_TRUE(stepper.timer_running());
+  EXPECT_EQ(motion.steps(), 0);
+  EXPECT_EQ(motion.ramp().phase(), StepperRamp::EPhase::kAccelerating);
+  EXPECT_EQ(stepper.Run(motion, 100 * kTicksPerSecond),
+            StepperMotion::kExceededAllowedSteps);
+  EXPECT_EQ(stepper.position(), position + 1000);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
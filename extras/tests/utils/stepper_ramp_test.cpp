@@ -0,0 +1,139 @@
+#include "utils/stepper_ramp.h"
+
+#include <McuCore.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+constexpr uint32_t kTicksPerSecond = 2000000;
+constexpr uint16_t kStartSpeed = 1000;
+constexpr uint16_t kMaxSpeed = 10000;
+constexpr uint32_t kAcceleration = 20000;
+
+// The number of steps and the time needed to accelerate from the start speed to
+// the max speed.
+constexpr double kRampSteps =
+    (1.0 * kMaxSpeed * kMaxSpeed - 1.0 * kStartSpeed * kStartSpeed) /
+    (2.0 * kAcceleration);
+constexpr double kRampTicks =
+    (1.0 * kMaxSpeed - kStartSpeed) / kAcceleration * kTicksPerSecond;
+
+StepperRamp MakeRamp() {
+  StepperRamp ramp;
+  ramp.Configure(kTicksPerSecond, kStartSpeed, kMaxSpeed, kAcceleration);
+  return ramp;
+}
+
+TEST(StepperRampTest, Configure) {
+  auto ramp = MakeRamp();
+  // F / sqrt(v0^2 + 2a)
+  EXPECT_EQ(ramp.start_interval(), 1961);
+  EXPECT_EQ(ramp.min_interval(), kTicksPerSecond / kMaxSpeed);
+}
+
+TEST(StepperRampTest, AcceleratesToMaxSpeed) {
+  auto ramp = MakeRamp();
+  uint32_t interval = ramp.Start(0);
+  EXPECT_EQ(interval, ramp.start_interval());
+  EXPECT_EQ(ramp.phase(), StepperRamp::EPhase::kAccelerating);
+
+  uint32_t ticks = 0;
+  while (ramp.phase() == StepperRamp::EPhase::kAccelerating) {
+    ticks += interval;
+    const uint32_t next_interval = ramp.NextInterval();
+    // Allow for the fraction carried from one interval to the next.
+    ASSERT_LE(next_interval, interval + 1) << "Step " << ramp.steps();
+    interval = next_interval;
+    ASSERT_LT(ramp.steps(), 2 * kRampSteps);
+  }
+  EXPECT_EQ(ramp.phase(), StepperRamp::EPhase::kCruising);
+  EXPECT_EQ(interval, ramp.min_interval());
+  EXPECT_NEAR(ramp.steps(), kRampSteps, kRampSteps * 0.05);
+  EXPECT_NEAR(ticks, kRampTicks, kRampTicks * 0.05);
+
+  // Without an expected number of steps, it never slows down.
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_EQ(ramp.NextInterval(), ramp.min_interval());
+  }
+  EXPECT_EQ(ramp.phase(), StepperRamp::EPhase::kCruising);
+}
+
+TEST(StepperRampTest, DeceleratesBeforeExpectedSteps) {
+  constexpr uint32_t kExpectedSteps = 20000;
+  auto ramp = MakeRamp();
+  std::vector<uint16_t> intervals;
+  intervals.push_back(ramp.Start(kExpectedSteps));
+  uint32_t decelerate_at = 0;
+  while (ramp.steps() < kExpectedSteps + 1000) {
+    intervals.push_back(ramp.NextInterval());
+    if (decelerate_at == 0 &&
+        ramp.phase() == StepperRamp::EPhase::kDecelerating) {
+      decelerate_at = ramp.steps();
+    }
+  }
+  EXPECT_NEAR(decelerate_at, kExpectedSteps - kRampSteps, kRampSteps * 0.05);
+  EXPECT_EQ(ramp.phase(), StepperRamp::EPhase::kCreeping);
+
+  // Reaches (close to) the start speed at about the expected step, and then
+  // stays at that speed.
+  EXPECT_GT(intervals[kExpectedSteps], ramp.start_interval() * 0.8);
+  EXPECT_EQ(intervals.back(), ramp.start_interval());
+
+  // The intervals don't decrease while decelerating.
+  for (uint32_t step = decelerate_at + 1; step < intervals.size(); ++step) {
+    ASSERT_GE(intervals[step] + 1, intervals[step - 1]) << "Step " << step;
+  }
+}
+
+TEST(StepperRampTest, ShortMoveNeverCruises) {
+  constexpr uint32_t kExpectedSteps = 1000;
+  auto ramp = MakeRamp();
+  uint16_t min_interval = ramp.Start(kExpectedSteps);
+  while (ramp.steps() < kExpectedSteps) {
+    min_interval = std::min(min_interval, ramp.NextInterval());
+    ASSERT_NE(ramp.phase(), StepperRamp::EPhase::kCruising);
+  }
+  EXPECT_GT(min_interval, ramp.min_interval());
+  EXPECT_NEAR(ramp.NextInterval(), ramp.start_interval(),
+              ramp.start_interval() * 0.2);
+}
+
+TEST(StepperRampTest, DecelerateOnRequest) {
+  auto ramp = MakeRamp();
+  ramp.Start(0);
+  while (ramp.phase() != StepperRamp::EPhase::kCruising) {
+    ramp.NextInterval();
+  }
+  const uint32_t cruise_steps = ramp.steps();
+  ramp.Decelerate();
+  EXPECT_EQ(ramp.phase(), StepperRamp::EPhase::kDecelerating);
+  while (ramp.phase() == StepperRamp::EPhase::kDecelerating) {
+    ramp.NextInterval();
+  }
+  EXPECT_NEAR(ramp.steps() - cruise_steps, kRampSteps, kRampSteps * 0.1);
+}
+
+TEST(StepperRampTest, NoAcceleration) {
+  StepperRamp ramp;
+  ramp.Configure(kTicksPerSecond, 3000, kMaxSpeed, 0);
+  EXPECT_EQ(ramp.Start(0), 666);
+  EXPECT_EQ(ramp.phase(), StepperRamp::EPhase::kCreeping);
+
+  // The fraction of a tick in each interval is carried forward, so the motor
+  // takes 3000 steps per second.
+  uint32_t ticks = 0;
+  for (int i = 0; i < 3000; ++i) {
+    ticks += ramp.NextInterval();
+  }
+  EXPECT_NEAR(ticks, kTicksPerSecond, 1);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
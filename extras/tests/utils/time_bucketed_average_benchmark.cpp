@@ -0,0 +1,71 @@
+// Compares the cost of recording a reading and computing the average with
+// TimeBucketedAverage and with MovingAverage, on the host. The absolute numbers
+// say little about an AVR (which has no FPU, making the double arithmetic of
+// MovingAverage relatively more expensive), but the relative cost of the
+// operations, and how they scale with the number of buckets, carry over.
+
+#include <stdint.h>
+
+#include "benchmark/benchmark.h"
+#include "utils/moving_average.h"
+#include "utils/time_bucketed_average.h"
+
+namespace alpaca {
+namespace {
+
+// One reading per second, with one minute buckets, and an average period of
+// about an hour.
+constexpr uint32_t kReadingInterval = 1000;
+constexpr uint32_t kBucketDuration = 60 * 1000;
+constexpr uint32_t kAveragePeriod = 60 * 60 * 1000;
+
+void BM_MovingAverage_RecordNewValue(benchmark::State& state) {
+  MovingAverage average;
+  uint32_t now = 0;
+  double value = 0;
+  for (auto _ : state) {
+    now += kReadingInterval;
+    value += 0.25;
+    average.RecordNewValue(value, now, kAveragePeriod);
+    benchmark::DoNotOptimize(average.average_value());
+  }
+}
+BENCHMARK(BM_MovingAverage_RecordNewValue);
+
+template <uint8_t kNumBuckets>
+void BM_TimeBucketedAverage_RecordValue(benchmark::State& state) {
+  TimeBucketedAverage<kNumBuckets> average(kBucketDuration);
+  uint32_t now = 0;
+  int32_t value = 0;
+  for (auto _ : state) {
+    now += kReadingInterval;
+    value += 25;
+    average.RecordValue(value, now);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK_TEMPLATE(BM_TimeBucketedAverage_RecordValue, 16);
+BENCHMARK_TEMPLATE(BM_TimeBucketedAverage_RecordValue, 64);
+BENCHMARK_TEMPLATE(BM_TimeBucketedAverage_RecordValue, 254);
+
+template <uint8_t kNumBuckets>
+void BM_TimeBucketedAverage_GetAverage(benchmark::State& state) {
+  TimeBucketedAverage<kNumBuckets> average(kBucketDuration);
+  uint32_t now = 0;
+  for (uint32_t ndx = 0; ndx < 1000 * kNumBuckets; ++ndx) {
+    now += kReadingInterval;
+    average.RecordValue(ndx, now);
+  }
+  const uint32_t average_period = average.MaxAveragePeriod();
+  for (auto _ : state) {
+    int32_t value = 0;
+    benchmark::DoNotOptimize(average.GetAverage(average_period, value));
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK_TEMPLATE(BM_TimeBucketedAverage_GetAverage, 16);
+BENCHMARK_TEMPLATE(BM_TimeBucketedAverage_GetAverage, 64);
+BENCHMARK_TEMPLATE(BM_TimeBucketedAverage_GetAverage, 254);
+
+}  // namespace
+}  // namespace alpaca
@@ -0,0 +1,230 @@
+#include "utils/time_bucketed_average.h"
+
+#include <stdint.h>
+
+#include <cmath>
+#include <vector>
+
+#include "absl/random/random.h"
+#include "gtest/gtest.h"
+
+namespace alpaca {
+namespace test {
+namespace {
+
+// Computes the same mean as TimeBucketedAverage::GetAverage by brute force,
+// from all of the readings.
+class ReferenceAverage {
+ public:
+  explicit ReferenceAverage(uint32_t bucket_duration, uint8_t num_buckets)
+      : bucket_duration_(bucket_duration), num_buckets_(num_buckets) {}
+
+  void AdvanceTo(uint32_t now) {
+    if (!started_) {
+      start_time_ = now;
+      started_ = true;
+    }
+    now_ = now;
+  }
+
+  void RecordValue(int32_t value, uint32_t now) {
+    AdvanceTo(now);
+    readings_.push_back({value, now});
+  }
+
+  bool GetAverage(uint32_t average_period, int32_t& average) const {
+    if (average_period == 0) {
+      if (readings_.empty()) {
+        return false;
+      }
+      average = readings_.back().value;
+      return true;
+    }
+    if (!started_) {
+      return false;
+    }
+    const int64_t current_bucket = BucketOf(now_);
+    int64_t num_buckets =
+        (average_period + bucket_duration_ - 1) / bucket_duration_;
+    num_buckets = std::min<int64_t>(num_buckets, num_buckets_);
+    num_buckets = std::min<int64_t>(num_buckets, current_bucket);
+    int64_t sum = 0;
+    int64_t count = 0;
+    for (const auto& reading : readings_) {
+      const int64_t bucket = BucketOf(reading.time);
+      if (bucket >= current_bucket - num_buckets && bucket < current_bucket) {
+        sum += reading.value;
+        ++count;
+      }
+    }
+    if (count == 0) {
+      return false;
+    }
+    average = static_cast<int32_t>(std::llround(static_cast<double>(sum) /
+                                                 static_cast<double>(count)));
+    return true;
+  }
+
+ private:
+  struct Reading {
+    int32_t value;
+    uint32_t time;
+  };
+
+  int64_t BucketOf(uint32_t time) const {
+    return static_cast<uint32_t>(time - start_time_) / bucket_duration_;
+  }
+
+  const uint32_t bucket_duration_;
+  const uint8_t num_buckets_;
+  std::vector<Reading> readings_;
+  uint32_t start_time_ = 0;
+  uint32_t now_ = 0;
+  bool started_ = false;
+};
+
+TEST(TimeBucketedAverageTest, Empty) {
+  TimeBucketedAverage<4> average(10);
+  EXPECT_EQ(average.MaxAveragePeriod(), 40);
+  EXPECT_EQ(average.bucket_duration(), 10);
+  EXPECT_EQ(average.num_complete_buckets(), 0);
+  int32_t value = 123;
+  EXPECT_FALSE(average.GetAverage(0, value));
+  EXPECT_FALSE(average.GetAverage(10, value));
+  EXPECT_EQ(value, 123);
+}
+
+TEST(TimeBucketedAverageTest, IncompleteBucketIsExcluded) {
+  TimeBucketedAverage<4> average(10);
+  average.RecordValue(100, 1000);
+  average.RecordValue(200, 1009);
+  EXPECT_EQ(average.num_complete_buckets(), 0);
+  int32_t value = 0;
+  EXPECT_TRUE(average.GetAverage(0, value));
+  EXPECT_EQ(value, 200);
+  EXPECT_FALSE(average.GetAverage(10, value));
+
+  average.AdvanceTo(1010);
+  EXPECT_EQ(average.num_complete_buckets(), 1);
+  EXPECT_TRUE(average.GetAverage(10, value));
+  EXPECT_EQ(value, 150);
+  // Asking for a longer period than is available gives the mean of what is.
+  EXPECT_TRUE(average.GetAverage(40, value));
+  EXPECT_EQ(value, 150);
+}
+
+TEST(TimeBucketedAverageTest, PeriodIsRoundedUpToWholeBuckets) {
+  TimeBucketedAverage<4> average(10);
+  average.RecordValue(10, 0);
+  average.RecordValue(20, 10);
+  average.RecordValue(30, 20);
+  average.RecordValue(40, 30);
+  average.AdvanceTo(40);
+  EXPECT_EQ(average.num_complete_buckets(), 4);
+  int32_t value = 0;
+  EXPECT_TRUE(average.GetAverage(10, value));
+  EXPECT_EQ(value, 40);
+  EXPECT_TRUE(average.GetAverage(11, value));
+  EXPECT_EQ(value, 35);
+  EXPECT_TRUE(average.GetAverage(30, value));
+  EXPECT_EQ(value, 30);
+  EXPECT_TRUE(average.GetAverage(40, value));
+  EXPECT_EQ(value, 25);
+  EXPECT_TRUE(average.GetAverage(1000, value));
+  EXPECT_EQ(value, 25);
+
+  // The oldest bucket is dropped once another is completed.
+  average.AdvanceTo(50);
+  EXPECT_EQ(average.num_complete_buckets(), 4);
+  EXPECT_TRUE(average.GetAverage(40, value));
+  EXPECT_EQ(value, 30);
+  // The newest bucket is empty.
+  EXPECT_FALSE(average.GetAverage(10, value));
+}
+
+TEST(TimeBucketedAverageTest, LongGap) {
+  TimeBucketedAverage<4> average(10);
+  average.RecordValue(10, 0);
+  average.AdvanceTo(1000000);
+  int32_t value = 0;
+  EXPECT_FALSE(average.GetAverage(40, value));
+  average.RecordValue(-10, 1000001);
+  average.AdvanceTo(1000010);
+  EXPECT_TRUE(average.GetAverage(40, value));
+  EXPECT_EQ(value, -10);
+}
+
+TEST(TimeBucketedAverageTest, ClockWrapsAround) {
+  TimeBucketedAverage<4> average(10);
+  average.RecordValue(1, 0xFFFFFFF0);
+  average.RecordValue(3, 0xFFFFFFFA);
+  average.RecordValue(5, 4);
+  average.AdvanceTo(14);
+  EXPECT_EQ(average.num_complete_buckets(), 3);
+  int32_t value = 0;
+  EXPECT_TRUE(average.GetAverage(30, value));
+  EXPECT_EQ(value, 3);
+}
+
+TEST(TimeBucketedAverageTest, RoundedQuotient) {
+  using Average = TimeBucketedAverage<1>;
+  EXPECT_EQ(Average::RoundedQuotient(0, 3), 0);
+  EXPECT_EQ(Average::RoundedQuotient(4, 3), 1);
+  EXPECT_EQ(Average::RoundedQuotient(5, 3), 2);
+  EXPECT_EQ(Average::RoundedQuotient(3, 2), 2);
+  EXPECT_EQ(Average::RoundedQuotient(-3, 2), -2);
+  EXPECT_EQ(Average::RoundedQuotient(-4, 3), -1);
+  EXPECT_EQ(Average::RoundedQuotient(-5, 3), -2);
+  EXPECT_EQ(Average::RoundedQuotient(INT32_MIN, 1), INT32_MIN);
+  EXPECT_EQ(Average::RoundedQuotient(INT32_MAX, 1), INT32_MAX);
+}
+
+// Compares the results with those computed by brute force, for random readings
+// taken at random intervals, many of which are shorter than a bucket, and some
+// of which are longer than all of the buckets.
+TEST(TimeBucketedAverageTest, MatchesReference) {
+  constexpr uint8_t kNumBuckets = 12;
+  constexpr uint32_t kBucketDuration = 100;
+  absl::BitGen bit_gen;
+  for (int trial = 0; trial < 20; ++trial) {
+    TimeBucketedAverage<kNumBuckets> average(kBucketDuration);
+    ReferenceAverage reference(kBucketDuration, kNumBuckets);
+    // Start near the wrap around of the clock in some trials.
+    uint32_t now = trial % 2 == 0 ? absl::Uniform<uint32_t>(bit_gen)
+                                  : 0xFFFFFFFF - 2000;
+    for (int step = 0; step < 2000; ++step) {
+      if (absl::Bernoulli(bit_gen, 0.01)) {
+        now += absl::Uniform<uint32_t>(bit_gen, 0, 2 * kNumBuckets *
+                                                       kBucketDuration);
+      } else {
+        now += absl::Uniform<uint32_t>(bit_gen, 0, 3 * kBucketDuration / 2);
+      }
+      if (absl::Bernoulli(bit_gen, 0.1)) {
+        average.AdvanceTo(now);
+        reference.AdvanceTo(now);
+      } else {
+        const int32_t value = absl::Uniform<int32_t>(bit_gen, -100000, 100000);
+        average.RecordValue(value, now);
+        reference.RecordValue(value, now);
+      }
+      const uint32_t average_period = absl::Uniform<uint32_t>(
+          absl::IntervalClosed, bit_gen, 0, average.MaxAveragePeriod() + 50);
+      int32_t actual = 0;
+      int32_t expected = 0;
+      const bool actual_ok = average.GetAverage(average_period, actual);
+      const bool expected_ok = reference.GetAverage(average_period, expected);
+      ASSERT_EQ(actual_ok, expected_ok)
+          << "trial=" << trial << " step=" << step
+          << " average_period=" << average_period;
+      if (actual_ok) {
+        ASSERT_EQ(actual, expected)
+            << "trial=" << trial << " step=" << step
+            << " average_period=" << average_period;
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace alpaca
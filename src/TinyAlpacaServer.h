@@ -16,6 +16,8 @@
 #include "ascom_error_codes.h"            // IWYU pragma: export
 #include "config.h"                       // IWYU pragma: export
 #include "configured_devices_response.h"  // IWYU pragma: export
+#include "connection_deadlines.h"         // IWYU pragma: export
+#include "connection_scheduler.h"         // IWYU pragma: export
 #include "constants.h"                    // IWYU pragma: export
 #include "device_description.h"           // IWYU pragma: export
 #include "device_interface.h"             // IWYU pragma: export
@@ -23,26 +25,45 @@
 #include "device_types/cover_calibrator/cover_calibrator_constants.h"  // IWYU pragma: export
 #include "device_types/device_impl_base.h"  // IWYU pragma: export
 #include "device_types/observing_conditions/observing_conditions_adapter.h"  // IWYU pragma: export
+#include "device_types/observing_conditions/sensor_history.h"  // IWYU pragma: export
+#include "device_types/observing_conditions/sensor_sampler.h"  // IWYU pragma: export
 #include "device_types/switch/multi_switch_adapter.h"  // IWYU pragma: export
 #include "device_types/switch/switch_adapter.h"        // IWYU pragma: export
 #include "device_types/switch/switch_interface.h"      // IWYU pragma: export
+#include "device_types/switch/switch_name_cache.h"     // IWYU pragma: export
 #include "device_types/switch/toggle_switch_base.h"    // IWYU pragma: export
 #include "eeprom_ids.h"                                // IWYU pragma: export
+#include "event_stream_state.h"                        // IWYU pragma: export
 #include "extra_parameters.h"                          // IWYU pragma: export
 #include "http_response_header.h"                      // IWYU pragma: export
 #include "json_response.h"                             // IWYU pragma: export
 #include "literals.h"                                  // IWYU pragma: export
+#include "loop_profiler.h"                             // IWYU pragma: export
 #include "match_literals.h"                            // IWYU pragma: export
+#include "memory_usage.h"                              // IWYU pragma: export
+#include "overload_detector.h"                         // IWYU pragma: export
 #include "request_decoder.h"                           // IWYU pragma: export
 #include "request_decoder_listener.h"                  // IWYU pragma: export
+#include "request_journal.h"                           // IWYU pragma: export
+#include "request_lanes.h"                             // IWYU pragma: export
 #include "request_listener.h"                          // IWYU pragma: export
+#include "response_cursor.h"                           // IWYU pragma: export
 #include "server_connection.h"                         // IWYU pragma: export
 #include "server_context.h"                            // IWYU pragma: export
 #include "server_description.h"                        // IWYU pragma: export
+#include "server_metrics.h"                            // IWYU pragma: export
 #include "server_socket_and_connection.h"              // IWYU pragma: export
 #include "server_sockets_and_connections.h"            // IWYU pragma: export
+#include "settings_journal.h"                          // IWYU pragma: export
+#include "socket_lease_policy.h"                       // IWYU pragma: export
 #include "tiny_alpaca_device_server.h"                 // IWYU pragma: export
 #include "tiny_alpaca_network_server.h"                // IWYU pragma: export
+#include "trace_ring.h"                                // IWYU pragma: export
+#include "utils/fixed_point.h"                         // IWYU pragma: export
+#include "utils/hashing_print.h"                       // IWYU pragma: export
 #include "utils/moving_average.h"                      // IWYU pragma: export
+#include "utils/stepper_motion.h"                      // IWYU pragma: export
+#include "utils/stepper_ramp.h"                        // IWYU pragma: export
+#include "utils/time_bucketed_average.h"               // IWYU pragma: export
 
 #endif  // TINY_ALPACA_SERVER_SRC_TINYALPACASERVER_H_
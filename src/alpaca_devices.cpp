@@ -4,16 +4,145 @@
 #include <McuNet.h>
 
 #include "alpaca_response.h"
+#include "ascom_error_codes.h"
 #include "configured_devices_response.h"
 #include "constants.h"
 #include "device_description.h"
+#include "http_response_header.h"
 #include "literals.h"
+#include "utils/hashing_print.h"
 
 namespace alpaca {
+namespace {
+
+#if TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || \
+    TAS_ENABLE_LONG_POLL
+// Forwards to another Print instance only those bytes which come after the end
+// of an HTTP response header (i.e. after the first "\r\n\r\n"). This allows the
+// JSON body of a response produced by a device to be embedded in the body of
+// another response, without needing any buffering.
+class HttpBodyPrint : public Print {
+ public:
+  explicit HttpBodyPrint(Print& out) : out_(out), eol_chars_matched_(0) {}
+
+  size_t write(uint8_t b) override {
+    if (eol_chars_matched_ >= 4) {
+      return out_.write(b);
+    }
+    // Odd numbered characters of "\r\n\r\n" are '\r', even are '\n'.
+    const char expected = (eol_chars_matched_ & 1) ? '\n' : '\r';
+    if (b == expected) {
+      ++eol_chars_matched_;
+    } else {
+      eol_chars_matched_ = (b == '\r') ? 1 : 0;
+    }
+    return 1;
+  }
+
+ private:
+  Print& out_;
+  uint8_t eol_chars_matched_;
+};
+#endif  // TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || ...
+
+#if TAS_ENABLE_BATCH_REQUESTS
+// Forwards to another Print the body of the response to one method of a batch
+// request, but only if the response has the status 200 OK. The body of any
+// other response (e.g. 400 Bad Request) is plain text, which would make the
+// body of the batch response invalid JSON, so the caller writes an error
+// object in its place. The status code is decoded from the status line (e.g.
+// "HTTP/1.1 400 Bad Request").
+class BatchElementPrint : public Print {
+ public:
+  explicit BatchElementPrint(Print& out)
+      : body_out_(out), status_code_(0), status_line_spaces_(0) {}
+
+  size_t write(uint8_t b) override {
+    if (status_line_spaces_ < 2) {
+      if (b == ' ') {
+        ++status_line_spaces_;
+      } else if (status_line_spaces_ == 1 && '0' <= b && b <= '9') {
+        status_code_ = status_code_ * 10 + (b - '0');
+      }
+    }
+    if (status_line_spaces_ < 2 || ok()) {
+      return body_out_.write(b);
+    }
+    return 1;
+  }
+
+  bool ok() const { return status_line_spaces_ >= 2 && status_code_ == 200; }
+  uint16_t status_code() const { return status_code_; }
+
+ private:
+  HttpBodyPrint body_out_;
+  uint16_t status_code_;
+  uint8_t status_line_spaces_;
+};
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_EVENT_STREAMS
+// Forwards to another Print all but the line breaks, so that a JSON response
+// body becomes the single line of data of a Server-Sent Event. Line breaks
+// within JSON strings are escaped, so those written are outside of any value.
+class EventDataPrint : public Print {
+ public:
+  explicit EventDataPrint(Print& out) : out_(out) {}
+
+  size_t write(uint8_t b) override {
+    if (b == '\r' || b == '\n') {
+      return 1;
+    }
+    return out_.write(b);
+  }
+
+ private:
+  Print& out_;
+};
+
+// Writes to out the body of the response to a GET /devicestate request.
+void WriteDeviceStateBody(const AlpacaRequest& stream_request,
+                          DeviceInterface& device, Print& out) {
+  AlpacaRequest request = stream_request;
+  request.http_method = EHttpMethod::GET;
+  request.device_method = EDeviceMethod::kDeviceState;
+  request.do_close = false;
+  request.is_embedded = true;
+  // Omit the transaction ids so that the body only changes if the state does.
+  request.have_client_transaction_id = false;
+  request.have_server_transaction_id = false;
+  HttpBodyPrint body_out(out);
+  device.HandleDeviceApiRequest(request, body_out);
+}
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+// Returns the hash of the Value in the device's response to the request.
+uint32_t HashOfResponseValue(const AlpacaRequest& long_poll_request,
+                             DeviceInterface& device) {
+  AlpacaRequest request = long_poll_request;
+  request.do_close = false;
+  request.is_embedded = true;
+  // Omit the transaction ids, which would otherwise be the first property if
+  // the response is an error.
+  request.have_client_transaction_id = false;
+  request.have_server_transaction_id = false;
+  JsonPropertyHashingPrint hasher;
+  HttpBodyPrint body_out(hasher);
+  device.HandleDeviceApiRequest(request, body_out);
+  return hasher.hash();
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
+}  // namespace
 
 AlpacaDevices::AlpacaDevices(ServerContext& server_context,
                              mcucore::ArrayView<DeviceInterface*> devices)
-    : server_context_(server_context), devices_(devices) {}
+    : server_context_(server_context), devices_(devices) {
+#if TAS_ENABLE_EVENT_STREAMS
+  num_event_streams_ = 0;
+#endif  // TAS_ENABLE_EVENT_STREAMS
+}
 
 // Before initializing the devices, we want to make sure they're valid:
 // * None of the pointers are nullptr.
@@ -103,6 +232,17 @@ void AlpacaDevices::MaintainDevices() {
   }
 }
 
+#if TAS_ENABLE_LOOP_PROFILER
+void AlpacaDevices::MaintainDevices(LoopProfiler& profiler) {
+  uint8_t device_ndx = 0;
+  for (DeviceInterface* device : devices_) {
+    const uint32_t start_micros = micros();
+    device->MaintainDevice();
+    profiler.RecordMaintainDevice(device_ndx++, micros() - start_micros);
+  }
+}
+#endif  // TAS_ENABLE_LOOP_PROFILER
+
 bool AlpacaDevices::HandleManagementConfiguredDevices(AlpacaRequest& request,
                                                       Print& out) {
   MCU_VLOG(3) << MCU_PSD("AlpacaDevices::HandleManagementConfiguredDevices");
@@ -158,6 +298,22 @@ bool AlpacaDevices::DispatchDeviceRequest(AlpacaRequest& request,
               << request.device_type << '/' << request.device_number << '/'
               << request.device_method;
   if (request.api == EAlpacaApi::kDeviceApi) {
+#if TAS_ENABLE_BATCH_REQUESTS
+    if (request.device_method == EDeviceMethod::kBatch) {
+      return HandleBatchRequest(request, device, out);
+    }
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+#if TAS_ENABLE_EVENT_STREAMS
+    if (request.device_method == EDeviceMethod::kEvents) {
+      return HandleEventStreamRequest(request, out);
+    }
+#endif  // TAS_ENABLE_EVENT_STREAMS
+#if TAS_ENABLE_LONG_POLL
+    if (request.have_wait_for_change_ms &&
+        request.http_method == EHttpMethod::GET) {
+      return HandleLongPollRequest(request, device, out);
+    }
+#endif  // TAS_ENABLE_LONG_POLL
     return device.HandleDeviceApiRequest(request, out);
   } else if (request.api == EAlpacaApi::kDeviceSetup) {
     return device.HandleDeviceSetupRequest(request, out);
@@ -171,6 +327,204 @@ bool AlpacaDevices::DispatchDeviceRequest(AlpacaRequest& request,
   // COV_NF_END
 }
 
+#if TAS_ENABLE_BATCH_REQUESTS
+bool AlpacaDevices::HandleBatchRequest(AlpacaRequest& request,
+                                       DeviceInterface& device, Print& out) {
+  MCU_VLOG(3) << MCU_PSD("AlpacaDevices::HandleBatchRequest: ")
+              << request.num_batch_methods << MCU_PSD(" methods");
+  // A batch only reads (i.e. each method is performed as a GET request); there
+  // is no obvious meaning for a PUT batch, where all of the parameters would
+  // be passed to each of the methods.
+  if (request.http_method == EHttpMethod::PUT) {
+    return WriteResponse::HttpErrorResponse(
+        EHttpStatusCode::kHttpMethodNotAllowed, mcucore::AnyPrintable(), out);
+  } else if (request.num_batch_methods == 0) {
+    return WriteResponse::AscomParameterMissingErrorResponse(
+        request, ProgmemStringViews::Method(), out);
+  }
+
+  // We don't know the length of the body in advance: computing it would mean
+  // calling each of the handlers twice (e.g. reading each sensor twice), and
+  // the values might change between the two calls. Instead we tell the client
+  // that the connection will be closed at the end of the body.
+  HttpResponseHeader hrh;
+  hrh.status_code = EHttpStatusCode::kHttpOk;
+  hrh.reason_phrase = ProgmemStrings::OK();
+  hrh.content_type = EContentType::kApplicationJson;
+  hrh.do_close = true;
+  hrh.printTo(out);
+  if (request.http_method == EHttpMethod::HEAD) {
+    return false;
+  }
+
+  // Each element of the array is the JSON object that would have been the body
+  // of the response to a separate GET request for the corresponding method. If
+  // that response wasn't 200 OK, the element is instead an ASCOM error object
+  // with the HTTP status code in the message.
+  AlpacaRequest sub_request = request;
+  sub_request.http_method = EHttpMethod::GET;
+  sub_request.do_close = false;
+  sub_request.is_embedded = true;
+  out.print('[');
+  for (uint8_t ndx = 0; ndx < request.num_batch_methods; ++ndx) {
+    if (ndx > 0) {
+      out.print(',');
+    }
+    sub_request.device_method = request.batch_methods[ndx];
+    BatchElementPrint element_out(out);
+    device.HandleDeviceApiRequest(sub_request, element_out);
+    if (!element_out.ok()) {
+      HttpBodyPrint body_out(out);
+      WriteResponse::AscomErrorResponse(
+          sub_request, ErrorCodes::kUnspecifiedError,
+          mcucore::PrintableCat(MCU_FLASHSTR("HTTP status "),
+                                element_out.status_code()),
+          body_out);
+    }
+  }
+  out.print(']');
+  return false;  // There is no Content-Length in the header, so we can't
+                 // continue the connection after this.
+}
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_EVENT_STREAMS
+bool AlpacaDevices::HandleEventStreamRequest(AlpacaRequest& request,
+                                             Print& out) {
+  MCU_VLOG(3) << MCU_PSD("AlpacaDevices::HandleEventStreamRequest: ")
+              << MCU_NAME_VAL(num_event_streams_);
+  if (request.http_method == EHttpMethod::PUT) {
+    return WriteResponse::HttpErrorResponse(
+        EHttpStatusCode::kHttpMethodNotAllowed, mcucore::AnyPrintable(), out);
+  } else if (num_event_streams_ >= TAS_MAX_EVENT_STREAMS) {
+    // Limiting the number of event streams ensures that there are sockets left
+    // for the Alpaca API requests.
+    return WriteResponse::HttpErrorResponse(
+        EHttpStatusCode::kHttpServiceUnavailable,
+        mcucore::AnyPrintable(MCU_PSD("Too many event streams")), out);
+  }
+
+  // The stream continues until one end closes the connection, so there is no
+  // Content-Length.
+  HttpResponseHeader hrh;
+  hrh.status_code = EHttpStatusCode::kHttpOk;
+  hrh.reason_phrase = ProgmemStrings::OK();
+  hrh.content_type = EContentType::kTextEventStream;
+  hrh.do_close = true;
+  hrh.printTo(out);
+  if (request.http_method == EHttpMethod::HEAD) {
+    return false;
+  }
+  ++num_event_streams_;
+  return true;
+}
+
+bool AlpacaDevices::WriteEventStream(const AlpacaRequest& request,
+                                     EventStreamState& state, Print& out) {
+  const uint32_t now = millis();
+  if (state.have_state_hash &&
+      (now - state.last_check_millis) < TAS_EVENT_STREAM_MIN_INTERVAL_MS) {
+    return true;
+  }
+  state.last_check_millis = now;
+
+  DeviceInterface* device =
+      FindDevice(request.device_type, request.device_number);
+  if (device == nullptr) {
+    // COV_NF_START
+    MCU_DCHECK(false) << MCU_PSD("Event stream device not found");
+    return false;
+    // COV_NF_END
+  }
+
+  // The device state is printed once to compute its hash, and again only if it
+  // has changed (the responses are embedded, so the device doesn't print them
+  // an extra time to compute the Content-Length).
+  HashingPrint hasher;
+  WriteDeviceStateBody(request, *device, hasher);
+  if (!state.have_state_hash || state.state_hash != hasher.hash()) {
+    MCU_VLOG(4) << MCU_PSD("AlpacaDevices::WriteEventStream: state changed");
+    state.state_hash = hasher.hash();
+    state.have_state_hash = true;
+    state.last_write_millis = now;
+    out.print(MCU_FLASHSTR("event: devicestate\ndata: "));
+    EventDataPrint data_out(out);
+    WriteDeviceStateBody(request, *device, data_out);
+    out.print(MCU_FLASHSTR("\n\n"));
+  } else if ((now - state.last_write_millis) >= TAS_EVENT_STREAM_KEEPALIVE_MS) {
+    // A comment line, ignored by the client, but it allows us to discover that
+    // the client has gone away.
+    state.last_write_millis = now;
+    out.print(MCU_FLASHSTR(":\n\n"));
+  }
+  return true;
+}
+
+void AlpacaDevices::OnEventStreamClosed(const AlpacaRequest& request) {
+  MCU_VLOG(3) << MCU_PSD("AlpacaDevices::OnEventStreamClosed: ")
+              << request.device_type << '/' << request.device_number;
+  MCU_DCHECK_GT(num_event_streams_, 0);
+  if (num_event_streams_ > 0) {
+    --num_event_streams_;
+  }
+}
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+bool AlpacaDevices::HandleLongPollRequest(AlpacaRequest& request,
+                                          DeviceInterface& device, Print& out) {
+  const uint32_t hash = HashOfResponseValue(request, device);
+  if (!request.have_if_not_equal) {
+    request.if_not_equal_hash = hash;
+    request.have_if_not_equal = true;
+  }
+  if (hash != request.if_not_equal_hash || request.wait_for_change_ms == 0) {
+    return device.HandleDeviceApiRequest(request, out);
+  }
+  MCU_VLOG(3) << MCU_PSD("AlpacaDevices::HandleLongPollRequest: parking ")
+              << request.device_method << MCU_PSD(" for ")
+              << request.wait_for_change_ms << MCU_PSD("ms");
+  if (request.wait_for_change_ms > TAS_MAX_WAIT_FOR_CHANGE_MS) {
+    request.wait_for_change_ms = TAS_MAX_WAIT_FOR_CHANGE_MS;
+  }
+  request.parked_millis = millis();
+  request.last_check_millis = request.parked_millis;
+  request.is_parked = true;
+  return true;
+}
+
+bool AlpacaDevices::WriteParkedRequest(AlpacaRequest& request, Print& out) {
+  MCU_DCHECK(request.is_parked);
+  DeviceInterface* device =
+      FindDevice(request.device_type, request.device_number);
+  if (device == nullptr) {
+    // COV_NF_START
+    MCU_DCHECK(false) << MCU_PSD("Parked request device not found");
+    return false;
+    // COV_NF_END
+  }
+
+  const uint32_t now = millis();
+  if ((now - request.parked_millis) < request.wait_for_change_ms) {
+    if ((now - request.last_check_millis) < TAS_LONG_POLL_CHECK_INTERVAL_MS) {
+      return true;
+    }
+    request.last_check_millis = now;
+    if (HashOfResponseValue(request, *device) == request.if_not_equal_hash) {
+      return true;
+    }
+  }
+
+  // Either the value has changed, or we've waited long enough, so respond
+  // with the current value.
+  MCU_VLOG(3) << MCU_PSD("AlpacaDevices::WriteParkedRequest: unparking ")
+              << request.device_method << MCU_PSD(" after ")
+              << (now - request.parked_millis) << MCU_PSD("ms");
+  request.is_parked = false;
+  return device->HandleDeviceApiRequest(request, out);
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
 // Returns the specified device, or nullptr if not found.
 DeviceInterface* AlpacaDevices::FindDevice(EDeviceType device_type,
                                            uint32_t device_number) {
@@ -11,8 +11,11 @@
 #include <McuCore.h>
 
 #include "alpaca_request.h"
+#include "config.h"
 #include "constants.h"
 #include "device_interface.h"
+#include "event_stream_state.h"
+#include "loop_profiler.h"
 #include "server_context.h"
 
 namespace alpaca {
@@ -38,8 +41,18 @@ class AlpacaDevices {
   // responding to a request (e.g. periodically reading sensor values).
   void MaintainDevices();
 
+#if TAS_ENABLE_LOOP_PROFILER
+  // As above, recording in profiler the time taken by each device.
+  void MaintainDevices(LoopProfiler& profiler);
+#endif  // TAS_ENABLE_LOOP_PROFILER
+
+  mcucore::ArrayView<DeviceInterface*> devices() const { return devices_; }
+
   // Given a request for "/management/v1/configureddevices", writes the response
-  // to out.
+  // to out. The response is written whole (i.e. isn't resumable, see
+  // TAS_ENABLE_RESUMABLE_RESPONSES) so that it can have a Content-Length and
+  // the connection can be kept open; it is about 150 bytes per device, so fits
+  // in the socket's transmit buffer unless there are many devices.
   bool HandleManagementConfiguredDevices(AlpacaRequest& request, Print& out);
 
   // Given an HTTP Device API or Device Setup request, dispatches to the
@@ -52,15 +65,65 @@ class AlpacaDevices {
   void AddToHomePageHtml(const AlpacaRequest& request, EHtmlPageSection section,
                          mcucore::OPrintStream& strm);
 
+#if TAS_ENABLE_EVENT_STREAMS
+  // Given the request that started an event stream, writes to out an event with
+  // the state of the device if it has changed since the last event, subject to
+  // throttling; if nothing has been written for a while, writes a keep-alive
+  // comment instead. Returns true if the stream should be kept open.
+  bool WriteEventStream(const AlpacaRequest& request, EventStreamState& state,
+                        Print& out);
+
+  // Called when an event stream has ended, making room for another.
+  void OnEventStreamClosed(const AlpacaRequest& request);
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+  // Given a request parked by DispatchDeviceRequest (i.e. with is_parked set),
+  // writes the response if the Value has changed or the wait has expired, in
+  // which case is_parked is cleared. Returns false if the connection should be
+  // closed.
+  bool WriteParkedRequest(AlpacaRequest& request, Print& out);
+#endif  // TAS_ENABLE_LONG_POLL
+
  private:
   bool DispatchDeviceRequest(AlpacaRequest& request, DeviceInterface& device,
                              Print& out);
 
+#if TAS_ENABLE_BATCH_REQUESTS
+  // Handles a request for /api/v1/{device_type}/{device_number}/batch by
+  // dispatching a GET request to the device for each of the methods in
+  // request.batch_methods, writing a response whose body is a JSON array of the
+  // bodies of the individual responses, in the order requested.
+  bool HandleBatchRequest(AlpacaRequest& request, DeviceInterface& device,
+                          Print& out);
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_EVENT_STREAMS
+  // Handles a request for /api/v1/{device_type}/{device_number}/events by
+  // writing the header of a Server-Sent Events response, if there is room for
+  // another event stream, else writes an error response. Returns true if the
+  // connection is to be used for streaming events.
+  bool HandleEventStreamRequest(AlpacaRequest& request, Print& out);
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+  // Handles a GET request with a WaitForChangeMs parameter: if the Value in the
+  // response would not be equal to IfNotEqual (or if the wait is zero), writes
+  // the response immediately. Otherwise parks the request by setting
+  // request.is_parked, without writing anything, and returns true; the caller
+  // is then expected to call WriteParkedRequest from time to time.
+  bool HandleLongPollRequest(AlpacaRequest& request, DeviceInterface& device,
+                             Print& out);
+#endif  // TAS_ENABLE_LONG_POLL
+
   // Returns the specified device, or nullptr if not found.
   DeviceInterface* FindDevice(EDeviceType device_type, uint32_t device_number);
 
   ServerContext& server_context_;
   mcucore::ArrayView<DeviceInterface*> devices_;
+#if TAS_ENABLE_EVENT_STREAMS
+  uint8_t num_event_streams_;
+#endif  // TAS_ENABLE_EVENT_STREAMS
 };
 
 }  // namespace alpaca
@@ -4,7 +4,59 @@
 
 #include "constants.h"
 
+#if TAS_ENABLE_LONG_POLL
+#include "utils/hashing_print.h"
+#endif  // TAS_ENABLE_LONG_POLL
+
 namespace alpaca {
+namespace {
+
+#if TAS_ENABLE_BATCH_REQUESTS
+// Returns true if the method may be an element of a batch, i.e. if it is an
+// ASCOM method whose value can be read with a GET request. Methods which may
+// only be used with PUT (e.g. opencover) are excluded, as are the Tiny Alpaca
+// Server extensions.
+bool IsBatchableMethod(EDeviceMethod method) {
+  switch (method) {
+    case EDeviceMethod::kUnknown:
+    case EDeviceMethod::kSetup:
+    case EDeviceMethod::kBatch:
+    case EDeviceMethod::kEvents:
+    case EDeviceMethod::kAction:
+    case EDeviceMethod::kCommandBlind:
+    case EDeviceMethod::kCommandBool:
+    case EDeviceMethod::kCommandString:
+    case EDeviceMethod::kCalibratorOff:
+    case EDeviceMethod::kCalibratorOn:
+    case EDeviceMethod::kCloseCover:
+    case EDeviceMethod::kHaltCover:
+    case EDeviceMethod::kOpenCover:
+    case EDeviceMethod::kRefresh:
+    case EDeviceMethod::kSetSwitch:
+    case EDeviceMethod::kSetSwitchName:
+    case EDeviceMethod::kSetSwitchValue:
+      return false;
+    default:
+      return true;
+  }
+}
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_LONG_POLL
+// Returns the value of a hexadecimal digit, or -1 if c isn't one.
+int HexDigitValue(char c) {
+  if ('0' <= c && c <= '9') {
+    return c - '0';
+  } else if ('a' <= c && c <= 'f') {
+    return c - 'a' + 10;
+  } else if ('A' <= c && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
+}  // namespace
 
 AlpacaRequest::AlpacaRequest() {
   // This call is mainly a benefit to tests. The server/decoder should call
@@ -15,6 +67,7 @@ AlpacaRequest::AlpacaRequest() {
 void AlpacaRequest::Reset() {
   http_method = EHttpMethod::kUnknown;
   sensor_name = ESensorName::kUnknown;
+  action = EDeviceAction::kUnknown;
 
   have_client_id = false;
   have_client_transaction_id = false;
@@ -27,6 +80,18 @@ void AlpacaRequest::Reset() {
   have_average_period = false;
   have_string_value = false;
   saw_content_type = false;
+#if TAS_ENABLE_LONG_POLL
+  have_wait_for_change_ms = false;
+  have_if_not_equal = false;
+  is_parked = false;
+#endif  // TAS_ENABLE_LONG_POLL
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  has_resumable_response = false;
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+#if TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || \
+    TAS_ENABLE_LONG_POLL
+  is_embedded = false;
+#endif  // TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || ...
 
   do_close = false;
 
@@ -50,9 +115,84 @@ void AlpacaRequest::Reset() {
   client_transaction_id = kResetClientTransactionId;
   id = -1;
 
+#if TAS_ENABLE_BATCH_REQUESTS
+  num_batch_methods = 0;
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+  num_switch_values = 0;
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
 #if TAS_ENABLE_EXTRA_REQUEST_PARAMETERS
   extra_parameters.clear();
 #endif  // TAS_ENABLE_EXTRA_REQUEST_PARAMETERS
 }
 
+#if TAS_ENABLE_BATCH_REQUESTS
+bool AlpacaRequest::add_batch_method(EDeviceMethod method) {
+  if (!(http_method == EHttpMethod::GET || http_method == EHttpMethod::HEAD) ||
+      !IsBatchableMethod(method) ||
+      num_batch_methods >= TAS_MAX_BATCH_METHODS) {
+    return false;
+  }
+  batch_methods[num_batch_methods++] = method;
+  return true;
+}
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+bool AlpacaRequest::set_switch_values(mcucore::StringView list) {
+  num_switch_values = 0;
+  while (true) {
+    mcucore::StringView::size_type end = 0;
+    while (end < list.size() && list.at(end) != ',') {
+      ++end;
+    }
+    double value;
+    if (num_switch_values >= TAS_MAX_SWITCH_VALUES ||
+        !list.prefix(end).to_double(value)) {
+      num_switch_values = 0;
+      return false;
+    }
+    switch_values[num_switch_values++] = value;
+    if (end == list.size()) {
+      return true;
+    }
+    list.remove_prefix(end + 1);
+  }
+}
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
+#if TAS_ENABLE_LONG_POLL
+bool AlpacaRequest::set_if_not_equal(const mcucore::StringView& value) {
+  MCU_DCHECK(!have_if_not_equal);
+  // Mimic the start and end of a JSON response body, with the URL decoded
+  // value in place of the Value property's JSON value.
+  JsonPropertyHashingPrint hasher;
+  hasher.print(MCU_FLASHSTR("{\"Value\": "));
+  for (mcucore::StringView::size_type ndx = 0; ndx < value.size(); ++ndx) {
+    char c = value.at(ndx);
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%') {
+      if (value.size() - ndx < 3) {
+        return false;
+      }
+      const int high = HexDigitValue(value.at(ndx + 1));
+      const int low = HexDigitValue(value.at(ndx + 2));
+      if (high < 0 || low < 0) {
+        return false;
+      }
+      c = static_cast<char>(high * 16 + low);
+      ndx += 2;
+    }
+    hasher.write(static_cast<uint8_t>(c));
+  }
+  hasher.print('}');
+  if_not_equal_hash = hasher.hash();
+  have_if_not_equal = true;
+  return true;
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
 }  // namespace alpaca
@@ -95,6 +95,40 @@ struct AlpacaRequest {
     return true;
   }
 
+#if TAS_ENABLE_BATCH_REQUESTS
+  // Appends a method to the list of methods to be performed by a batch
+  // request. Only GET and HEAD batches are supported, so the method must be
+  // one whose value can be read with a GET request. Returns false if the
+  // batch's http_method isn't a read, if the method can't be read or can't be
+  // included in a batch (e.g. a nested batch), or if there is no more room.
+  bool add_batch_method(EDeviceMethod method);
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+  // Sets switch_values from a comma separated list of numbers (e.g. the
+  // Parameters of a SetSwitchValues action). Returns false if any of the
+  // entries isn't a number, or if there are too many, in which case
+  // num_switch_values is zero.
+  bool set_switch_values(mcucore::StringView list);
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
+#if TAS_ENABLE_LONG_POLL
+  void set_wait_for_change_ms(uint32_t ms) {
+    MCU_DCHECK(!have_wait_for_change_ms);
+    wait_for_change_ms = ms;
+    have_wait_for_change_ms = true;
+  }
+
+  // Records the hash of the IfNotEqual parameter's value, computed as if it
+  // were the Value of a response, so that it can be compared with the hash of
+  // the Value of the response to this request. The value is URL decoded (i.e.
+  // %XX and '+'), and must then be the Value exactly as it appears in the JSON
+  // of the server's earlier response, optionally without the quotes around a
+  // string; e.g. the server formats the numbers, so 1.50 won't match 1.5.
+  // Returns false if the value has an invalid percent escape.
+  bool set_if_not_equal(const mcucore::StringView& value);
+#endif  // TAS_ENABLE_LONG_POLL
+
   // From the HTTP method and path:
   EHttpMethod http_method;
   EApiGroup api_group;
@@ -119,12 +153,14 @@ struct AlpacaRequest {
   uint32_t client_id;
   uint32_t client_transaction_id;
   ESensorName sensor_name;
+  EDeviceAction action;  // kUnknown if the Action isn't one we implement.
   bool connected;
   int32_t brightness;
   int32_t id;  // Switch id.
   bool state;
   double value;
   double average_period;
+  // The value of the Name or the Parameters parameter.
   mcucore::TinyString<32> string_value;
 
   // NOT from the client; this is set by the server/decoder at the *start* of
@@ -138,6 +174,34 @@ struct AlpacaRequest {
   ExtraParameterValueMap extra_parameters;
 #endif  // TAS_ENABLE_EXTRA_REQUEST_PARAMETERS
 
+#if TAS_ENABLE_BATCH_REQUESTS
+  // The methods named by the Method parameters of a batch request, in the order
+  // in which they appeared in the request.
+  EDeviceMethod batch_methods[TAS_MAX_BATCH_METHODS];
+  uint8_t num_batch_methods;
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+  // The values in the Parameters parameter, if it is a list of numbers, as
+  // needed by the SetSwitchValues action. Parameters may be too long to fit in
+  // string_value, so the list is decoded as the request is received.
+  double switch_values[TAS_MAX_SWITCH_VALUES];
+  uint8_t num_switch_values;
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
+#if TAS_ENABLE_LONG_POLL
+  // From the WaitForChangeMs and IfNotEqual parameters. If IfNotEqual isn't
+  // provided, if_not_equal_hash is set to the hash of the Value at the time the
+  // request is handled, i.e. the response is delayed until the value changes.
+  uint32_t wait_for_change_ms;
+  uint32_t if_not_equal_hash;
+
+  // NOT from the client; these are set while the request is parked, i.e. while
+  // the response is delayed waiting for the value to change.
+  uint32_t parked_millis;
+  uint32_t last_check_millis;
+#endif  // TAS_ENABLE_LONG_POLL
+
   // Set to zero by Reset, set to 1 when the corresponding field is set.
   unsigned int have_client_id : 1;
   unsigned int have_client_transaction_id : 1;
@@ -149,6 +213,29 @@ struct AlpacaRequest {
   unsigned int have_value : 1;
   unsigned int have_average_period : 1;
   unsigned int have_string_value : 1;
+#if TAS_ENABLE_LONG_POLL
+  unsigned int have_wait_for_change_ms : 1;
+  unsigned int have_if_not_equal : 1;
+
+  // Set while the request is parked.
+  unsigned int is_parked : 1;
+#endif  // TAS_ENABLE_LONG_POLL
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  // NOT from the client; set by the RequestListener when the response is to be
+  // written in parts (see RequestListener::OnResumableResponseCanWrite).
+  unsigned int has_resumable_response : 1;
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+
+#if TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || \
+    TAS_ENABLE_LONG_POLL
+  // NOT from the client; set by AlpacaDevices on a copy of a request which it
+  // passes to a device in order to embed the body of the response in another
+  // response, or to hash it. The header of such a response is discarded, so
+  // WriteResponse omits the Content-Length, which it would otherwise have to
+  // print the body an extra time to compute.
+  unsigned int is_embedded : 1;
+#endif  // TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || ...
 
   // So far we only support a single content type for PUT requests, so don't
   // store it.
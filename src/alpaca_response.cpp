@@ -7,6 +7,8 @@
 #include "http_response_header.h"
 #include "json_response.h"
 #include "literals.h"
+#include "request_journal.h"
+#include "utils/fixed_point.h"
 
 namespace alpaca {
 namespace {
@@ -25,6 +27,69 @@ class ProgmemStringArraySource : public mcucore::JsonElementSource {
   const mcucore::ProgmemStringArray& strings_;
 };
 
+// Forwards to another Print all but the first byte written to it.
+class SkipFirstBytePrint : public Print {
+ public:
+  explicit SkipFirstBytePrint(Print& out) : out_(out) {}
+
+  size_t write(uint8_t b) override {
+    if (!skipped_) {
+      skipped_ = true;
+      return 1;
+    }
+    const size_t result = out_.write(b);
+    count_ += result;
+    return result;
+  }
+
+  // Returns the number of bytes written to out_.
+  size_t count() const { return count_; }
+
+ private:
+  Print& out_;
+  bool skipped_ = false;
+  size_t count_ = 0;
+};
+
+// The JSON body of a response whose Value is a FixedPoint. JsonObjectEncoder
+// can only print floating point values as doubles, so the Value property is
+// printed here, followed by the remainder of the object as produced by
+// JsonMethodResponse, minus its opening brace.
+class FixedPointResponseBody : public Printable {
+ public:
+  FixedPointResponseBody(const AlpacaRequest& request, FixedPoint value)
+      : request_(request), value_(value) {}
+
+  size_t printTo(Print& out) const override {
+    size_t count = out.print('{');
+    count += out.print('"');
+    count += ProgmemStringViews::Value().printTo(out);
+    count += out.print(MCU_FLASHSTR("\": "));
+    count += value_.PrintTo(out);
+    count += out.print(MCU_FLASHSTR(", "));
+    JsonMethodResponse method_response(request_);
+    mcucore::PrintableJsonObject remainder(method_response);
+    SkipFirstBytePrint skip_open_brace(out);
+    remainder.printTo(skip_open_brace);
+    return count + skip_open_brace.count();
+  }
+
+ private:
+  const AlpacaRequest& request_;
+  const FixedPoint value_;
+};
+
+// Returns true if the response header should include the Content-Length, which
+// requires printing the body an extra time in order to measure it.
+bool NeedsContentLength(const AlpacaRequest& request) {
+#if TAS_ENABLE_BATCH_REQUESTS || TAS_ENABLE_EVENT_STREAMS || \
+    TAS_ENABLE_LONG_POLL
+  return !request.is_embedded;
+#else
+  return true;
+#endif
+}
+
 }  // namespace
 
 bool WriteResponse::OkResponse(const AlpacaRequest& request,
@@ -36,9 +101,11 @@ bool WriteResponse::OkResponse(const AlpacaRequest& request,
   hrh.status_code = EHttpStatusCode::kHttpOk;
   hrh.reason_phrase = ProgmemStrings::OK();
   hrh.content_type = content_type;
-  hrh.content_length = mcucore::SizeOfPrintable(content_source);
-  if (append_http_newline) {
-    hrh.content_length += 2;
+  if (NeedsContentLength(request)) {
+    hrh.content_length = mcucore::SizeOfPrintable(content_source);
+    if (append_http_newline) {
+      hrh.content_length += 2;
+    }
   }
   hrh.do_close = request.do_close;
   hrh.printTo(out);
@@ -115,6 +182,23 @@ bool WriteResponse::StatusOrDoubleResponse(
   }
 }
 
+bool WriteResponse::FixedPointResponse(const AlpacaRequest& request,
+                                       FixedPoint value, Print& out) {
+  FixedPointResponseBody body(request, value);
+  return OkResponse(request, EContentType::kApplicationJson, body, out,
+                    /*append_http_newline=*/true);
+}
+
+bool WriteResponse::StatusOrFixedPointResponse(
+    const AlpacaRequest& request,
+    mcucore::StatusOr<FixedPoint> status_or_value, Print& out) {
+  if (status_or_value.ok()) {
+    return FixedPointResponse(request, status_or_value.value(), out);
+  } else {
+    return AscomErrorResponse(request, status_or_value.status(), out);
+  }
+}
+
 bool WriteResponse::FloatResponse(const AlpacaRequest& request, float value,
                                   Print& out) {
   JsonFloatResponse source(request, value);
@@ -210,6 +294,9 @@ bool WriteResponse::AscomErrorResponse(AlpacaRequest request,
                                        const Printable& error_message,
                                        Print& out) {
   request.do_close = true;
+#if TAS_ENABLE_REQUEST_JOURNAL
+  ResponseOutcome::RecordAscomError(error_number);
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
   JsonMethodResponse source(request, error_number, error_message);
   return OkJsonResponse(request, source, out);
 }
@@ -274,6 +361,23 @@ bool WriteResponse::AscomParameterInvalidErrorResponse(
                             out);
 }
 
+bool WriteResponse::ServiceUnavailableResponse(uint16_t retry_after_seconds,
+                                               Print& out) {
+  HttpResponseHeader hrh;
+  hrh.status_code = EHttpStatusCode::kHttpServiceUnavailable;
+#if TAS_ENABLE_REQUEST_JOURNAL
+  ResponseOutcome::RecordHttpError(hrh.status_code);
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
+  hrh.reason_phrase =
+      ToFlashStringHelper(EHttpStatusCode::kHttpServiceUnavailable);
+  hrh.content_type = EContentType::kTextPlain;
+  hrh.content_length = 0;
+  hrh.retry_after_seconds = retry_after_seconds;
+  hrh.do_close = true;
+  hrh.printTo(out);
+  return false;
+}
+
 bool WriteResponse::HttpErrorResponse(EHttpStatusCode status_code,
                                       const Printable& body, Print& out) {
   MCU_DCHECK_GE(status_code, EHttpStatusCode::kHttpBadRequest)
@@ -289,6 +393,9 @@ bool WriteResponse::HttpErrorResponse(EHttpStatusCode status_code,
   } else {
     hrh.status_code = status_code;
   }
+#if TAS_ENABLE_REQUEST_JOURNAL
+  ResponseOutcome::RecordHttpError(hrh.status_code);
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
   if (status_code < EHttpStatusCode::kHttpBadRequest || phrase == nullptr) {
     hrh.reason_phrase =
         MCU_PSD("Internal Server Error: Invalid HTTP mcucore::Status Code");
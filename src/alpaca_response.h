@@ -9,6 +9,7 @@
 
 #include "alpaca_request.h"
 #include "constants.h"
+#include "utils/fixed_point.h"
 
 namespace alpaca {
 
@@ -78,6 +79,14 @@ struct WriteResponse {
                                      mcucore::StatusOr<double> status_or_value,
                                      Print& out);
 
+  // Produces the same response as DoubleResponse(value.ToDouble()) would, but
+  // without any floating point arithmetic.
+  static bool FixedPointResponse(const AlpacaRequest& request,
+                                 FixedPoint value, Print& out);
+  static bool StatusOrFixedPointResponse(
+      const AlpacaRequest& request,
+      mcucore::StatusOr<FixedPoint> status_or_value, Print& out);
+
   // TODO(jamessynge): Decide whether to keep the versions with float values.
   // Arduino's Print class only handles doubles, not floats, and the Alpaca API
   // specifies double as the floating point type, so this may be pointless.
@@ -188,6 +197,12 @@ struct WriteResponse {
   static bool AscomActionNotImplementedResponse(const AlpacaRequest& request,
                                                 Print& out);
 
+  // Writes an HTTP 503 Service Unavailable response, with an empty body and a
+  // Retry-After header, to out. This is cheap to produce, so can be used when
+  // the server is overloaded. Returns false.
+  static bool ServiceUnavailableResponse(uint16_t retry_after_seconds,
+                                         Print& out);
+
   // Writes an HTTP error response with a text body to out. Returns false.
   static bool HttpErrorResponse(EHttpStatusCode status_code,
                                 const Printable& body, Print& out);
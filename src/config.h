@@ -30,12 +30,245 @@
 #endif
 #endif
 
-// The number of hardware sockets we'll dedicate to listening for TCP
-// connections to the Tiny Alpaca Server.
+// The number of TCP connections to the Tiny Alpaca Server that we can handle at
+// once, i.e. the number of ServerConnection objects, each of which has room for
+// the decoder and request state of one connection. Hardware sockets are leased
+// for these connections until TAS_MIN_LISTENING_SOCKETS are listening for new
+// connections (or all of the connections have a socket), leaving
+// TAS_NUM_RESERVED_SOCKETS hardware sockets (plus one for the priority port)
+// for other uses (e.g. DHCP renewal, or outbound connections), except when that
+// would leave no socket listening. Once leased, a socket stays with its
+// connection, and listens again after the client disconnects.
+//
+// With the defaults, every connection is leased a socket by Initialize, exactly
+// as when each connection had a dedicated socket, so the number of concurrent
+// clients is unchanged. Leasing later only matters if a socket couldn't be
+// leased at startup (e.g. it was in use), or if these limits are lowered. As
+// before, no socket is listening while every connection is in use by a client;
+// when TAS_ENABLE_EVENT_STREAMS is on, a static_assert ensures that there are
+// more connections than event streams.
 #ifndef TAS_NUM_SERVER_CONNECTIONS
 #define TAS_NUM_SERVER_CONNECTIONS 3
 #endif
 
+#ifndef TAS_MIN_LISTENING_SOCKETS
+#define TAS_MIN_LISTENING_SOCKETS TAS_NUM_SERVER_CONNECTIONS
+#endif
+
+#ifndef TAS_NUM_RESERVED_SOCKETS
+#define TAS_NUM_RESERVED_SOCKETS 0
+#endif
+
+// Each call to ServerSocketsAndConnections::PerformIO services each connection
+// at most once (i.e. reads at most SERVER_CONNECTION_INPUT_BUFFER_SIZE bytes
+// and dispatches at most one request), starting with a different connection
+// each time. Once TAS_PERFORM_IO_BUDGET_MICROS have elapsed, the remaining
+// connections are left for the next call, though at least one connection is
+// serviced per call. TAS_MAX_WRITE_BYTES_PER_PASS limits how much of a
+// resumable response (see TAS_ENABLE_RESUMABLE_RESPONSES) or of an event stream
+// is written when a connection is serviced. Those are written only as fast as
+// the connection's availableForWrite() allows, except that Arduino's
+// Print::availableForWrite() returns 0 unless overridden, so 0 is taken to mean
+// that the space is unknown, in which case up to
+// TAS_WRITE_BYTES_IF_SPACE_UNKNOWN are written per pass (which may wait for
+// the client to acknowledge earlier writes, as any write of a whole response
+// may).
+#ifndef TAS_PERFORM_IO_BUDGET_MICROS
+#define TAS_PERFORM_IO_BUDGET_MICROS 5000
+#endif
+
+#ifndef TAS_MAX_WRITE_BYTES_PER_PASS
+#define TAS_MAX_WRITE_BYTES_PER_PASS 1024
+#endif
+
+#ifndef TAS_WRITE_BYTES_IF_SPACE_UNKNOWN
+#define TAS_WRITE_BYTES_IF_SPACE_UNKNOWN 256
+#endif
+
+// If non-zero, ServerConnection closes a connection on which the client has
+// neither sent nor received anything for TAS_CONNECTION_IDLE_TIMEOUT_MS, or on
+// which the client has taken more than TAS_REQUEST_TIMEOUT_MS to send a
+// complete request (header and body) after sending its first byte. This
+// prevents idle or very slow clients from tying up the few hardware sockets.
+// Event streams and parked requests have their own limits, so aren't subject
+// to these deadlines. The number of connections closed for each reason is
+// served at /metrics if TAS_ENABLE_METRICS is non-zero.
+#ifndef TAS_ENABLE_CONNECTION_DEADLINES
+#define TAS_ENABLE_CONNECTION_DEADLINES 1
+#endif
+
+#ifndef TAS_CONNECTION_IDLE_TIMEOUT_MS
+#define TAS_CONNECTION_IDLE_TIMEOUT_MS 30000
+#endif
+
+#ifndef TAS_REQUEST_TIMEOUT_MS
+#define TAS_REQUEST_TIMEOUT_MS 5000
+#endif
+
+// If non-zero, requests are assigned to a lane (see request_lanes.h) as soon as
+// their path has been decoded; connections with a request in the priority lane
+// are serviced first in the next call to
+// ServerSocketsAndConnections::PerformIO. If TAS_ENABLE_METRICS is also
+// non-zero, the latency of requests is recorded for each lane (12 bytes of RAM
+// per lane in each connection), and served at /metrics. If
+// TAS_PRIORITY_TCP_PORT is non-zero, a hardware socket is reserved for
+// listening on that port, and all requests received on it are in the priority
+// lane. This allows, for example, an observatory's
+// safety logic to reach the server even while browsers are using all of the
+// other connections.
+#ifndef TAS_ENABLE_PRIORITY_LANES
+#define TAS_ENABLE_PRIORITY_LANES 1
+#endif
+
+#ifndef TAS_PRIORITY_TCP_PORT
+#define TAS_PRIORITY_TCP_PORT 0
+#endif
+
+// If non-zero, TinyAlpacaDeviceServer measures the time between calls to
+// MaintainDevices (i.e. the duration of the Arduino loop), and when the average
+// exceeds TAS_OVERLOAD_LOOP_MICROS, ServerConnection responds to requests in
+// the low lane (e.g. the setup and status pages) with 503 Service Unavailable,
+// including a Retry-After header of TAS_OVERLOAD_RETRY_AFTER_SECONDS, until
+// the average drops below TAS_OVERLOAD_EXIT_LOOP_MICROS. Requires
+// TAS_ENABLE_PRIORITY_LANES.
+#ifndef TAS_ENABLE_OVERLOAD_SHEDDING
+#define TAS_ENABLE_OVERLOAD_SHEDDING TAS_ENABLE_PRIORITY_LANES
+#endif
+
+#ifndef TAS_OVERLOAD_LOOP_MICROS
+#define TAS_OVERLOAD_LOOP_MICROS 20000
+#endif
+
+#ifndef TAS_OVERLOAD_EXIT_LOOP_MICROS
+#define TAS_OVERLOAD_EXIT_LOOP_MICROS 10000
+#endif
+
+#ifndef TAS_OVERLOAD_RETRY_AFTER_SECONDS
+#define TAS_OVERLOAD_RETRY_AFTER_SECONDS 2
+#endif
+
+// If non-zero, ServerConnection measures the time taken to decode, handle and
+// write the response to each request, and reports it to the RequestListener
+// (as it also does for TAS_ENABLE_REQUEST_JOURNAL), and TinyAlpacaDeviceServer
+// collects histograms of those times, and counts of requests and of decoding
+// errors, which it serves at /metrics in the Prometheus text format. This uses
+// about 550 bytes of RAM, a large fraction of the 8KB of an ATmega2560, so it is
+// disabled by default.
+#ifndef TAS_ENABLE_METRICS
+#define TAS_ENABLE_METRICS 0
+#endif
+
+// If non-zero, the time taken by each phase of the Arduino loop is recorded:
+// the whole loop, TinyAlpacaNetworkServer::PerformIO, and the MaintainDevice
+// method of each of the first TAS_LOOP_PROFILER_MAX_DEVICES devices. The min,
+// mean, max and 99th percentile of each phase are shown on the server's status
+// page (which doesn't need TAS_ENABLE_METRICS), and are also served at /metrics
+// if TAS_ENABLE_METRICS is non-zero. The 99th percentile is of the most recent
+// TAS_LOOP_PROFILER_WINDOW durations (at most 255), each of which takes two
+// bytes of RAM per phase. With the defaults the profiler uses about 600 bytes
+// of RAM, so it is disabled by default.
+//
+// Limitations: network IO is timed as a whole, including the discovery server,
+// so the profile doesn't show which connection used the time; the per
+// connection service times are only available at /metrics, when
+// TAS_ENABLE_METRICS is non-zero. Devices beyond the first
+// TAS_LOOP_PROFILER_MAX_DEVICES aren't timed separately, though their time is
+// included in that of the whole loop.
+#ifndef TAS_ENABLE_LOOP_PROFILER
+#define TAS_ENABLE_LOOP_PROFILER 0
+#endif
+
+#ifndef TAS_LOOP_PROFILER_WINDOW
+#define TAS_LOOP_PROFILER_WINDOW 32
+#endif
+
+#ifndef TAS_LOOP_PROFILER_MAX_DEVICES
+#define TAS_LOOP_PROFILER_MAX_DEVICES 4
+#endif
+
+// If non-zero, TinyAlpacaDeviceServer keeps a journal of the last
+// TAS_REQUEST_JOURNAL_SIZE requests (at most 255, 24 bytes each), which is
+// served at /management/v1/requestjournal. Each entry has the server and client
+// transaction ids, the device and method, the HTTP status and ASCOM error
+// number of the response, and the decode and handle times. ServerConnection
+// measures those times if either this or TAS_ENABLE_METRICS is non-zero, so
+// the journal doesn't depend on the metrics. Enabled by default only for host
+// builds (i.e. tests), to save RAM on the microcontroller, which also means
+// that the tests cover the journal without the metrics.
+#ifndef TAS_ENABLE_REQUEST_JOURNAL
+#define TAS_ENABLE_REQUEST_JOURNAL MCU_HOST_TARGET
+#endif
+
+#ifndef TAS_REQUEST_JOURNAL_SIZE
+#define TAS_REQUEST_JOURNAL_SIZE 8
+#endif
+
+// If non-zero, TAS_TRACE records fixed size binary records of events such as
+// connections opening and closing, the request decoder moving from one decode
+// function to the next, and requests being dispatched, in a RAM ring buffer of
+// TAS_TRACE_RING_SIZE records (8 bytes each). Unlike MCU_VLOG, this doesn't
+// format any text at the time of the event, so has little effect on the timing
+// of the server. Call TraceRing::Global().DumpTo(Serial) to dump the buffer,
+// and decode the dump with extras/dev_tools/decode_trace.py.
+#ifndef TAS_ENABLE_TRACE_RING
+#define TAS_ENABLE_TRACE_RING 0
+#endif
+
+#ifndef TAS_TRACE_RING_SIZE
+#define TAS_TRACE_RING_SIZE 64
+#endif
+
+// If non-zero, TinyAlpacaDeviceServer reports the high-water mark of the stack
+// (on AVR, where unused RAM is painted at startup), and the sizes of the
+// largest structs, on the server's status page and at /metrics. The stack is
+// measured in full when reported, and in the background by a scan started every
+// TAS_MEMORY_USAGE_SAMPLE_MILLIS, which examines at most
+// TAS_MEMORY_USAGE_SCAN_BYTES bytes of RAM per pass of the server's loop so
+// that the loop isn't delayed by scanning all of the unused RAM at once.
+#ifndef TAS_ENABLE_MEMORY_USAGE
+#define TAS_ENABLE_MEMORY_USAGE 1
+#endif
+
+#ifndef TAS_MEMORY_USAGE_SAMPLE_MILLIS
+#define TAS_MEMORY_USAGE_SAMPLE_MILLIS 1000
+#endif
+
+#ifndef TAS_MEMORY_USAGE_SCAN_BYTES
+#define TAS_MEMORY_USAGE_SCAN_BYTES 128
+#endif
+
+// The maximum number of sensors that each ObservingConditionsAdapter can
+// register for periodic sampling (see SensorSampler). Every
+// ObservingConditionsAdapter reserves RAM for this many sensors, about 24 bytes
+// each, plus the size of its SensorHistory (about 64 bytes with the default
+// TAS_SENSOR_HISTORY_LENGTH) if TAS_ENABLE_SENSOR_HISTORY is non-zero.
+#ifndef TAS_MAX_SAMPLED_SENSORS
+#define TAS_MAX_SAMPLED_SENSORS 4
+#endif
+
+// If non-zero, SensorSampler keeps a history of each sampled sensor, one point
+// (the mean of the readings) per TAS_SENSOR_HISTORY_INTERVAL_MILLIS, for the
+// most recent TAS_SENSOR_HISTORY_LENGTH intervals; ObservingConditionsAdapter
+// returns it in response to the History action. The points are stored as 16
+// bit deltas, so each sensor takes 2 bytes of RAM per point, plus about 16,
+// i.e. about 64 bytes with the default length, for each of the
+// TAS_MAX_SAMPLED_SENSORS of every ObservingConditionsAdapter; hence it is
+// disabled by default. The response to the History action isn't written in
+// parts (see TAS_ENABLE_RESUMABLE_RESPONSES), so it must fit in the socket's
+// transmit buffer; hence TAS_MAX_SAMPLED_SENSORS * TAS_SENSOR_HISTORY_LENGTH
+// may be at most 96 (see SensorSampler::kMaxHistoryPoints).
+#ifndef TAS_ENABLE_SENSOR_HISTORY
+#define TAS_ENABLE_SENSOR_HISTORY 0
+#endif
+
+#ifndef TAS_SENSOR_HISTORY_LENGTH
+#define TAS_SENSOR_HISTORY_LENGTH 24
+#endif
+
+#ifndef TAS_SENSOR_HISTORY_INTERVAL_MILLIS
+#define TAS_SENSOR_HISTORY_INTERVAL_MILLIS 300000
+#endif
+
 // If non-zero, RequestDecoder will make calls to the OnAssetPathSegment method
 // of the RequestDecoderListener, if provided. If zero, then the method is not
 // defined, so there is no space taken up for (stub) implementations of the
@@ -87,6 +320,153 @@
 #define SERVER_CONNECTION_INPUT_BUFFER_SIZE 128
 #endif
 
+// If non-zero, the server supports the Tiny Alpaca Server specific "batch"
+// device method, which allows a client to fetch the values of many properties
+// of a device in a single round trip; TAS_MAX_BATCH_METHODS is the maximum
+// number of Method parameters that can be provided in one batch request, and
+// determines how much RAM is added to each AlpacaRequest (1 byte per method, in
+// every connection). Disabled by default to save that RAM.
+#ifndef TAS_ENABLE_BATCH_REQUESTS
+#define TAS_ENABLE_BATCH_REQUESTS 0
+#endif
+
+#ifndef TAS_MAX_BATCH_METHODS
+#define TAS_MAX_BATCH_METHODS 16
+#endif
+
+// If non-zero, SwitchAdapter supports the GetAllSwitchValues and
+// SetSwitchValues actions, which read or write the values of all of the
+// switches of a device in a single request; GetAllSwitchValues returns them as
+// a JSON array. TAS_MAX_SWITCH_VALUES is the maximum number of switches for
+// which the actions are supported, and determines how much RAM is added to
+// each AlpacaRequest (4 bytes per value on AVR, i.e. 64 bytes by default, in
+// every connection); hence the actions are disabled by default.
+#ifndef TAS_ENABLE_BULK_SWITCH_ACTIONS
+#define TAS_ENABLE_BULK_SWITCH_ACTIONS 0
+#endif
+
+#ifndef TAS_MAX_SWITCH_VALUES
+#define TAS_MAX_SWITCH_VALUES 16
+#endif
+
+// If non-zero, each SwitchAdapter holds the names given to its switches in RAM,
+// so that getswitchname doesn't search EEPROM, and setswitchname doesn't wait
+// for an EEPROM write. This costs about TAS_SWITCH_NAME_CACHE_SIZE + 8 bytes of
+// RAM per SwitchAdapter. If zero, the names are read into a temporary buffer of
+// that size on the stack when a name is read or set, and setswitchname writes
+// them to EEPROM before responding. Either way, any switch can be named, so
+// long as the names fit in TAS_SWITCH_NAME_CACHE_SIZE bytes.
+#ifndef TAS_ENABLE_SWITCH_NAME_CACHE
+#define TAS_ENABLE_SWITCH_NAME_CACHE 0
+#endif
+
+// The number of bytes of RAM used to hold the names given to the switches of a
+// SwitchAdapter (see above); each name uses 3 bytes plus its length. With the
+// cache, changed names are written to EEPROM by MaintainDevice once
+// TAS_SWITCH_NAME_WRITE_DELAY_MILLIS have passed without another change, so a
+// burst of changes results in a single write.
+#ifndef TAS_SWITCH_NAME_CACHE_SIZE
+#define TAS_SWITCH_NAME_CACHE_SIZE 128
+#endif
+
+#ifndef TAS_SWITCH_NAME_WRITE_DELAY_MILLIS
+#define TAS_SWITCH_NAME_WRITE_DELAY_MILLIS 2000
+#endif
+
+// If non-zero, ServerContext holds a SettingsJournal, in which values such as
+// the server location and device names can be stored (overriding the values
+// compiled into the sketch). TAS_SETTINGS_JOURNAL_CACHE_SIZE is the number of
+// bytes of RAM used to hold the settings (each uses 3 bytes plus its length).
+// TAS_SETTINGS_JOURNAL_RECORDS (a power of two) is the number of changes which
+// are appended to EEPROM before the journal is compacted into a snapshot, and
+// TAS_SETTINGS_WRITE_DELAY_MILLIS is how long to wait after a change before
+// writing, so that a burst of changes is coalesced. The snapshot is written in
+// chunks of at most TAS_SETTINGS_SNAPSHOT_CHUNK_SIZE bytes, one per loop, which
+// bounds the time spent writing EEPROM in any one loop. Nothing in the library
+// calls SettingsJournal::Set yet; it is for sketches to call. Disabled by
+// default, as the cache is reserved whether or not any settings are changed.
+#ifndef TAS_ENABLE_SETTINGS_JOURNAL
+#define TAS_ENABLE_SETTINGS_JOURNAL 0
+#endif
+
+#ifndef TAS_SETTINGS_JOURNAL_CACHE_SIZE
+#define TAS_SETTINGS_JOURNAL_CACHE_SIZE 96
+#endif
+
+#ifndef TAS_SETTINGS_JOURNAL_RECORDS
+#define TAS_SETTINGS_JOURNAL_RECORDS 4
+#endif
+
+#ifndef TAS_SETTINGS_SNAPSHOT_CHUNK_SIZE
+#define TAS_SETTINGS_SNAPSHOT_CHUNK_SIZE 32
+#endif
+
+#ifndef TAS_SETTINGS_WRITE_DELAY_MILLIS
+#define TAS_SETTINGS_WRITE_DELAY_MILLIS 1000
+#endif
+
+// If non-zero, the server supports the Tiny Alpaca Server specific "events"
+// device method, which holds the connection open and pushes a Server-Sent
+// Event with the device's state whenever that state changes.
+// TAS_MAX_EVENT_STREAMS limits the number of connections that may be used for
+// event streams at one time, so that the Alpaca API requests are not starved
+// of sockets; it must be less than TAS_NUM_SERVER_CONNECTIONS.
+// TAS_EVENT_STREAM_MIN_INTERVAL_MS is the minimum time between checks for a
+// change on a single stream (i.e. throttles the rate of events), and
+// TAS_EVENT_STREAM_KEEPALIVE_MS is the maximum time between writes to the
+// stream, so that a dead client is detected eventually.
+#ifndef TAS_ENABLE_EVENT_STREAMS
+#define TAS_ENABLE_EVENT_STREAMS 1
+#endif
+
+#ifndef TAS_MAX_EVENT_STREAMS
+#define TAS_MAX_EVENT_STREAMS 1
+#endif
+
+#ifndef TAS_EVENT_STREAM_MIN_INTERVAL_MS
+#define TAS_EVENT_STREAM_MIN_INTERVAL_MS 250
+#endif
+
+#ifndef TAS_EVENT_STREAM_KEEPALIVE_MS
+#define TAS_EVENT_STREAM_KEEPALIVE_MS 15000
+#endif
+
+// If non-zero, a GET device API request may include the Tiny Alpaca Server
+// specific parameters WaitForChangeMs and IfNotEqual, which ask the server to
+// hold the response until the Value is no longer equal to IfNotEqual (or to the
+// current value if IfNotEqual isn't provided), or until WaitForChangeMs has
+// elapsed. The wait is limited to TAS_MAX_WAIT_FOR_CHANGE_MS, and the value is
+// checked for a change at most once every TAS_LONG_POLL_CHECK_INTERVAL_MS.
+// IfNotEqual is compared, after URL decoding, with the Value as formatted in
+// the server's JSON response, so clients should echo back a Value they received
+// rather than format their own.
+#ifndef TAS_ENABLE_LONG_POLL
+#define TAS_ENABLE_LONG_POLL 1
+#endif
+
+#ifndef TAS_MAX_WAIT_FOR_CHANGE_MS
+#define TAS_MAX_WAIT_FOR_CHANGE_MS 30000
+#endif
+
+#ifndef TAS_LONG_POLL_CHECK_INTERVAL_MS
+#define TAS_LONG_POLL_CHECK_INTERVAL_MS 100
+#endif
+
+// If non-zero, the server's status page is written in parts, only as fast as
+// the socket's transmit buffer can accept them, rather than waiting (stalling
+// the loop) for the client to acknowledge receipt of the earlier parts. The
+// ServerConnection records which part is to be written next (see
+// ResponseCursor), and the remaining parts are written by later calls to
+// PerformIO. Only the status page is written this way: the management API
+// responses (e.g. configureddevices) and the device API responses are written
+// whole, and so must be small (see device_interface.h). This depends on the
+// platform's connection reporting the free space in the transmit buffer via
+// availableForWrite(), which hasn't yet been verified on the hardware, so it is
+// enabled by default only for host builds (i.e. tests).
+#ifndef TAS_ENABLE_RESUMABLE_RESPONSES
+#define TAS_ENABLE_RESUMABLE_RESPONSES MCU_HOST_TARGET
+#endif
+
 // This isn't fully fleshed out, but the basics are there for storing the
 // parameter enum and short string value of parameter types that are defined
 // and have token entries in kRecognizedParameters passed
@@ -0,0 +1,101 @@
+#ifndef TINY_ALPACA_SERVER_SRC_CONNECTION_DEADLINES_H_
+#define TINY_ALPACA_SERVER_SRC_CONNECTION_DEADLINES_H_
+
+// ConnectionDeadlines tracks the deadlines by which a client must make progress
+// on a connection, so that a client which opens a connection and then sends
+// nothing (or trickles a request one byte at a time) doesn't hold on to one of
+// the few hardware sockets indefinitely. There are two deadlines:
+//
+// * The idle deadline, which is reset whenever bytes are read from or written
+//   to the connection.
+// * The request deadline, which starts when the first byte of a request is
+//   read, and which is met only if the entire request (i.e. the header and any
+//   body) is decoded by then.
+//
+// Times are provided by the caller (i.e. from millis()) so that the deadlines
+// can be tested with simulated time.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+enum class EConnectionDeadline : uint8_t {
+  kNone,     // No deadline has passed.
+  kIdle,     // Neither read nor written for too long.
+  kRequest,  // Too long decoding the current request.
+};
+
+class ConnectionDeadlines {
+ public:
+  ConnectionDeadlines(uint32_t idle_timeout_ms, uint32_t request_timeout_ms)
+      : idle_timeout_ms_(idle_timeout_ms),
+        request_timeout_ms_(request_timeout_ms),
+        last_activity_ms_(0),
+        request_start_ms_(0),
+        num_idle_timeouts_(0),
+        num_request_timeouts_(0),
+        is_decoding_(false) {}
+
+  // Starts tracking a new connection.
+  void Reset(uint32_t now_ms) {
+    last_activity_ms_ = now_ms;
+    is_decoding_ = false;
+  }
+
+  // Records that bytes have been read from or written to the connection.
+  void RecordActivity(uint32_t now_ms) { last_activity_ms_ = now_ms; }
+
+  // Records that the first bytes of a request have been read. Has no effect if
+  // already decoding a request.
+  void StartRequest(uint32_t now_ms) {
+    if (!is_decoding_) {
+      request_start_ms_ = now_ms;
+      is_decoding_ = true;
+    }
+  }
+
+  // Records that decoding of the current request is complete.
+  void EndRequest() { is_decoding_ = false; }
+
+  // Returns the deadline that has passed, if any. The request deadline takes
+  // precedence over the idle deadline.
+  EConnectionDeadline Check(uint32_t now_ms) const {
+    if (is_decoding_ && (now_ms - request_start_ms_) >= request_timeout_ms_) {
+      return EConnectionDeadline::kRequest;
+    } else if ((now_ms - last_activity_ms_) >= idle_timeout_ms_) {
+      return EConnectionDeadline::kIdle;
+    }
+    return EConnectionDeadline::kNone;
+  }
+
+  // Counts a connection closed because the deadline passed.
+  void RecordExpiration(EConnectionDeadline deadline) {
+    if (deadline == EConnectionDeadline::kIdle) {
+      ++num_idle_timeouts_;
+    } else if (deadline == EConnectionDeadline::kRequest) {
+      ++num_request_timeouts_;
+    }
+  }
+
+  bool is_decoding() const { return is_decoding_; }
+
+  // Number of connections closed because of each kind of deadline. These
+  // aren't cleared by Reset.
+  uint32_t num_idle_timeouts() const { return num_idle_timeouts_; }
+  uint32_t num_request_timeouts() const { return num_request_timeouts_; }
+
+ private:
+  const uint32_t idle_timeout_ms_;
+  const uint32_t request_timeout_ms_;
+  uint32_t last_activity_ms_;
+  uint32_t request_start_ms_;
+  uint32_t num_idle_timeouts_;
+  uint32_t num_request_timeouts_;
+  bool is_decoding_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_CONNECTION_DEADLINES_H_
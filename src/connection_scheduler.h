@@ -0,0 +1,184 @@
+#ifndef TINY_ALPACA_SERVER_SRC_CONNECTION_SCHEDULER_H_
+#define TINY_ALPACA_SERVER_SRC_CONNECTION_SCHEDULER_H_
+
+// ConnectionScheduler decides the order in which the connections are serviced
+// by ServerSocketsAndConnections::PerformIO, such that a burst of requests on
+// one connection doesn't add much latency to the others, nor to the rest of
+// the loop (e.g. MaintainDevices).
+//
+// Each pass (i.e. call to PerformIO) starts with a different connection, and
+// ends early once the pass has used up its time budget, in which case the next
+// pass starts with the first connection not serviced. The connections limit the
+// amount of work done when serviced (e.g. at most one request is dispatched),
+// so at least one connection is serviced per pass. Connections may also be
+// prioritized, in which case they're serviced at the start of the next pass,
+// regardless of the budget.
+//
+// Times are provided by the caller (i.e. from micros()) so that the scheduler
+// can be tested with simulated time.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+// Statistics about the time taken to service a single connection.
+struct ConnectionServiceStats {
+  void Reset() {
+    num_services = 0;
+    num_deferrals = 0;
+    total_micros = 0;
+    max_micros = 0;
+  }
+
+  void RecordService(uint32_t elapsed_micros) {
+    ++num_services;
+    total_micros += elapsed_micros;
+    if (max_micros < elapsed_micros) {
+      max_micros = elapsed_micros;
+    }
+  }
+
+  uint32_t mean_micros() const {
+    return num_services == 0 ? 0 : total_micros / num_services;
+  }
+
+  // Number of times the connection has been serviced.
+  uint32_t num_services;
+
+  // Number of passes which ended before servicing the connection because the
+  // time budget was used up.
+  uint32_t num_deferrals;
+
+  // Total and maximum time taken to service the connection. The total will
+  // wrap around after about 71 minutes of servicing.
+  uint32_t total_micros;
+  uint32_t max_micros;
+};
+
+template <uint8_t kNumConnections>
+class ConnectionScheduler {
+ public:
+  static_assert(kNumConnections > 0, "Must have at least one connection");
+
+  explicit ConnectionScheduler(uint32_t budget_micros)
+      : budget_micros_(budget_micros),
+        pass_start_(0),
+        service_start_(0),
+        next_start_ndx_(0),
+        ndx_(0),
+        current_ndx_(0),
+        count_(0),
+        num_serviced_(0),
+        in_pass_(false) {
+    for (uint8_t ndx = 0; ndx < kNumConnections; ++ndx) {
+      stats_[ndx].Reset();
+      serviced_[ndx] = false;
+      prioritized_[ndx] = false;
+    }
+  }
+
+  // Requests that connection 'ndx' be serviced at the start of the next pass
+  // (or of this pass, if it hasn't yet been serviced).
+  void Prioritize(uint8_t ndx) {
+    MCU_DCHECK_LT(ndx, kNumConnections);
+    prioritized_[ndx] = true;
+  }
+
+  // Starts a pass over the connections.
+  void StartPass(uint32_t now_micros) {
+    pass_start_ = now_micros;
+    ndx_ = next_start_ndx_;
+    count_ = 0;
+    num_serviced_ = 0;
+    in_pass_ = true;
+    for (auto& serviced : serviced_) {
+      serviced = false;
+    }
+  }
+
+  // Returns true, and sets ndx to the index of the next connection to be
+  // serviced, if there is one and the time budget isn't used up. Else returns
+  // false, which ends the pass.
+  bool NextConnection(uint32_t now_micros, uint8_t& ndx) {
+    if (!in_pass_) {
+      return false;
+    }
+    for (uint8_t i = 0; i < kNumConnections; ++i) {
+      if (prioritized_[i] && !serviced_[i]) {
+        prioritized_[i] = false;
+        return StartService(now_micros, i, ndx);
+      }
+    }
+    // Skip over connections already serviced because they were prioritized.
+    while (count_ < kNumConnections && serviced_[ndx_]) {
+      ndx_ = Increment(ndx_);
+      ++count_;
+    }
+    if (count_ >= kNumConnections) {
+      // Every connection was serviced, so start the next pass with the
+      // connection after the one that started this pass.
+      next_start_ndx_ = Increment(next_start_ndx_);
+      in_pass_ = false;
+      return false;
+    } else if (num_serviced_ > 0 &&
+               (now_micros - pass_start_) >= budget_micros_) {
+      // Out of time. The next pass starts with the first connection that
+      // wasn't serviced in this one.
+      next_start_ndx_ = ndx_;
+      for (uint8_t n = count_, i = ndx_; n < kNumConnections; ++n) {
+        if (!serviced_[i]) {
+          ++stats_[i].num_deferrals;
+        }
+        i = Increment(i);
+      }
+      in_pass_ = false;
+      return false;
+    }
+    return StartService(now_micros, ndx_, ndx);
+  }
+
+  // Records that the connection returned by the last call to NextConnection
+  // has been serviced.
+  void EndService(uint32_t now_micros) {
+    MCU_DCHECK(in_pass_);
+    stats_[current_ndx_].RecordService(now_micros - service_start_);
+    serviced_[current_ndx_] = true;
+    ++num_serviced_;
+  }
+
+  const ConnectionServiceStats& service_stats(uint8_t ndx) const {
+    MCU_DCHECK_LT(ndx, kNumConnections);
+    return stats_[ndx];
+  }
+
+ private:
+  bool StartService(uint32_t now_micros, uint8_t service_ndx, uint8_t& ndx) {
+    current_ndx_ = service_ndx;
+    service_start_ = now_micros;
+    ndx = service_ndx;
+    return true;
+  }
+
+  static uint8_t Increment(uint8_t ndx) {
+    return (ndx + 1 < kNumConnections) ? ndx + 1 : 0;
+  }
+
+  const uint32_t budget_micros_;
+  uint32_t pass_start_;
+  uint32_t service_start_;
+  uint8_t next_start_ndx_;
+  uint8_t ndx_;           // Next connection in rotation order.
+  uint8_t current_ndx_;   // Connection being serviced.
+  uint8_t count_;         // Number of connections passed in rotation order.
+  uint8_t num_serviced_;  // Number of connections serviced in this pass.
+  bool in_pass_;
+  ConnectionServiceStats stats_[kNumConnections];
+  bool serviced_[kNumConnections];
+  bool prioritized_[kNumConnections];
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_CONNECTION_SCHEDULER_H_
@@ -95,6 +95,8 @@ _ToFlashStringHelperViaSwitch(EHttpStatusCode v) {
       return MCU_FLASHSTR("Internal Server Error");
     case EHttpStatusCode::kHttpNotImplemented:
       return MCU_FLASHSTR("Not Implemented");
+    case EHttpStatusCode::kHttpServiceUnavailable:
+      return MCU_FLASHSTR("Service Unavailable");
     case EHttpStatusCode::kHttpVersionNotSupported:
       return MCU_FLASHSTR("HTTP Version Not Supported");
   }
@@ -146,6 +148,9 @@ const __FlashStringHelper* ToFlashStringHelper(EHttpStatusCode v) {
   if (v == EHttpStatusCode::kHttpNotImplemented) {
     return MCU_FLASHSTR("Not Implemented");
   }
+  if (v == EHttpStatusCode::kHttpServiceUnavailable) {
+    return MCU_FLASHSTR("Service Unavailable");
+  }
   if (v == EHttpStatusCode::kHttpVersionNotSupported) {
     return MCU_FLASHSTR("HTTP Version Not Supported");
   }
@@ -226,6 +231,8 @@ _ToFlashStringHelperViaSwitch(EApiGroup v) {
       return MCU_FLASHSTR("Asset");
     case EApiGroup::kServerStatus:
       return MCU_FLASHSTR("ServerStatus");
+    case EApiGroup::kMetrics:
+      return MCU_FLASHSTR("Metrics");
   }
   return nullptr;
 }
@@ -255,6 +262,9 @@ const __FlashStringHelper* ToFlashStringHelper(EApiGroup v) {
   if (v == EApiGroup::kServerStatus) {
     return MCU_FLASHSTR("ServerStatus");
   }
+  if (v == EApiGroup::kMetrics) {
+    return MCU_FLASHSTR("Metrics");
+  }
   return nullptr;
 #else   // not TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
   // Protection against enumerator definitions changing:
@@ -264,6 +274,7 @@ const __FlashStringHelper* ToFlashStringHelper(EApiGroup v) {
   static_assert(EApiGroup::kSetup == static_cast<EApiGroup>(3));
   static_assert(EApiGroup::kAsset == static_cast<EApiGroup>(4));
   static_assert(EApiGroup::kServerStatus == static_cast<EApiGroup>(5));
+  static_assert(EApiGroup::kMetrics == static_cast<EApiGroup>(6));
   static MCU_FLASH_STRING_TABLE(  // Force new line.
       flash_string_table,
       MCU_PSD("Unknown"),       // 0: kUnknown
@@ -272,9 +283,10 @@ const __FlashStringHelper* ToFlashStringHelper(EApiGroup v) {
       MCU_PSD("Setup"),         // 3: kSetup
       MCU_PSD("Asset"),         // 4: kAsset
       MCU_PSD("ServerStatus"),  // 5: kServerStatus
+      MCU_PSD("Metrics"),       // 6: kMetrics
   );
   return mcucore::LookupFlashStringForDenseEnum<uint_fast8_t>(
-      flash_string_table, EApiGroup::kUnknown, EApiGroup::kServerStatus, v);
+      flash_string_table, EApiGroup::kUnknown, EApiGroup::kMetrics, v);
 #endif  // TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
 #endif  // TO_FLASH_STRING_HELPER_PREFER_SWITCH
 }
@@ -296,12 +308,16 @@ _ToFlashStringHelperViaSwitch(EAlpacaApi v) {
       return MCU_FLASHSTR("ManagementDescription");
     case EAlpacaApi::kManagementConfiguredDevices:
       return MCU_FLASHSTR("ManagementConfiguredDevices");
+    case EAlpacaApi::kManagementRequestJournal:
+      return MCU_FLASHSTR("ManagementRequestJournal");
     case EAlpacaApi::kAsset:
       return MCU_FLASHSTR("Asset");
     case EAlpacaApi::kServerSetup:
       return MCU_FLASHSTR("ServerSetup");
     case EAlpacaApi::kServerStatus:
       return MCU_FLASHSTR("ServerStatus");
+    case EAlpacaApi::kServerMetrics:
+      return MCU_FLASHSTR("ServerMetrics");
   }
   return nullptr;
 }
@@ -331,6 +347,9 @@ const __FlashStringHelper* ToFlashStringHelper(EAlpacaApi v) {
   if (v == EAlpacaApi::kManagementConfiguredDevices) {
     return MCU_FLASHSTR("ManagementConfiguredDevices");
   }
+  if (v == EAlpacaApi::kManagementRequestJournal) {
+    return MCU_FLASHSTR("ManagementRequestJournal");
+  }
   if (v == EAlpacaApi::kAsset) {
     return MCU_FLASHSTR("Asset");
   }
@@ -340,6 +359,9 @@ const __FlashStringHelper* ToFlashStringHelper(EAlpacaApi v) {
   if (v == EAlpacaApi::kServerStatus) {
     return MCU_FLASHSTR("ServerStatus");
   }
+  if (v == EAlpacaApi::kServerMetrics) {
+    return MCU_FLASHSTR("ServerMetrics");
+  }
   return nullptr;
 #else   // not TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
   // Protection against enumerator definitions changing:
@@ -352,9 +374,12 @@ const __FlashStringHelper* ToFlashStringHelper(EAlpacaApi v) {
                 static_cast<EAlpacaApi>(4));
   static_assert(EAlpacaApi::kManagementConfiguredDevices ==
                 static_cast<EAlpacaApi>(5));
-  static_assert(EAlpacaApi::kAsset == static_cast<EAlpacaApi>(6));
-  static_assert(EAlpacaApi::kServerSetup == static_cast<EAlpacaApi>(7));
-  static_assert(EAlpacaApi::kServerStatus == static_cast<EAlpacaApi>(8));
+  static_assert(EAlpacaApi::kManagementRequestJournal ==
+                static_cast<EAlpacaApi>(6));
+  static_assert(EAlpacaApi::kAsset == static_cast<EAlpacaApi>(7));
+  static_assert(EAlpacaApi::kServerSetup == static_cast<EAlpacaApi>(8));
+  static_assert(EAlpacaApi::kServerStatus == static_cast<EAlpacaApi>(9));
+  static_assert(EAlpacaApi::kServerMetrics == static_cast<EAlpacaApi>(10));
   static MCU_FLASH_STRING_TABLE(  // Force new line.
       flash_string_table,
       MCU_PSD("Unknown"),                // 0: kUnknown
@@ -363,13 +388,15 @@ const __FlashStringHelper* ToFlashStringHelper(EAlpacaApi v) {
       MCU_PSD("ManagementApiVersions"),  // 3: kManagementApiVersions
       MCU_PSD("ManagementDescription"),  // 4: kManagementDescription
       MCU_PSD(
-          "ManagementConfiguredDevices"),  // 5: kManagementConfiguredDevices
-      MCU_PSD("Asset"),                    // 6: kAsset
-      MCU_PSD("ServerSetup"),              // 7: kServerSetup
-      MCU_PSD("ServerStatus"),             // 8: kServerStatus
+          "ManagementConfiguredDevices"),   // 5: kManagementConfiguredDevices
+      MCU_PSD("ManagementRequestJournal"),  // 6: kManagementRequestJournal
+      MCU_PSD("Asset"),                     // 7: kAsset
+      MCU_PSD("ServerSetup"),               // 8: kServerSetup
+      MCU_PSD("ServerStatus"),              // 9: kServerStatus
+      MCU_PSD("ServerMetrics"),             // 10: kServerMetrics
   );
   return mcucore::LookupFlashStringForDenseEnum<uint_fast8_t>(
-      flash_string_table, EAlpacaApi::kUnknown, EAlpacaApi::kServerStatus, v);
+      flash_string_table, EAlpacaApi::kUnknown, EAlpacaApi::kServerMetrics, v);
 #endif  // TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
 #endif  // TO_FLASH_STRING_HELPER_PREFER_SWITCH
 }
@@ -385,6 +412,8 @@ _ToFlashStringHelperViaSwitch(EManagementMethod v) {
       return MCU_FLASHSTR("Description");
     case EManagementMethod::kConfiguredDevices:
       return MCU_FLASHSTR("ConfiguredDevices");
+    case EManagementMethod::kRequestJournal:
+      return MCU_FLASHSTR("RequestJournal");
   }
   return nullptr;
 }
@@ -405,6 +434,9 @@ const __FlashStringHelper* ToFlashStringHelper(EManagementMethod v) {
   if (v == EManagementMethod::kConfiguredDevices) {
     return MCU_FLASHSTR("ConfiguredDevices");
   }
+  if (v == EManagementMethod::kRequestJournal) {
+    return MCU_FLASHSTR("RequestJournal");
+  }
   return nullptr;
 #else   // not TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
   // Protection against enumerator definitions changing:
@@ -414,15 +446,18 @@ const __FlashStringHelper* ToFlashStringHelper(EManagementMethod v) {
                 static_cast<EManagementMethod>(1));
   static_assert(EManagementMethod::kConfiguredDevices ==
                 static_cast<EManagementMethod>(2));
+  static_assert(EManagementMethod::kRequestJournal ==
+                static_cast<EManagementMethod>(3));
   static MCU_FLASH_STRING_TABLE(  // Force new line.
       flash_string_table,
       MCU_PSD("Unknown"),            // 0: kUnknown
       MCU_PSD("Description"),        // 1: kDescription
       MCU_PSD("ConfiguredDevices"),  // 2: kConfiguredDevices
+      MCU_PSD("RequestJournal"),     // 3: kRequestJournal
   );
   return mcucore::LookupFlashStringForDenseEnum<uint_fast8_t>(
       flash_string_table, EManagementMethod::kUnknown,
-      EManagementMethod::kConfiguredDevices, v);
+      EManagementMethod::kRequestJournal, v);
 #endif  // TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
 #endif  // TO_FLASH_STRING_HELPER_PREFER_SWITCH
 }
@@ -542,6 +577,10 @@ _ToFlashStringHelperViaSwitch(EDeviceMethod v) {
       return MCU_FLASHSTR("Unknown");
     case EDeviceMethod::kSetup:
       return MCU_FLASHSTR("Setup");
+    case EDeviceMethod::kBatch:
+      return MCU_FLASHSTR("Batch");
+    case EDeviceMethod::kEvents:
+      return MCU_FLASHSTR("Events");
     case EDeviceMethod::kAction:
       return MCU_FLASHSTR("Action");
     case EDeviceMethod::kCommandBlind:
@@ -554,6 +593,8 @@ _ToFlashStringHelperViaSwitch(EDeviceMethod v) {
       return MCU_FLASHSTR("Connected");
     case EDeviceMethod::kDescription:
       return MCU_FLASHSTR("Description");
+    case EDeviceMethod::kDeviceState:
+      return MCU_FLASHSTR("DeviceState");
     case EDeviceMethod::kDriverInfo:
       return MCU_FLASHSTR("DriverInfo");
     case EDeviceMethod::kDriverVersion:
@@ -659,6 +700,12 @@ const __FlashStringHelper* ToFlashStringHelper(EDeviceMethod v) {
   if (v == EDeviceMethod::kSetup) {
     return MCU_FLASHSTR("Setup");
   }
+  if (v == EDeviceMethod::kBatch) {
+    return MCU_FLASHSTR("Batch");
+  }
+  if (v == EDeviceMethod::kEvents) {
+    return MCU_FLASHSTR("Events");
+  }
   if (v == EDeviceMethod::kAction) {
     return MCU_FLASHSTR("Action");
   }
@@ -677,6 +724,9 @@ const __FlashStringHelper* ToFlashStringHelper(EDeviceMethod v) {
   if (v == EDeviceMethod::kDescription) {
     return MCU_FLASHSTR("Description");
   }
+  if (v == EDeviceMethod::kDeviceState) {
+    return MCU_FLASHSTR("DeviceState");
+  }
   if (v == EDeviceMethod::kDriverInfo) {
     return MCU_FLASHSTR("DriverInfo");
   }
@@ -814,128 +864,135 @@ const __FlashStringHelper* ToFlashStringHelper(EDeviceMethod v) {
   // Protection against enumerator definitions changing:
   static_assert(EDeviceMethod::kUnknown == static_cast<EDeviceMethod>(0));
   static_assert(EDeviceMethod::kSetup == static_cast<EDeviceMethod>(1));
-  static_assert(EDeviceMethod::kAction == static_cast<EDeviceMethod>(2));
-  static_assert(EDeviceMethod::kCommandBlind == static_cast<EDeviceMethod>(3));
-  static_assert(EDeviceMethod::kCommandBool == static_cast<EDeviceMethod>(4));
-  static_assert(EDeviceMethod::kCommandString == static_cast<EDeviceMethod>(5));
-  static_assert(EDeviceMethod::kConnected == static_cast<EDeviceMethod>(6));
-  static_assert(EDeviceMethod::kDescription == static_cast<EDeviceMethod>(7));
-  static_assert(EDeviceMethod::kDriverInfo == static_cast<EDeviceMethod>(8));
-  static_assert(EDeviceMethod::kDriverVersion == static_cast<EDeviceMethod>(9));
+  static_assert(EDeviceMethod::kBatch == static_cast<EDeviceMethod>(2));
+  static_assert(EDeviceMethod::kEvents == static_cast<EDeviceMethod>(3));
+  static_assert(EDeviceMethod::kAction == static_cast<EDeviceMethod>(4));
+  static_assert(EDeviceMethod::kCommandBlind == static_cast<EDeviceMethod>(5));
+  static_assert(EDeviceMethod::kCommandBool == static_cast<EDeviceMethod>(6));
+  static_assert(EDeviceMethod::kCommandString == static_cast<EDeviceMethod>(7));
+  static_assert(EDeviceMethod::kConnected == static_cast<EDeviceMethod>(8));
+  static_assert(EDeviceMethod::kDescription == static_cast<EDeviceMethod>(9));
+  static_assert(EDeviceMethod::kDeviceState == static_cast<EDeviceMethod>(10));
+  static_assert(EDeviceMethod::kDriverInfo == static_cast<EDeviceMethod>(11));
+  static_assert(EDeviceMethod::kDriverVersion ==
+                static_cast<EDeviceMethod>(12));
   static_assert(EDeviceMethod::kInterfaceVersion ==
-                static_cast<EDeviceMethod>(10));
-  static_assert(EDeviceMethod::kName == static_cast<EDeviceMethod>(11));
+                static_cast<EDeviceMethod>(13));
+  static_assert(EDeviceMethod::kName == static_cast<EDeviceMethod>(14));
   static_assert(EDeviceMethod::kSupportedActions ==
-                static_cast<EDeviceMethod>(12));
-  static_assert(EDeviceMethod::kBrightness == static_cast<EDeviceMethod>(13));
+                static_cast<EDeviceMethod>(15));
+  static_assert(EDeviceMethod::kBrightness == static_cast<EDeviceMethod>(16));
   static_assert(EDeviceMethod::kCalibratorState ==
-                static_cast<EDeviceMethod>(14));
-  static_assert(EDeviceMethod::kCoverState == static_cast<EDeviceMethod>(15));
+                static_cast<EDeviceMethod>(17));
+  static_assert(EDeviceMethod::kCoverState == static_cast<EDeviceMethod>(18));
   static_assert(EDeviceMethod::kMaxBrightness ==
-                static_cast<EDeviceMethod>(16));
+                static_cast<EDeviceMethod>(19));
   static_assert(EDeviceMethod::kCalibratorOff ==
-                static_cast<EDeviceMethod>(17));
-  static_assert(EDeviceMethod::kCalibratorOn == static_cast<EDeviceMethod>(18));
-  static_assert(EDeviceMethod::kCloseCover == static_cast<EDeviceMethod>(19));
-  static_assert(EDeviceMethod::kHaltCover == static_cast<EDeviceMethod>(20));
-  static_assert(EDeviceMethod::kOpenCover == static_cast<EDeviceMethod>(21));
+                static_cast<EDeviceMethod>(20));
+  static_assert(EDeviceMethod::kCalibratorOn == static_cast<EDeviceMethod>(21));
+  static_assert(EDeviceMethod::kCloseCover == static_cast<EDeviceMethod>(22));
+  static_assert(EDeviceMethod::kHaltCover == static_cast<EDeviceMethod>(23));
+  static_assert(EDeviceMethod::kOpenCover == static_cast<EDeviceMethod>(24));
   static_assert(EDeviceMethod::kAveragePeriod ==
-                static_cast<EDeviceMethod>(22));
-  static_assert(EDeviceMethod::kCloudCover == static_cast<EDeviceMethod>(23));
-  static_assert(EDeviceMethod::kDewPoint == static_cast<EDeviceMethod>(24));
-  static_assert(EDeviceMethod::kHumidity == static_cast<EDeviceMethod>(25));
-  static_assert(EDeviceMethod::kPressure == static_cast<EDeviceMethod>(26));
-  static_assert(EDeviceMethod::kRainRate == static_cast<EDeviceMethod>(27));
-  static_assert(EDeviceMethod::kRefresh == static_cast<EDeviceMethod>(28));
+                static_cast<EDeviceMethod>(25));
+  static_assert(EDeviceMethod::kCloudCover == static_cast<EDeviceMethod>(26));
+  static_assert(EDeviceMethod::kDewPoint == static_cast<EDeviceMethod>(27));
+  static_assert(EDeviceMethod::kHumidity == static_cast<EDeviceMethod>(28));
+  static_assert(EDeviceMethod::kPressure == static_cast<EDeviceMethod>(29));
+  static_assert(EDeviceMethod::kRainRate == static_cast<EDeviceMethod>(30));
+  static_assert(EDeviceMethod::kRefresh == static_cast<EDeviceMethod>(31));
   static_assert(EDeviceMethod::kSensorDescription ==
-                static_cast<EDeviceMethod>(29));
+                static_cast<EDeviceMethod>(32));
   static_assert(EDeviceMethod::kSkyBrightness ==
-                static_cast<EDeviceMethod>(30));
-  static_assert(EDeviceMethod::kSkyQuality == static_cast<EDeviceMethod>(31));
+                static_cast<EDeviceMethod>(33));
+  static_assert(EDeviceMethod::kSkyQuality == static_cast<EDeviceMethod>(34));
   static_assert(EDeviceMethod::kSkyTemperature ==
-                static_cast<EDeviceMethod>(32));
-  static_assert(EDeviceMethod::kStarFWHM == static_cast<EDeviceMethod>(33));
-  static_assert(EDeviceMethod::kTemperature == static_cast<EDeviceMethod>(34));
-  static_assert(EDeviceMethod::kTimeSinceLastUpdate ==
                 static_cast<EDeviceMethod>(35));
+  static_assert(EDeviceMethod::kStarFWHM == static_cast<EDeviceMethod>(36));
+  static_assert(EDeviceMethod::kTemperature == static_cast<EDeviceMethod>(37));
+  static_assert(EDeviceMethod::kTimeSinceLastUpdate ==
+                static_cast<EDeviceMethod>(38));
   static_assert(EDeviceMethod::kWindDirection ==
-                static_cast<EDeviceMethod>(36));
-  static_assert(EDeviceMethod::kWindGust == static_cast<EDeviceMethod>(37));
-  static_assert(EDeviceMethod::kWindSpeed == static_cast<EDeviceMethod>(38));
-  static_assert(EDeviceMethod::kIsSafe == static_cast<EDeviceMethod>(39));
-  static_assert(EDeviceMethod::kMaxSwitch == static_cast<EDeviceMethod>(40));
-  static_assert(EDeviceMethod::kCanWrite == static_cast<EDeviceMethod>(41));
-  static_assert(EDeviceMethod::kGetSwitch == static_cast<EDeviceMethod>(42));
+                static_cast<EDeviceMethod>(39));
+  static_assert(EDeviceMethod::kWindGust == static_cast<EDeviceMethod>(40));
+  static_assert(EDeviceMethod::kWindSpeed == static_cast<EDeviceMethod>(41));
+  static_assert(EDeviceMethod::kIsSafe == static_cast<EDeviceMethod>(42));
+  static_assert(EDeviceMethod::kMaxSwitch == static_cast<EDeviceMethod>(43));
+  static_assert(EDeviceMethod::kCanWrite == static_cast<EDeviceMethod>(44));
+  static_assert(EDeviceMethod::kGetSwitch == static_cast<EDeviceMethod>(45));
   static_assert(EDeviceMethod::kGetSwitchDescription ==
-                static_cast<EDeviceMethod>(43));
+                static_cast<EDeviceMethod>(46));
   static_assert(EDeviceMethod::kGetSwitchName ==
-                static_cast<EDeviceMethod>(44));
+                static_cast<EDeviceMethod>(47));
   static_assert(EDeviceMethod::kGetSwitchValue ==
-                static_cast<EDeviceMethod>(45));
+                static_cast<EDeviceMethod>(48));
   static_assert(EDeviceMethod::kMinSwitchValue ==
-                static_cast<EDeviceMethod>(46));
+                static_cast<EDeviceMethod>(49));
   static_assert(EDeviceMethod::kMaxSwitchValue ==
-                static_cast<EDeviceMethod>(47));
-  static_assert(EDeviceMethod::kSetSwitch == static_cast<EDeviceMethod>(48));
+                static_cast<EDeviceMethod>(50));
+  static_assert(EDeviceMethod::kSetSwitch == static_cast<EDeviceMethod>(51));
   static_assert(EDeviceMethod::kSetSwitchName ==
-                static_cast<EDeviceMethod>(49));
+                static_cast<EDeviceMethod>(52));
   static_assert(EDeviceMethod::kSetSwitchValue ==
-                static_cast<EDeviceMethod>(50));
-  static_assert(EDeviceMethod::kSwitchStep == static_cast<EDeviceMethod>(51));
+                static_cast<EDeviceMethod>(53));
+  static_assert(EDeviceMethod::kSwitchStep == static_cast<EDeviceMethod>(54));
   static MCU_FLASH_STRING_TABLE(  // Force new line.
       flash_string_table,
       MCU_PSD("Unknown"),               // 0: kUnknown
       MCU_PSD("Setup"),                 // 1: kSetup
-      MCU_PSD("Action"),                // 2: kAction
-      MCU_PSD("CommandBlind"),          // 3: kCommandBlind
-      MCU_PSD("CommandBool"),           // 4: kCommandBool
-      MCU_PSD("CommandString"),         // 5: kCommandString
-      MCU_PSD("Connected"),             // 6: kConnected
-      MCU_PSD("Description"),           // 7: kDescription
-      MCU_PSD("DriverInfo"),            // 8: kDriverInfo
-      MCU_PSD("DriverVersion"),         // 9: kDriverVersion
-      MCU_PSD("InterfaceVersion"),      // 10: kInterfaceVersion
-      MCU_PSD("Name"),                  // 11: kName
-      MCU_PSD("SupportedActions"),      // 12: kSupportedActions
-      MCU_PSD("Brightness"),            // 13: kBrightness
-      MCU_PSD("CalibratorState"),       // 14: kCalibratorState
-      MCU_PSD("CoverState"),            // 15: kCoverState
-      MCU_PSD("MaxBrightness"),         // 16: kMaxBrightness
-      MCU_PSD("CalibratorOff"),         // 17: kCalibratorOff
-      MCU_PSD("CalibratorOn"),          // 18: kCalibratorOn
-      MCU_PSD("CloseCover"),            // 19: kCloseCover
-      MCU_PSD("HaltCover"),             // 20: kHaltCover
-      MCU_PSD("OpenCover"),             // 21: kOpenCover
-      MCU_PSD("AveragePeriod"),         // 22: kAveragePeriod
-      MCU_PSD("CloudCover"),            // 23: kCloudCover
-      MCU_PSD("DewPoint"),              // 24: kDewPoint
-      MCU_PSD("Humidity"),              // 25: kHumidity
-      MCU_PSD("Pressure"),              // 26: kPressure
-      MCU_PSD("RainRate"),              // 27: kRainRate
-      MCU_PSD("Refresh"),               // 28: kRefresh
-      MCU_PSD("SensorDescription"),     // 29: kSensorDescription
-      MCU_PSD("SkyBrightness"),         // 30: kSkyBrightness
-      MCU_PSD("SkyQuality"),            // 31: kSkyQuality
-      MCU_PSD("SkyTemperature"),        // 32: kSkyTemperature
-      MCU_PSD("StarFWHM"),              // 33: kStarFWHM
-      MCU_PSD("Temperature"),           // 34: kTemperature
-      MCU_PSD("TimeSinceLastUpdate"),   // 35: kTimeSinceLastUpdate
-      MCU_PSD("WindDirection"),         // 36: kWindDirection
-      MCU_PSD("WindGust"),              // 37: kWindGust
-      MCU_PSD("WindSpeed"),             // 38: kWindSpeed
-      MCU_PSD("IsSafe"),                // 39: kIsSafe
-      MCU_PSD("MaxSwitch"),             // 40: kMaxSwitch
-      MCU_PSD("CanWrite"),              // 41: kCanWrite
-      MCU_PSD("GetSwitch"),             // 42: kGetSwitch
-      MCU_PSD("GetSwitchDescription"),  // 43: kGetSwitchDescription
-      MCU_PSD("GetSwitchName"),         // 44: kGetSwitchName
-      MCU_PSD("GetSwitchValue"),        // 45: kGetSwitchValue
-      MCU_PSD("MinSwitchValue"),        // 46: kMinSwitchValue
-      MCU_PSD("MaxSwitchValue"),        // 47: kMaxSwitchValue
-      MCU_PSD("SetSwitch"),             // 48: kSetSwitch
-      MCU_PSD("SetSwitchName"),         // 49: kSetSwitchName
-      MCU_PSD("SetSwitchValue"),        // 50: kSetSwitchValue
-      MCU_PSD("SwitchStep"),            // 51: kSwitchStep
+      MCU_PSD("Batch"),                 // 2: kBatch
+      MCU_PSD("Events"),                // 3: kEvents
+      MCU_PSD("Action"),                // 4: kAction
+      MCU_PSD("CommandBlind"),          // 5: kCommandBlind
+      MCU_PSD("CommandBool"),           // 6: kCommandBool
+      MCU_PSD("CommandString"),         // 7: kCommandString
+      MCU_PSD("Connected"),             // 8: kConnected
+      MCU_PSD("Description"),           // 9: kDescription
+      MCU_PSD("DeviceState"),           // 10: kDeviceState
+      MCU_PSD("DriverInfo"),            // 11: kDriverInfo
+      MCU_PSD("DriverVersion"),         // 12: kDriverVersion
+      MCU_PSD("InterfaceVersion"),      // 13: kInterfaceVersion
+      MCU_PSD("Name"),                  // 14: kName
+      MCU_PSD("SupportedActions"),      // 15: kSupportedActions
+      MCU_PSD("Brightness"),            // 16: kBrightness
+      MCU_PSD("CalibratorState"),       // 17: kCalibratorState
+      MCU_PSD("CoverState"),            // 18: kCoverState
+      MCU_PSD("MaxBrightness"),         // 19: kMaxBrightness
+      MCU_PSD("CalibratorOff"),         // 20: kCalibratorOff
+      MCU_PSD("CalibratorOn"),          // 21: kCalibratorOn
+      MCU_PSD("CloseCover"),            // 22: kCloseCover
+      MCU_PSD("HaltCover"),             // 23: kHaltCover
+      MCU_PSD("OpenCover"),             // 24: kOpenCover
+      MCU_PSD("AveragePeriod"),         // 25: kAveragePeriod
+      MCU_PSD("CloudCover"),            // 26: kCloudCover
+      MCU_PSD("DewPoint"),              // 27: kDewPoint
+      MCU_PSD("Humidity"),              // 28: kHumidity
+      MCU_PSD("Pressure"),              // 29: kPressure
+      MCU_PSD("RainRate"),              // 30: kRainRate
+      MCU_PSD("Refresh"),               // 31: kRefresh
+      MCU_PSD("SensorDescription"),     // 32: kSensorDescription
+      MCU_PSD("SkyBrightness"),         // 33: kSkyBrightness
+      MCU_PSD("SkyQuality"),            // 34: kSkyQuality
+      MCU_PSD("SkyTemperature"),        // 35: kSkyTemperature
+      MCU_PSD("StarFWHM"),              // 36: kStarFWHM
+      MCU_PSD("Temperature"),           // 37: kTemperature
+      MCU_PSD("TimeSinceLastUpdate"),   // 38: kTimeSinceLastUpdate
+      MCU_PSD("WindDirection"),         // 39: kWindDirection
+      MCU_PSD("WindGust"),              // 40: kWindGust
+      MCU_PSD("WindSpeed"),             // 41: kWindSpeed
+      MCU_PSD("IsSafe"),                // 42: kIsSafe
+      MCU_PSD("MaxSwitch"),             // 43: kMaxSwitch
+      MCU_PSD("CanWrite"),              // 44: kCanWrite
+      MCU_PSD("GetSwitch"),             // 45: kGetSwitch
+      MCU_PSD("GetSwitchDescription"),  // 46: kGetSwitchDescription
+      MCU_PSD("GetSwitchName"),         // 47: kGetSwitchName
+      MCU_PSD("GetSwitchValue"),        // 48: kGetSwitchValue
+      MCU_PSD("MinSwitchValue"),        // 49: kMinSwitchValue
+      MCU_PSD("MaxSwitchValue"),        // 50: kMaxSwitchValue
+      MCU_PSD("SetSwitch"),             // 51: kSetSwitch
+      MCU_PSD("SetSwitchName"),         // 52: kSetSwitchName
+      MCU_PSD("SetSwitchValue"),        // 53: kSetSwitchValue
+      MCU_PSD("SwitchStep"),            // 54: kSwitchStep
   );
   return mcucore::LookupFlashStringForDenseEnum<uint_fast8_t>(
       flash_string_table, EDeviceMethod::kUnknown, EDeviceMethod::kSwitchStep,
@@ -965,6 +1022,12 @@ _ToFlashStringHelperViaSwitch(EParameter v) {
       return MCU_FLASHSTR("Parameters");
     case EParameter::kRaw:
       return MCU_FLASHSTR("Raw");
+    case EParameter::kMethod:
+      return MCU_FLASHSTR("Method");
+    case EParameter::kIfNotEqual:
+      return MCU_FLASHSTR("IfNotEqual");
+    case EParameter::kWaitForChangeMs:
+      return MCU_FLASHSTR("WaitForChangeMs");
     case EParameter::kBrightness:
       return MCU_FLASHSTR("Brightness");
     case EParameter::kAveragePeriod:
@@ -1014,6 +1077,15 @@ const __FlashStringHelper* ToFlashStringHelper(EParameter v) {
   if (v == EParameter::kRaw) {
     return MCU_FLASHSTR("Raw");
   }
+  if (v == EParameter::kMethod) {
+    return MCU_FLASHSTR("Method");
+  }
+  if (v == EParameter::kIfNotEqual) {
+    return MCU_FLASHSTR("IfNotEqual");
+  }
+  if (v == EParameter::kWaitForChangeMs) {
+    return MCU_FLASHSTR("WaitForChangeMs");
+  }
   if (v == EParameter::kBrightness) {
     return MCU_FLASHSTR("Brightness");
   }
@@ -1046,13 +1118,16 @@ const __FlashStringHelper* ToFlashStringHelper(EParameter v) {
   static_assert(EParameter::kConnected == static_cast<EParameter>(5));
   static_assert(EParameter::kParameters == static_cast<EParameter>(6));
   static_assert(EParameter::kRaw == static_cast<EParameter>(7));
-  static_assert(EParameter::kBrightness == static_cast<EParameter>(8));
-  static_assert(EParameter::kAveragePeriod == static_cast<EParameter>(9));
-  static_assert(EParameter::kSensorName == static_cast<EParameter>(10));
-  static_assert(EParameter::kId == static_cast<EParameter>(11));
-  static_assert(EParameter::kName == static_cast<EParameter>(12));
-  static_assert(EParameter::kState == static_cast<EParameter>(13));
-  static_assert(EParameter::kValue == static_cast<EParameter>(14));
+  static_assert(EParameter::kMethod == static_cast<EParameter>(8));
+  static_assert(EParameter::kIfNotEqual == static_cast<EParameter>(9));
+  static_assert(EParameter::kWaitForChangeMs == static_cast<EParameter>(10));
+  static_assert(EParameter::kBrightness == static_cast<EParameter>(11));
+  static_assert(EParameter::kAveragePeriod == static_cast<EParameter>(12));
+  static_assert(EParameter::kSensorName == static_cast<EParameter>(13));
+  static_assert(EParameter::kId == static_cast<EParameter>(14));
+  static_assert(EParameter::kName == static_cast<EParameter>(15));
+  static_assert(EParameter::kState == static_cast<EParameter>(16));
+  static_assert(EParameter::kValue == static_cast<EParameter>(17));
   static MCU_FLASH_STRING_TABLE(  // Force new line.
       flash_string_table,
       MCU_PSD("Unknown"),              // 0: kUnknown
@@ -1063,13 +1138,16 @@ const __FlashStringHelper* ToFlashStringHelper(EParameter v) {
       MCU_PSD("Connected"),            // 5: kConnected
       MCU_PSD("Parameters"),           // 6: kParameters
       MCU_PSD("Raw"),                  // 7: kRaw
-      MCU_PSD("Brightness"),           // 8: kBrightness
-      MCU_PSD("AveragePeriod"),        // 9: kAveragePeriod
-      MCU_PSD("SensorName"),           // 10: kSensorName
-      MCU_PSD("Id"),                   // 11: kId
-      MCU_PSD("Name"),                 // 12: kName
-      MCU_PSD("State"),                // 13: kState
-      MCU_PSD("Value"),                // 14: kValue
+      MCU_PSD("Method"),               // 8: kMethod
+      MCU_PSD("IfNotEqual"),           // 9: kIfNotEqual
+      MCU_PSD("WaitForChangeMs"),      // 10: kWaitForChangeMs
+      MCU_PSD("Brightness"),           // 11: kBrightness
+      MCU_PSD("AveragePeriod"),        // 12: kAveragePeriod
+      MCU_PSD("SensorName"),           // 13: kSensorName
+      MCU_PSD("Id"),                   // 14: kId
+      MCU_PSD("Name"),                 // 15: kName
+      MCU_PSD("State"),                // 16: kState
+      MCU_PSD("Value"),                // 17: kValue
   );
   return mcucore::LookupFlashStringForDenseEnum<uint_fast8_t>(
       flash_string_table, EParameter::kUnknown, EParameter::kValue, v);
@@ -1205,6 +1283,65 @@ const __FlashStringHelper* ToFlashStringHelper(ESensorName v) {
 
 namespace {
 
+MCU_MAYBE_UNUSED_FUNCTION inline const __FlashStringHelper*
+_ToFlashStringHelperViaSwitch(EDeviceAction v) {
+  switch (v) {
+    case EDeviceAction::kUnknown:
+      return MCU_FLASHSTR("Unknown");
+    case EDeviceAction::kHistory:
+      return MCU_FLASHSTR("History");
+    case EDeviceAction::kGetAllSwitchValues:
+      return MCU_FLASHSTR("GetAllSwitchValues");
+    case EDeviceAction::kSetSwitchValues:
+      return MCU_FLASHSTR("SetSwitchValues");
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+const __FlashStringHelper* ToFlashStringHelper(EDeviceAction v) {
+#ifdef TO_FLASH_STRING_HELPER_PREFER_SWITCH
+  return _ToFlashStringHelperViaSwitch(v);
+#else  // not TO_FLASH_STRING_HELPER_PREFER_SWITCH
+#ifdef TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
+  if (v == EDeviceAction::kUnknown) {
+    return MCU_FLASHSTR("Unknown");
+  }
+  if (v == EDeviceAction::kHistory) {
+    return MCU_FLASHSTR("History");
+  }
+  if (v == EDeviceAction::kGetAllSwitchValues) {
+    return MCU_FLASHSTR("GetAllSwitchValues");
+  }
+  if (v == EDeviceAction::kSetSwitchValues) {
+    return MCU_FLASHSTR("SetSwitchValues");
+  }
+  return nullptr;
+#else   // not TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
+  // Protection against enumerator definitions changing:
+  static_assert(EDeviceAction::kUnknown == static_cast<EDeviceAction>(0));
+  static_assert(EDeviceAction::kHistory == static_cast<EDeviceAction>(1));
+  static_assert(EDeviceAction::kGetAllSwitchValues ==
+                static_cast<EDeviceAction>(2));
+  static_assert(EDeviceAction::kSetSwitchValues ==
+                static_cast<EDeviceAction>(3));
+  static MCU_FLASH_STRING_TABLE(  // Force new line.
+      flash_string_table,
+      MCU_PSD("Unknown"),             // 0: kUnknown
+      MCU_PSD("History"),             // 1: kHistory
+      MCU_PSD("GetAllSwitchValues"),  // 2: kGetAllSwitchValues
+      MCU_PSD("SetSwitchValues"),     // 3: kSetSwitchValues
+  );
+  return mcucore::LookupFlashStringForDenseEnum<uint_fast8_t>(
+      flash_string_table, EDeviceAction::kUnknown,
+      EDeviceAction::kSetSwitchValues, v);
+#endif  // TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
+#endif  // TO_FLASH_STRING_HELPER_PREFER_SWITCH
+}
+
+namespace {
+
 MCU_MAYBE_UNUSED_FUNCTION inline const __FlashStringHelper*
 _ToFlashStringHelperViaSwitch(EHttpHeader v) {
   switch (v) {
@@ -1277,6 +1414,8 @@ _ToFlashStringHelperViaSwitch(EContentType v) {
       return MCU_FLASHSTR("text/plain");
     case EContentType::kTextHtml:
       return MCU_FLASHSTR("text/html");
+    case EContentType::kTextEventStream:
+      return MCU_FLASHSTR("text/event-stream");
   }
   return nullptr;
 }
@@ -1297,21 +1436,26 @@ const __FlashStringHelper* ToFlashStringHelper(EContentType v) {
   if (v == EContentType::kTextHtml) {
     return MCU_FLASHSTR("text/html");
   }
+  if (v == EContentType::kTextEventStream) {
+    return MCU_FLASHSTR("text/event-stream");
+  }
   return nullptr;
 #else   // not TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
   // Protection against enumerator definitions changing:
   static_assert(EContentType::kApplicationJson == static_cast<EContentType>(0));
   static_assert(EContentType::kTextPlain == static_cast<EContentType>(1));
   static_assert(EContentType::kTextHtml == static_cast<EContentType>(2));
+  static_assert(EContentType::kTextEventStream == static_cast<EContentType>(3));
   static MCU_FLASH_STRING_TABLE(  // Force new line.
       flash_string_table,
-      MCU_PSD("application/json"),  // 0: kApplicationJson
-      MCU_PSD("text/plain"),        // 1: kTextPlain
-      MCU_PSD("text/html"),         // 2: kTextHtml
+      MCU_PSD("application/json"),   // 0: kApplicationJson
+      MCU_PSD("text/plain"),         // 1: kTextPlain
+      MCU_PSD("text/html"),          // 2: kTextHtml
+      MCU_PSD("text/event-stream"),  // 3: kTextEventStream
   );
   return mcucore::LookupFlashStringForDenseEnum<uint_fast8_t>(
       flash_string_table, EContentType::kApplicationJson,
-      EContentType::kTextHtml, v);
+      EContentType::kTextEventStream, v);
 #endif  // TO_FLASH_STRING_HELPER_PREFER_IF_STATEMENTS
 #endif  // TO_FLASH_STRING_HELPER_PREFER_SWITCH
 }
@@ -1493,6 +1637,15 @@ size_t PrintValueTo(ESensorName v, Print& out) {
                                           static_cast<uint32_t>(v), out);
 }
 
+size_t PrintValueTo(EDeviceAction v, Print& out) {
+  auto flash_string = ToFlashStringHelper(v);
+  if (flash_string != nullptr) {
+    return out.print(flash_string);
+  }
+  return mcucore::PrintUnknownEnumValueTo(MCU_FLASHSTR("EDeviceAction"),
+                                          static_cast<uint32_t>(v), out);
+}
+
 size_t PrintValueTo(EHttpHeader v, Print& out) {
   auto flash_string = ToFlashStringHelper(v);
   if (flash_string != nullptr) {
@@ -1602,6 +1755,13 @@ std::ostream& operator<<(std::ostream& os, ESensorName v) {
   return os << std::string_view(buffer, print.data_size());
 }
 
+std::ostream& operator<<(std::ostream& os, EDeviceAction v) {
+  char buffer[256];
+  mcucore::PrintToBuffer print(buffer);
+  PrintValueTo(v, print);
+  return os << std::string_view(buffer, print.data_size());
+}
+
 std::ostream& operator<<(std::ostream& os, EHttpHeader v) {
   char buffer[256];
   mcucore::PrintToBuffer print(buffer);
@@ -109,6 +109,10 @@ enum class EHttpStatusCode : uint_fast16_t {
   // We only support GET, HEAD and PUT, and return this for any other method.
   TASENUMERATOR(kHttpNotImplemented, "Not Implemented") = 501,
 
+  // The server is temporarily unable to handle the request, e.g. because all
+  // of the sockets available for event streams are in use.
+  TASENUMERATOR(kHttpServiceUnavailable, "Service Unavailable") = 503,
+
   // Only HTTP/1.1 is supported. Could support 1.0 easily enough.
   TASENUMERATOR(kHttpVersionNotSupported, "HTTP Version Not Supported") = 505,
 };
@@ -129,6 +133,7 @@ enum class EApiGroup : uint_fast8_t {
   kSetup,         // Path: /setup...
   kAsset,         // Path: /asset...
   kServerStatus,  // Path: /
+  kMetrics,       // Path: /metrics
 };
 
 enum class EAlpacaApi : uint_fast8_t {
@@ -149,6 +154,10 @@ enum class EAlpacaApi : uint_fast8_t {
   // Path: /management/v1/configureddevices
   kManagementConfiguredDevices,
 
+  // Tiny Alpaca Server extension, not part of the ASCOM Alpaca API.
+  // Path: /management/v1/requestjournal
+  kManagementRequestJournal,
+
   // Path: /asset/...
   kAsset,
 
@@ -157,12 +166,16 @@ enum class EAlpacaApi : uint_fast8_t {
 
   // Path: /
   kServerStatus,
+
+  // Path: /metrics
+  kServerMetrics,
 };
 
 enum class EManagementMethod : uint_fast8_t {
   kUnknown,
   kDescription,
   kConfiguredDevices,
+  kRequestJournal,
 };
 
 // Note that we depend in the HTML generation code on the generated PrintValueTo
@@ -192,6 +205,15 @@ enum class EDeviceMethod : uint_fast8_t {
   // This is the only method for EAlpacaApi::kDeviceSetup:
   kSetup,
 
+  // Tiny Alpaca Server extension, not part of the ASCOM Alpaca API, supported
+  // for all device types: GET .../batch?Method=temperature&Method=humidity
+  // returns a JSON array with the responses to each of the named GET methods.
+  kBatch,
+
+  // Tiny Alpaca Server extension: GET .../events opens a Server-Sent Events
+  // stream on which the server pushes the device's state when it changes.
+  kEvents,
+
   // Supported common methods:
   kAction,
   kCommandBlind,
@@ -199,6 +221,7 @@ enum class EDeviceMethod : uint_fast8_t {
   kCommandString,
   kConnected,
   kDescription,
+  kDeviceState,  // Returns all operational properties in one response.
   kDriverInfo,
   kDriverVersion,
   kInterfaceVersion,
@@ -268,6 +291,13 @@ enum class EParameter : uint_fast8_t {
   kParameters,
   kRaw,
 
+  // Batch parameters (may be repeated).
+  kMethod,
+
+  // Long-poll parameters, for any GET device method.
+  kIfNotEqual,
+  kWaitForChangeMs,
+
   // Calibrator parameters.
   kBrightness,
 
@@ -303,6 +333,21 @@ enum class ESensorName : uint_fast8_t {
   kWindSpeed,
 };
 
+// These are the names of the actions (i.e. the values of the Action parameter
+// of a PUT /action request) which are implemented by the device type adapters,
+// rather than by individual devices. These are to be matched case
+// insensitively.
+enum class EDeviceAction : uint_fast8_t {
+  kUnknown,
+
+  // ObservingConditions actions.
+  kHistory,
+
+  // Switch actions.
+  kGetAllSwitchValues,
+  kSetSwitchValues,
+};
+
 enum class EHttpHeader : uint_fast8_t {
   kUnknown,
 
@@ -324,6 +369,7 @@ enum class EContentType : uint_fast8_t {
   TASENUMERATOR(kApplicationJson, "application/json"),
   TASENUMERATOR(kTextPlain, "text/plain"),
   TASENUMERATOR(kTextHtml, "text/html"),
+  TASENUMERATOR(kTextEventStream, "text/event-stream"),
 };
 
 // This is used for generating HTML responses, not for input.
@@ -356,6 +402,7 @@ const __FlashStringHelper* ToFlashStringHelper(EDeviceType v);
 const __FlashStringHelper* ToFlashStringHelper(EDeviceMethod v);
 const __FlashStringHelper* ToFlashStringHelper(EParameter v);
 const __FlashStringHelper* ToFlashStringHelper(ESensorName v);
+const __FlashStringHelper* ToFlashStringHelper(EDeviceAction v);
 const __FlashStringHelper* ToFlashStringHelper(EHttpHeader v);
 const __FlashStringHelper* ToFlashStringHelper(EContentType v);
 const __FlashStringHelper* ToFlashStringHelper(EHtmlPageSection v);
@@ -371,6 +418,7 @@ size_t PrintValueTo(EDeviceType v, Print& out);
 size_t PrintValueTo(EDeviceMethod v, Print& out);
 size_t PrintValueTo(EParameter v, Print& out);
 size_t PrintValueTo(ESensorName v, Print& out);
+size_t PrintValueTo(EDeviceAction v, Print& out);
 size_t PrintValueTo(EHttpHeader v, Print& out);
 size_t PrintValueTo(EContentType v, Print& out);
 size_t PrintValueTo(EHtmlPageSection v, Print& out);
@@ -388,6 +436,7 @@ std::ostream& operator<<(std::ostream& os, EDeviceType v);
 std::ostream& operator<<(std::ostream& os, EDeviceMethod v);
 std::ostream& operator<<(std::ostream& os, EParameter v);
 std::ostream& operator<<(std::ostream& os, ESensorName v);
+std::ostream& operator<<(std::ostream& os, EDeviceAction v);
 std::ostream& operator<<(std::ostream& os, EHttpHeader v);
 std::ostream& operator<<(std::ostream& os, EContentType v);
 std::ostream& operator<<(std::ostream& os, EHtmlPageSection v);
@@ -19,7 +19,14 @@ size_t PrintUuid(Print& out, const void* data) {
 
 void DeviceDescription::AddConfiguredDeviceTo(
     mcucore::JsonObjectEncoder& object_encoder, EepromTlv& tlv) const {
-  object_encoder.AddStringProperty(ProgmemStringViews::DeviceName(), name);
+  AddConfiguredDeviceTo(object_encoder, tlv, mcucore::AnyPrintable(name));
+}
+
+void DeviceDescription::AddConfiguredDeviceTo(
+    mcucore::JsonObjectEncoder& object_encoder, EepromTlv& tlv,
+    const mcucore::AnyPrintable& name_override) const {
+  object_encoder.AddStringProperty(ProgmemStringViews::DeviceName(),
+                                   name_override);
 
   // TODO(jamessynge): Check on the case requirements of the device type's name.
   object_encoder.AddStringProperty(ProgmemStringViews::DeviceType(),
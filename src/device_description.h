@@ -21,6 +21,12 @@ struct DeviceDescription {
   void AddConfiguredDeviceTo(mcucore::JsonObjectEncoder& object_encoder,
                              mcucore::EepromTlv& tlv) const;
 
+  // As above, but with the specified name in place of the name field, e.g.
+  // because the user has renamed the device at runtime.
+  void AddConfiguredDeviceTo(mcucore::JsonObjectEncoder& object_encoder,
+                             mcucore::EepromTlv& tlv,
+                             const mcucore::AnyPrintable& name_override) const;
+
   // Get the UUID for this device; this may require generating it, and storing
   // it in EEPROM, if it isn't yet stored in EEPROM.
   mcucore::StatusOr<mcucore::Uuid> GetOrCreateUniqueId(
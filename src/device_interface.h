@@ -12,12 +12,12 @@
 //      /api/v1/{device_type}/{device_number}/{method_name}
 //      /setup/v1/{device_type}/{device_number}/setup
 //
-// There is no support for incrementally returning responses (i.e. over the
-// course of multiple Arduino loop() executions), so the responses produced by
-// the Handle*Request methods generally need to be small enough to fit in the
-// buffers available via 'out' (e.g. at most a few Ethernet frames as provided
-// by a WIZ5500), else they'll stall the system while we wait for ACKs from the
-// client.
+// There is no support for incrementally returning the responses of devices
+// (i.e. over the course of multiple Arduino loop() executions), so the
+// responses produced by the Handle*Request methods generally need to be small
+// enough to fit in the buffers available via 'out' (e.g. at most a few Ethernet
+// frames as provided by a WIZ5500), else they'll stall the system while we wait
+// for ACKs from the client.
 //
 // This is separated out in part to make it easier to test the request
 // dispatching logic.
@@ -6,6 +6,15 @@
 #include "literals.h"
 
 namespace alpaca {
+namespace {
+template <typename E>
+mcucore::StatusOr<int32_t> ToStatusOrInt(mcucore::StatusOr<E> status_or_enum) {
+  if (status_or_enum.ok()) {
+    return static_cast<int32_t>(status_or_enum.value());
+  }
+  return status_or_enum.status();
+}
+}  // namespace
 
 CoverCalibratorAdapter::CoverCalibratorAdapter(
     ServerContext& server_context, const DeviceDescription& device_description)
@@ -43,6 +52,15 @@ bool CoverCalibratorAdapter::HandleGetRequest(const AlpacaRequest& request,
   return DeviceImplBase::HandleGetRequest(request, out);
 }
 
+void CoverCalibratorAdapter::AddDeviceStateTo(
+    mcucore::JsonArrayEncoder& encoder) {
+  AddIntDeviceState(encoder, MCU_PSV("Brightness"), GetBrightness());
+  AddIntDeviceState(encoder, MCU_PSV("CalibratorState"),
+                    ToStatusOrInt(GetCalibratorState()));
+  AddIntDeviceState(encoder, MCU_PSV("CoverState"),
+                    ToStatusOrInt(GetCoverState()));
+}
+
 mcucore::StatusOr<int32_t> CoverCalibratorAdapter::GetBrightness() {
   return ErrorCodes::ActionNotImplemented();
 }
@@ -36,6 +36,9 @@ class CoverCalibratorAdapter : public DeviceImplBase {
   // the base classes' HandleGetRequest method.
   bool HandleGetRequest(const AlpacaRequest& request, Print& out) override;
 
+  // Adds the Brightness, CalibratorState and CoverState.
+  void AddDeviceStateTo(mcucore::JsonArrayEncoder& encoder) override;
+
   // Handles PUT 'request', writes the HTTP response message to 'out'. Returns
   // true to indicate that the response was written without error, otherwise
   // false, in which case the connection to the client will be closed.
@@ -3,8 +3,10 @@
 #include <McuCore.h>
 
 #include "alpaca_response.h"
+#include "config.h"
 #include "constants.h"
 #include "device_description.h"
+#include "eeprom_ids.h"
 #include "literals.h"
 
 namespace alpaca {
@@ -30,12 +32,98 @@ class DeviceDescriptionHtml : public Printable {
   const DeviceImplBase& device_;
 };
 
+// One element of the array that is the value of a /devicestate response.
+template <typename T>
+class DeviceStateItem : public mcucore::JsonPropertySource {
+ public:
+  DeviceStateItem(const mcucore::AnyPrintable& name, T value)
+      : name_(name), value_(value) {}
+
+  void AddTo(mcucore::JsonObjectEncoder& object_encoder) const override {
+    object_encoder.AddStringProperty(ProgmemStringViews::Name(), name_);
+    AddValueTo(object_encoder, value_);
+  }
+
+ private:
+  static void AddValueTo(mcucore::JsonObjectEncoder& object_encoder,
+                         bool value) {
+    object_encoder.AddBooleanProperty(ProgmemStringViews::Value(), value);
+  }
+  static void AddValueTo(mcucore::JsonObjectEncoder& object_encoder,
+                         double value) {
+    object_encoder.AddDoubleProperty(ProgmemStringViews::Value(), value);
+  }
+  static void AddValueTo(mcucore::JsonObjectEncoder& object_encoder,
+                         int32_t value) {
+    object_encoder.AddIntProperty(ProgmemStringViews::Value(), value);
+  }
+
+  const mcucore::AnyPrintable& name_;
+  const T value_;
+};
+
+template <typename T>
+void AddDeviceStateItem(mcucore::JsonArrayEncoder& encoder,
+                        const mcucore::AnyPrintable& name,
+                        const mcucore::StatusOr<T>& status_or_value) {
+  if (status_or_value.ok()) {
+    DeviceStateItem<T> item(name, status_or_value.value());
+    encoder.AddObjectElement(item);
+  }
+}
+
+// Produces the array of Name and Value objects by calling back into the device.
+class DeviceStateSource : public mcucore::JsonElementSource {
+ public:
+  explicit DeviceStateSource(DeviceImplBase& device) : device_(device) {}
+
+  void AddTo(mcucore::JsonArrayEncoder& encoder) const override {
+    device_.AddDeviceStateTo(encoder);
+  }
+
+ private:
+  DeviceImplBase& device_;
+};
+
+// Produces the array of action names by calling back into the device.
+class SupportedActionsSource : public mcucore::JsonElementSource {
+ public:
+  explicit SupportedActionsSource(DeviceImplBase& device) : device_(device) {}
+
+  void AddTo(mcucore::JsonArrayEncoder& encoder) const override {
+    device_.AddSupportedActionsTo(encoder);
+  }
+
+ private:
+  DeviceImplBase& device_;
+};
+
 }  // namespace
 
 void DeviceImplBase::AddConfiguredDeviceTo(
     mcucore::JsonObjectEncoder& object_encoder) const {
-  device_description_.AddConfiguredDeviceTo(object_encoder,
-                                            server_context_.eeprom_tlv());
+  device_description_.AddConfiguredDeviceTo(
+      object_encoder, server_context_.eeprom_tlv(), Name());
+}
+
+mcucore::AnyPrintable DeviceImplBase::Name() const {
+  return SettingOr(kDeviceNameId, device_description_.name);
+}
+
+mcucore::AnyPrintable DeviceImplBase::Description() const {
+  return SettingOr(kDeviceDescriptionId, device_description_.description);
+}
+
+mcucore::AnyPrintable DeviceImplBase::SettingOr(
+    uint8_t id, const mcucore::ProgmemString& default_value) const {
+#if TAS_ENABLE_SETTINGS_JOURNAL
+  const mcucore::StringView value = server_context_.settings().Get(
+      {.domain = device_description_.domain, .id = id});
+  if (!value.empty()) {
+    return mcucore::AnyPrintable(value);
+  }
+#endif  // TAS_ENABLE_SETTINGS_JOURNAL
+  return mcucore::AnyPrintable(default_value);
 }
 
 bool DeviceImplBase::HandleDeviceSetupRequest(const AlpacaRequest& request,
@@ -100,7 +188,7 @@ void DeviceImplBase::AddEndDeviceSection(mcucore::OPrintStream& strm) {
 
 void DeviceImplBase::AddDeviceBanner(mcucore::OPrintStream& strm) {
   strm << MCU_PSD("<div class=db><h3><span class=dn>")
-       << device_description_.name << MCU_PSD("</span> <span class=dt>")
+       << Name() << MCU_PSD("</span> <span class=dt>")
        << device_description_.device_type << MCU_PSD(" device #")
        << device_description_.device_number << MCU_PSD("</span></h3></div>\n");
 }
@@ -109,7 +197,7 @@ void DeviceImplBase::AddDeviceSummary(mcucore::OPrintStream& strm) {
   strm << MCU_PSD(
               "<table class=ds>\n<tr class=dd><td>Description:</td>"
               "<td class=dd>")
-       << device_description_.description << MCU_PSD("</td></tr>\n");
+       << Description() << MCU_PSD("</td></tr>\n");
 
   auto status_or_uuid =
       device_description_.GetOrCreateUniqueId(server_context_.eeprom_tlv());
@@ -164,8 +252,12 @@ bool DeviceImplBase::HandleGetRequest(const AlpacaRequest& request,
       return WriteResponse::StatusOrBoolResponse(request, GetConnected(), out);
 
     case EDeviceMethod::kDescription:
-      return WriteResponse::AnyPrintableStringResponse(
-          request, device_description_.description, out);
+      return WriteResponse::AnyPrintableStringResponse(request, Description(),
+                                                       out);
+
+    case EDeviceMethod::kDeviceState:
+      return WriteResponse::ArrayResponse(request, DeviceStateSource(*this),
+                                          out);
 
     case EDeviceMethod::kDriverInfo:
       return WriteResponse::AnyPrintableStringResponse(
@@ -180,18 +272,43 @@ bool DeviceImplBase::HandleGetRequest(const AlpacaRequest& request,
           request, device_description_.interface_version(), out);
 
     case EDeviceMethod::kName:
-      return WriteResponse::AnyPrintableStringResponse(
-          request, device_description_.name, out);
+      return WriteResponse::AnyPrintableStringResponse(request, Name(), out);
 
     case EDeviceMethod::kSupportedActions:
-      return WriteResponse::ProgmemStringArrayResponse(
-          request, device_description_.supported_actions, out);
+      return WriteResponse::ArrayResponse(
+          request, SupportedActionsSource(*this), out);
 
     default:
       return WriteResponse::AscomMethodNotImplementedResponse(request, out);
   }
 }
 
+void DeviceImplBase::AddBoolDeviceState(
+    mcucore::JsonArrayEncoder& encoder, const mcucore::AnyPrintable& name,
+    mcucore::StatusOr<bool> status_or_value) {
+  AddDeviceStateItem(encoder, name, status_or_value);
+}
+
+void DeviceImplBase::AddDoubleDeviceState(
+    mcucore::JsonArrayEncoder& encoder, const mcucore::AnyPrintable& name,
+    mcucore::StatusOr<double> status_or_value) {
+  AddDeviceStateItem(encoder, name, status_or_value);
+}
+
+void DeviceImplBase::AddIntDeviceState(
+    mcucore::JsonArrayEncoder& encoder, const mcucore::AnyPrintable& name,
+    mcucore::StatusOr<int32_t> status_or_value) {
+  AddDeviceStateItem(encoder, name, status_or_value);
+}
+
+void DeviceImplBase::AddSupportedActionsTo(
+    mcucore::JsonArrayEncoder& encoder) {
+  for (const mcucore::ProgmemString& action :
+       device_description_.supported_actions) {
+    encoder.AddStringElement(action);
+  }
+}
+
 bool DeviceImplBase::HandlePutRequest(const AlpacaRequest& request,
                                       Print& out) {
   switch (request.device_method) {
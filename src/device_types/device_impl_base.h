@@ -48,6 +48,13 @@ class DeviceImplBase : public DeviceInterface {
 
   void AddConfiguredDeviceTo(
       mcucore::JsonObjectEncoder& object_encoder) const override;
+
+  // Returns the name (or description) of the device which the user has set at
+  // runtime (stored in the SettingsJournal, with ids kDeviceNameId and
+  // kDeviceDescriptionId in the device's domain), if there is one, else the
+  // name (or description) in the DeviceDescription.
+  mcucore::AnyPrintable Name() const;
+  mcucore::AnyPrintable Description() const;
   void AddToHomePageHtml(const AlpacaRequest& request, EHtmlPageSection section,
                          mcucore::OPrintStream& strm) override;
   bool HandleDeviceSetupRequest(const AlpacaRequest& request,
@@ -68,6 +75,21 @@ class DeviceImplBase : public DeviceInterface {
   virtual void WriteDeviceSetupHtml(const AlpacaRequest& request,
                                     mcucore::OPrintStream& strm) const;
 
+  // Adds the operational properties of the device to encoder, one JSON object
+  // (with Name and Value properties) per property, for the response to a GET
+  // /devicestate request. Properties whose value can't currently be determined
+  // should be omitted. Note that this is called twice per request, once to
+  // compute the Content-Length and once to write the body. The default
+  // implementation adds nothing.
+  virtual void AddDeviceStateTo(mcucore::JsonArrayEncoder& encoder) {}
+
+  // Adds the names of the supported actions to encoder, for the response to a
+  // GET /supportedactions request. The default implementation adds those listed
+  // in the DeviceDescription; device type adapters which implement actions of
+  // their own (e.g. ObservingConditionsAdapter's History action) override this
+  // to add those too.
+  virtual void AddSupportedActionsTo(mcucore::JsonArrayEncoder& encoder);
+
  protected:
   // Additional methods provided by this class, can be overridden by subclass.
 
@@ -81,6 +103,18 @@ class DeviceImplBase : public DeviceInterface {
   virtual void AddDeviceDetails(mcucore::OPrintStream& strm) {}
   virtual void AddEndDeviceSection(mcucore::OPrintStream& strm);
 
+  // Helpers for implementations of AddDeviceStateTo. Each adds a Name and Value
+  // object to encoder if status_or_value is OK, else does nothing.
+  static void AddBoolDeviceState(mcucore::JsonArrayEncoder& encoder,
+                                 const mcucore::AnyPrintable& name,
+                                 mcucore::StatusOr<bool> status_or_value);
+  static void AddDoubleDeviceState(mcucore::JsonArrayEncoder& encoder,
+                                   const mcucore::AnyPrintable& name,
+                                   mcucore::StatusOr<double> status_or_value);
+  static void AddIntDeviceState(mcucore::JsonArrayEncoder& encoder,
+                                const mcucore::AnyPrintable& name,
+                                mcucore::StatusOr<int32_t> status_or_value);
+
   // Handles a subset of the "ASCOM Alpaca Methods Common To All Devices": the
   // device metadata inquiry methods, such as /interfaceversion and
   // /supportedactions, which can be answered using the DeviceDescription
@@ -138,6 +172,10 @@ class DeviceImplBase : public DeviceInterface {
 
   ServerContext& server_context_;
   const DeviceDescription& device_description_;
+
+ private:
+  mcucore::AnyPrintable SettingOr(
+      uint8_t id, const mcucore::ProgmemString& default_value) const;
 };
 
 }  // namespace alpaca
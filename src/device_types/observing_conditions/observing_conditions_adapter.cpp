@@ -6,6 +6,7 @@
 #include "ascom_error_codes.h"
 #include "constants.h"
 #include "literals.h"
+#include "match_literals.h"
 
 namespace alpaca {
 namespace {
@@ -25,6 +26,61 @@ void AddSensorTableRow(
   }
   strm << MCU_PSD("</td></tr>\n");
 }
+
+// Returns the sensor whose value is returned by the method, or kUnknown if the
+// method doesn't return a sensor value.
+ESensorName SensorOfMethod(EDeviceMethod method) {
+  switch (method) {
+    case EDeviceMethod::kCloudCover:
+      return ESensorName::kCloudCover;
+    case EDeviceMethod::kDewPoint:
+      return ESensorName::kDewPoint;
+    case EDeviceMethod::kHumidity:
+      return ESensorName::kHumidity;
+    case EDeviceMethod::kPressure:
+      return ESensorName::kPressure;
+    case EDeviceMethod::kRainRate:
+      return ESensorName::kRainRate;
+    case EDeviceMethod::kSkyBrightness:
+      return ESensorName::kSkyBrightness;
+    case EDeviceMethod::kSkyQuality:
+      return ESensorName::kSkyQuality;
+    case EDeviceMethod::kSkyTemperature:
+      return ESensorName::kSkyTemperature;
+    case EDeviceMethod::kStarFWHM:
+      return ESensorName::kStarFWHM;
+    case EDeviceMethod::kTemperature:
+      return ESensorName::kTemperature;
+    case EDeviceMethod::kWindDirection:
+      return ESensorName::kWindDirection;
+    case EDeviceMethod::kWindGust:
+      return ESensorName::kWindGust;
+    case EDeviceMethod::kWindSpeed:
+      return ESensorName::kWindSpeed;
+    default:
+      return ESensorName::kUnknown;
+  }
+}
+
+#if TAS_ENABLE_SENSOR_HISTORY
+class SensorHistoryCsv : public Printable {
+ public:
+  SensorHistoryCsv(const SensorSampler& sensor_sampler,
+                   ESensorName sensor_name, uint32_t now_millis)
+      : sensor_sampler_(sensor_sampler),
+        sensor_name_(sensor_name),
+        now_millis_(now_millis) {}
+
+  size_t printTo(Print& out) const override {
+    return sensor_sampler_.PrintHistoryTo(sensor_name_, now_millis_, out);
+  }
+
+ private:
+  const SensorSampler& sensor_sampler_;
+  const ESensorName sensor_name_;
+  const uint32_t now_millis_;
+};
+#endif  // TAS_ENABLE_SENSOR_HISTORY
 }  // namespace
 
 ObservingConditionsAdapter::ObservingConditionsAdapter(
@@ -36,6 +92,18 @@ ObservingConditionsAdapter::ObservingConditionsAdapter(
 
 ObservingConditionsAdapter::~ObservingConditionsAdapter() {}
 
+void ObservingConditionsAdapter::MaintainDevice() { SampleSensors(millis()); }
+
+void ObservingConditionsAdapter::AddSupportedActionsTo(
+    mcucore::JsonArrayEncoder& encoder) {
+  DeviceImplBase::AddSupportedActionsTo(encoder);
+#if TAS_ENABLE_SENSOR_HISTORY
+  if (HasHistory()) {
+    encoder.AddStringElement(ProgmemStringViews::History());
+  }
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+}
+
 void ObservingConditionsAdapter::AddDeviceDetails(mcucore::OPrintStream& strm) {
   strm << MCU_PSD("<div class=ocp>\n<h4>Observing Conditions Properties</h4>\n")
        << MCU_PSD("<table>\n");
@@ -103,9 +171,38 @@ void ObservingConditionsAdapter::AddDeviceDetails(mcucore::OPrintStream& strm) {
   strm << MCU_PSD("</table>\n</div>\n");
 }
 
+void ObservingConditionsAdapter::AddDeviceStateTo(
+    mcucore::JsonArrayEncoder& encoder) {
+  // The ASCOM spec also calls for a TimeStamp, but we don't have a clock.
+  AddDoubleDeviceState(encoder, MCU_PSV("CloudCover"), GetCloudCover());
+  AddDoubleDeviceState(encoder, MCU_PSV("DewPoint"), GetDewPoint());
+  AddDoubleDeviceState(encoder, MCU_PSV("Humidity"), GetHumidity());
+  AddDoubleDeviceState(encoder, MCU_PSV("Pressure"), GetPressure());
+  AddDoubleDeviceState(encoder, MCU_PSV("RainRate"), GetRainRate());
+  AddDoubleDeviceState(encoder, MCU_PSV("SkyBrightness"), GetSkyBrightness());
+  AddDoubleDeviceState(encoder, MCU_PSV("SkyQuality"), GetSkyQuality());
+  AddDoubleDeviceState(encoder, MCU_PSV("SkyTemperature"),
+                       GetSkyTemperature());
+  AddDoubleDeviceState(encoder, MCU_PSV("StarFWHM"), GetStarFWHM());
+  AddDoubleDeviceState(encoder, MCU_PSV("Temperature"), GetTemperature());
+  AddDoubleDeviceState(encoder, MCU_PSV("WindDirection"), GetWindDirection());
+  AddDoubleDeviceState(encoder, MCU_PSV("WindGust"), GetWindGust());
+  AddDoubleDeviceState(encoder, MCU_PSV("WindSpeed"), GetWindSpeed());
+}
+
 // Handle a GET 'request', write the HTTP response message to out.
 bool ObservingConditionsAdapter::HandleGetRequest(const AlpacaRequest& request,
                                                   Print& out) {
+  const ESensorName sensor_name = SensorOfMethod(request.device_method);
+  if (sensor_name != ESensorName::kUnknown) {
+    auto result = GetFixedPointValue(sensor_name);
+    if (result.ok()) {
+      return WriteResponse::FixedPointResponse(request, result.value(), out);
+    } else if (static_cast<int>(result.status().code()) !=
+               ErrorCodes::kNotImplemented) {
+      return WriteResponse::StatusResponse(request, result.status(), out);
+    }
+  }
   switch (request.device_method) {
     case EDeviceMethod::kAveragePeriod:
       return WriteResponse::StatusOrDoubleResponse(request, GetAveragePeriod(),
@@ -207,50 +304,55 @@ mcucore::StatusOr<double> ObservingConditionsAdapter::GetAveragePeriod() {
   }
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetCloudCover() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kCloudCover);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetDewPoint() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kDewPoint);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetHumidity() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kHumidity);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetPressure() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kPressure);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetRainRate() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kRainRate);
 }
 mcucore::StatusOr<mcucore::ProgmemStringView>
 ObservingConditionsAdapter::GetSensorDescription(ESensorName sensor_name) {
   return ErrorCodes::NotImplemented();
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetSkyBrightness() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kSkyBrightness);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetSkyQuality() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kSkyQuality);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetSkyTemperature() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kSkyTemperature);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetStarFWHM() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kStarFWHM);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetTemperature() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kTemperature);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetTimeSinceLastUpdate(
     ESensorName sensor_name) {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetTimeSinceLastUpdate(sensor_name, millis());
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetWindDirection() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kWindDirection);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetWindGust() {
-  return ErrorCodes::NotImplemented();
+  return sensor_sampler_.GetValue(ESensorName::kWindGust);
 }
 mcucore::StatusOr<double> ObservingConditionsAdapter::GetWindSpeed() {
+  return sensor_sampler_.GetValue(ESensorName::kWindSpeed);
+}
+
+mcucore::StatusOr<FixedPoint> ObservingConditionsAdapter::GetFixedPointValue(
+    ESensorName sensor_name) {
   return ErrorCodes::NotImplemented();
 }
 
@@ -305,10 +407,71 @@ bool ObservingConditionsAdapter::HandlePutRefresh(const AlpacaRequest& request,
   return WriteResponse::StatusResponse(request, Refresh(), out);
 }
 
+bool ObservingConditionsAdapter::HandlePutAction(const AlpacaRequest& request,
+                                                 Print& out) {
+#if TAS_ENABLE_SENSOR_HISTORY
+  if (HasHistory()) {
+    if (request.action == EDeviceAction::kHistory) {
+      return HandlePutHistoryAction(request, out);
+    } else if (device_description().supported_actions.size == 0) {
+      // There are some valid actions, so this isn't MethodNotImplemented.
+      return WriteResponse::AscomActionNotImplementedResponse(request, out);
+    }
+  }
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+  return DeviceImplBase::HandlePutAction(request, out);
+}
+
+#if TAS_ENABLE_SENSOR_HISTORY
+bool ObservingConditionsAdapter::HasHistory() const {
+  return sensor_sampler_.num_sensors() > 0;
+}
+
+bool ObservingConditionsAdapter::HandlePutHistoryAction(
+    const AlpacaRequest& request, Print& out) {
+  // The Parameters are optional; if provided, they name a single sensor.
+  ESensorName sensor_name = ESensorName::kUnknown;
+  if (request.have_string_value && !request.string_value.empty()) {
+    mcucore::StringView view(request.string_value.data(),
+                             request.string_value.size());
+    if (!MatchSensorName(view, sensor_name)) {
+      return WriteResponse::AscomParameterInvalidErrorResponse(
+          request, ProgmemStringViews::Parameters(), out);
+    } else if (!sensor_sampler_.IsRegistered(sensor_name)) {
+      return WriteSensorNotImpementedResponse(request, sensor_name, out);
+    }
+  }
+  // The CSV is printed twice, once to measure it and once to write it, and is
+  // written whole; SensorSampler::kMaxHistoryPoints limits its size.
+  SensorHistoryCsv csv(sensor_sampler_, sensor_name, millis());
+  return WriteResponse::PrintableStringResponse(request, csv, out);
+}
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+
 mcucore::Status ObservingConditionsAdapter::Refresh() {
+  if (sensor_sampler_.num_sensors() == 0) {
+    return ErrorCodes::NotImplemented();
+  }
+  sensor_sampler_.MakeAllDue();
+  return mcucore::OkStatus();
+}
+
+mcucore::StatusOr<double> ObservingConditionsAdapter::ReadSensor(
+    ESensorName sensor_name) {
   return ErrorCodes::NotImplemented();
 }
 
+void ObservingConditionsAdapter::SampleSensors(uint32_t now_millis) {
+#if TAS_ENABLE_SENSOR_HISTORY
+  sensor_sampler_.AdvanceHistory(now_millis);
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+  const ESensorName sensor_name = sensor_sampler_.NextDueSensor(now_millis);
+  if (sensor_name != ESensorName::kUnknown) {
+    sensor_sampler_.RecordReading(sensor_name, ReadSensor(sensor_name),
+                                  now_millis);
+  }
+}
+
 bool ObservingConditionsAdapter::WriteDoubleOrSensorErrorResponse(
     const AlpacaRequest& request, ESensorName sensor_name,
     mcucore::StatusOr<double> result, Print& out) {
@@ -4,12 +4,26 @@
 // Implements much of the common logic for all Observing Conditions devices,
 // providing a simple API for sub-classes to implement (e.g. GetHumidity).
 //
+// Rather than implementing the GetXyz methods, a sub-class can register each
+// of its sensors with RegisterSensor, and implement ReadSensor. MaintainDevice
+// then reads at most one sensor per call, the one most overdue for reading, and
+// the GetXyz methods and GetTimeSinceLastUpdate return the cached readings, so
+// that requests are answered without reading the sensors.
+//
+// If TAS_ENABLE_SENSOR_HISTORY is non-zero, the registered sensors also have a
+// downsampled history (see SensorHistory), which is returned by the History
+// action (PUT /action with Action=History, and optionally Parameters set to a
+// sensor name), as CSV in the Value string. This allows a client which has
+// reconnected to catch up with one request, rather than many polls.
+//
 // Author: james.synge@gmail.com
 
 #include <McuCore.h>
 
 #include "constants.h"
 #include "device_types/device_impl_base.h"
+#include "device_types/observing_conditions/sensor_sampler.h"
+#include "utils/fixed_point.h"
 
 namespace alpaca {
 
@@ -24,21 +38,34 @@ class ObservingConditionsAdapter : public DeviceImplBase {
   // provide a default implementation of ResetHardware.
   void ResetHardware() override {}
 
+  // Reads the registered sensor (if any) which is most overdue for reading.
+  // Sub-classes which override this should call this implementation.
+  void MaintainDevice() override;
+
   void AddDeviceDetails(mcucore::OPrintStream& strm) override;
 
+  // Adds the value of each sensor, as the ASCOM spec calls for; AveragePeriod
+  // is a setting rather than a sensor, so it isn't included.
+  void AddDeviceStateTo(mcucore::JsonArrayEncoder& encoder) override;
+
+  // Adds History to the supported actions if there are registered sensors.
+  void AddSupportedActionsTo(mcucore::JsonArrayEncoder& encoder) override;
+
   // Handles GET 'request', writes the HTTP response message to 'out'. Returns
   // true to indicate that the response was written without error, otherwise
   // false, in which case the connection to the client will be closed.
   //
   // For device specific methods (e.g. "/humidity"), gets the value to be
-  // returned to the client by calling the appropriate GetXyz() method below
-  // (e.g. GetHumidity). For other methods (e.g. "/driverinfo"), delegates to
-  // the base classes' HandleGetRequest method.
+  // returned to the client by calling GetFixedPointValue, or if that isn't
+  // implemented for the sensor, the appropriate GetXyz() method below (e.g.
+  // GetHumidity). For other methods (e.g. "/driverinfo"), delegates to the base
+  // classes' HandleGetRequest method.
   bool HandleGetRequest(const AlpacaRequest& request, Print& out) override;
 
   //////////////////////////////////////////////////////////////////////////////
-  // Accessors for various sensor values. The default implementations return an
-  // unimplemented error.
+  // Accessors for various sensor values. The default implementations return the
+  // most recent reading of the sensor if it has been registered with
+  // RegisterSensor, else an unimplemented error.
 
   // Returns the number of hours over which all sensor values will be averaged.
   virtual mcucore::StatusOr<double> GetAveragePeriod();
@@ -84,7 +111,8 @@ class ObservingConditionsAdapter : public DeviceImplBase {
   virtual mcucore::StatusOr<double> GetTemperature();
 
   // Returns the time (hours) since the sensor specified in the SensorName
-  // parameter was last updated.
+  // parameter was last updated. The default implementation returns the time
+  // since the last successful reading of a registered sensor.
   virtual mcucore::StatusOr<double> GetTimeSinceLastUpdate(
       ESensorName sensor_name);
 
@@ -102,6 +130,14 @@ class ObservingConditionsAdapter : public DeviceImplBase {
   // Returns the wind speed(m/s) at the observatory.
   virtual mcucore::StatusOr<double> GetWindSpeed();
 
+  // Returns the value of the specified sensor as a FixedPoint. A sub-class
+  // whose sensors produce integer values (e.g. hundredths of a degree) can
+  // override this to avoid floating point arithmetic and printing, which are
+  // slow on AVR. The default implementation returns an unimplemented error, in which
+  // case the double accessor above is used instead.
+  virtual mcucore::StatusOr<FixedPoint> GetFixedPointValue(
+      ESensorName sensor_name);
+
   //////////////////////////////////////////////////////////////////////////////
 
   // Handles PUT 'request', writes the HTTP response message to 'out'. Returns
@@ -124,6 +160,9 @@ class ObservingConditionsAdapter : public DeviceImplBase {
   virtual bool HandlePutAveragePeriod(const AlpacaRequest& request, Print& out);
   virtual bool HandlePutRefresh(const AlpacaRequest& request, Print& out);
 
+  // Handles the History action, else delegates to the base class.
+  bool HandlePutAction(const AlpacaRequest& request, Print& out) override;
+
   //////////////////////////////////////////////////////////////////////////////
   // Handlers for the core of the above methods.
 
@@ -139,9 +178,34 @@ class ObservingConditionsAdapter : public DeviceImplBase {
   // value must not be less than zero.
   virtual double MaxAveragePeriod() const;
 
-  // Refreshes sensor values from hardware.
+  // Refreshes sensor values from hardware. The default implementation makes
+  // all of the registered sensors due for reading, so that they are read during
+  // the next few calls to MaintainDevice, rather than while handling the
+  // request; if there are none, it returns an unimplemented error.
   virtual mcucore::Status Refresh();
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Support for sampling sensors at regular intervals.
+
+  // Registers a sensor to be read (by calling ReadSensor) every
+  // interval_millis. Returns false if the sensor is already registered, or if
+  // TAS_MAX_SAMPLED_SENSORS sensors have already been registered.
+  bool RegisterSensor(ESensorName sensor_name, uint32_t interval_millis) {
+    return sensor_sampler_.RegisterSensor(sensor_name, interval_millis);
+  }
+
+  // Reads the specified sensor from the hardware. Must be overridden by
+  // sub-classes which register sensors; the default implementation returns an
+  // unimplemented error.
+  virtual mcucore::StatusOr<double> ReadSensor(ESensorName sensor_name);
+
+  // Reads the registered sensor (if any) which is most overdue for reading at
+  // now_millis, and records the result. Called by MaintainDevice; now_millis
+  // is passed in to support testing.
+  void SampleSensors(uint32_t now_millis);
+
+  const SensorSampler& sensor_sampler() const { return sensor_sampler_; }
+
   // If the result is OK, the write a DoubleResponse, else write the specified
   // sensor error.
   static bool WriteDoubleOrSensorErrorResponse(const AlpacaRequest& request,
@@ -153,6 +217,14 @@ class ObservingConditionsAdapter : public DeviceImplBase {
   static bool WriteSensorNotImpementedResponse(const AlpacaRequest& request,
                                                ESensorName sensor_name,
                                                Print& out);
+
+ private:
+#if TAS_ENABLE_SENSOR_HISTORY
+  bool HasHistory() const;
+  bool HandlePutHistoryAction(const AlpacaRequest& request, Print& out);
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+
+  SensorSampler sensor_sampler_;
 };
 
 }  // namespace alpaca
@@ -0,0 +1,163 @@
+#include "device_types/observing_conditions/sensor_history.h"
+
+#include <McuCore.h>
+
+namespace alpaca {
+namespace {
+
+// Readings are clamped to this magnitude (in hundredths), which is far beyond
+// the range of any weather sensor, so that the differences between values
+// can't overflow.
+constexpr int32_t kMaxMagnitude = 20000000;
+
+int32_t ToHundredths(double value) {
+  const double scaled = value * SensorHistory::kScale;
+  if (scaled >= kMaxMagnitude) {
+    return kMaxMagnitude;
+  } else if (scaled <= -kMaxMagnitude) {
+    return -kMaxMagnitude;
+  } else if (scaled >= 0) {
+    return static_cast<int32_t>(scaled + 0.5);
+  } else {
+    return -static_cast<int32_t>(-scaled + 0.5);
+  }
+}
+
+// Returns sum / count rounded to the nearest integer, with halves rounded away
+// from zero.
+int32_t RoundedMean(int32_t sum, uint16_t count) {
+  if (sum >= 0) {
+    return static_cast<int32_t>((static_cast<uint32_t>(sum) + count / 2) /
+                                count);
+  }
+  const uint32_t magnitude = 0u - static_cast<uint32_t>(sum);
+  return -static_cast<int32_t>((magnitude + count / 2) / count);
+}
+
+// Prints value (hundredths) as a decimal number, with no trailing zeroes after
+// the decimal point (e.g. 1250 as 12.5, and -5 as -0.05).
+size_t PrintHundredths(int32_t value, Print& out) {
+  size_t count = 0;
+  uint32_t magnitude = static_cast<uint32_t>(value);
+  if (value < 0) {
+    count += out.print('-');
+    magnitude = 0u - magnitude;
+  }
+  count += out.print(magnitude / 100);
+  const uint8_t fraction = magnitude % 100;
+  if (fraction != 0) {
+    count += out.print('.');
+    if (fraction < 10) {
+      count += out.print('0');
+      count += out.print(fraction);
+    } else if (fraction % 10 == 0) {
+      count += out.print(fraction / 10);
+    } else {
+      count += out.print(fraction);
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+void SensorHistory::Reset() {
+  base_value_ = 0;
+  newest_value_ = 0;
+  interval_sum_ = 0;
+  interval_count_ = 0;
+  oldest_ndx_ = 0;
+  num_points_ = 0;
+  num_values_ = 0;
+}
+
+void SensorHistory::AddReading(double value) {
+  const int32_t hundredths = ToHundredths(value);
+  // Ignore the reading if the sum would overflow, which can only happen if
+  // there are more than a hundred readings per interval of a very large value.
+  if (interval_count_ == 0xFFFF ||
+      (hundredths > 0 && interval_sum_ > INT32_MAX - hundredths) ||
+      (hundredths < 0 && interval_sum_ < INT32_MIN - hundredths)) {
+    return;
+  }
+  interval_sum_ += hundredths;
+  ++interval_count_;
+}
+
+void SensorHistory::EndInterval() {
+  if (num_points_ == kMaxPoints) {
+    // Discard the oldest point, which becomes the base for the remainder.
+    const int16_t delta = deltas_[oldest_ndx_];
+    if (delta != kGap) {
+      base_value_ += delta;
+      --num_values_;
+    }
+    oldest_ndx_ = PointIndex(1);
+    --num_points_;
+  }
+  int16_t delta = kGap;
+  if (interval_count_ > 0) {
+    const int32_t mean = RoundedMean(interval_sum_, interval_count_);
+    if (num_values_ == 0) {
+      // Nothing to be relative to, so the base is moved to the mean (the base
+      // only matters once there is a point which isn't a gap).
+      base_value_ = mean;
+      newest_value_ = mean;
+      delta = 0;
+    } else {
+      int32_t difference = mean - newest_value_;
+      if (difference > kMaxDelta) {
+        difference = kMaxDelta;
+      } else if (difference < -kMaxDelta) {
+        difference = -kMaxDelta;
+      }
+      delta = static_cast<int16_t>(difference);
+      newest_value_ += delta;
+    }
+    ++num_values_;
+  }
+  deltas_[PointIndex(num_points_)] = delta;
+  ++num_points_;
+  interval_sum_ = 0;
+  interval_count_ = 0;
+}
+
+bool SensorHistory::GetPoint(uint8_t ndx, int32_t& value) const {
+  if (ndx >= num_points_) {
+    return false;
+  }
+  int32_t result = base_value_;
+  int16_t delta = kGap;
+  for (uint8_t i = 0; i <= ndx; ++i) {
+    delta = deltas_[PointIndex(i)];
+    if (delta != kGap) {
+      result += delta;
+    }
+  }
+  if (delta == kGap) {
+    return false;
+  }
+  value = result;
+  return true;
+}
+
+size_t SensorHistory::PrintPointsTo(Print& out) const {
+  size_t count = 0;
+  int32_t value = base_value_;
+  for (uint8_t i = 0; i < num_points_; ++i) {
+    count += out.print(',');
+    const int16_t delta = deltas_[PointIndex(i)];
+    if (delta != kGap) {
+      value += delta;
+      count += PrintHundredths(value, out);
+    }
+  }
+  return count;
+}
+
+uint8_t SensorHistory::PointIndex(uint8_t ndx) const {
+  const uint16_t result = static_cast<uint16_t>(oldest_ndx_) + ndx;
+  return result >= kMaxPoints ? result - kMaxPoints : result;
+}
+
+}  // namespace alpaca
@@ -0,0 +1,82 @@
+#ifndef TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_OBSERVING_CONDITIONS_SENSOR_HISTORY_H_
+#define TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_OBSERVING_CONDITIONS_SENSOR_HISTORY_H_
+
+// SensorHistory keeps a downsampled history of the readings of one sensor in a
+// fixed amount of RAM: one point per interval, the mean of the readings during
+// that interval, for the most recent kMaxPoints intervals. SensorHistory
+// doesn't track time itself; the owner (SensorSampler) calls EndInterval at the
+// end of each interval.
+//
+// The values are stored in fixed-point (hundredths), and each point is stored
+// as the 16-bit difference from the previous point, so a point takes just 2
+// bytes. A change of more than kMaxDelta between two points is spread across
+// the following points, i.e. the history lags behind a very abrupt change.
+// Intervals during which there were no (successful) readings are recorded as
+// gaps, which don't use up any of the range of the following delta.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "config.h"
+
+namespace alpaca {
+
+class SensorHistory {
+ public:
+  static constexpr uint8_t kMaxPoints = TAS_SENSOR_HISTORY_LENGTH;
+  static_assert(0 < kMaxPoints && kMaxPoints < 255,
+                "TAS_SENSOR_HISTORY_LENGTH must be in the range [1, 254]");
+
+  // The values are stored in units of 1/kScale.
+  static constexpr int32_t kScale = 100;
+  static constexpr int16_t kMaxDelta = 32767;
+
+  SensorHistory() { Reset(); }
+
+  // Discards all of the points, and the readings of the current interval.
+  void Reset();
+
+  // Adds a reading to the mean of the current interval.
+  void AddReading(double value);
+
+  // Ends the current interval, appending the mean of its readings as the newest
+  // point, or a gap if there were none. If the history is full, the oldest
+  // point is discarded.
+  void EndInterval();
+
+  // Returns the number of points, including gaps.
+  uint8_t size() const { return num_points_; }
+
+  // Returns true and sets value (hundredths) if the point ndx (zero is the
+  // oldest) is not a gap.
+  bool GetPoint(uint8_t ndx, int32_t& value) const;
+
+  // Prints the points, oldest first, each preceded by a comma, and with gaps
+  // printed as empty fields (e.g. ",12.5,,12.75"). Returns the number of bytes
+  // printed.
+  size_t PrintPointsTo(Print& out) const;
+
+ private:
+  // The delta recorded for a gap.
+  static constexpr int16_t kGap = -32768;
+
+  uint8_t PointIndex(uint8_t ndx) const;
+
+  // The value before the oldest point, to which its delta is added.
+  int32_t base_value_;
+  // The value of the newest point which isn't a gap.
+  int32_t newest_value_;
+  // The sum (hundredths) and count of the readings in the current interval.
+  int32_t interval_sum_;
+  uint16_t interval_count_;
+  int16_t deltas_[kMaxPoints];
+  uint8_t oldest_ndx_;
+  uint8_t num_points_;
+  // The number of points which aren't gaps.
+  uint8_t num_values_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_OBSERVING_CONDITIONS_SENSOR_HISTORY_H_
@@ -0,0 +1,182 @@
+#include "device_types/observing_conditions/sensor_sampler.h"
+
+#include <McuCore.h>
+
+#include "ascom_error_codes.h"
+
+namespace alpaca {
+namespace {
+constexpr double kMillisPerHour = 60.0 * 60.0 * 1000.0;
+}  // namespace
+
+SensorSampler::SensorSampler() : num_sensors_(0) {
+#if TAS_ENABLE_SENSOR_HISTORY
+  history_interval_start_ = 0;
+  history_started_ = false;
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+}
+
+bool SensorSampler::RegisterSensor(ESensorName sensor_name,
+                                   uint32_t interval_millis) {
+  MCU_DCHECK_NE(sensor_name, ESensorName::kUnknown);
+  if (num_sensors_ >= kMaxSensors || IsRegistered(sensor_name)) {
+    MCU_VLOG(1) << MCU_PSD("Unable to register sensor ") << sensor_name;
+    return false;
+  }
+  SampledSensor& sensor = sensors_[num_sensors_++];
+  sensor.status = ErrorCodes::ValueNotSet();
+  sensor.value = 0;
+  sensor.interval_millis = interval_millis;
+  sensor.read_time = 0;
+  sensor.update_time = 0;
+  sensor.sensor_name = sensor_name;
+  sensor.due = true;
+  sensor.updated = false;
+#if TAS_ENABLE_SENSOR_HISTORY
+  sensor.history.Reset();
+  // Keep the history intervals of all the sensors aligned.
+  for (uint8_t i = 0; i < sensors_[0].history.size(); ++i) {
+    sensor.history.EndInterval();
+  }
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+  return true;
+}
+
+ESensorName SensorSampler::NextDueSensor(uint32_t now_millis) const {
+  ESensorName result = ESensorName::kUnknown;
+  uint32_t most_overdue = 0;
+  for (uint8_t ndx = 0; ndx < num_sensors_; ++ndx) {
+    const SampledSensor& sensor = sensors_[ndx];
+    if (sensor.due) {
+      return sensor.sensor_name;
+    }
+    // Unsigned subtraction handles the rollover of millis().
+    const uint32_t elapsed = now_millis - sensor.read_time;
+    if (elapsed < sensor.interval_millis) {
+      continue;
+    }
+    const uint32_t overdue = elapsed - sensor.interval_millis;
+    if (result == ESensorName::kUnknown || overdue > most_overdue) {
+      result = sensor.sensor_name;
+      most_overdue = overdue;
+    }
+  }
+  return result;
+}
+
+void SensorSampler::RecordReading(ESensorName sensor_name,
+                                  mcucore::StatusOr<double> result,
+                                  uint32_t now_millis) {
+  SampledSensor* sensor = FindSensor(sensor_name);
+  if (sensor == nullptr) {
+    MCU_DCHECK(false) << MCU_PSD("Sensor not registered: ") << sensor_name;
+    return;
+  }
+  sensor->read_time = now_millis;
+  sensor->due = false;
+  sensor->status = result.status();
+  if (result.ok()) {
+    sensor->value = result.value();
+    sensor->update_time = now_millis;
+    sensor->updated = true;
+#if TAS_ENABLE_SENSOR_HISTORY
+    sensor->history.AddReading(result.value());
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+  }
+}
+
+void SensorSampler::MakeAllDue() {
+  for (uint8_t ndx = 0; ndx < num_sensors_; ++ndx) {
+    sensors_[ndx].due = true;
+  }
+}
+
+mcucore::StatusOr<double> SensorSampler::GetValue(
+    ESensorName sensor_name) const {
+  const SampledSensor* sensor = FindSensor(sensor_name);
+  if (sensor == nullptr) {
+    return ErrorCodes::NotImplemented();
+  } else if (!sensor->status.ok()) {
+    return sensor->status;
+  }
+  return sensor->value;
+}
+
+mcucore::StatusOr<double> SensorSampler::GetTimeSinceLastUpdate(
+    ESensorName sensor_name, uint32_t now_millis) const {
+  const SampledSensor* sensor = FindSensor(sensor_name);
+  if (sensor == nullptr) {
+    return ErrorCodes::NotImplemented();
+  } else if (!sensor->updated) {
+    return ErrorCodes::ValueNotSet();
+  }
+  return (now_millis - sensor->update_time) / kMillisPerHour;
+}
+
+#if TAS_ENABLE_SENSOR_HISTORY
+void SensorSampler::AdvanceHistory(uint32_t now_millis) {
+  if (!history_started_) {
+    history_interval_start_ = now_millis;
+    history_started_ = true;
+    return;
+  }
+  // Unsigned subtraction handles the rollover of millis().
+  const uint32_t num_ended = (now_millis - history_interval_start_) /
+                             TAS_SENSOR_HISTORY_INTERVAL_MILLIS;
+  if (num_ended == 0) {
+    return;
+  }
+  history_interval_start_ += num_ended * TAS_SENSOR_HISTORY_INTERVAL_MILLIS;
+  // After a very long gap, the histories will be full of gaps, so there is no
+  // need to append any more than that.
+  const uint32_t num_to_end = num_ended < SensorHistory::kMaxPoints
+                                  ? num_ended
+                                  : SensorHistory::kMaxPoints;
+  for (uint8_t ndx = 0; ndx < num_sensors_; ++ndx) {
+    for (uint32_t i = 0; i < num_to_end; ++i) {
+      sensors_[ndx].history.EndInterval();
+    }
+  }
+}
+
+size_t SensorSampler::PrintHistoryTo(ESensorName sensor_name,
+                                     uint32_t now_millis, Print& out) const {
+  const uint32_t age_secs = (now_millis - history_interval_start_) / 1000;
+  size_t count = 0;
+  for (uint8_t ndx = 0; ndx < num_sensors_; ++ndx) {
+    const SampledSensor& sensor = sensors_[ndx];
+    if (sensor_name != ESensorName::kUnknown &&
+        sensor_name != sensor.sensor_name) {
+      continue;
+    }
+    if (count > 0) {
+      count += out.print('\n');
+    }
+    count += PrintValueTo(sensor.sensor_name, out);
+    count += out.print(',');
+    count += out.print(TAS_SENSOR_HISTORY_INTERVAL_MILLIS / 1000);
+    count += out.print(',');
+    count += out.print(age_secs);
+    count += sensor.history.PrintPointsTo(out);
+  }
+  return count;
+}
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+
+const SensorSampler::SampledSensor* SensorSampler::FindSensor(
+    ESensorName sensor_name) const {
+  for (uint8_t ndx = 0; ndx < num_sensors_; ++ndx) {
+    if (sensors_[ndx].sensor_name == sensor_name) {
+      return &sensors_[ndx];
+    }
+  }
+  return nullptr;
+}
+
+SensorSampler::SampledSensor* SensorSampler::FindSensor(
+    ESensorName sensor_name) {
+  const SensorSampler* const_this = this;
+  return const_cast<SampledSensor*>(const_this->FindSensor(sensor_name));
+}
+
+}  // namespace alpaca
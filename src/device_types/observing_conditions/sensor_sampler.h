@@ -0,0 +1,132 @@
+#ifndef TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_OBSERVING_CONDITIONS_SENSOR_SAMPLER_H_
+#define TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_OBSERVING_CONDITIONS_SENSOR_SAMPLER_H_
+
+// SensorSampler schedules the reading of the sensors of an ObservingConditions
+// device, each at its own interval, and caches the most recent reading of each
+// sensor, along with the time it was taken. This allows requests for sensor
+// values to be answered from RAM, without any I/O (e.g. over I2C) on the
+// request path, and allows the reads to be spread across iterations of the
+// Arduino loop: NextDueSensor returns only one sensor per call, the one most
+// overdue for reading.
+//
+// SensorSampler does not read the sensors itself; ObservingConditionsAdapter
+// asks it which sensor to read next, reads it, and records the result.
+//
+// If TAS_ENABLE_SENSOR_HISTORY is non-zero, SensorSampler also keeps a
+// SensorHistory for each sensor, with the intervals of all the histories
+// aligned, so that the History action can be answered from RAM.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "config.h"
+#include "constants.h"
+#include "device_types/observing_conditions/sensor_history.h"
+
+namespace alpaca {
+
+class SensorSampler {
+ public:
+  static constexpr uint8_t kMaxSensors = TAS_MAX_SAMPLED_SENSORS;
+
+#if TAS_ENABLE_SENSOR_HISTORY
+  // The response to the History action is written whole, in one blocking
+  // write, so it must fit in the socket's transmit buffer (2KB on a W5500).
+  // A point takes at most 13 bytes (e.g. ",-21474836.48"), so limiting the
+  // number of points limits the response to about 1.7KB.
+  static constexpr uint16_t kMaxHistoryPoints = 96;
+  static_assert(kMaxSensors * TAS_SENSOR_HISTORY_LENGTH <= kMaxHistoryPoints,
+                "TAS_MAX_SAMPLED_SENSORS * TAS_SENSOR_HISTORY_LENGTH must be "
+                "at most 96");
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+
+  SensorSampler();
+
+  // Registers sensor_name to be read every interval_millis. Returns false if
+  // there is no room for another sensor, or if the sensor is already
+  // registered.
+  bool RegisterSensor(ESensorName sensor_name, uint32_t interval_millis);
+
+  uint8_t num_sensors() const { return num_sensors_; }
+
+  bool IsRegistered(ESensorName sensor_name) const {
+    return FindSensor(sensor_name) != nullptr;
+  }
+
+  // Returns the registered sensor which is most overdue for reading at
+  // now_millis, or ESensorName::kUnknown if none are due. Sensors which have
+  // never been read are due immediately, in the order in which they were
+  // registered.
+  ESensorName NextDueSensor(uint32_t now_millis) const;
+
+  // Records the result of reading sensor_name at now_millis. If the reading
+  // failed, the error is returned by GetValue until the next reading.
+  void RecordReading(ESensorName sensor_name, mcucore::StatusOr<double> result,
+                     uint32_t now_millis);
+
+  // Makes all of the sensors due for reading, e.g. in response to a Refresh
+  // request.
+  void MakeAllDue();
+
+  // Returns the most recent reading of the sensor; an error if the sensor isn't
+  // registered (NotImplemented), if it hasn't yet been read (ValueNotSet), or
+  // if the most recent reading failed.
+  mcucore::StatusOr<double> GetValue(ESensorName sensor_name) const;
+
+  // Returns the time (hours) since the sensor was last read successfully.
+  mcucore::StatusOr<double> GetTimeSinceLastUpdate(ESensorName sensor_name,
+                                                   uint32_t now_millis) const;
+
+#if TAS_ENABLE_SENSOR_HISTORY
+  // Ends the history interval(s) which have ended by now_millis. The first call
+  // starts the first interval.
+  void AdvanceHistory(uint32_t now_millis);
+
+  // Prints the history of the specified sensor, or of all the sensors if
+  // sensor_name is kUnknown, as CSV, one line per sensor:
+  //
+  //     SensorName,IntervalSecs,AgeSecs,Value,Value,...
+  //
+  // Where AgeSecs is the time since the end of the newest point's interval, and
+  // the values are oldest first, with gaps as empty fields. Returns the number
+  // of bytes printed.
+  size_t PrintHistoryTo(ESensorName sensor_name, uint32_t now_millis,
+                        Print& out) const;
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+
+ private:
+  struct SampledSensor {
+    // The outcome of the most recent attempt to read the sensor, and the value
+    // of the most recent successful reading.
+    mcucore::Status status;
+    double value;
+    uint32_t interval_millis;
+    // The time of the most recent attempt to read the sensor.
+    uint32_t read_time;
+    // The time of the most recent successful reading of the sensor.
+    uint32_t update_time;
+    ESensorName sensor_name;
+    bool due;  // True if never read, or if MakeAllDue has been called.
+    bool updated;
+#if TAS_ENABLE_SENSOR_HISTORY
+    SensorHistory history;
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+  };
+
+  const SampledSensor* FindSensor(ESensorName sensor_name) const;
+  SampledSensor* FindSensor(ESensorName sensor_name);
+
+  SampledSensor sensors_[kMaxSensors];
+  uint8_t num_sensors_;
+#if TAS_ENABLE_SENSOR_HISTORY
+  // The time at which the current history interval started, i.e. at which the
+  // newest point's interval ended.
+  uint32_t history_interval_start_;
+  bool history_started_;
+#endif  // TAS_ENABLE_SENSOR_HISTORY
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_OBSERVING_CONDITIONS_SENSOR_SAMPLER_H_
@@ -14,8 +14,6 @@ namespace alpaca {
 
 class MultiSwitchAdapter : public SwitchAdapter {
  public:
-  static constexpr uint8_t kMaxSwitchesForName = 10;
-
   MultiSwitchAdapter(ServerContext& server_context,
                      const DeviceDescription& device_description,
                      mcucore::ArrayView<SwitchInterface*> switches);
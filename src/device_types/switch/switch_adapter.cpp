@@ -3,6 +3,7 @@
 #include <McuCore.h>
 
 #include "alpaca_response.h"
+#include "ascom_error_codes.h"
 #include "constants.h"
 #include "eeprom_ids.h"
 #include "literals.h"
@@ -11,10 +12,38 @@ namespace alpaca {
 
 using mcucore::TinyString;
 
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+namespace {
+
+// Adds the values of all of the switches to a JSON array, for the
+// GetAllSwitchValues action.
+class SwitchValuesSource : public mcucore::JsonElementSource {
+ public:
+  SwitchValuesSource(const double* values, uint16_t num_values)
+      : values_(values), num_values_(num_values) {}
+
+  void AddTo(mcucore::JsonArrayEncoder& encoder) const override {
+    for (uint16_t ndx = 0; ndx < num_values_; ++ndx) {
+      encoder.AddDoubleElement(values_[ndx]);
+    }
+  }
+
+ private:
+  const double* const values_;
+  const uint16_t num_values_;
+};
+
+}  // namespace
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
 SwitchAdapter::SwitchAdapter(ServerContext& server_context,
                              const DeviceDescription& device_description)
     : DeviceImplBase(server_context, device_description) {
   MCU_DCHECK_EQ(device_description.device_type, EDeviceType::kSwitch);
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+  switch_names_changed_millis_ = 0;
+  switch_names_loaded_ = false;
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
 }
 
 SwitchAdapter::~SwitchAdapter() {}
@@ -25,6 +54,18 @@ void SwitchAdapter::ValidateConfiguration() {
   ValidateSwitchDeviceConfiguration();
 }
 
+static_assert(SwitchNameCache::kMaxNameLength == SwitchAdapter::kMaxNameLength);
+
+void SwitchAdapter::InitializeDevice() {
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+  LoadSwitchNames();
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
+}
+
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+void SwitchAdapter::MaintainDevice() { SaveSwitchNamesIfDue(millis()); }
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
+
 bool SwitchAdapter::HandleGetRequest(const AlpacaRequest& request, Print& out) {
   MCU_DCHECK_EQ(request.api, EAlpacaApi::kDeviceApi);
   MCU_DCHECK_EQ(request.device_type, EDeviceType::kSwitch);
@@ -51,6 +92,23 @@ bool SwitchAdapter::HandleGetRequest(const AlpacaRequest& request, Print& out) {
       break;
   }
 
+  switch (request.device_method) {
+    case EDeviceMethod::kGetSwitchValue:
+    case EDeviceMethod::kMinSwitchValue:
+    case EDeviceMethod::kMaxSwitchValue:
+    case EDeviceMethod::kSwitchStep: {
+      auto result = GetFixedPointValue(request.device_method, request.id);
+      if (result.ok() || static_cast<int>(result.status().code()) !=
+                             ErrorCodes::kNotImplemented) {
+        return WriteResponse::StatusOrFixedPointResponse(request, result, out);
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+
   switch (request.device_method) {
     case EDeviceMethod::kMaxSwitch:
       return WriteResponse::IntResponse(request, GetMaxSwitch(), out);
@@ -89,6 +147,30 @@ bool SwitchAdapter::HandleGetRequest(const AlpacaRequest& request, Print& out) {
   }
 }
 
+void SwitchAdapter::AddDeviceStateTo(mcucore::JsonArrayEncoder& encoder) {
+  const auto max_switch = GetMaxSwitch();
+  for (uint16_t switch_id = 0; switch_id < max_switch; ++switch_id) {
+    auto get_switch =
+        mcucore::PrintableCat(MCU_FLASHSTR("GetSwitch"), switch_id);
+    AddBoolDeviceState(encoder, mcucore::AnyPrintable(get_switch),
+                       GetSwitch(switch_id));
+    auto get_switch_value =
+        mcucore::PrintableCat(MCU_FLASHSTR("GetSwitchValue"), switch_id);
+    AddDoubleDeviceState(encoder, mcucore::AnyPrintable(get_switch_value),
+                         GetSwitchValue(switch_id));
+  }
+}
+
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+void SwitchAdapter::AddSupportedActionsTo(mcucore::JsonArrayEncoder& encoder) {
+  DeviceImplBase::AddSupportedActionsTo(encoder);
+  if (GetMaxSwitch() <= TAS_MAX_SWITCH_VALUES) {
+    encoder.AddStringElement(ProgmemStringViews::GetAllSwitchValues());
+    encoder.AddStringElement(ProgmemStringViews::SetSwitchValues());
+  }
+}
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
 //////////////////////////////////////////////////////////////////////////////
 
 // Handle a PUT 'request', write the HTTP response message to out.
@@ -128,9 +210,7 @@ bool SwitchAdapter::HandlePutRequest(const AlpacaRequest& request, Print& out) {
         return WriteResponse::AscomParameterMissingErrorResponse(
             request, ProgmemStringViews::Name(), out);
       }
-      // TODO(jamessynge): Implement
-      MCU_CHECK(false) << MCU_PSD("NOT IMPLEMENTED");
-      return false;
+      return HandleSetSwitchName(request, request.id, out);
 
     case EDeviceMethod::kSetSwitchValue:
       // Requires the value parameter.
@@ -146,14 +226,83 @@ bool SwitchAdapter::HandlePutRequest(const AlpacaRequest& request, Print& out) {
       return WriteResponse::StatusResponse(
           request, SetSwitchValue(request.id, request.value), out);
 
-      // TODO(jamessynge): Verify that the request has a valid name parameter.
-      return HandleSetSwitchName(request, request.id, out);
-
     default:
       return DeviceImplBase::HandlePutRequest(request, out);
   }
 }
 
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+bool SwitchAdapter::HandlePutAction(const AlpacaRequest& request, Print& out) {
+  if (GetMaxSwitch() <= TAS_MAX_SWITCH_VALUES) {
+    if (request.action == EDeviceAction::kGetAllSwitchValues) {
+      return HandlePutGetAllSwitchValuesAction(request, out);
+    } else if (request.action == EDeviceAction::kSetSwitchValues) {
+      return HandlePutSetSwitchValuesAction(request, out);
+    } else if (device_description().supported_actions.size == 0) {
+      // There are some valid actions, so this isn't MethodNotImplemented.
+      return WriteResponse::AscomActionNotImplementedResponse(request, out);
+    }
+  }
+  return DeviceImplBase::HandlePutAction(request, out);
+}
+
+bool SwitchAdapter::HandlePutGetAllSwitchValuesAction(
+    const AlpacaRequest& request, Print& out) {
+  // Read all of the values before writing any of the response, so that each
+  // switch is read once, and an error can be reported instead.
+  const uint16_t max_switch = GetMaxSwitch();
+  double values[TAS_MAX_SWITCH_VALUES];
+  for (uint16_t switch_id = 0; switch_id < max_switch; ++switch_id) {
+    auto fixed_point =
+        GetFixedPointValue(EDeviceMethod::kGetSwitchValue, switch_id);
+    if (fixed_point.ok()) {
+      values[switch_id] = fixed_point.value().ToDouble();
+    } else if (static_cast<int>(fixed_point.status().code()) !=
+               ErrorCodes::kNotImplemented) {
+      return WriteResponse::AscomErrorResponse(request, fixed_point.status(),
+                                               out);
+    } else {
+      auto value = GetSwitchValue(switch_id);
+      if (!value.ok()) {
+        return WriteResponse::AscomErrorResponse(request, value.status(), out);
+      }
+      values[switch_id] = value.value();
+    }
+  }
+  return WriteResponse::ArrayResponse(
+      request, SwitchValuesSource(values, max_switch), out);
+}
+
+bool SwitchAdapter::HandlePutSetSwitchValuesAction(const AlpacaRequest& request,
+                                                   Print& out) {
+  // The Parameters must be a list of the values of all of the switches.
+  const uint16_t max_switch = GetMaxSwitch();
+  if (!request.have_string_value && request.num_switch_values == 0) {
+    return WriteResponse::AscomParameterMissingErrorResponse(
+        request, ProgmemStringViews::Parameters(), out);
+  } else if (request.num_switch_values != max_switch) {
+    return WriteResponse::AscomParameterInvalidErrorResponse(
+        request, ProgmemStringViews::Parameters(), out);
+  }
+
+  // Validate all of the values before setting any of them, so that an invalid
+  // request leaves all of the switches unchanged.
+  for (uint16_t switch_id = 0; switch_id < max_switch; ++switch_id) {
+    if (!GetCanWrite(switch_id)) {
+      return WriteResponse::AscomMethodNotImplementedResponse(request, out);
+    }
+    const double value = request.switch_values[switch_id];
+    if (value < GetMinSwitchValue(switch_id) ||
+        GetMaxSwitchValue(switch_id) < value) {
+      return WriteResponse::AscomParameterInvalidErrorResponse(
+          request, ProgmemStringViews::Parameters(), out);
+    }
+  }
+  return WriteResponse::StatusResponse(
+      request, SetAllSwitchValues(request.switch_values, max_switch), out);
+}
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
 bool SwitchAdapter::HandleGetSwitchName(const AlpacaRequest& request,
                                         uint16_t switch_id, Print& out) {
   mcucore::TinyString<kMaxNameLength> name_buffer;
@@ -167,10 +316,29 @@ bool SwitchAdapter::HandleGetSwitchName(const AlpacaRequest& request,
 
 bool SwitchAdapter::HandleSetSwitchName(const AlpacaRequest& request,
                                         uint16_t switch_id, Print& out) {
-  MCU_CHECK(false) << MCU_PSD("NOT IMPLEMENTED");
-  return false;
+  mcucore::StringView name(request.string_value.data(),
+                           request.string_value.size());
+  return WriteSwitchName(request, switch_id, name, out);
 }
 
+mcucore::StatusOr<FixedPoint> SwitchAdapter::GetFixedPointValue(
+    EDeviceMethod method, uint16_t switch_id) {
+  return ErrorCodes::NotImplemented();
+}
+
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+mcucore::Status SwitchAdapter::SetAllSwitchValues(const double* values,
+                                                  uint16_t num_values) {
+  for (uint16_t switch_id = 0; switch_id < num_values; ++switch_id) {
+    auto status = SetSwitchValue(switch_id, values[switch_id]);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return mcucore::OkStatus();
+}
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
 bool SwitchAdapter::ValidateSwitchIdParameter(const AlpacaRequest& request,
                                               Print& out, bool& handler_ret) {
   if (request.have_id) {
@@ -191,31 +359,21 @@ bool SwitchAdapter::ValidateSwitchIdParameter(const AlpacaRequest& request,
 
 bool SwitchAdapter::ReadSwitchName(uint16_t switch_id,
                                    TinyString<kMaxNameLength>& name) {
-  // Not overridden by subclass, so we have a much stricter limit on the number
-  // of supported switches:
-  MCU_CHECK_LE(GetMaxSwitch(), kMaxSwitchesForName);
-
-  auto status_or_tlv = mcucore::EepromTlv::GetIfValid();
-  MCU_DCHECK_OK(status_or_tlv);
-  if (!status_or_tlv.ok()) {
-    return false;
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+  if (!switch_names_loaded_) {
+    LoadSwitchNames();
   }
-
-  auto tlv = status_or_tlv.value();
-  auto tag = MakeTag(kSwitch0NameId + switch_id);
-
-  static_assert(sizeof(char) == sizeof(uint8_t));
-  auto status_or_size = tlv.ReadEntry(
-      tag, reinterpret_cast<uint8_t*>(name.data()), name.maximum_size());
-
-  if (!status_or_size.ok()) {
-    MCU_DCHECK(mcucore::IsNotFound(status_or_size.status()))
-        << status_or_size.status();
+  const SwitchNameCache& switch_names = switch_names_;
+#else   // !TAS_ENABLE_SWITCH_NAME_CACHE
+  SwitchNameCache switch_names;
+  ReadSwitchNames(switch_names);
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
+  const auto stored_name = switch_names.GetName(switch_id);
+  if (stored_name.empty() || stored_name.size() > name.maximum_size()) {
     return false;
   }
-
-  // Success!
-  name.set_size(status_or_size.value());
+  memcpy(name.data(), stored_name.data(), stored_name.size());
+  name.set_size(stored_name.size());
   return true;
 }
 
@@ -231,22 +389,85 @@ bool SwitchAdapter::WriteSwitchName(const AlpacaRequest& request,
                                     uint16_t switch_id,
                                     const mcucore::StringView& name,
                                     Print& out) {
-  // Not overridden by subclass, so we have a much stricter limit on the number
-  // of supported switches:
-  MCU_CHECK_LE(GetMaxSwitch(), kMaxSwitchesForName);
+  if (name.empty() || name.size() > kMaxNameLength) {
+    return WriteResponse::AscomParameterInvalidErrorResponse(
+        request, ProgmemStringViews::Name(), out);
+  }
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+  if (!switch_names_loaded_) {
+    LoadSwitchNames();
+  }
+  if (!switch_names_.SetName(switch_id, name)) {
+    // There isn't room in the cache for the name.
+    return WriteResponse::StatusResponse(
+        request, ErrorCodes::InvalidOperation(), out);
+  }
+  if (switch_names_.dirty()) {
+    switch_names_changed_millis_ = millis();
+  }
+  return WriteResponse::StatusResponse(request, mcucore::OkStatus(), out);
+#else   // !TAS_ENABLE_SWITCH_NAME_CACHE
+  SwitchNameCache switch_names;
+  ReadSwitchNames(switch_names);
+  if (!switch_names.SetName(switch_id, name)) {
+    // There isn't room in the entry for the name.
+    return WriteResponse::StatusResponse(
+        request, ErrorCodes::InvalidOperation(), out);
+  }
+  mcucore::Status status;
+  if (switch_names.dirty()) {
+    status = switch_names.WriteTo(server_context_.eeprom_tlv(),
+                                  MakeTag(kSwitchNamesId));
+  }
+  return WriteResponse::StatusResponse(request, status, out);
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
+}
 
-  auto status_or_tlv = mcucore::EepromTlv::GetIfValid();
-  MCU_DCHECK_OK(status_or_tlv);
-  if (!status_or_tlv.ok()) {
-    return WriteResponse::StatusResponse(request, status_or_tlv.status(), out);
+void SwitchAdapter::ReadSwitchNames(SwitchNameCache& names) {
+  auto& tlv = server_context_.eeprom_tlv();
+  auto status = names.ReadFrom(tlv, MakeTag(kSwitchNamesId));
+  if (!mcucore::IsNotFound(status)) {
+    MCU_VLOG_IF_ERROR(1, status);
+    return;
   }
 
-  auto tlv = status_or_tlv.value();
-  auto tag = MakeTag(kSwitch0NameId + switch_id);
+  // Earlier versions stored the name of each switch in a separate entry.
+  const uint16_t max_switch = GetMaxSwitch();
+  for (uint16_t switch_id = 0;
+       switch_id < max_switch && switch_id < kMaxSwitchesForName;
+       ++switch_id) {
+    TinyString<kMaxNameLength> name;
+    auto status_or_size =
+        tlv.ReadEntry(MakeTag(kSwitch0NameId + switch_id),
+                      reinterpret_cast<uint8_t*>(name.data()),
+                      name.maximum_size());
+    if (status_or_size.ok()) {
+      names.SetName(switch_id,
+                    mcucore::StringView(name.data(), status_or_size.value()));
+    }
+  }
+}
 
-  auto status = tlv.WriteEntry(
-      tag, reinterpret_cast<const uint8_t*>(name.data()), name.size());
-  return WriteResponse::StatusResponse(request, status, out);
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+void SwitchAdapter::LoadSwitchNames() {
+  switch_names_loaded_ = true;
+  ReadSwitchNames(switch_names_);
+}
+
+void SwitchAdapter::SaveSwitchNamesIfDue(uint32_t now_millis) {
+  // Unsigned subtraction handles the rollover of millis().
+  if (!switch_names_.dirty() || now_millis - switch_names_changed_millis_ <
+                                    TAS_SWITCH_NAME_WRITE_DELAY_MILLIS) {
+    return;
+  }
+  auto status = switch_names_.WriteTo(server_context_.eeprom_tlv(),
+                                     MakeTag(kSwitchNamesId));
+  if (!status.ok()) {
+    MCU_VLOG(1) << MCU_PSD("Unable to save switch names: ") << status;
+    // Try again after another delay, rather than on every call.
+    switch_names_changed_millis_ = now_millis;
+  }
 }
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
 
 }  // namespace alpaca
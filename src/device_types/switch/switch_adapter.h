@@ -32,11 +32,24 @@
 // have two states, and multi-state if it can have more than two values. These
 // are treated the same in the interface definition.
 //
+// Switch Names
+//
+// The names given to the switches via setswitchname are stored in EEPROM as a
+// single entry (see SwitchNameCache), so any switch can be named. By default
+// the entry is read into a temporary SwitchNameCache on the stack when a name
+// is read or set, and setswitchname waits for the entry to be written. If
+// TAS_ENABLE_SWITCH_NAME_CACHE is non-zero, the names are instead held in RAM,
+// and are written to EEPROM by MaintainDevice a short while after the last
+// change, so that requests don't wait for EEPROM reads or writes.
+//
 // Author: james.synge@gmail.com
 
 #include <McuCore.h>
 
+#include "config.h"
 #include "device_types/device_impl_base.h"
+#include "device_types/switch/switch_name_cache.h"
+#include "utils/fixed_point.h"
 
 namespace alpaca {
 
@@ -46,7 +59,7 @@ class SwitchAdapter : public DeviceImplBase {
   // so the maximum value allowed is INT16_MAX, i.e. 2^15 - 1, or 32767.
   static constexpr uint16_t kMaxMaxSwitch = INT16_MAX;
 
-  // Max supported name length for storage in EEPROM.
+  // Max supported length of a switch name.
   static constexpr uint8_t kMaxNameLength = 32;
 
   SwitchAdapter(ServerContext& server_context,
@@ -59,6 +72,16 @@ class SwitchAdapter : public DeviceImplBase {
   // a subclass can not prevent its execution.
   void ValidateConfiguration() final;
 
+  // Loads the switch names from EEPROM if TAS_ENABLE_SWITCH_NAME_CACHE is
+  // non-zero. Sub-classes which override this should call this implementation.
+  void InitializeDevice() override;
+
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+  // Writes the switch names to EEPROM if they have changed. Sub-classes which
+  // override this should call this implementation.
+  void MaintainDevice() override;
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
+
   // Handles GET 'request', writes the HTTP response message to 'out'. Returns
   // true to indicate that the response was written without error, otherwise
   // false, in which case the connection to the client will be closed.
@@ -80,6 +103,21 @@ class SwitchAdapter : public DeviceImplBase {
   // device type are delegated to the base class, DeviceImplBase.
   bool HandlePutRequest(const AlpacaRequest& request, Print& out) override;
 
+  // Adds GetSwitchN and GetSwitchValueN for each switch N, from 0 to MaxSwitch
+  // - 1.
+  void AddDeviceStateTo(mcucore::JsonArrayEncoder& encoder) override;
+
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+  // Adds GetAllSwitchValues and SetSwitchValues if there are few enough
+  // switches (at most TAS_MAX_SWITCH_VALUES) for all of their values to be
+  // held at once.
+  void AddSupportedActionsTo(mcucore::JsonArrayEncoder& encoder) override;
+
+  // Handles the GetAllSwitchValues and SetSwitchValues actions, else delegates
+  // to the base class.
+  bool HandlePutAction(const AlpacaRequest& request, Print& out) override;
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
   // Method which a subclass may override to validate device specific aspects of
   // the device's configuration.
   virtual void ValidateSwitchDeviceConfiguration() {}
@@ -102,7 +140,8 @@ class SwitchAdapter : public DeviceImplBase {
                                    uint16_t switch_id, Print& out);
 
   // Sets the name of the specified switch device. The switch name has not been
-  // extracted from the request, nor validated.
+  // extracted from the request, nor validated. The default implementation
+  // passes the name to WriteSwitchName.
   virtual bool HandleSetSwitchName(const AlpacaRequest& request,
                                    uint16_t switch_id, Print& out);
 
@@ -179,6 +218,15 @@ class SwitchAdapter : public DeviceImplBase {
   // successive values of the device). Must be implemented.
   virtual double GetSwitchStep(uint16_t switch_id) = 0;
 
+  // Returns the value to be returned by the specified method (one of
+  // GetSwitchValue, MinSwitchValue, MaxSwitchValue or SwitchStep) as a
+  // FixedPoint. A sub-class whose values are integers (e.g. a PWM duty cycle)
+  // can override this to avoid floating point arithmetic and printing, which
+  // are slow on AVR. The default implementation returns an unimplemented error,
+  // in which case the double accessor above is used instead.
+  virtual mcucore::StatusOr<FixedPoint> GetFixedPointValue(
+      EDeviceMethod method, uint16_t switch_id);
+
   //////////////////////////////////////////////////////////////////////////////
   // Setters for mutating requests.
 
@@ -195,6 +243,18 @@ class SwitchAdapter : public DeviceImplBase {
   // value.
   virtual mcucore::Status SetSwitchValue(uint16_t switch_id, double value) = 0;
 
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+  // Sets the values of all of the switch devices, for the SetSwitchValues
+  // action; values[n] is the value for switch n, and num_values is MaxSwitch.
+  // Each switch has been verified to be writable, and each value to be between
+  // MinSwitchValue and MaxSwitchValue of its switch. The default implementation
+  // calls SetSwitchValue for each switch in turn, stopping at the first error;
+  // a subclass which can apply all of the values at once (e.g. by updating all
+  // of the channels of a PWM driver together) can override this.
+  virtual mcucore::Status SetAllSwitchValues(const double* values,
+                                             uint16_t num_values);
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
  protected:
   // Returns true if the request has a valid ID parameter, else false, in which
   // case handler_ret is set to the value to be returned by HandleGetRequest or
@@ -202,9 +262,9 @@ class SwitchAdapter : public DeviceImplBase {
   bool ValidateSwitchIdParameter(const AlpacaRequest& request, Print& out,
                                  bool& handler_ret);
 
-  // Fills the provided TinyString with the name of the specified switch, as
-  // stored in EEPROM. Returns true if it was able to find the name in EEPROM,
-  // and it fits in the provided TinyString; else returns false.
+  // Fills the provided TinyString with the name given to the specified switch,
+  // if it has been given one. Returns true if it was able to find the name;
+  // else returns false.
   virtual bool ReadSwitchName(uint16_t switch_id,
                               mcucore::TinyString<kMaxNameLength>& name);
 
@@ -214,12 +274,44 @@ class SwitchAdapter : public DeviceImplBase {
   virtual void GenerateSwitchName(uint16_t switch_id,
                                   mcucore::TinyString<kMaxNameLength>& name);
 
-  // Implements the core of SetSwitchName, writing the provided switch name to
-  // EEPROM, and writes the response message to `out`.  Returns true to indicate
-  // that the response was written without error, otherwise false, in which case
-  // the connection to the client will be closed.
+  // Implements the core of SetSwitchName, storing the provided switch name
+  // (in EEPROM, or in the cache to be written to EEPROM later by
+  // MaintainDevice), and writes the response message to `out`. An empty or too
+  // long name is rejected as an invalid value. Returns true to indicate that
+  // the response was written without error, otherwise false, in which case the
+  // connection to the client will be closed.
   virtual bool WriteSwitchName(const AlpacaRequest& request, uint16_t switch_id,
                                const mcucore::StringView& name, Print& out);
+
+  // Reads the switch names from EEPROM into names. Names stored by earlier
+  // versions of this class, as one EEPROM entry per switch, are read if there
+  // is no entry holding all of the names; they are then saved in the current
+  // form when the names are next written.
+  void ReadSwitchNames(SwitchNameCache& names);
+
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+  // Reads the switch names from EEPROM into the cache.
+  void LoadSwitchNames();
+
+  // Writes the switch names to EEPROM if they have changed, and at least
+  // TAS_SWITCH_NAME_WRITE_DELAY_MILLIS have passed since the last change.
+  // Called by MaintainDevice; now_millis is passed in to support testing.
+  void SaveSwitchNamesIfDue(uint32_t now_millis);
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
+
+ private:
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+  bool HandlePutGetAllSwitchValuesAction(const AlpacaRequest& request,
+                                         Print& out);
+  bool HandlePutSetSwitchValuesAction(const AlpacaRequest& request,
+                                      Print& out);
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+
+#if TAS_ENABLE_SWITCH_NAME_CACHE
+  SwitchNameCache switch_names_;
+  uint32_t switch_names_changed_millis_;
+  bool switch_names_loaded_;
+#endif  // TAS_ENABLE_SWITCH_NAME_CACHE
 };
 
 }  // namespace alpaca
@@ -0,0 +1,120 @@
+#include "device_types/switch/switch_name_cache.h"
+
+#include <McuCore.h>
+
+#include "ascom_error_codes.h"
+
+namespace alpaca {
+namespace {
+
+uint16_t EntryId(const uint8_t* entry) {
+  return entry[0] | (static_cast<uint16_t>(entry[1]) << 8);
+}
+
+}  // namespace
+
+SwitchNameCache::SwitchNameCache() { Clear(); }
+
+void SwitchNameCache::Clear() {
+  size_ = 0;
+  dirty_ = false;
+}
+
+mcucore::StringView SwitchNameCache::GetName(uint16_t switch_id) const {
+  const uint16_t offset = FindEntry(switch_id);
+  if (offset >= size_) {
+    return mcucore::StringView();
+  }
+  const uint8_t* entry = entries_ + offset;
+  return mcucore::StringView(
+      reinterpret_cast<const char*>(entry + kEntryHeaderSize), entry[2]);
+}
+
+bool SwitchNameCache::SetName(uint16_t switch_id,
+                              const mcucore::StringView& name) {
+  if (name.empty() || name.size() > kMaxNameLength) {
+    return false;
+  }
+  const uint16_t offset = FindEntry(switch_id);
+  uint16_t old_entry_size = 0;
+  if (offset < size_) {
+    if (GetName(switch_id) == name) {
+      return true;
+    }
+    old_entry_size = kEntryHeaderSize + entries_[offset + 2];
+  }
+  const uint16_t new_entry_size = kEntryHeaderSize + name.size();
+  if (size_ - old_entry_size + new_entry_size > kCapacity) {
+    MCU_VLOG(2) << MCU_PSD("No room for the name of switch ") << switch_id;
+    return false;
+  }
+
+  // Remove the old entry, if any, then append the new one.
+  if (old_entry_size > 0) {
+    memmove(entries_ + offset, entries_ + offset + old_entry_size,
+            size_ - offset - old_entry_size);
+    size_ -= old_entry_size;
+  }
+  uint8_t* entry = entries_ + size_;
+  entry[0] = switch_id & 0xFF;
+  entry[1] = switch_id >> 8;
+  entry[2] = name.size();
+  memcpy(entry + kEntryHeaderSize, name.data(), name.size());
+  size_ += new_entry_size;
+  dirty_ = true;
+  return true;
+}
+
+mcucore::Status SwitchNameCache::ReadFrom(mcucore::EepromTlv& tlv,
+                                          const mcucore::EepromTag& tag) {
+  Clear();
+  auto status_or_size = tlv.ReadEntry(tag, entries_, kCapacity);
+  if (!status_or_size.ok()) {
+    return status_or_size.status();
+  }
+  size_ = status_or_size.value();
+  if (!IsWellFormed()) {
+    MCU_VLOG(1) << MCU_PSD("Discarding malformed switch names, size ") << size_;
+    size_ = 0;
+    return ErrorCodes::SettingsProviderError();
+  }
+  return mcucore::OkStatus();
+}
+
+mcucore::Status SwitchNameCache::WriteTo(mcucore::EepromTlv& tlv,
+                                         const mcucore::EepromTag& tag) {
+  auto status = tlv.WriteEntry(tag, entries_, size_);
+  if (status.ok()) {
+    dirty_ = false;
+  }
+  return status;
+}
+
+uint16_t SwitchNameCache::FindEntry(uint16_t switch_id) const {
+  uint16_t offset = 0;
+  while (offset < size_) {
+    const uint8_t* entry = entries_ + offset;
+    if (EntryId(entry) == switch_id) {
+      return offset;
+    }
+    offset += kEntryHeaderSize + entry[2];
+  }
+  return size_;
+}
+
+bool SwitchNameCache::IsWellFormed() const {
+  uint16_t offset = 0;
+  while (offset < size_) {
+    if (size_ - offset < kEntryHeaderSize) {
+      return false;
+    }
+    const uint8_t length = entries_[offset + 2];
+    if (length == 0 || length > kMaxNameLength) {
+      return false;
+    }
+    offset += kEntryHeaderSize + length;
+  }
+  return offset == size_;
+}
+
+}  // namespace alpaca
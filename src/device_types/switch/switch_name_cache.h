@@ -0,0 +1,78 @@
+#ifndef TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_SWITCH_SWITCH_NAME_CACHE_H_
+#define TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_SWITCH_SWITCH_NAME_CACHE_H_
+
+// SwitchNameCache holds the names given to the switches of a SwitchAdapter
+// (via setswitchname), so that getswitchname can be answered from RAM rather
+// than by searching EEPROM. Only switches which have been given a name use any
+// space: each entry is the switch id (2 bytes), the length of the name (1 byte)
+// and the characters of the name (not terminated), packed one after another.
+// The whole cache is stored in EEPROM as a single entry, so a burst of changes
+// can be saved with one write.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "config.h"
+
+namespace alpaca {
+
+class SwitchNameCache {
+ public:
+  // The maximum length of a name.
+  static constexpr uint8_t kMaxNameLength = 32;
+
+  // The number of bytes available for entries.
+  static constexpr uint16_t kCapacity = TAS_SWITCH_NAME_CACHE_SIZE;
+
+  SwitchNameCache();
+
+  // Removes all of the names, and clears the dirty flag.
+  void Clear();
+
+  // Returns the name of the specified switch, or an empty view if it hasn't
+  // been given one.
+  mcucore::StringView GetName(uint16_t switch_id) const;
+
+  // Sets the name of the specified switch, replacing any previous name, and
+  // sets the dirty flag. Returns false if the name is empty or too long, or if
+  // there isn't room for it, in which case the cache is unchanged.
+  bool SetName(uint16_t switch_id, const mcucore::StringView& name);
+
+  // Replaces the contents of the cache with the entry stored in EEPROM with the
+  // specified tag. If there is no such entry, or if it can't be read or isn't
+  // well formed, returns an error and leaves the cache empty. Clears the dirty
+  // flag in either case.
+  mcucore::Status ReadFrom(mcucore::EepromTlv& tlv,
+                           const mcucore::EepromTag& tag);
+
+  // Writes the contents of the cache to EEPROM with the specified tag. Clears
+  // the dirty flag if successful.
+  mcucore::Status WriteTo(mcucore::EepromTlv& tlv,
+                          const mcucore::EepromTag& tag);
+
+  // True if a name has been set since the cache was last read or written.
+  bool dirty() const { return dirty_; }
+
+  // The number of bytes used by the entries.
+  uint16_t size() const { return size_; }
+
+ private:
+  static constexpr uint8_t kEntryHeaderSize = 3;
+
+  // Returns the offset of the entry for the specified switch, or size_ if there
+  // is no such entry.
+  uint16_t FindEntry(uint16_t switch_id) const;
+
+  // Returns true if the first size_ bytes of entries_ are a sequence of
+  // complete entries.
+  bool IsWellFormed() const;
+
+  uint8_t entries_[kCapacity];
+  uint16_t size_;
+  bool dirty_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_DEVICE_TYPES_SWITCH_SWITCH_NAME_CACHE_H_
@@ -14,6 +14,7 @@
 // Please sort the values here by ascending domain number.
 //
 // Domain    Sketch                Device Type/Name
+// 10        (TinyAlpacaServer)    SettingsJournal (server-wide settings)
 // 17        CoverCalibrator       CoverCalibrator
 // 18        CoverCalibrator       Switch
 // 70        AM_WeatherBox         ObservingConditions
@@ -21,8 +22,23 @@
 namespace alpaca {
 // Please sort the values here by ascending id.
 
+// Keys of settings in the SettingsJournal, which override the corresponding
+// fields of the DeviceDescription (in the device's domain) or of the
+// ServerDescription (in SettingsJournal::ServerDomain()). These are not stored
+// as EEPROM entries of their own.
+static constexpr uint8_t kDeviceNameId = 20;
+static constexpr uint8_t kDeviceDescriptionId = 21;
+static constexpr uint8_t kServerLocationId = 22;
+
+// For storing the SettingsJournal (in SettingsJournal::ServerDomain()): the
+// ring of records appended since the snapshot was written, which uses
+// TAS_SETTINGS_JOURNAL_RECORDS ids starting with kSettingsJournalFirstId.
+static constexpr uint8_t kSettingsJournalFirstId = 31;
+static constexpr uint8_t kSettingsJournalMaxRecords = 16;
+
 // For storing the name given to a particular switch. Applies to all Switch
-// device domains.
+// device domains. These are no longer written, but are read if there is no
+// kSwitchNamesId entry, i.e. if the names were stored by an earlier version.
 static constexpr uint8_t kMaxSwitchesForName = 10;
 static constexpr uint8_t kSwitch0NameId = 50;
 static constexpr uint8_t kSwitch1NameId = 51;
@@ -35,6 +51,15 @@ static constexpr uint8_t kSwitch7NameId = 57;
 static constexpr uint8_t kSwitch8NameId = 58;
 static constexpr uint8_t kSwitch9NameId = 59;
 
+// For storing the names of all of the switches of a Switch device, as a single
+// entry (see SwitchNameCache). Applies to all Switch device domains.
+static constexpr uint8_t kSwitchNamesId = 60;
+
+// For storing the snapshot of the SettingsJournal, as two banks of up to
+// kSettingsSnapshotMaxChunks chunks each, starting at kSettingsSnapshotFirstId.
+static constexpr uint8_t kSettingsSnapshotFirstId = 70;
+static constexpr uint8_t kSettingsSnapshotMaxChunks = 8;
+
 // For storing the UniqueId of a device; applies to all device domains.
 static constexpr uint8_t kUniqueIdTagId = 128;
 
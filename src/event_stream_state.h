@@ -0,0 +1,41 @@
+#ifndef TINY_ALPACA_SERVER_SRC_EVENT_STREAM_STATE_H_
+#define TINY_ALPACA_SERVER_SRC_EVENT_STREAM_STATE_H_
+
+// EventStreamState holds the per-connection state of a Server-Sent Events
+// stream, i.e. the response to a request with a path like:
+//
+//      /api/v1/{device_type}/{device_number}/events
+//
+// It is owned by the ServerConnection whose socket is streaming, and is updated
+// by the RequestListener each time the stream is serviced, which allows the
+// listener to throttle the stream and detect changes without storing anything
+// per connection itself.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+struct EventStreamState {
+  void Reset() {
+    last_check_millis = 0;
+    last_write_millis = 0;
+    state_hash = 0;
+    have_state_hash = false;
+  }
+
+  // Time at which the state of the device was last examined.
+  uint32_t last_check_millis;
+
+  // Time at which an event or keep-alive comment was last written.
+  uint32_t last_write_millis;
+
+  // Hash of the device state last sent, used to detect changes.
+  uint32_t state_hash;
+  bool have_state_hash;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_EVENT_STREAM_STATE_H_
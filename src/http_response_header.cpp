@@ -24,6 +24,7 @@ void HttpResponseHeader::Reset() {
   reason_phrase = {};
   content_type = {};
   content_length = kContentLengthUnknown;
+  retry_after_seconds = 0;
   do_close = true;
 }
 
@@ -44,6 +45,11 @@ size_t HttpResponseHeader::printTo(Print& out) const {
     count += ProgmemStringViews::close().printTo(out);
   }
 
+  if (retry_after_seconds != 0) {
+    count += WriteEolHeaderName(ProgmemStringViews::HttpRetryAfter(), out);
+    count += out.print(retry_after_seconds);
+  }
+
   count += WriteEolHeaderName(ProgmemStringViews::HttpContentType(), out);
   switch (content_type) {
     case EContentType::kApplicationJson:
@@ -57,6 +63,10 @@ size_t HttpResponseHeader::printTo(Print& out) const {
     case EContentType::kTextHtml:
       count += ProgmemStringViews::MimeTypeTextHtml().printTo(out);
       break;
+
+    case EContentType::kTextEventStream:
+      count += ProgmemStringViews::MimeTypeEventStream().printTo(out);
+      break;
   }
   if (content_length != kContentLengthUnknown) {
     count += WriteEolHeaderName(ProgmemStringViews::HttpContentLength(), out);
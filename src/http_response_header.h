@@ -28,6 +28,9 @@ struct HttpResponseHeader : public Printable {
   mcucore::ProgmemString reason_phrase;
   EContentType content_type;
   uint32_t content_length;
+
+  // If non-zero, a Retry-After header is added with this many seconds.
+  uint16_t retry_after_seconds;
   bool do_close;
 };
 
@@ -0,0 +1,146 @@
+#include "loop_profiler.h"
+
+#include <McuCore.h>
+
+#include "constants.h"
+#include "device_description.h"
+
+namespace alpaca {
+namespace {
+
+// Prints the name of a phase for the status page.
+void PrintPhaseName(mcucore::ArrayView<DeviceInterface*> devices, uint8_t ndx,
+                    mcucore::OPrintStream& strm) {
+  if (ndx == LoopProfiler::kLoopPhase) {
+    strm << MCU_PSD("Whole Loop");
+  } else if (ndx == LoopProfiler::kNetworkIOPhase) {
+    strm << MCU_PSD("Network IO");
+  } else {
+    const auto& description =
+        devices[ndx - LoopProfiler::kFirstDevicePhase]->device_description();
+    strm << description.device_type << '/' << description.device_number;
+  }
+}
+
+// Prints the labels that identify a phase in the metrics.
+void PrintPhaseLabels(mcucore::ArrayView<DeviceInterface*> devices,
+                      uint8_t ndx, mcucore::OPrintStream& strm) {
+  if (ndx == LoopProfiler::kLoopPhase) {
+    strm << MCU_PSD("phase=\"loop\"");
+  } else if (ndx == LoopProfiler::kNetworkIOPhase) {
+    strm << MCU_PSD("phase=\"network_io\"");
+  } else {
+    const auto& description =
+        devices[ndx - LoopProfiler::kFirstDevicePhase]->device_description();
+    strm << MCU_PSD("phase=\"maintain_device\",device=\"")
+         << description.device_type << '/' << description.device_number
+         << '"';
+  }
+}
+
+// Returns the number of phases for which there is something to report, i.e.
+// excluding those for devices that don't exist.
+uint8_t NumPhases(mcucore::ArrayView<DeviceInterface*> devices) {
+  if (devices.size() < LoopProfiler::kMaxDevices) {
+    return LoopProfiler::kFirstDevicePhase + devices.size();
+  }
+  return LoopProfiler::kNumPhases;
+}
+
+}  // namespace
+
+uint32_t LoopPhaseStats::WindowPercentile(uint8_t percent) const {
+  if (window_count_ == 0) {
+    return 0;
+  }
+  // Sort a copy of the window; it is small, so insertion sort is fine.
+  uint16_t sorted[kWindowSize];
+  for (uint8_t i = 0; i < window_count_; ++i) {
+    uint16_t v = window_[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > v) {
+      sorted[j] = sorted[j - 1];
+      --j;
+    }
+    sorted[j] = v;
+  }
+  // The nearest rank is ceil(percent * window_count_ / 100).
+  uint16_t rank = (static_cast<uint16_t>(percent) * window_count_ + 99) / 100;
+  if (rank == 0) {
+    rank = 1;
+  } else if (rank > window_count_) {
+    rank = window_count_;
+  }
+  return sorted[rank - 1];
+}
+
+void LoopProfiler::Reset() {
+  for (auto& phase : phases_) {
+    phase.Reset();
+  }
+  last_loop_start_micros_ = 0;
+  has_loop_start_ = false;
+  TakeSnapshot();
+}
+
+void LoopProfiler::TakeSnapshot() {
+  for (uint8_t ndx = 0; ndx < kNumPhases; ++ndx) {
+    const LoopPhaseStats& phase = phases_[ndx];
+    PhaseSummary& summary = snapshot_[ndx];
+    summary.min_micros = phase.min_micros();
+    summary.mean_micros = phase.mean_micros();
+    summary.max_micros = phase.max_micros();
+    summary.p99_micros = phase.WindowPercentile(99);
+    summary.count = phase.count();
+  }
+}
+
+void LoopProfiler::PrintHtml(mcucore::ArrayView<DeviceInterface*> devices,
+                             mcucore::OPrintStream& strm) const {
+  strm << MCU_PSD("<div class=lp>\n<h2 id=lph>Loop Profile (micros)</h2>\n")
+       << MCU_PSD("<table>\n<tr><th>Phase</th><th>Count</th><th>Min</th>")
+       << MCU_PSD("<th>Mean</th><th>Max</th><th>P99</th></tr>\n");
+  const uint8_t num_phases = NumPhases(devices);
+  for (uint8_t ndx = 0; ndx < num_phases; ++ndx) {
+    const PhaseSummary& summary = snapshot_[ndx];
+    strm << MCU_PSD("<tr><td>");
+    PrintPhaseName(devices, ndx, strm);
+    strm << MCU_PSD("</td><td>") << summary.count << MCU_PSD("</td><td>")
+         << summary.min_micros << MCU_PSD("</td><td>") << summary.mean_micros
+         << MCU_PSD("</td><td>") << summary.max_micros << MCU_PSD("</td><td>")
+         << summary.p99_micros << MCU_PSD("</td></tr>\n");
+  }
+  strm << MCU_PSD("</table>\n</div>\n");
+}
+
+void LoopProfiler::PrintMetrics(mcucore::ArrayView<DeviceInterface*> devices,
+                                mcucore::OPrintStream& strm) const {
+  strm << MCU_PSD("# TYPE tas_loop_phase_micros gauge\n");
+  const uint8_t num_phases = NumPhases(devices);
+  for (uint8_t ndx = 0; ndx < num_phases; ++ndx) {
+    const PhaseSummary& summary = snapshot_[ndx];
+    const struct {
+      const __FlashStringHelper* stat;
+      uint32_t value;
+    } stats[] = {
+        {MCU_FLASHSTR("min"), summary.min_micros},
+        {MCU_FLASHSTR("mean"), summary.mean_micros},
+        {MCU_FLASHSTR("max"), summary.max_micros},
+        {MCU_FLASHSTR("p99"), summary.p99_micros},
+    };
+    for (const auto& stat : stats) {
+      strm << MCU_PSD("tas_loop_phase_micros{");
+      PrintPhaseLabels(devices, ndx, strm);
+      strm << MCU_PSD(",stat=\"") << stat.stat << MCU_PSD("\"} ") << stat.value
+           << '\n';
+    }
+  }
+  strm << MCU_PSD("# TYPE tas_loop_phase_iterations_total counter\n");
+  for (uint8_t ndx = 0; ndx < num_phases; ++ndx) {
+    strm << MCU_PSD("tas_loop_phase_iterations_total{");
+    PrintPhaseLabels(devices, ndx, strm);
+    strm << MCU_PSD("} ") << snapshot_[ndx].count << '\n';
+  }
+}
+
+}  // namespace alpaca
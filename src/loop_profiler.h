@@ -0,0 +1,160 @@
+#ifndef TINY_ALPACA_SERVER_SRC_LOOP_PROFILER_H_
+#define TINY_ALPACA_SERVER_SRC_LOOP_PROFILER_H_
+
+// LoopProfiler records the time taken by each phase of the Arduino loop()
+// function: the whole loop (measured between calls to
+// TinyAlpacaDeviceServer::MaintainDevices), network IO (i.e.
+// TinyAlpacaNetworkServer::PerformIO), and the MaintainDevice method of each
+// device. This makes it possible to find which device or connection is using up
+// the loop's time budget, which shows up as jitter in LED dimming, stepper
+// timing and the like.
+//
+// For each phase we keep the min, mean and max since the profiler was reset,
+// and a ring buffer of the most recent durations, from which the 99th
+// percentile is computed.
+//
+// Network IO is a single phase: the time used by each connection isn't
+// recorded here (see ServerSocketsAndConnections::PrintMetrics for that).
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "config.h"
+#include "device_interface.h"
+
+namespace alpaca {
+
+class LoopPhaseStats {
+ public:
+  static constexpr uint8_t kWindowSize = TAS_LOOP_PROFILER_WINDOW;
+
+  LoopPhaseStats() { Reset(); }
+
+  void Reset() {
+    min_micros_ = 0;
+    max_micros_ = 0;
+    total_micros_ = 0;
+    count_ = 0;
+    next_ndx_ = 0;
+    window_count_ = 0;
+  }
+
+  void Record(uint32_t micros) {
+    if (count_ == 0 || micros < min_micros_) {
+      min_micros_ = micros;
+    }
+    if (micros > max_micros_) {
+      max_micros_ = micros;
+    }
+    total_micros_ += micros;
+    ++count_;
+    // Durations too long for the window are recorded as the longest possible,
+    // which is plenty for identifying a problem; max_micros is exact.
+    window_[next_ndx_] = micros > 0xFFFF ? 0xFFFF : micros;
+    next_ndx_ = (next_ndx_ + 1) % kWindowSize;
+    if (window_count_ < kWindowSize) {
+      ++window_count_;
+    }
+  }
+
+  // Returns the specified percentile (1 to 100) of the durations in the window,
+  // using the nearest-rank method, or zero if there are none.
+  uint32_t WindowPercentile(uint8_t percent) const;
+
+  uint32_t min_micros() const { return min_micros_; }
+  uint32_t max_micros() const { return max_micros_; }
+  uint32_t mean_micros() const {
+    return count_ == 0 ? 0 : static_cast<uint32_t>(total_micros_ / count_);
+  }
+  uint32_t count() const { return count_; }
+  uint8_t window_count() const { return window_count_; }
+
+ private:
+  uint16_t window_[kWindowSize];
+  // A 64-bit total, because the total of the whole loop phase would otherwise
+  // wrap around after about 71 minutes.
+  uint64_t total_micros_;
+  uint32_t min_micros_;
+  uint32_t max_micros_;
+  uint32_t count_;
+  uint8_t next_ndx_;
+  uint8_t window_count_;
+};
+
+class LoopProfiler {
+ public:
+  // Only the first kMaxDevices devices are profiled.
+  static constexpr uint8_t kMaxDevices = TAS_LOOP_PROFILER_MAX_DEVICES;
+
+  // The phases are identified by index: the whole loop, then network IO, then
+  // each of the devices.
+  static constexpr uint8_t kLoopPhase = 0;
+  static constexpr uint8_t kNetworkIOPhase = 1;
+  static constexpr uint8_t kFirstDevicePhase = 2;
+  static constexpr uint8_t kNumPhases = kFirstDevicePhase + kMaxDevices;
+
+  // The summary of a phase, as of the last call to TakeSnapshot.
+  struct PhaseSummary {
+    uint32_t min_micros;
+    uint32_t mean_micros;
+    uint32_t max_micros;
+    uint32_t p99_micros;
+    uint32_t count;
+  };
+
+  LoopProfiler() { Reset(); }
+
+  void Reset();
+
+  // Records the start of an iteration of the loop, at which point the previous
+  // iteration has ended. now_micros is the current value of micros(); passed in
+  // to support testing.
+  void RecordLoopStart(uint32_t now_micros) {
+    if (has_loop_start_) {
+      // Unsigned subtraction handles the rollover of micros().
+      phases_[kLoopPhase].Record(now_micros - last_loop_start_micros_);
+    }
+    last_loop_start_micros_ = now_micros;
+    has_loop_start_ = true;
+  }
+
+  void RecordNetworkIO(uint32_t micros) {
+    phases_[kNetworkIOPhase].Record(micros);
+  }
+
+  // Records the time taken by MaintainDevice of the device with index
+  // device_ndx in the server's list of devices.
+  void RecordMaintainDevice(uint8_t device_ndx, uint32_t micros) {
+    if (device_ndx < kMaxDevices) {
+      phases_[kFirstDevicePhase + device_ndx].Record(micros);
+    }
+  }
+
+  const LoopPhaseStats& phase(uint8_t ndx) const { return phases_[ndx]; }
+
+  // Copies the current summary of each phase into the snapshot, which is what
+  // is printed by the methods below. This allows the same output to be
+  // produced more than once for one request (e.g. to measure a part of the
+  // status page before writing it), even though the loop is still running.
+  void TakeSnapshot();
+  const PhaseSummary& snapshot(uint8_t ndx) const { return snapshot_[ndx]; }
+
+  // Writes the snapshot as an HTML section for the server's status page.
+  void PrintHtml(mcucore::ArrayView<DeviceInterface*> devices,
+                 mcucore::OPrintStream& strm) const;
+
+  // Writes the snapshot in the Prometheus text exposition format.
+  void PrintMetrics(mcucore::ArrayView<DeviceInterface*> devices,
+                    mcucore::OPrintStream& strm) const;
+
+ private:
+  LoopPhaseStats phases_[kNumPhases];
+  PhaseSummary snapshot_[kNumPhases];
+  uint32_t last_loop_start_micros_;
+  bool has_loop_start_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_LOOP_PROFILER_H_
@@ -31,6 +31,7 @@ bool MatchApiGroup(const mcucore::StringView& view, EApiGroup& match) {
   MATCH_ONE_LITERAL_EXACTLY(management, EApiGroup::kManagement);
   MATCH_ONE_LITERAL_EXACTLY(setup, EApiGroup::kSetup);
   MATCH_ONE_LITERAL_EXACTLY(asset, EApiGroup::kAsset);
+  MATCH_ONE_LITERAL_EXACTLY(metrics, EApiGroup::kMetrics);
   return false;
 }
 
@@ -39,6 +40,7 @@ bool MatchManagementMethod(const mcucore::StringView& view,
   MATCH_ONE_LITERAL_EXACTLY(description, EManagementMethod::kDescription);
   MATCH_ONE_LITERAL_EXACTLY(configureddevices,
                             EManagementMethod::kConfiguredDevices);
+  MATCH_ONE_LITERAL_EXACTLY(requestjournal, EManagementMethod::kRequestJournal);
   return false;
 }
 
@@ -62,13 +64,16 @@ namespace internal {
 bool MatchCommonDeviceMethod(const mcucore::StringView& view,
                              EDeviceMethod& match) {
   MATCH_ONE_LITERAL_EXACTLY(action, EDeviceMethod::kAction);
+  MATCH_ONE_LITERAL_EXACTLY(batch, EDeviceMethod::kBatch);
   MATCH_ONE_LITERAL_EXACTLY(commandblind, EDeviceMethod::kCommandBlind);
   MATCH_ONE_LITERAL_EXACTLY(commandbool, EDeviceMethod::kCommandBool);
   MATCH_ONE_LITERAL_EXACTLY(commandstring, EDeviceMethod::kCommandString);
   MATCH_ONE_LITERAL_EXACTLY(connected, EDeviceMethod::kConnected);
   MATCH_ONE_LITERAL_EXACTLY(description, EDeviceMethod::kDescription);
+  MATCH_ONE_LITERAL_EXACTLY(devicestate, EDeviceMethod::kDeviceState);
   MATCH_ONE_LITERAL_EXACTLY(driverinfo, EDeviceMethod::kDriverInfo);
   MATCH_ONE_LITERAL_EXACTLY(driverversion, EDeviceMethod::kDriverVersion);
+  MATCH_ONE_LITERAL_EXACTLY(events, EDeviceMethod::kEvents);
   MATCH_ONE_LITERAL_EXACTLY(interfaceversion, EDeviceMethod::kInterfaceVersion);
   MATCH_ONE_LITERAL_EXACTLY(name, EDeviceMethod::kName);
   MATCH_ONE_LITERAL_EXACTLY(supportedactions, EDeviceMethod::kSupportedActions);
@@ -205,12 +210,16 @@ bool MatchParameter(const mcucore::StringView& view, EParameter& match) {
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Command, EParameter::kCommand);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Connected, EParameter::kConnected);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Id, EParameter::kId);
+  MATCH_ONE_LITERAL_CASE_INSENSITIVELY(IfNotEqual, EParameter::kIfNotEqual);
+  MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Method, EParameter::kMethod);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Name, EParameter::kName);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Parameters, EParameter::kParameters);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Raw, EParameter::kRaw);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(SensorName, EParameter::kSensorName);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(State, EParameter::kState);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Value, EParameter::kValue);
+  MATCH_ONE_LITERAL_CASE_INSENSITIVELY(WaitForChangeMs,
+                                       EParameter::kWaitForChangeMs);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(AveragePeriod,
                                        EParameter::kAveragePeriod);
 
@@ -237,6 +246,15 @@ bool MatchSensorName(const mcucore::StringView& view, ESensorName& match) {
   return false;
 }
 
+bool MatchDeviceAction(const mcucore::StringView& view, EDeviceAction& match) {
+  MATCH_ONE_LITERAL_CASE_INSENSITIVELY(History, EDeviceAction::kHistory);
+  MATCH_ONE_LITERAL_CASE_INSENSITIVELY(GetAllSwitchValues,
+                                       EDeviceAction::kGetAllSwitchValues);
+  MATCH_ONE_LITERAL_CASE_INSENSITIVELY(SetSwitchValues,
+                                       EDeviceAction::kSetSwitchValues);
+  return false;
+}
+
 bool MatchHttpHeader(const mcucore::StringView& view, EHttpHeader& match) {
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(Connection, EHttpHeader::kConnection);
   MATCH_ONE_LITERAL_CASE_INSENSITIVELY(HttpContentLength,
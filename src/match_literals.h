@@ -53,6 +53,11 @@ bool MatchHttpHeader(const mcucore::StringView& view, EHttpHeader& match);
 // return false.
 bool MatchSensorName(const mcucore::StringView& view, ESensorName& match);
 
+// Match `view` against the names of the actions implemented by the device type
+// adapters (e.g. "History"). If successful, set `match` to the corresponding
+// enum and return true. Else return false.
+bool MatchDeviceAction(const mcucore::StringView& view, EDeviceAction& match);
+
 namespace internal {
 // Match `view` against ASCOM Alpaca Device API methods which apply to all
 // devices (e.g. "connected". If successful, set `match` to the corresponding
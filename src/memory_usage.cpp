@@ -0,0 +1,158 @@
+#include "memory_usage.h"
+
+#include <McuCore.h>
+
+#include "alpaca_request.h"
+#include "request_decoder.h"
+#include "server_connection.h"
+
+#if TAS_CAN_MEASURE_STACK
+
+// Symbols provided by avr-libc and the linker script.
+extern uint8_t __heap_start;  // End of the static data, start of the heap.
+extern uint8_t __stack;       // Top of the stack, i.e. RAMEND.
+extern char* __brkval;        // End of the heap, or zero if never allocated.
+
+// Paints the RAM between the static data and the top of the stack. Placed in
+// .init3 so that it runs after the stack pointer has been initialized, and
+// before the static data is initialized and main() is called; the painting
+// doesn't need the stack, so it doesn't matter that it is also painted.
+extern "C" void TasPaintStack() __attribute__((naked, used, section(".init3")));
+extern "C" void TasPaintStack() {
+  uint8_t* p = &__heap_start;
+  while (p <= &__stack) {
+    *p++ = alpaca::MemoryUsage::kPaintByte;
+  }
+}
+
+#endif  // TAS_CAN_MEASURE_STACK
+
+namespace alpaca {
+namespace {
+
+struct StructSize {
+  const __FlashStringHelper* name;
+  uint16_t size;
+};
+
+// The sizes of the structs of which the server has the most instances, or which
+// are otherwise the largest.
+constexpr uint8_t kNumStructSizes = 3;
+void GetStructSizes(StructSize (&sizes)[kNumStructSizes]) {
+  sizes[0] = {MCU_FLASHSTR("ServerConnection"), sizeof(ServerConnection)};
+  sizes[1] = {MCU_FLASHSTR("AlpacaRequest"), sizeof(AlpacaRequest)};
+  sizes[2] = {MCU_FLASHSTR("RequestDecoderState"),
+              sizeof(RequestDecoderState)};
+}
+
+}  // namespace
+
+void MemoryUsage::Reset() {
+  measurements_.stack_peak_bytes = 0;
+  measurements_.stack_headroom_bytes = 0;
+  snapshot_ = measurements_;
+  last_sample_millis_ = 0;
+#if TAS_CAN_MEASURE_STACK
+  scan_cursor_ = nullptr;
+#endif  // TAS_CAN_MEASURE_STACK
+}
+
+#if TAS_CAN_MEASURE_STACK
+bool MemoryUsage::Scan(uint16_t max_bytes) {
+  const uint8_t* const heap_end =
+      __brkval == nullptr ? &__heap_start
+                          : reinterpret_cast<const uint8_t*>(__brkval);
+  // The heap may have grown over the part already scanned.
+  if (scan_cursor_ == nullptr || scan_cursor_ < heap_end) {
+    scan_cursor_ = heap_end;
+  }
+  // Don't scan past the current top of the stack, which may by chance contain
+  // the paint byte.
+  const uint8_t* const stack_top = reinterpret_cast<const uint8_t*>(SP);
+  const uint8_t* p = scan_cursor_;
+  for (; max_bytes > 0 && p < stack_top && *p == kPaintByte; --max_bytes) {
+    ++p;
+  }
+  if (p < stack_top && *p == kPaintByte) {
+    // Ran out of bytes to scan before finding the deepest point.
+    scan_cursor_ = p;
+    return false;
+  }
+  scan_cursor_ = nullptr;
+  const uint16_t stack_peak_bytes = static_cast<uint16_t>(&__stack - p) + 1;
+  if (stack_peak_bytes > measurements_.stack_peak_bytes) {
+    MCU_VLOG(2) << MCU_PSD("Stack peak increased to ") << stack_peak_bytes
+                << MCU_PSD(" bytes");
+  }
+  measurements_.stack_peak_bytes = stack_peak_bytes;
+  measurements_.stack_headroom_bytes = static_cast<uint16_t>(p - heap_end);
+  return true;
+}
+#endif  // TAS_CAN_MEASURE_STACK
+
+void MemoryUsage::Sample() {
+#if TAS_CAN_MEASURE_STACK
+  // Abandon any scan in progress, and scan all the way in one call; the RAM of
+  // an AVR is far smaller than 64KB.
+  scan_cursor_ = nullptr;
+  Scan(UINT16_MAX);
+#endif  // TAS_CAN_MEASURE_STACK
+}
+
+void MemoryUsage::MaybeSample(uint32_t now_millis) {
+#if TAS_CAN_MEASURE_STACK
+  if (scan_cursor_ != nullptr) {
+    Scan(TAS_MEMORY_USAGE_SCAN_BYTES);
+    return;
+  }
+#endif  // TAS_CAN_MEASURE_STACK
+  // Unsigned subtraction handles the rollover of millis().
+  if (now_millis - last_sample_millis_ >= TAS_MEMORY_USAGE_SAMPLE_MILLIS) {
+    last_sample_millis_ = now_millis;
+#if TAS_CAN_MEASURE_STACK
+    Scan(TAS_MEMORY_USAGE_SCAN_BYTES);
+#endif  // TAS_CAN_MEASURE_STACK
+  }
+}
+
+void MemoryUsage::TakeSnapshot() {
+  Sample();
+  snapshot_ = measurements_;
+}
+
+void MemoryUsage::PrintHtml(mcucore::OPrintStream& strm) const {
+  strm << MCU_PSD("<div class=mu>\n<h2 id=muh>Memory Usage (bytes)</h2>\n")
+       << MCU_PSD("<table>\n");
+#if TAS_CAN_MEASURE_STACK
+  strm << MCU_PSD("<tr><td>Stack Peak</td><td>") << snapshot_.stack_peak_bytes
+       << MCU_PSD("</td></tr>\n<tr><td>Stack Headroom</td><td>")
+       << snapshot_.stack_headroom_bytes << MCU_PSD("</td></tr>\n");
+#endif  // TAS_CAN_MEASURE_STACK
+  StructSize sizes[kNumStructSizes];
+  GetStructSizes(sizes);
+  for (const auto& struct_size : sizes) {
+    strm << MCU_PSD("<tr><td>sizeof(") << struct_size.name
+         << MCU_PSD(")</td><td>") << struct_size.size
+         << MCU_PSD("</td></tr>\n");
+  }
+  strm << MCU_PSD("</table>\n</div>\n");
+}
+
+void MemoryUsage::PrintMetrics(mcucore::OPrintStream& strm) const {
+#if TAS_CAN_MEASURE_STACK
+  strm << MCU_PSD("# TYPE tas_stack_bytes gauge\n")
+       << MCU_PSD("tas_stack_bytes{stat=\"peak\"} ")
+       << snapshot_.stack_peak_bytes << '\n'
+       << MCU_PSD("tas_stack_bytes{stat=\"headroom\"} ")
+       << snapshot_.stack_headroom_bytes << '\n';
+#endif  // TAS_CAN_MEASURE_STACK
+  StructSize sizes[kNumStructSizes];
+  GetStructSizes(sizes);
+  strm << MCU_PSD("# TYPE tas_struct_size_bytes gauge\n");
+  for (const auto& struct_size : sizes) {
+    strm << MCU_PSD("tas_struct_size_bytes{struct=\"") << struct_size.name
+         << MCU_PSD("\"} ") << struct_size.size << '\n';
+  }
+}
+
+}  // namespace alpaca
@@ -0,0 +1,103 @@
+#ifndef TINY_ALPACA_SERVER_SRC_MEMORY_USAGE_H_
+#define TINY_ALPACA_SERVER_SRC_MEMORY_USAGE_H_
+
+// MemoryUsage reports how close the server is to running out of RAM, which on
+// an ATmega2560 with only a few hundred bytes to spare is otherwise a matter of
+// guesswork (e.g. when deciding whether there is room for another connection).
+//
+// On AVR the RAM between the end of the static data and the top of the stack is
+// painted with a known byte at startup, before main() is called. The deepest
+// point reached by the stack is then found by scanning upwards from the end of
+// the heap for the first byte that is no longer painted. That can be several
+// KB, too long to scan in one pass of the server's loop without delaying it, so
+// TinyAlpacaDeviceServer::MaintainDevices scans at most
+// TAS_MEMORY_USAGE_SCAN_BYTES per call, resuming where the previous call
+// stopped, and starts a new scan every TAS_MEMORY_USAGE_SAMPLE_MILLIS. A full
+// scan is done only when the usage is reported, i.e. on the status page and at
+// /metrics, where the time taken to produce the response is already large.
+//
+// On other platforms (including the host, for tests) the stack isn't measured,
+// but the sizes of the structs which take up most of the RAM are still
+// reported, so that changes to them can be evaluated without an Arduino.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "config.h"
+
+#if defined(__AVR__)
+#define TAS_CAN_MEASURE_STACK 1
+#else
+#define TAS_CAN_MEASURE_STACK 0
+#endif
+
+namespace alpaca {
+
+class MemoryUsage {
+ public:
+  // The value written to each byte of the unused RAM at startup.
+  static constexpr uint8_t kPaintByte = 0xC5;
+
+  // The measurements, as of the last call to Sample.
+  struct Measurements {
+    // The most bytes of stack that have been used since startup.
+    uint16_t stack_peak_bytes;
+    // The number of painted bytes between the end of the heap and the deepest
+    // point reached by the stack, i.e. how much more the stack (or heap) could
+    // grow without a collision.
+    uint16_t stack_headroom_bytes;
+  };
+
+  MemoryUsage() { Reset(); }
+
+  void Reset();
+
+  // Measures the stack's high-water mark with a full scan, and logs if it has
+  // increased.
+  void Sample();
+
+  // Continues the incremental scan if one is in progress, else starts one if
+  // at least TAS_MEMORY_USAGE_SAMPLE_MILLIS have passed since the last one was
+  // started. Scans at most TAS_MEMORY_USAGE_SCAN_BYTES. The measurements are
+  // updated when a scan completes. If the stack grows below the point already
+  // scanned while a scan is in progress, the growth is found by the next scan.
+  // now_millis is the current value of millis(); passed in to support testing.
+  void MaybeSample(uint32_t now_millis);
+
+  const Measurements& measurements() const { return measurements_; }
+
+  // Samples, then copies the measurements into the snapshot, which is what is
+  // printed by the methods below. This allows the same output to be produced
+  // more than once for one request (e.g. to measure a part of the status page
+  // before writing it), even though the stack may grow while doing so.
+  void TakeSnapshot();
+  const Measurements& snapshot() const { return snapshot_; }
+
+  // Writes the snapshot, and the sizes of the largest structs, as an HTML
+  // section for the server's status page.
+  void PrintHtml(mcucore::OPrintStream& strm) const;
+
+  // Writes the same in the Prometheus text exposition format.
+  void PrintMetrics(mcucore::OPrintStream& strm) const;
+
+ private:
+#if TAS_CAN_MEASURE_STACK
+  // Scans at most max_bytes, starting from scan_cursor_ (or from the end of the
+  // heap if no scan is in progress). Returns true if the scan has completed,
+  // in which case the measurements have been updated.
+  bool Scan(uint16_t max_bytes);
+
+  // Where the next call to Scan should start, or nullptr if no scan is in
+  // progress.
+  const uint8_t* scan_cursor_;
+#endif  // TAS_CAN_MEASURE_STACK
+
+  Measurements measurements_;
+  Measurements snapshot_;
+  uint32_t last_sample_millis_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_MEMORY_USAGE_H_
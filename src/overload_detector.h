@@ -0,0 +1,101 @@
+#ifndef TINY_ALPACA_SERVER_SRC_OVERLOAD_DETECTOR_H_
+#define TINY_ALPACA_SERVER_SRC_OVERLOAD_DETECTOR_H_
+
+// OverloadDetector tracks the time taken by each iteration of the Arduino
+// loop() function, and decides when the server is overloaded, i.e. when the
+// loop is taking so long that devices aren't being maintained promptly (e.g. a
+// cover motor isn't stopped at its limit switch quickly enough). While
+// overloaded, TinyAlpacaDeviceServer refuses requests in the low lane (see
+// request_lanes.h) with a cheap 503 Service Unavailable response, rather than
+// spending time producing HTML pages and the like.
+//
+// The loop time is smoothed with an exponentially weighted moving average, and
+// there is hysteresis between entering and leaving the overloaded state so
+// that the server doesn't flip back and forth on every iteration.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+class OverloadDetector {
+ public:
+  // The server becomes overloaded when the average loop time exceeds
+  // enter_micros, and is no longer overloaded once the average drops below
+  // exit_micros, which should be less than enter_micros.
+  OverloadDetector(uint32_t enter_micros, uint32_t exit_micros)
+      : enter_micros_(enter_micros), exit_micros_(exit_micros) {
+    MCU_DCHECK_LT(exit_micros_, enter_micros_);
+    Reset();
+  }
+
+  void Reset() {
+    mean_loop_micros_ = 0;
+    last_loop_start_micros_ = 0;
+    num_overloads_ = 0;
+    num_shed_requests_ = 0;
+    has_loop_start_ = false;
+    has_mean_ = false;
+    is_overloaded_ = false;
+  }
+
+  // Records the start of an iteration of the loop, at which point the previous
+  // iteration has ended. now_micros is the current value of micros(); passed in
+  // to support testing.
+  void RecordLoopStart(uint32_t now_micros) {
+    if (has_loop_start_) {
+      // Unsigned subtraction handles the rollover of micros().
+      RecordLoopDuration(now_micros - last_loop_start_micros_);
+    }
+    last_loop_start_micros_ = now_micros;
+    has_loop_start_ = true;
+  }
+
+  // Records the duration of an iteration of the loop. Each sample has a weight
+  // of 1/8 in the average.
+  void RecordLoopDuration(uint32_t micros) {
+    if (has_mean_) {
+      mean_loop_micros_ = mean_loop_micros_ - (mean_loop_micros_ >> 3) +
+                          (micros >> 3);
+    } else {
+      mean_loop_micros_ = micros;
+      has_mean_ = true;
+    }
+    if (is_overloaded_) {
+      if (mean_loop_micros_ < exit_micros_) {
+        is_overloaded_ = false;
+      }
+    } else if (mean_loop_micros_ > enter_micros_) {
+      is_overloaded_ = true;
+      ++num_overloads_;
+    }
+  }
+
+  // Records that a request was refused because the server is overloaded.
+  void RecordShedRequest() { ++num_shed_requests_; }
+
+  bool is_overloaded() const { return is_overloaded_; }
+  uint32_t mean_loop_micros() const { return mean_loop_micros_; }
+
+  // Number of times the server has become overloaded.
+  uint32_t num_overloads() const { return num_overloads_; }
+
+  // Number of requests refused because the server was overloaded.
+  uint32_t num_shed_requests() const { return num_shed_requests_; }
+
+ private:
+  const uint32_t enter_micros_;
+  const uint32_t exit_micros_;
+  uint32_t mean_loop_micros_;
+  uint32_t last_loop_start_micros_;
+  uint32_t num_overloads_;
+  uint32_t num_shed_requests_;
+  bool has_loop_start_;
+  bool has_mean_;
+  bool is_overloaded_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_OVERLOAD_DETECTOR_H_
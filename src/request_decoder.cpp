@@ -26,6 +26,7 @@
 #include "constants.h"
 #include "literals.h"
 #include "match_literals.h"
+#include "trace_ring.h"
 
 // NOTE: The syntax for the query portion of a URI is not as clearly specified
 // as the rest of HTTP (AFAICT), so I'm assuming that:
@@ -48,6 +49,10 @@ namespace {
 using DecodeFunction = RequestDecoderState::DecodeFunction;
 using CharMatchFunction = bool (*)(char c);
 
+#if TAS_ENABLE_TRACE_RING
+uint16_t DecodeFunctionTraceId(DecodeFunction decode_function);
+#endif  // TAS_ENABLE_TRACE_RING
+
 ////////////////////////////////////////////////////////////////////////////////
 // Helpers for decoder functions.
 
@@ -397,6 +402,7 @@ EHttpStatusCode DecodeHeaderLines(RequestDecoderState& state,
     } else {
       // There is a body of known length to be decoded.
       state.is_decoding_header = false;
+      TAS_TRACE(kDecodeFunction, 0, DecodeFunctionTraceId(DecodeParamName));
       state.decode_function = DecodeParamName;
       return EHttpStatusCode::kNeedMoreInput;
     }
@@ -582,17 +588,65 @@ EHttpStatusCode DecodeParamValue(RequestDecoderState& state,
     } else {
       state.request.sensor_name = matched;
     }
-  } else if (state.current_parameter == EParameter::kName) {
+  } else if (state.current_parameter == EParameter::kName ||
+             state.current_parameter == EParameter::kParameters) {
     // We don't yet have have unique storage for name, vs. any other
-    // parameter that might need to use the AlpacaRequest.string_value field
-    // (none so far). Throwing caution to the wind, I'm just assuming
-    // another use won't be added soon.
+    // parameter that might need to use the AlpacaRequest.string_value field.
+    // Name is used only by setswitchname, and Parameters only by action, so
+    // they can share the field.
     // TODO(jamessynge): Switch to using SerialMap<EParameter> (or similar)
     // for storing the values of parameters.
     state.request.have_string_value = 0;
-    if (!state.request.set_string_value(value)) {
+    bool stored_ok = state.request.set_string_value(value);
+#if TAS_ENABLE_BULK_SWITCH_ACTIONS
+    // Parameters may instead (or also) be the list of values for the
+    // SetSwitchValues action, which may be too long for string_value.
+    if (state.current_parameter == EParameter::kParameters &&
+        state.request.set_switch_values(value)) {
+      stored_ok = true;
+    }
+#endif  // TAS_ENABLE_BULK_SWITCH_ACTIONS
+    if (!stored_ok) {
       return RemoveInvalidParamValue(state, value);
     }
+  } else if (state.current_parameter == EParameter::kAction) {
+    // An action we don't implement isn't an error at this level; the device
+    // decides how to respond to it.
+    EDeviceAction matched;
+    if (MatchDeviceAction(value, matched)) {
+      state.request.action = matched;
+    } else {
+      state.request.action = EDeviceAction::kUnknown;
+    }
+#if TAS_ENABLE_BATCH_REQUESTS
+  } else if (state.current_parameter == EParameter::kMethod) {
+    // The Method parameter may appear multiple times, hence we append rather
+    // than overwrite. Note that the method must be one supported by the device
+    // type named in the path, and must be readable by a GET request, which is
+    // checked by add_batch_method.
+    EDeviceMethod method;
+    if (!MatchDeviceMethod(EApiGroup::kDevice, state.request.device_type,
+                           value, method) ||
+        !state.request.add_batch_method(method)) {
+      return RemoveInvalidParamValue(state, value);
+    }
+#endif  // TAS_ENABLE_BATCH_REQUESTS
+#if TAS_ENABLE_LONG_POLL
+  } else if (state.current_parameter == EParameter::kWaitForChangeMs) {
+    uint32_t ms;
+    bool converted_ok = value.to_uint32(ms);
+    if (!converted_ok) {
+      return RemoveInvalidParamValue(state, value);
+    } else {
+      state.request.set_wait_for_change_ms(ms);
+    }
+  } else if (state.current_parameter == EParameter::kIfNotEqual) {
+    // We store only a hash of the value, which is all we need to detect a
+    // change.
+    if (!state.request.set_if_not_equal(value)) {
+      return RemoveInvalidParamValue(state, value);
+    }
+#endif  // TAS_ENABLE_LONG_POLL
 #if TAS_ENABLE_EXTRA_PARAMETER_DECODING
   } else if (state.current_parameter != EParameter::kUnknown) {
     // Recognized but no built-in support.
@@ -789,6 +843,8 @@ EHttpStatusCode ProcessManagementMethod(RequestDecoderState& state,
       state.request.api = EAlpacaApi::kManagementDescription;
     } else if (method == EManagementMethod::kConfiguredDevices) {
       state.request.api = EAlpacaApi::kManagementConfiguredDevices;
+    } else if (method == EManagementMethod::kRequestJournal) {
+      state.request.api = EAlpacaApi::kManagementRequestJournal;
     } else {
       // COV_NF_START
       MCU_DCHECK(false) << MCU_PSD("method (") << method
@@ -930,15 +986,20 @@ EHttpStatusCode ProcessApiGroup(RequestDecoderState& state,
       }
 #endif  // TAS_ENABLE_ASSET_PATH_DECODING
       return EHttpStatusCode::kHttpNotFound;
+    } else if (group == EApiGroup::kMetrics) {
+      return EHttpStatusCode::kHttpNotFound;
     }
     MCU_DCHECK(group == EApiGroup::kDevice || group == EApiGroup::kSetup)
         << MCU_PSD("group: ") << group;
     return state.SetDecodeFunction(DecodeApiVersion);
   }
-  if (group != EApiGroup::kSetup) {
+  if (group == EApiGroup::kSetup) {
+    state.request.api = EAlpacaApi::kServerSetup;
+  } else if (group == EApiGroup::kMetrics) {
+    state.request.api = EAlpacaApi::kServerMetrics;
+  } else {
     return EHttpStatusCode::kHttpBadRequest;
   }
-  state.request.api = EAlpacaApi::kServerSetup;
   if (!HttpMethodIsRead(state.request.http_method)) {
     return EHttpStatusCode::kHttpMethodNotAllowed;
   }
@@ -1037,6 +1098,50 @@ size_t PrintValueTo(DecodeFunction decode_function, Print& out) {
   // COV_NF_END
 }
 
+#if TAS_ENABLE_TRACE_RING
+namespace {
+
+// Returns the id used to identify decode_function in a trace record. These are
+// part of the trace dump format, so must match the list of names in
+// extras/dev_tools/decode_trace.py.
+uint16_t DecodeFunctionTraceId(DecodeFunction decode_function) {
+  uint16_t id = 0;
+#define RETURN_ID_IF_MATCH(symbol) \
+  ++id;                            \
+  if (decode_function == symbol) return id
+
+  RETURN_ID_IF_MATCH(DecodeApiGroup);
+  RETURN_ID_IF_MATCH(DecodeApiVersion);
+  RETURN_ID_IF_MATCH(DecodeDeviceMethod);
+  RETURN_ID_IF_MATCH(DecodeDeviceNumber);
+  RETURN_ID_IF_MATCH(DecodeDeviceType);
+  RETURN_ID_IF_MATCH(DecodeEndOfPath);
+  RETURN_ID_IF_MATCH(DecodeHeaderLineEnd);
+  RETURN_ID_IF_MATCH(DecodeHeaderLines);
+  RETURN_ID_IF_MATCH(DecodeHeaderName);
+  RETURN_ID_IF_MATCH(DecodeHeaderValue);
+  RETURN_ID_IF_MATCH(DecodeHttpMethod);
+  RETURN_ID_IF_MATCH(DecodeManagementMethod);
+  RETURN_ID_IF_MATCH(DecodeManagementType);
+  RETURN_ID_IF_MATCH(DecodeParamName);
+  RETURN_ID_IF_MATCH(DecodeParamSeparator);
+  RETURN_ID_IF_MATCH(DecodeParamValue);
+  RETURN_ID_IF_MATCH(MatchHttpVersion);
+  RETURN_ID_IF_MATCH(MatchStartOfPath);
+  RETURN_ID_IF_MATCH(SkipHeaderValue);
+
+#if TAS_ENABLE_ASSET_PATH_DECODING
+  RETURN_ID_IF_MATCH(DecodeAssetPath);
+#endif  // TAS_ENABLE_ASSET_PATH_DECODING
+
+#undef RETURN_ID_IF_MATCH
+
+  return 0;  // COV_NF_LINE
+}
+
+}  // namespace
+#endif  // TAS_ENABLE_TRACE_RING
+
 #if TAS_ENABLE_REQUEST_DECODER_LISTENER
 RequestDecoderState::RequestDecoderState(AlpacaRequest& request)
     : decode_function(nullptr), request(request), listener(nullptr) {}
@@ -1053,6 +1158,7 @@ void RequestDecoderState::Reset() {
   MCU_VLOG(1) << MCU_FLASHSTR_128(
       "Reset "
       "################################################################");
+  TAS_TRACE(kDecoderReset, 0, 0);
   decode_function = DecodeHttpMethod;
   request.Reset();
   is_decoding_header = true;
@@ -1252,6 +1358,7 @@ EHttpStatusCode RequestDecoderState::SetDecodeFunction(
   MCU_VLOG(3) << MCU_PSD("SetDecodeFunction(") << func << ')';
   MCU_CHECK_NE(decode_function, nullptr);
   MCU_CHECK_NE(decode_function, func);
+  TAS_TRACE(kDecodeFunction, 0, DecodeFunctionTraceId(func));
   decode_function = func;
   return EHttpStatusCode::kContinueDecoding;
 }
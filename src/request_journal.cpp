@@ -0,0 +1,118 @@
+#include "request_journal.h"
+
+#include <McuCore.h>
+
+#include "literals.h"
+
+namespace alpaca {
+namespace {
+
+// Generate the properties of a single object in the Value array, i.e. a single
+// journal entry.
+class RequestJournalEntrySource : public mcucore::JsonPropertySource {
+ public:
+  explicit RequestJournalEntrySource(const RequestJournalEntry& entry)
+      : entry_(entry) {}
+
+  void AddTo(mcucore::JsonObjectEncoder& object_encoder) const override {
+    object_encoder.AddUIntProperty(ProgmemStringViews::ServerTransactionID(),
+                                   entry_.server_transaction_id);
+    object_encoder.AddUIntProperty(ProgmemStringViews::ClientTransactionID(),
+                                   entry_.client_transaction_id);
+    object_encoder.AddStringProperty(ProgmemStringViews::Api(),
+                                     ToFlashStringHelper(entry_.api));
+    if (entry_.api == EAlpacaApi::kDeviceApi ||
+        entry_.api == EAlpacaApi::kDeviceSetup) {
+      object_encoder.AddStringProperty(ProgmemStringViews::DeviceType(),
+                                       ToFlashStringHelper(entry_.device_type));
+      object_encoder.AddUIntProperty(ProgmemStringViews::DeviceNumber(),
+                                     entry_.device_number);
+      object_encoder.AddStringProperty(
+          ProgmemStringViews::Method(),
+          ToFlashStringHelper(entry_.device_method));
+    }
+    object_encoder.AddUIntProperty(ProgmemStringViews::HttpStatus(),
+                                   entry_.http_status);
+    object_encoder.AddUIntProperty(ProgmemStringViews::ErrorNumber(),
+                                   entry_.error_number);
+    object_encoder.AddUIntProperty(ProgmemStringViews::DecodeMicros(),
+                                   entry_.decode_micros);
+    object_encoder.AddUIntProperty(ProgmemStringViews::HandleMicros(),
+                                   entry_.handle_micros);
+  }
+
+ private:
+  const RequestJournalEntry& entry_;
+};
+
+// Generate the elements of the array that is the value of the Value property.
+class RequestJournalValue : public mcucore::JsonElementSource {
+ public:
+  explicit RequestJournalValue(const RequestJournal& journal)
+      : journal_(journal) {}
+
+  void AddTo(mcucore::JsonArrayEncoder& array_encoder) const override {
+    for (uint8_t ndx = 0; ndx < journal_.size(); ++ndx) {
+      RequestJournalEntrySource source(journal_.entry(ndx));
+      array_encoder.AddObjectElement(source);
+    }
+  }
+
+ private:
+  const RequestJournal& journal_;
+};
+
+}  // namespace
+
+EHttpStatusCode ResponseOutcome::http_status_ = EHttpStatusCode::kHttpOk;
+uint32_t ResponseOutcome::error_number_ = 0;
+
+void RequestJournal::Record(const AlpacaRequest& request,
+                            EHttpStatusCode http_status, uint32_t error_number,
+                            const RequestTimings& timings) {
+  RequestJournalEntry& entry = entries_[next_ndx_];
+  entry.server_transaction_id = request.server_transaction_id;
+  entry.client_transaction_id = request.have_client_transaction_id
+                                    ? request.client_transaction_id
+                                    : 0;
+  entry.decode_micros = timings.decode_micros;
+  entry.handle_micros = timings.handle_micros + timings.write_micros;
+  entry.http_status = static_cast<uint16_t>(http_status);
+  entry.error_number = static_cast<uint16_t>(error_number);
+  entry.api = request.api;
+  entry.device_type = request.device_type;
+  entry.device_method = request.device_method;
+  entry.device_number =
+      request.device_number > 255 ? 255 : request.device_number;
+  if (++next_ndx_ == kSize) {
+    next_ndx_ = 0;
+  }
+  if (size_ < kSize) {
+    ++size_;
+  }
+}
+
+const RequestJournalEntry& RequestJournal::entry(uint8_t ndx) const {
+  MCU_DCHECK_LT(ndx, size_);
+  if (size_ < kSize) {
+    return entries_[ndx];
+  }
+  // The journal is full, so the oldest entry is the next to be overwritten.
+  uint16_t actual_ndx = ndx + next_ndx_;
+  if (actual_ndx >= kSize) {
+    actual_ndx -= kSize;
+  }
+  return entries_[actual_ndx];
+}
+
+void RequestJournalResponse::AddTo(
+    mcucore::JsonObjectEncoder& object_encoder) const {
+  // Add the Value property first.
+  RequestJournalValue value(journal_);
+  object_encoder.AddArrayProperty(ProgmemStringViews::Value(), value);
+
+  // Then the remaining fields.
+  JsonMethodResponse::AddTo(object_encoder);
+}
+
+}  // namespace alpaca
@@ -0,0 +1,111 @@
+#ifndef TINY_ALPACA_SERVER_SRC_REQUEST_JOURNAL_H_
+#define TINY_ALPACA_SERVER_SRC_REQUEST_JOURNAL_H_
+
+// RequestJournal is a circular journal of the most recent requests handled by
+// the server, so that when a client reports that a command failed, the
+// client's ClientTransactionID (or the ServerTransactionID in the response) can
+// be used to find out what the server did with it: the device and method, the
+// status of the response, the ASCOM error number (if any), and how long the
+// request took to decode and to handle. TinyAlpacaDeviceServer serves the
+// journal at /management/v1/requestjournal.
+//
+// Entries are fixed size and are simply copied into place, so recording a
+// request takes only a few microseconds.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "alpaca_request.h"
+#include "config.h"
+#include "constants.h"
+#include "json_response.h"
+#include "server_metrics.h"
+
+namespace alpaca {
+
+// The outcome of the most recently written response, other than its body.
+// This is recorded by the WriteResponse methods that write error responses, and
+// read by TinyAlpacaDeviceServer once the request has been handled, which
+// avoids having to return it through all of the request handlers.
+class ResponseOutcome {
+ public:
+  // Called before the response to a request is written.
+  static void Reset() {
+    http_status_ = EHttpStatusCode::kHttpOk;
+    error_number_ = 0;
+  }
+
+  static void RecordHttpError(EHttpStatusCode status) { http_status_ = status; }
+  static void RecordAscomError(uint32_t error_number) {
+    error_number_ = error_number;
+  }
+
+  static EHttpStatusCode http_status() { return http_status_; }
+  static uint32_t error_number() { return error_number_; }
+
+ private:
+  static EHttpStatusCode http_status_;
+  static uint32_t error_number_;
+};
+
+struct RequestJournalEntry {
+  uint32_t server_transaction_id;
+  uint32_t client_transaction_id;  // Zero if not provided by the client.
+  uint32_t decode_micros;
+  uint32_t handle_micros;  // Including writing all of the response.
+  uint16_t http_status;
+  uint16_t error_number;  // ASCOM error numbers are less than 0x1000.
+  EAlpacaApi api;
+  EDeviceType device_type;
+  EDeviceMethod device_method;
+  uint8_t device_number;  // Saturates at 255.
+};
+
+class RequestJournal {
+ public:
+  static constexpr uint8_t kSize = TAS_REQUEST_JOURNAL_SIZE;
+
+  RequestJournal() { Reset(); }
+
+  void Reset() {
+    next_ndx_ = 0;
+    size_ = 0;
+  }
+
+  // Records a request that has been handled, overwriting the oldest entry if
+  // the journal is full.
+  void Record(const AlpacaRequest& request, EHttpStatusCode http_status,
+              uint32_t error_number, const RequestTimings& timings);
+
+  // Returns the number of entries in the journal.
+  uint8_t size() const { return size_; }
+
+  // Returns the ndx-th oldest entry in the journal; ndx must be less than
+  // size().
+  const RequestJournalEntry& entry(uint8_t ndx) const;
+
+ private:
+  RequestJournalEntry entries_[kSize];
+  uint8_t next_ndx_;
+  uint8_t size_;
+};
+
+// Generates the JSON body for "/management/v1/requestjournal" requests, i.e. an
+// Alpaca response whose Value is an array of the journal's entries, oldest
+// first.
+class RequestJournalResponse : public JsonMethodResponse {
+ public:
+  RequestJournalResponse(const AlpacaRequest& request,
+                         const RequestJournal& journal)
+      : JsonMethodResponse(request), journal_(journal) {}
+
+  void AddTo(mcucore::JsonObjectEncoder& object_encoder) const override;
+
+ private:
+  const RequestJournal& journal_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_REQUEST_JOURNAL_H_
@@ -0,0 +1,57 @@
+#include "request_lanes.h"
+
+#include <McuCore.h>
+
+#include "constants.h"
+
+namespace alpaca {
+
+ERequestLane ClassifyRequest(const AlpacaRequest& request) {
+  switch (request.api) {
+    case EAlpacaApi::kUnknown:
+      // Not yet decoded.
+      return ERequestLane::kNormal;
+
+    case EAlpacaApi::kDeviceApi:
+      break;
+
+    case EAlpacaApi::kServerMetrics:
+      // Monitoring should be able to see that the server is overloaded.
+      return ERequestLane::kNormal;
+
+    case EAlpacaApi::kDeviceSetup:
+    case EAlpacaApi::kManagementApiVersions:
+    case EAlpacaApi::kManagementDescription:
+    case EAlpacaApi::kManagementConfiguredDevices:
+    case EAlpacaApi::kManagementRequestJournal:
+    case EAlpacaApi::kAsset:
+    case EAlpacaApi::kServerSetup:
+    case EAlpacaApi::kServerStatus:
+      return ERequestLane::kLow;
+  }
+
+  if (request.http_method == EHttpMethod::PUT) {
+    switch (request.device_method) {
+      case EDeviceMethod::kCalibratorOff:
+      case EDeviceMethod::kCloseCover:
+      case EDeviceMethod::kHaltCover:
+        return ERequestLane::kPriority;
+      default:
+        return ERequestLane::kNormal;
+    }
+  }
+
+  switch (request.device_method) {
+    case EDeviceMethod::kDescription:
+    case EDeviceMethod::kDriverInfo:
+    case EDeviceMethod::kDriverVersion:
+    case EDeviceMethod::kInterfaceVersion:
+    case EDeviceMethod::kName:
+    case EDeviceMethod::kSupportedActions:
+      return ERequestLane::kLow;
+    default:
+      return ERequestLane::kNormal;
+  }
+}
+
+}  // namespace alpaca
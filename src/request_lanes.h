@@ -0,0 +1,78 @@
+#ifndef TINY_ALPACA_SERVER_SRC_REQUEST_LANES_H_
+#define TINY_ALPACA_SERVER_SRC_REQUEST_LANES_H_
+
+// Requests are assigned to one of three lanes: the priority lane, for requests
+// that must not wait behind others (e.g. an observatory's safety logic closing
+// a cover); the low lane, for requests that can be refused when the server is
+// overloaded (e.g. the status page and the setup pages); and the normal lane
+// for everything else. A connection with a request in the priority lane is
+// serviced first in the next pass over the connections, and, if
+// TAS_ENABLE_METRICS is non-zero, the latency of requests is recorded
+// separately for each lane and served at /metrics.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "alpaca_request.h"
+
+namespace alpaca {
+
+enum class ERequestLane : uint8_t {
+  kNormal = 0,
+  kPriority = 1,
+  kLow = 2,
+};
+
+constexpr uint8_t kNumRequestLanes = 3;
+
+// Returns the lane for the request, based on those fields that have been
+// decoded so far; request must have been Reset before decoding started. The
+// priority lane is for device API PUT requests whose methods make a device
+// safe, e.g. closecover and haltcover. The low lane is for the HTML pages, the
+// management API, and device API GET requests for static metadata (e.g.
+// driverinfo).
+ERequestLane ClassifyRequest(const AlpacaRequest& request);
+
+// Statistics about the time from the start of decoding a request until it has
+// been handled by the RequestListener (i.e. the response has been written, or
+// at least started or deferred, for responses written incrementally or parked).
+struct RequestLatencyStats {
+  void Reset() {
+    num_requests = 0;
+    total_micros = 0;
+    max_micros = 0;
+  }
+
+  void RecordRequest(uint32_t elapsed_micros) {
+    ++num_requests;
+    total_micros += elapsed_micros;
+    if (max_micros < elapsed_micros) {
+      max_micros = elapsed_micros;
+    }
+  }
+
+  // Adds the requests recorded in other to those recorded in this instance.
+  void Add(const RequestLatencyStats& other) {
+    num_requests += other.num_requests;
+    total_micros += other.total_micros;
+    if (max_micros < other.max_micros) {
+      max_micros = other.max_micros;
+    }
+  }
+
+  uint32_t mean_micros() const {
+    return num_requests == 0 ? 0 : total_micros / num_requests;
+  }
+
+  uint32_t num_requests;
+
+  // Total and maximum latency. The total will wrap around after about 71
+  // minutes of latency.
+  uint32_t total_micros;
+  uint32_t max_micros;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_REQUEST_LANES_H_
@@ -8,7 +8,11 @@
 #include <McuCore.h>
 
 #include "alpaca_request.h"
+#include "config.h"
 #include "constants.h"
+#include "event_stream_state.h"
+#include "response_cursor.h"
+#include "server_metrics.h"
 
 namespace alpaca {
 
@@ -26,6 +30,14 @@ class RequestListener {
   // requests from the client, false to disconnect.
   virtual bool OnRequestDecoded(AlpacaRequest& request, Print& out) = 0;
 
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+  // Called once for each successfully decoded request in the low lane (see
+  // request_lanes.h), before OnRequestDecoded. Return true if the server is too
+  // busy to handle the request, in which case ServerConnection responds with
+  // 503 Service Unavailable and OnRequestDecoded is not called.
+  virtual bool ShouldShedRequest(const AlpacaRequest& request) = 0;
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+
   // Called when decoding of a request has failed. 'out' should be used to write
   // an error response to the client. The connection to the client will be
   // closed after the response is returned.
@@ -35,6 +47,65 @@ class RequestListener {
   // Called when the connection is broken during *decoding* of a request. This
   // exists to allow for cleaning up any collected data (if necessary).
   virtual void OnRequestAborted(AlpacaRequest& request) = 0;
+
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  // Called once the response to a request has been written (or, for event
+  // streams, once OnRequestDecoded has returned), with status kHttpOk, or after
+  // OnRequestDecodingError with the error status. For a parked request, that
+  // is once OnParkedRequestCanWrite has written the response, and for a
+  // resumable response, once OnResumableResponseCanWrite has written the last
+  // part.
+  // Provides the time taken by each phase of handling the request.
+  virtual void OnRequestCompleted(const AlpacaRequest& request,
+                                  EHttpStatusCode status,
+                                  const RequestTimings& timings) = 0;
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+
+#if TAS_ENABLE_EVENT_STREAMS
+  // Called periodically for a connection whose request was for an event stream
+  // (i.e. EDeviceMethod::kEvents), and for which OnRequestDecoded returned
+  // true after writing the response header. 'out' should be used to write any
+  // events to the client, and 'state' may be used to track what has been sent.
+  // Return true to keep streaming, false to close the connection.
+  // NOTE: ServerConnection first calls this with a copy of 'state' in order to
+  // measure what would be written, and only calls it again with the real state
+  // if that fits in the socket's transmit buffer, so this must not have side
+  // effects other than on 'state'.
+  virtual bool OnEventStreamCanWrite(const AlpacaRequest& request,
+                                     EventStreamState& state, Print& out) = 0;
+
+  // Called when an event stream has ended, whether closed by the client or by
+  // the server.
+  virtual void OnEventStreamClosed(const AlpacaRequest& request) = 0;
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+  // Called periodically for a connection whose request was parked, i.e. for
+  // which OnRequestDecoded set request.is_parked and returned true without
+  // writing a response. When ready, the callee should write the response to
+  // 'out' and clear request.is_parked. The return value has the same meaning as
+  // for OnRequestDecoded.
+  virtual bool OnParkedRequestCanWrite(AlpacaRequest& request, Print& out) = 0;
+#endif  // TAS_ENABLE_LONG_POLL
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  // Called periodically for a connection whose request has a resumable
+  // response, i.e. for which OnRequestDecoded set
+  // request.has_resumable_response and returned without writing anything. The
+  // callee should write to 'out' the part of the response identified by
+  // 'cursor', then advance 'cursor' to the next part, or set
+  // cursor.is_complete if that was the last part. The connection is closed once
+  // the response is complete, so the response needn't have a Content-Length.
+  // NOTE: ServerConnection first calls this with a copy of 'cursor' in order to
+  // measure the part, and only calls it again with the real cursor if the part
+  // fits in the socket's transmit buffer (or is the first part written in the
+  // current pass), so this must not have side effects other than on 'cursor'.
+  // Parts should be small (e.g. a few hundred bytes), as a part that doesn't
+  // fit stalls the loop while it is written.
+  virtual void OnResumableResponseCanWrite(const AlpacaRequest& request,
+                                           ResponseCursor& cursor,
+                                           Print& out) = 0;
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
 };
 
 }  // namespace alpaca
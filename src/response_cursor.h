@@ -0,0 +1,37 @@
+#ifndef TINY_ALPACA_SERVER_SRC_RESPONSE_CURSOR_H_
+#define TINY_ALPACA_SERVER_SRC_RESPONSE_CURSOR_H_
+
+// ResponseCursor records how much of a resumable response (i.e. one which is
+// written in parts, over several calls to PerformIO) has been written. It is
+// owned by the ServerConnection writing the response, and is advanced by the
+// RequestListener as it writes each part, so the listener needn't store
+// anything per connection, nor produce any part of the response more than once.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+struct ResponseCursor {
+  void Reset() {
+    section = 0;
+    item = 0;
+    is_complete = false;
+  }
+
+  // The section of the response to be written next, with the meaning of each
+  // value defined by the producer of the response.
+  uint8_t section;
+
+  // The item within the section to be written next, e.g. the index of a device
+  // in a section with a part for each device.
+  uint8_t item;
+
+  // Set by the producer when the last part of the response has been written.
+  bool is_complete;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_RESPONSE_CURSOR_H_
@@ -3,20 +3,107 @@
 #include <McuCore.h>
 #include <McuNet.h>
 
+#include "alpaca_response.h"
 #include "constants.h"
 #include "literals.h"
 #include "request_listener.h"
+#include "trace_ring.h"
 
 #if MCU_HOST_TARGET
 #include <string.h>
 #endif
 
 namespace alpaca {
+namespace {
+
+#if TAS_ENABLE_EVENT_STREAMS || TAS_ENABLE_RESUMABLE_RESPONSES
+// Returns the number of bytes that can be written to the connection without
+// waiting for the client to acknowledge receipt of those already written,
+// limited to TAS_MAX_WRITE_BYTES_PER_PASS. Print::availableForWrite() returns
+// zero if not overridden, so zero is treated as unknown rather than as full.
+size_t WriteBudget(Print& out) {
+  const int available = out.availableForWrite();
+  if (available <= 0) {
+    return TAS_WRITE_BYTES_IF_SPACE_UNKNOWN;
+  } else if (available > TAS_MAX_WRITE_BYTES_PER_PASS) {
+    return TAS_MAX_WRITE_BYTES_PER_PASS;
+  }
+  return available;
+}
+#endif  // TAS_ENABLE_EVENT_STREAMS || TAS_ENABLE_RESUMABLE_RESPONSES
+
+#if TAS_ENABLE_EVENT_STREAMS
+// Has the RequestListener write to an event stream using a copy of the state
+// of the stream, so that the size of what it would write can be measured
+// without changing that state.
+class EventStreamProbe : public Printable {
+ public:
+  EventStreamProbe(RequestListener& request_listener,
+                   const AlpacaRequest& request, const EventStreamState& state)
+      : request_listener_(request_listener), request_(request), state_(state) {}
+
+  size_t printTo(Print& out) const override {
+    EventStreamState state = state_;
+    mcucore::CountingPrint counter(out);
+    request_listener_.OnEventStreamCanWrite(request_, state, counter);
+    return counter.count();
+  }
+
+ private:
+  RequestListener& request_listener_;
+  const AlpacaRequest& request_;
+  const EventStreamState& state_;
+};
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+// Has the RequestListener write the next part of a resumable response using a
+// copy of the cursor, so that the size of the part can be measured without
+// advancing the cursor.
+class ResumableResponseProbe : public Printable {
+ public:
+  ResumableResponseProbe(RequestListener& request_listener,
+                         const AlpacaRequest& request,
+                         const ResponseCursor& cursor)
+      : request_listener_(request_listener),
+        request_(request),
+        cursor_(cursor) {}
+
+  size_t printTo(Print& out) const override {
+    ResponseCursor cursor = cursor_;
+    mcucore::CountingPrint counter(out);
+    request_listener_.OnResumableResponseCanWrite(request_, cursor, counter);
+    return counter.count();
+  }
+
+ private:
+  RequestListener& request_listener_;
+  const AlpacaRequest& request_;
+  const ResponseCursor& cursor_;
+};
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+
+}  // namespace
 
 ServerConnection::ServerConnection(RequestListener& request_listener)
     : request_listener_(request_listener),
       request_decoder_(request_),
+#if TAS_ENABLE_CONNECTION_DEADLINES
+      deadlines_(TAS_CONNECTION_IDLE_TIMEOUT_MS, TAS_REQUEST_TIMEOUT_MS),
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
       sock_num_(MAX_SOCK_NUM) {
+#if TAS_ENABLE_EVENT_STREAMS
+  is_event_stream_ = false;
+#endif  // TAS_ENABLE_EVENT_STREAMS
+#if TAS_ENABLE_PRIORITY_LANES
+  default_lane_ = ERequestLane::kNormal;
+  lane_ = ERequestLane::kNormal;
+#endif  // TAS_ENABLE_PRIORITY_LANES
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+  for (auto& stats : latency_stats_) {
+    stats.Reset();
+  }
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
   MCU_VLOG(4) << MCU_PSD("ServerConnection @ ") << this << MCU_PSD(" ctor");
 }
 
@@ -25,9 +112,19 @@ void ServerConnection::OnConnect(mcunet::Connection& connection) {
               << MCU_PSD(" ->::OnConnect ") << connection.sock_num();
   MCU_DCHECK(!has_socket());
   sock_num_ = connection.sock_num();
+  TAS_TRACE(kConnect, sock_num_, 0);
   request_decoder_.Reset();
   between_requests_ = true;
   input_buffer_size_ = 0;
+#if TAS_ENABLE_EVENT_STREAMS
+  is_event_stream_ = false;
+#endif  // TAS_ENABLE_EVENT_STREAMS
+#if TAS_ENABLE_CONNECTION_DEADLINES
+  deadlines_.Reset(millis());
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+#if TAS_ENABLE_PRIORITY_LANES
+  lane_ = default_lane_;
+#endif  // TAS_ENABLE_PRIORITY_LANES
 }
 
 void ServerConnection::OnCanRead(mcunet::Connection& connection) {
@@ -35,6 +132,35 @@ void ServerConnection::OnCanRead(mcunet::Connection& connection) {
               << MCU_PSD(" ->::OnCanRead ") << MCU_PSD("socket ")
               << connection.sock_num();
   MCU_DCHECK_EQ(sock_num(), connection.sock_num());
+#if TAS_ENABLE_CONNECTION_DEADLINES
+  if (EnforceDeadlines(millis(), connection)) {
+    return;
+  }
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+#if TAS_ENABLE_EVENT_STREAMS
+  if (is_event_stream_) {
+    // The client isn't expected to send anything more, so discard any input.
+    connection.read(reinterpret_cast<uint8_t*>(input_buffer_),
+                    sizeof input_buffer_);
+    PerformEventStreamIO(connection);
+    return;
+  }
+#endif  // TAS_ENABLE_EVENT_STREAMS
+#if TAS_ENABLE_LONG_POLL
+  if (request_.is_parked) {
+    // Leave any further input (i.e. another request) in the socket until the
+    // response to the parked request has been written.
+    PerformParkedRequestIO(connection);
+    return;
+  }
+#endif  // TAS_ENABLE_LONG_POLL
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  if (request_.has_resumable_response) {
+    // Likewise, leave any further input until the response has been written.
+    WriteResumableResponse(connection);
+    return;
+  }
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
   MCU_DCHECK(request_decoder_.status() == RequestDecoderStatus::kReset ||
              request_decoder_.status() == RequestDecoderStatus::kDecoding);
   // Load input_buffer_ with as much data as will fit.
@@ -45,6 +171,9 @@ void ServerConnection::OnCanRead(mcunet::Connection& connection) {
     if (ret > 0) {
       input_buffer_size_ += ret;
       between_requests_ = false;
+#if TAS_ENABLE_CONNECTION_DEADLINES
+      deadlines_.RecordActivity(millis());
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
     }
   }
 
@@ -52,6 +181,15 @@ void ServerConnection::OnCanRead(mcunet::Connection& connection) {
   if (input_buffer_size_ > 0) {
     if (request_decoder_.status() == RequestDecoderStatus::kReset) {
       request_listener_.OnStartDecoding(request_);
+#if TAS_ENABLE_CONNECTION_DEADLINES
+      deadlines_.StartRequest(millis());
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+#if TAS_ENABLE_PRIORITY_LANES
+      lane_ = default_lane_;
+#endif  // TAS_ENABLE_PRIORITY_LANES
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+      request_start_micros_ = micros();
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
     }
 
     mcucore::StringView view(input_buffer_, input_buffer_size_);
@@ -76,11 +214,29 @@ void ServerConnection::OnCanRead(mcunet::Connection& connection) {
       }
     }
 
+#if TAS_ENABLE_PRIORITY_LANES
+    // Classify the request as soon as the path has been decoded, so that if
+    // the rest of the request hasn't arrived yet, this connection can be
+    // serviced first in the next pass.
+    if (lane_ == ERequestLane::kNormal) {
+      lane_ = ClassifyRequest(request_);
+    }
+#endif  // TAS_ENABLE_PRIORITY_LANES
+
     // Are we done decoding?
     if (status_code < EHttpStatusCode::kHttpOk) {
       // No.
       return;
     }
+    TAS_TRACE(kDecoded, sock_num_, status_code);
+#if TAS_ENABLE_CONNECTION_DEADLINES
+    deadlines_.EndRequest();
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+    const uint32_t decoded_micros = micros();
+    timings_.decode_micros = decoded_micros - request_start_micros_;
+    timings_.write_micros = 0;
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
 
     bool close_connection = false;
     if (status_code == EHttpStatusCode::kHttpOk) {
@@ -90,8 +246,64 @@ void ServerConnection::OnCanRead(mcunet::Connection& connection) {
       if (input_buffer_size_ == 0) {
         between_requests_ = true;
       }
-      if (!request_listener_.OnRequestDecoded(request_, connection)) {
+      const bool keep_open = DispatchRequest(connection);
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+      RecordRequestLatency();
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+      handled_micros_ = micros();
+      timings_.handle_micros = handled_micros_ - decoded_micros;
+      bool response_complete = true;
+#if TAS_ENABLE_LONG_POLL
+      // If not, PerformParkedRequestIO reports it once the response is written.
+      response_complete = !request_.is_parked;
+#endif  // TAS_ENABLE_LONG_POLL
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+      // Likewise WriteResumableResponse, once the response is complete.
+      response_complete =
+          response_complete && !request_.has_resumable_response;
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+      if (response_complete) {
+        request_listener_.OnRequestCompleted(request_, status_code, timings_);
+      }
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+      if (request_.has_resumable_response) {
+        // The listener writes the response in parts, from
+        // WriteResumableResponse, which needs request_ to do so.
+        MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
+                    << MCU_PSD(" ->::OnCanRead ")
+                    << MCU_PSD("writing resumable response");
+        response_cursor_.Reset();
+        WriteResumableResponse(connection);
+        return;
+      }
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+      if (!keep_open) {
         close_connection = true;
+#if TAS_ENABLE_EVENT_STREAMS
+      } else if (request_.api == EAlpacaApi::kDeviceApi &&
+                 request_.device_method == EDeviceMethod::kEvents) {
+        // The listener has written the header of the event stream response.
+        // From here on request_ identifies the device whose events are to be
+        // streamed, so we don't reset the decoder (and hence request_).
+        MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
+                    << MCU_PSD(" ->::OnCanRead ")
+                    << MCU_PSD("starting event stream");
+        TAS_TRACE(kEventStreamStart, sock_num_, 0);
+        is_event_stream_ = true;
+        event_stream_state_.Reset();
+        return;
+#endif  // TAS_ENABLE_EVENT_STREAMS
+#if TAS_ENABLE_LONG_POLL
+      } else if (request_.is_parked) {
+        // The listener will write the response later, from
+        // PerformParkedRequestIO, so we mustn't reset request_ yet.
+        MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
+                    << MCU_PSD(" ->::OnCanRead ") << MCU_PSD("request parked");
+        TAS_TRACE(kRequestParked, sock_num_, 0);
+        return;
+#endif  // TAS_ENABLE_LONG_POLL
       }
     } else {
       MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
@@ -99,6 +311,13 @@ void ServerConnection::OnCanRead(mcunet::Connection& connection) {
                   << status_code;
       request_listener_.OnRequestDecodingError(request_, status_code,
                                                connection);
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+      RecordRequestLatency();
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+      timings_.handle_micros = micros() - decoded_micros;
+      request_listener_.OnRequestCompleted(request_, status_code, timings_);
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
       close_connection = true;
     }
 
@@ -108,6 +327,7 @@ void ServerConnection::OnCanRead(mcunet::Connection& connection) {
       MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
                   << MCU_PSD(" ->::OnCanRead ")
                   << MCU_PSD("closing connection");
+      TAS_TRACE(kCloseConnection, sock_num_, status_code);
 
       connection.close();
       sock_num_ = MAX_SOCK_NUM;
@@ -118,16 +338,190 @@ void ServerConnection::OnCanRead(mcunet::Connection& connection) {
   }
 }
 
+bool ServerConnection::DispatchRequest(Print& out) {
+  TAS_TRACE(kDispatch, request_.api, request_.device_method);
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+  // The lane is final once the request has been decoded. Requests received on
+  // the priority port stay in the priority lane, so are never shed.
+  if (lane_ == ERequestLane::kLow &&
+      request_listener_.ShouldShedRequest(request_)) {
+    MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
+                << MCU_PSD(" ->::DispatchRequest ")
+                << MCU_PSD("shedding request");
+    return WriteResponse::ServiceUnavailableResponse(
+        TAS_OVERLOAD_RETRY_AFTER_SECONDS, out);
+  }
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+  return request_listener_.OnRequestDecoded(request_, out);
+}
+
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+void ServerConnection::RecordRequestLatency() {
+  latency_stats_[static_cast<uint8_t>(lane_)].RecordRequest(
+      micros() - request_start_micros_);
+}
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+
 void ServerConnection::OnDisconnect() {
   MCU_VLOG(2) << MCU_PSD("ServerConnection @ ") << this
               << MCU_PSD(" ->::OnDisconnect,") << MCU_NAME_VAL(sock_num_)
               << MCU_NAME_VAL(between_requests_);
   MCU_DCHECK(has_socket());
+  TAS_TRACE(kDisconnect, sock_num_, 0);
+#if TAS_ENABLE_EVENT_STREAMS
+  if (is_event_stream_) {
+    EndEventStream();
+  } else if (!between_requests_) {
+#else
   if (!between_requests_) {
+#endif  // TAS_ENABLE_EVENT_STREAMS
     // We've read some data but haven't been able to decode a complete request.
     request_listener_.OnRequestAborted(request_);
   }
   sock_num_ = MAX_SOCK_NUM;
 }
 
+#if TAS_ENABLE_EVENT_STREAMS
+void ServerConnection::PerformEventStreamIO(mcunet::Connection& connection) {
+  // Writing more than the socket can accept would stall the loop until the
+  // client acknowledged the excess, so first measure what would be written.
+  const size_t size = mcucore::SizeOfPrintable(
+      EventStreamProbe(request_listener_, request_, event_stream_state_));
+  if (size > WriteBudget(connection)) {
+    if (size <= TAS_MAX_WRITE_BYTES_PER_PASS) {
+      // Try again once the client has acknowledged more of the stream.
+      return;
+    }
+    MCU_VLOG(2) << MCU_PSD("ServerConnection @ ") << this
+                << MCU_PSD(" ->::PerformEventStreamIO ")
+                << MCU_PSD("event too large: ") << size;
+  } else if (request_listener_.OnEventStreamCanWrite(
+                 request_, event_stream_state_, connection)) {
+    return;
+  }
+  MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
+              << MCU_PSD(" ->::PerformEventStreamIO ")
+              << MCU_PSD("closing connection");
+  EndEventStream();
+  connection.close();
+  sock_num_ = MAX_SOCK_NUM;
+}
+
+void ServerConnection::EndEventStream() {
+  MCU_DCHECK(is_event_stream_);
+  is_event_stream_ = false;
+  request_listener_.OnEventStreamClosed(request_);
+}
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+void ServerConnection::PerformParkedRequestIO(mcunet::Connection& connection) {
+  const bool keep_open =
+      request_listener_.OnParkedRequestCanWrite(request_, connection);
+  if (keep_open && request_.is_parked) {
+    // Still waiting for the value to change.
+    return;
+  }
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  timings_.write_micros = micros() - handled_micros_;
+  request_listener_.OnRequestCompleted(request_, EHttpStatusCode::kHttpOk,
+                                       timings_);
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  if (!keep_open) {
+    MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
+                << MCU_PSD(" ->::PerformParkedRequestIO ")
+                << MCU_PSD("closing connection");
+    connection.close();
+    sock_num_ = MAX_SOCK_NUM;
+  } else {
+    // The response has been written, so prepare the decoder for the next
+    // request.
+    request_decoder_.Reset();
+  }
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+void ServerConnection::WriteResumableResponse(mcunet::Connection& connection) {
+  size_t budget = WriteBudget(connection);
+  size_t written = 0;
+  while (budget > 0 && !response_cursor_.is_complete) {
+    // The first part written in a pass is written even if it doesn't fit, as
+    // it might be larger than the transmit buffer; otherwise parts are only
+    // written if they fit, as writing more than the socket can accept would
+    // stall the loop until the client acknowledged the excess.
+    if (written > 0 &&
+        mcucore::SizeOfPrintable(ResumableResponseProbe(
+            request_listener_, request_, response_cursor_)) > budget) {
+      break;
+    }
+    mcucore::CountingPrint counter(connection);
+    request_listener_.OnResumableResponseCanWrite(request_, response_cursor_,
+                                                  counter);
+    written += counter.count();
+    budget = counter.count() < budget ? budget - counter.count() : 0;
+  }
+#if TAS_ENABLE_CONNECTION_DEADLINES
+  if (written > 0) {
+    deadlines_.RecordActivity(millis());
+  }
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+  if (!response_cursor_.is_complete) {
+    if (written > 0) {
+      TAS_TRACE(kResponseIncomplete, sock_num_, written);
+    }
+    return;
+  }
+  TAS_TRACE(kResponseComplete, sock_num_, written);
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  timings_.write_micros = micros() - handled_micros_;
+  request_listener_.OnRequestCompleted(request_, EHttpStatusCode::kHttpOk,
+                                       timings_);
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  // The response has no Content-Length, so the client relies on the connection
+  // being closed to find the end of it.
+  MCU_VLOG(3) << MCU_PSD("ServerConnection @ ") << this
+              << MCU_PSD(" ->::WriteResumableResponse ")
+              << MCU_PSD("closing connection");
+  connection.close();
+  sock_num_ = MAX_SOCK_NUM;
+}
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+
+#if TAS_ENABLE_CONNECTION_DEADLINES
+bool ServerConnection::EnforceDeadlines(uint32_t now_ms,
+                                        mcunet::Connection& connection) {
+#if TAS_ENABLE_EVENT_STREAMS
+  if (is_event_stream_) {
+    // Event streams have their own keepalive, so don't need a deadline.
+    deadlines_.RecordActivity(now_ms);
+    return false;
+  }
+#endif  // TAS_ENABLE_EVENT_STREAMS
+#if TAS_ENABLE_LONG_POLL
+  if (request_.is_parked) {
+    // Likewise, a parked request is limited by its WaitForChangeMs parameter.
+    deadlines_.RecordActivity(now_ms);
+    return false;
+  }
+#endif  // TAS_ENABLE_LONG_POLL
+  const EConnectionDeadline deadline = deadlines_.Check(now_ms);
+  if (deadline == EConnectionDeadline::kNone) {
+    return false;
+  }
+  MCU_VLOG(2) << MCU_PSD("ServerConnection @ ") << this
+              << MCU_PSD(" ->::EnforceDeadlines ")
+              << MCU_PSD("closing connection, deadline ")
+              << static_cast<int>(deadline) << MCU_PSD(" passed");
+  TAS_TRACE(kDeadlineExpired, sock_num_, deadline);
+  deadlines_.RecordExpiration(deadline);
+  if (!between_requests_) {
+    request_listener_.OnRequestAborted(request_);
+  }
+  connection.close();
+  sock_num_ = MAX_SOCK_NUM;
+  return true;
+}
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+
 }  // namespace alpaca
@@ -14,8 +14,13 @@
 
 #include "alpaca_request.h"
 #include "config.h"
+#include "connection_deadlines.h"
+#include "event_stream_state.h"
 #include "request_decoder.h"
+#include "request_lanes.h"
 #include "request_listener.h"
+#include "response_cursor.h"
+#include "server_metrics.h"
 
 namespace alpaca {
 
@@ -33,14 +38,111 @@ class ServerConnection : public mcunet::ServerSocketListener {
   void OnCanRead(mcunet::Connection& connection) override;
   void OnDisconnect() override;
 
+#if TAS_ENABLE_EVENT_STREAMS
+  // True if the connection is being used for a Server-Sent Events stream, in
+  // which case requests are no longer decoded from it.
+  bool is_event_stream() const { return is_event_stream_; }
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_CONNECTION_DEADLINES
+  const ConnectionDeadlines& deadlines() const { return deadlines_; }
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+
+#if TAS_ENABLE_PRIORITY_LANES
+  // Sets the lane of all requests received on this connection, unless
+  // ClassifyRequest places a request in another lane.
+  void set_default_lane(ERequestLane lane) { default_lane_ = lane; }
+
+  // Returns true if the request being decoded is in the priority lane.
+  bool has_priority_request() const {
+    return has_socket() && lane_ == ERequestLane::kPriority &&
+           request_decoder_.status() == RequestDecoderStatus::kDecoding;
+  }
+
+#endif  // TAS_ENABLE_PRIORITY_LANES
+
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+  const RequestLatencyStats& latency_stats(ERequestLane lane) const {
+    return latency_stats_[static_cast<uint8_t>(lane)];
+  }
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+
  private:
+  // Delivers request_ to the RequestListener so that it can write a response
+  // to out. Returns false if the connection should be closed.
+  bool DispatchRequest(Print& out);
+
+#if TAS_ENABLE_CONNECTION_DEADLINES
+  // Closes the connection if the client has been idle for too long, or has
+  // taken too long to send the current request. Returns true if it did so.
+  // Called at the start of each OnCanRead, which ServerSocket calls on each
+  // PerformIO while the connection is open, whether or not there is input.
+  bool EnforceDeadlines(uint32_t now_ms, mcunet::Connection& connection);
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+  // Records the latency of the current request in the stats for its lane.
+  void RecordRequestLatency();
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  // The current request has a resumable response, so has the RequestListener
+  // write the next parts of it, as many as fit in the space available in the
+  // socket's transmit buffer. Once the response is complete, reports that and
+  // closes the connection.
+  void WriteResumableResponse(mcunet::Connection& connection);
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+
+#if TAS_ENABLE_LONG_POLL
+  // The current request is parked (i.e. its response is being delayed until
+  // the value changes), so gives the RequestListener a chance to write the
+  // response. Once it has, reports the completion of the request, and either
+  // closes the connection or prepares to decode the next request.
+  void PerformParkedRequestIO(mcunet::Connection& connection);
+#endif  // TAS_ENABLE_LONG_POLL
+
+#if TAS_ENABLE_EVENT_STREAMS
+  // Gives the RequestListener a chance to write events to the client, if they
+  // fit in the space available in the socket's transmit buffer; if not, they
+  // are left for a later call, when the client has acknowledged more of the
+  // earlier events. Closes the connection if the listener asks for that.
+  void PerformEventStreamIO(mcunet::Connection& connection);
+
+  // Ends the event stream, and notifies the RequestListener.
+  void EndEventStream();
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
   RequestListener& request_listener_;
   AlpacaRequest request_;
   RequestDecoder request_decoder_;
+#if TAS_ENABLE_CONNECTION_DEADLINES
+  ConnectionDeadlines deadlines_;
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
   uint8_t sock_num_;
   bool between_requests_;
   uint8_t input_buffer_size_;
   char input_buffer_[SERVER_CONNECTION_INPUT_BUFFER_SIZE];
+#if TAS_ENABLE_EVENT_STREAMS
+  bool is_event_stream_;
+  EventStreamState event_stream_state_;
+#endif  // TAS_ENABLE_EVENT_STREAMS
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  ResponseCursor response_cursor_;
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+#if TAS_ENABLE_PRIORITY_LANES
+  ERequestLane default_lane_;
+  ERequestLane lane_;  // Of the current request.
+#endif  // TAS_ENABLE_PRIORITY_LANES
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+  RequestLatencyStats latency_stats_[kNumRequestLanes];
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  uint32_t request_start_micros_;
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  RequestTimings timings_;  // Of the current request.
+  uint32_t handled_micros_;  // When the listener finished handling it.
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
 };
 
 }  // namespace alpaca
@@ -9,6 +9,11 @@ mcucore::Status ServerContext::Initialize() { return Initialize(EEPROM); }
 mcucore::Status ServerContext::Initialize(EEPROMClass& eeprom) {
   status_or_eeprom_tlv_ = mcucore::EepromTlv::Get(eeprom);
   MCU_VLOG_IF_ERROR(1, status_or_eeprom_tlv_.status());
+#if TAS_ENABLE_SETTINGS_JOURNAL
+  if (status_or_eeprom_tlv_.ok()) {
+    MCU_VLOG_IF_ERROR(1, settings_.Load(status_or_eeprom_tlv_.value()));
+  }
+#endif  // TAS_ENABLE_SETTINGS_JOURNAL
   return status_or_eeprom_tlv_.status();
 }
 
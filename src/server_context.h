@@ -7,6 +7,9 @@
 
 #include <McuCore.h>
 
+#include "config.h"
+#include "settings_journal.h"
+
 namespace alpaca {
 
 class ServerContext {
@@ -15,7 +18,8 @@ class ServerContext {
   ServerContext(const ServerContext&) = delete;
 
   // Initialize using the default EEPROM instance. Returns an error if unable
-  // to initialize all features (so far just EepromTlv).
+  // to initialize all features (so far just EepromTlv); a failure to load the
+  // settings is logged, but isn't an error.
   mcucore::Status Initialize();
 
   // As above, but using the specified EEPROM instance. This variant exists to
@@ -27,8 +31,19 @@ class ServerContext {
   // OK, else it will crash.
   mcucore::EepromTlv& eeprom_tlv();
 
+#if TAS_ENABLE_SETTINGS_JOURNAL
+  // The settings which the user has changed at runtime (e.g. device names),
+  // loaded from EEPROM by Initialize. Changes are written to EEPROM by
+  // TinyAlpacaDeviceServer::MaintainDevices.
+  SettingsJournal& settings() { return settings_; }
+  const SettingsJournal& settings() const { return settings_; }
+#endif  // TAS_ENABLE_SETTINGS_JOURNAL
+
  private:
   mcucore::StatusOr<mcucore::EepromTlv> status_or_eeprom_tlv_;
+#if TAS_ENABLE_SETTINGS_JOURNAL
+  SettingsJournal settings_;
+#endif  // TAS_ENABLE_SETTINGS_JOURNAL
 };
 
 }  // namespace alpaca
@@ -8,13 +8,20 @@ namespace alpaca {
 
 void ServerDescription::AddTo(
     mcucore::JsonObjectEncoder& object_encoder) const {
+  AddTo(object_encoder, mcucore::AnyPrintable(location));
+}
+
+void ServerDescription::AddTo(
+    mcucore::JsonObjectEncoder& object_encoder,
+    const mcucore::AnyPrintable& location_override) const {
   object_encoder.AddStringProperty(ProgmemStringViews::ServerName(),
                                    server_name);
   object_encoder.AddStringProperty(ProgmemStringViews::Manufacturer(),
                                    manufacturer);
   object_encoder.AddStringProperty(ProgmemStringViews::ManufacturerVersion(),
                                    manufacturer_version);
-  object_encoder.AddStringProperty(ProgmemStringViews::Location(), location);
+  object_encoder.AddStringProperty(ProgmemStringViews::Location(),
+                                   location_override);
 }
 
 }  // namespace alpaca
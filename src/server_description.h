@@ -20,6 +20,11 @@ struct ServerDescription {
   // outermost object that is the body of the response to /man
   void AddTo(mcucore::JsonObjectEncoder& object_encoder) const;
 
+  // As above, but with the specified location in place of the location field,
+  // e.g. because the user has set the location at runtime.
+  void AddTo(mcucore::JsonObjectEncoder& object_encoder,
+             const mcucore::AnyPrintable& location_override) const;
+
   // The device or server's overall name.
   mcucore::ProgmemString server_name;
 
@@ -31,28 +36,6 @@ struct ServerDescription {
 
   // The device or server's location.
   mcucore::ProgmemString location;
-
-#if 0
-  // TODO(jamessynge): Implement support for recording the server's physical
-  // location (e.g. the Lat-Long of the observatory) in EEPROM, and fetching it
-  // here. Ideas for the API:
-
-  // Returns the number of bytes used to store the saved location of the server.
-  // Returns 0 if it is not stored.
-  size_t StoredLocationSize() const;
-
-  // Fill buffer with the saved location of the server, if the buffer is large
-  // enough, returning the number of bytes copied. If buffer_size is not big
-  // enough, returns 0. If the value is not stored in EEPROM, 0 is returned.
-  size_t LoadLocation(uint8_t* buffer, size_t buffer_size) const;
-
-  // Store the location in eeprom. Definitely NOT the final API. I really need
-  // to build on my earlier EepromIO ideas:
-  // https://github.com/jamessynge/arduino_experiments/blob/master/utilities/eeprom_io.h
-  // In particular, the idea of having "Persistable" objects, similar to a
-  // Printable object (already a part of the Arduino API).
-  size_t SaveLocation(const mcucore::StringView& location) const;
-#endif
 };
 
 }  // namespace alpaca
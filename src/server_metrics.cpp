@@ -0,0 +1,203 @@
+#include "server_metrics.h"
+
+#include <McuCore.h>
+
+#include "constants.h"
+
+namespace alpaca {
+namespace {
+
+// Prints value followed by a newline; the exposition format requires '\n'
+// rather than the "\r\n" printed by Print::println.
+size_t PrintValueLine(uint32_t value, Print& out) {
+  size_t count = out.print(value);
+  count += out.print('\n');
+  return count;
+}
+
+// Prints the samples of one phase of the tas_request_micros histogram.
+size_t PrintHistogram(const __FlashStringHelper* phase,
+                      const Log2Histogram& histogram, Print& out) {
+  size_t count = 0;
+  uint32_t cumulative = 0;
+  for (uint8_t ndx = 0; ndx < Log2Histogram::kNumBuckets; ++ndx) {
+    cumulative += histogram.bucket_count(ndx);
+    count += out.print(MCU_FLASHSTR("tas_request_micros_bucket{phase=\""));
+    count += out.print(phase);
+    count += out.print(MCU_FLASHSTR("\",le=\""));
+    if (ndx + 1 < Log2Histogram::kNumBuckets) {
+      count += out.print(Log2Histogram::BucketUpperBound(ndx));
+    } else {
+      count += out.print(MCU_FLASHSTR("+Inf"));
+    }
+    count += out.print(MCU_FLASHSTR("\"} "));
+    count += PrintValueLine(cumulative, out);
+  }
+  count += out.print(MCU_FLASHSTR("tas_request_micros_sum{phase=\""));
+  count += out.print(phase);
+  count += out.print(MCU_FLASHSTR("\"} "));
+  count += PrintValueLine(histogram.sum_micros(), out);
+  count += out.print(MCU_FLASHSTR("tas_request_micros_count{phase=\""));
+  count += out.print(phase);
+  count += out.print(MCU_FLASHSTR("\"} "));
+  count += PrintValueLine(histogram.count(), out);
+  return count;
+}
+
+// Prints one sample of a counter with a single label, e.g.
+//     tas_requests_total{api="DeviceApi"} 123
+size_t PrintCounter(const __FlashStringHelper* name,
+                    const __FlashStringHelper* label_name,
+                    const __FlashStringHelper* label_value, uint32_t value,
+                    Print& out) {
+  size_t count = out.print(name);
+  count += out.print('{');
+  count += out.print(label_name);
+  count += out.print(MCU_FLASHSTR("=\""));
+  count += out.print(label_value);
+  count += out.print(MCU_FLASHSTR("\"} "));
+  count += PrintValueLine(value, out);
+  return count;
+}
+
+}  // namespace
+
+void Log2Histogram::Reset() {
+  for (auto& bucket_count : bucket_counts_) {
+    bucket_count = 0;
+  }
+  count_ = 0;
+  sum_micros_ = 0;
+}
+
+void Log2Histogram::Record(uint32_t micros) {
+  ++bucket_counts_[BucketIndex(micros)];
+  ++count_;
+  sum_micros_ += micros;
+}
+
+uint8_t Log2Histogram::BucketIndex(uint32_t micros) {
+  // Bucket i (for i > 0) holds durations in the range
+  // (kFirstBucketMicros << (i-1), kFirstBucketMicros << i], so the index is
+  // the number of bits needed to represent (micros-1) / kFirstBucketMicros.
+  if (micros <= kFirstBucketMicros) {
+    return 0;
+  }
+  uint32_t v = (micros - 1) / kFirstBucketMicros;
+  uint8_t ndx = 0;
+  while (v != 0 && ndx + 1 < kNumBuckets) {
+    v >>= 1;
+    ++ndx;
+  }
+  return ndx;
+}
+
+void ServerMetrics::Reset() {
+  decode_micros_.Reset();
+  handle_micros_.Reset();
+  write_micros_.Reset();
+  for (auto& api_count : api_counts_) {
+    api_count = 0;
+  }
+  for (auto& device_method_count : device_method_counts_) {
+    device_method_count = 0;
+  }
+  for (auto& entry : decoding_errors_) {
+    entry.status = EHttpStatusCode::kContinueDecoding;
+    entry.count = 0;
+  }
+  other_decoding_errors_ = 0;
+}
+
+void ServerMetrics::RecordRequest(const AlpacaRequest& request,
+                                  const RequestTimings& timings) {
+  decode_micros_.Record(timings.decode_micros);
+  handle_micros_.Record(timings.handle_micros);
+  write_micros_.Record(timings.write_micros);
+  const auto api_ndx = static_cast<uint8_t>(request.api);
+  if (api_ndx < kNumApis) {
+    ++api_counts_[api_ndx];
+  }
+  if (request.api == EAlpacaApi::kDeviceApi) {
+    const auto method_ndx = static_cast<uint8_t>(request.device_method);
+    if (method_ndx < kNumDeviceMethods) {
+      ++device_method_counts_[method_ndx];
+    }
+  }
+}
+
+void ServerMetrics::RecordDecodingError(EHttpStatusCode status,
+                                        const RequestTimings& timings) {
+  decode_micros_.Record(timings.decode_micros);
+  handle_micros_.Record(timings.handle_micros);
+  for (auto& entry : decoding_errors_) {
+    if (entry.count == 0) {
+      entry.status = status;
+    }
+    if (entry.status == status) {
+      ++entry.count;
+      return;
+    }
+  }
+  ++other_decoding_errors_;
+}
+
+uint32_t ServerMetrics::decoding_error_count(EHttpStatusCode status) const {
+  for (const auto& entry : decoding_errors_) {
+    if (entry.count > 0 && entry.status == status) {
+      return entry.count;
+    }
+  }
+  return 0;
+}
+
+size_t ServerMetrics::printTo(Print& out) const {
+  size_t count = 0;
+
+  count += out.print(MCU_FLASHSTR("# TYPE tas_request_micros histogram\n"));
+  count += PrintHistogram(MCU_FLASHSTR("decode"), decode_micros_, out);
+  count += PrintHistogram(MCU_FLASHSTR("handle"), handle_micros_, out);
+  count += PrintHistogram(MCU_FLASHSTR("write"), write_micros_, out);
+
+  count += out.print(MCU_FLASHSTR("# TYPE tas_requests_total counter\n"));
+  for (uint8_t ndx = 0; ndx < kNumApis; ++ndx) {
+    if (api_counts_[ndx] > 0) {
+      count += PrintCounter(MCU_FLASHSTR("tas_requests_total"),
+                            MCU_FLASHSTR("api"),
+                            ToFlashStringHelper(static_cast<EAlpacaApi>(ndx)),
+                            api_counts_[ndx], out);
+    }
+  }
+
+  count += out.print(
+      MCU_FLASHSTR("# TYPE tas_device_method_requests_total counter\n"));
+  for (uint8_t ndx = 0; ndx < kNumDeviceMethods; ++ndx) {
+    if (device_method_counts_[ndx] > 0) {
+      count += PrintCounter(
+          MCU_FLASHSTR("tas_device_method_requests_total"),
+          MCU_FLASHSTR("method"),
+          ToFlashStringHelper(static_cast<EDeviceMethod>(ndx)),
+          device_method_counts_[ndx], out);
+    }
+  }
+
+  count +=
+      out.print(MCU_FLASHSTR("# TYPE tas_decoding_errors_total counter\n"));
+  for (const auto& entry : decoding_errors_) {
+    if (entry.count > 0) {
+      count += out.print(MCU_FLASHSTR("tas_decoding_errors_total{code=\""));
+      count += out.print(static_cast<unsigned int>(entry.status));
+      count += out.print(MCU_FLASHSTR("\"} "));
+      count += PrintValueLine(entry.count, out);
+    }
+  }
+  if (other_decoding_errors_ > 0) {
+    count += PrintCounter(MCU_FLASHSTR("tas_decoding_errors_total"),
+                          MCU_FLASHSTR("code"), MCU_FLASHSTR("other"),
+                          other_decoding_errors_, out);
+  }
+
+  return count;
+}
+
+}  // namespace alpaca
@@ -0,0 +1,133 @@
+#ifndef TINY_ALPACA_SERVER_SRC_SERVER_METRICS_H_
+#define TINY_ALPACA_SERVER_SRC_SERVER_METRICS_H_
+
+// ServerMetrics collects low overhead instrumentation of the requests handled
+// by the server: histograms of the time taken to decode each request, to handle
+// it, and to write the remainder of its response; counts of requests per
+// EAlpacaApi and per EDeviceMethod; and counts of decoding errors per
+// EHttpStatusCode. TinyAlpacaDeviceServer serves these at /metrics, in the
+// Prometheus text exposition format, so that they can be scraped by existing
+// monitoring.
+//
+// Durations are recorded in microseconds, rather than the seconds preferred by
+// Prometheus, to avoid floating point formatting on the microcontroller; the
+// metric names end in _micros to make this clear.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "alpaca_request.h"
+#include "constants.h"
+
+namespace alpaca {
+
+// The time taken by each phase of handling a request, as measured by
+// ServerConnection.
+struct RequestTimings {
+  // From the start of decoding the request (i.e. when its first byte was
+  // available) until decoding was complete, including any time spent waiting
+  // for more of the request to arrive.
+  uint32_t decode_micros;
+
+  // Duration of the call to the RequestListener to handle the request (or the
+  // decoding error), which includes writing the response, except for the part
+  // of a resumable response that couldn't be written immediately.
+  uint32_t handle_micros;
+
+  // From the end of that call until the rest of a resumable response, or the
+  // response to a parked request, had been written; zero if the response was
+  // written entirely during handling.
+  uint32_t write_micros;
+};
+
+// A histogram of durations, with buckets whose upper bounds are powers of two.
+// Bucket i holds durations of at most (kFirstBucketMicros << i), except for
+// the last bucket, which holds all longer durations.
+class Log2Histogram {
+ public:
+  static constexpr uint8_t kNumBuckets = 16;
+  static constexpr uint32_t kFirstBucketMicros = 16;
+
+  Log2Histogram() { Reset(); }
+
+  void Reset();
+  void Record(uint32_t micros);
+
+  // Returns the index of the bucket that holds micros.
+  static uint8_t BucketIndex(uint32_t micros);
+
+  // Returns the upper bound of the bucket, which is not meaningful for the last
+  // bucket (i.e. it is +Inf).
+  static uint32_t BucketUpperBound(uint8_t ndx) {
+    return kFirstBucketMicros << ndx;
+  }
+
+  uint32_t bucket_count(uint8_t ndx) const { return bucket_counts_[ndx]; }
+  uint32_t count() const { return count_; }
+
+  // The sum will wrap around after about 71 minutes of recorded durations.
+  uint32_t sum_micros() const { return sum_micros_; }
+
+ private:
+  uint32_t bucket_counts_[kNumBuckets];
+  uint32_t count_;
+  uint32_t sum_micros_;
+};
+
+class ServerMetrics : public Printable {
+ public:
+  // The number of distinct decoding error status codes that are counted
+  // separately; others are counted together.
+  static constexpr uint8_t kMaxDecodingErrorCodes = 6;
+
+  ServerMetrics() { Reset(); }
+
+  void Reset();
+
+  // Records a request that was successfully decoded and then handled.
+  void RecordRequest(const AlpacaRequest& request,
+                     const RequestTimings& timings);
+
+  // Records a request whose decoding failed with the specified status.
+  void RecordDecodingError(EHttpStatusCode status,
+                           const RequestTimings& timings);
+
+  // Writes the metrics to out in the Prometheus text exposition format.
+  size_t printTo(Print& out) const override;
+
+  const Log2Histogram& decode_micros() const { return decode_micros_; }
+  const Log2Histogram& handle_micros() const { return handle_micros_; }
+  const Log2Histogram& write_micros() const { return write_micros_; }
+
+  uint32_t api_count(EAlpacaApi api) const {
+    return api_counts_[static_cast<uint8_t>(api)];
+  }
+  uint32_t device_method_count(EDeviceMethod method) const {
+    return device_method_counts_[static_cast<uint8_t>(method)];
+  }
+  uint32_t decoding_error_count(EHttpStatusCode status) const;
+
+ private:
+  static constexpr uint8_t kNumApis =
+      static_cast<uint8_t>(EAlpacaApi::kServerMetrics) + 1;
+  static constexpr uint8_t kNumDeviceMethods =
+      static_cast<uint8_t>(EDeviceMethod::kSwitchStep) + 1;
+
+  struct DecodingErrorCount {
+    EHttpStatusCode status;
+    uint32_t count;
+  };
+
+  Log2Histogram decode_micros_;
+  Log2Histogram handle_micros_;
+  Log2Histogram write_micros_;
+  uint32_t api_counts_[kNumApis];
+  uint32_t device_method_counts_[kNumDeviceMethods];
+  DecodingErrorCount decoding_errors_[kMaxDecodingErrorCodes];
+  uint32_t other_decoding_errors_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_SERVER_METRICS_H_
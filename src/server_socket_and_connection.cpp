@@ -1,16 +1,26 @@
 #include "server_socket_and_connection.h"
 
+#include <McuCore.h>
+#include <McuNet.h>
+
+#include "config.h"
+
 namespace alpaca {
 
 ServerSocketAndConnection::ServerSocketAndConnection(
     uint16_t tcp_port, RequestListener& request_listener)
     : server_connection_(request_listener),
-      server_socket_(tcp_port, server_connection_) {}
+      server_socket_(tcp_port, server_connection_),
+      leased_(false) {}
 
-bool ServerSocketAndConnection::Initialize() {
-  return server_socket_.PickClosedSocket();
+bool ServerSocketAndConnection::LeaseSocket() {
+  MCU_DCHECK(!has_socket());
+  leased_ = server_socket_.PickClosedSocket();
+  return leased_;
 }
 
-void ServerSocketAndConnection::PerformIO() { server_socket_.PerformIO(); }
+void ServerSocketAndConnection::PerformIO() {
+  server_socket_.PerformIO();
+}
 
 }  // namespace alpaca
@@ -2,13 +2,17 @@
 #define TINY_ALPACA_SERVER_SRC_SERVER_SOCKET_AND_CONNECTION_H_
 
 // Combines a ServerSocket that binds a hardware socket to a TCP port and a
-// ServerConnection that listens to events from the socket.
+// ServerConnection that listens to events from the socket. The hardware socket
+// is leased when needed by ServerSocketsAndConnections, after which the
+// ServerSocket keeps it, listening again after each client disconnects.
 //
 // Author: james.synge@gmail.com
 
 #include <McuCore.h>
 #include <McuNet.h>
 
+#include "config.h"
+#include "request_lanes.h"
 #include "request_listener.h"
 #include "server_connection.h"
 
@@ -21,19 +25,43 @@ class ServerSocketAndConnection {
 
   // Placement new operator. Used to allow us to have a compile time
   // configuration of the number of simultaneous connections that we want to
-  // support, i.e. the number of hardware sockets dedicated to serving tcp_port.
+  // support.
   void* operator new(size_t size, void* ptr) { return ptr; }
 
-  // Prepares the instance to receive TCP connections. Returns true if able to
-  // do so, false otherwise.
-  bool Initialize();
+  // Leases a closed hardware socket and starts listening for TCP connections
+  // on it. Returns true if able to do so, false otherwise (e.g. if there are no
+  // closed sockets).
+  bool LeaseSocket();
+
+  // Returns true if a hardware socket has been leased.
+  bool has_socket() const { return leased_; }
+
+  // Returns true if a hardware socket has been leased and no client is
+  // connected to it, i.e. it is listening for a client to connect.
+  bool is_listening() const {
+    return leased_ && !server_connection_.has_socket();
+  }
 
   // Performs network IO as appropriate.
   void PerformIO();
 
+  const ServerConnection& server_connection() const {
+    return server_connection_;
+  }
+
+#if TAS_ENABLE_PRIORITY_LANES
+  void set_default_lane(ERequestLane lane) {
+    server_connection_.set_default_lane(lane);
+  }
+#endif  // TAS_ENABLE_PRIORITY_LANES
+
  private:
   ServerConnection server_connection_;
   mcunet::ServerSocket server_socket_;
+
+  // The ServerSocket keeps the hardware socket once picked, listening again
+  // after each client disconnects, so this is never cleared.
+  bool leased_;
 };
 
 }  // namespace alpaca
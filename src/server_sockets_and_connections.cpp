@@ -1,44 +1,258 @@
 #include "server_sockets_and_connections.h"
 
 #include <McuCore.h>
+#include <McuNet.h>
 
 namespace alpaca {
+namespace {
+
+#if TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+constexpr uint8_t kNumPrioritySockets = 1;
+#else
+constexpr uint8_t kNumPrioritySockets = 0;
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+
+static_assert(TAS_NUM_RESERVED_SOCKETS + kNumPrioritySockets < MAX_SOCK_NUM,
+              "Too many reserved sockets");
+
+// The number of hardware sockets the pool may hold, leaving the others for the
+// priority port and for other uses.
+constexpr uint8_t kMaxLeasedSockets =
+    MAX_SOCK_NUM - TAS_NUM_RESERVED_SOCKETS - kNumPrioritySockets;
+
+}  // namespace
 
 ServerSocketsAndConnections::ServerSocketsAndConnections(
-    uint16_t tcp_port, RequestListener& request_listener) {
-  static_assert(0 < kNumSockets, "Too few server connections");
-  static_assert(kNumSockets < MAX_SOCK_NUM, "Too many server connections");
+    uint16_t tcp_port, RequestListener& request_listener)
+    :
+#if TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+      priority_connection_(TAS_PRIORITY_TCP_PORT, request_listener),
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+      scheduler_(TAS_PERFORM_IO_BUDGET_MICROS),
+      lease_policy_(TAS_MIN_LISTENING_SOCKETS, kMaxLeasedSockets) {
+  static_assert(0 < kNumConnections, "Too few server connections");
+  static_assert(0 < TAS_MIN_LISTENING_SOCKETS, "Too few listening sockets");
+  static_assert(TAS_MIN_LISTENING_SOCKETS <= kNumConnections,
+                "Too many listening sockets");
+#if TAS_ENABLE_EVENT_STREAMS
+  static_assert(TAS_MAX_EVENT_STREAMS < kNumConnections,
+                "Event streams would use all of the connections");
+#endif  // TAS_ENABLE_EVENT_STREAMS
 
-  for (size_t ndx = 0; ndx < kNumSockets; ++ndx) {
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
     new (GetServerSocketAndConnection(ndx))
         ServerSocketAndConnection(tcp_port, request_listener);
   }
+#if TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+  priority_connection_.set_default_lane(ERequestLane::kPriority);
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
 }
 
 bool ServerSocketsAndConnections::Initialize() {
   MCU_VLOG(2) << MCU_PSD("ServerSocketsAndConnections::Initialize");
-  uint8_t count = 0;
-  for (size_t ndx = 0; ndx < kNumSockets; ++ndx) {
-    if (GetServerSocketAndConnection(ndx)->Initialize()) {
-      ++count;
+#if TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+  // Lease the socket for the priority port first, so that the pool can't take
+  // all of the sockets.
+  if (!priority_connection_.LeaseSocket()) {
+    MCU_VLOG(1) << MCU_PSD("Unable to lease a socket for the priority port");
+  }
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+  // Lease the minimum number of listening sockets, if possible.
+  for (uint8_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    if (lease_policy_.Decide(GetSocketPoolState()) !=
+            ESocketPoolAction::kLease ||
+        !GetServerSocketAndConnection(ndx)->LeaseSocket()) {
+      break;
     }
   }
-  MCU_VLOG(2) << MCU_PSD("Initialized ") << count << MCU_PSD(" of ")
-              << kNumSockets << MCU_PSD(" ServerSocketAndConnection objects");
-  return count != kNumSockets;
+  const uint8_t count = num_leased_sockets();
+  MCU_VLOG(2) << MCU_PSD("Leased ") << count << MCU_PSD(" sockets for ")
+              << kNumConnections
+              << MCU_PSD(" ServerSocketAndConnection objects");
+  return count > 0;
 }
 
 void ServerSocketsAndConnections::PerformIO() {
   MCU_VLOG(6) << MCU_PSD("ServerSocketsAndConnections::PerformIO entry");
-  for (size_t ndx = 0; ndx < kNumSockets; ++ndx) {
+#if TAS_ENABLE_PRIORITY_LANES
+#if TAS_PRIORITY_TCP_PORT
+  priority_connection_.PerformIO();
+#endif  // TAS_PRIORITY_TCP_PORT
+  // Connections which have started to receive a request in the priority lane
+  // are serviced first.
+  for (uint8_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    if (GetServerSocketAndConnection(ndx)
+            ->server_connection()
+            .has_priority_request()) {
+      scheduler_.Prioritize(ndx);
+    }
+  }
+#endif  // TAS_ENABLE_PRIORITY_LANES
+  scheduler_.StartPass(micros());
+  uint8_t ndx;
+  while (scheduler_.NextConnection(micros(), ndx)) {
     GetServerSocketAndConnection(ndx)->PerformIO();
+    scheduler_.EndService(micros());
   }
+  MaintainSocketPool();
   MCU_VLOG(6) << MCU_PSD("ServerSocketsAndConnections::PerformIO exit");
 }
 
+#if TAS_ENABLE_CONNECTION_DEADLINES
+uint32_t ServerSocketsAndConnections::num_idle_timeouts() const {
+  uint32_t total = 0;
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    total += GetServerSocketAndConnection(ndx)
+                 ->server_connection()
+                 .deadlines()
+                 .num_idle_timeouts();
+  }
+#if TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+  total += priority_connection_.server_connection()
+               .deadlines()
+               .num_idle_timeouts();
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+  return total;
+}
+
+uint32_t ServerSocketsAndConnections::num_request_timeouts() const {
+  uint32_t total = 0;
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    total += GetServerSocketAndConnection(ndx)
+                 ->server_connection()
+                 .deadlines()
+                 .num_request_timeouts();
+  }
+#if TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+  total += priority_connection_.server_connection()
+               .deadlines()
+               .num_request_timeouts();
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+  return total;
+}
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+RequestLatencyStats ServerSocketsAndConnections::latency_stats(
+    ERequestLane lane) const {
+  RequestLatencyStats stats;
+  stats.Reset();
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    stats.Add(
+        GetServerSocketAndConnection(ndx)->server_connection().latency_stats(
+            lane));
+  }
+#if TAS_PRIORITY_TCP_PORT
+  stats.Add(priority_connection_.server_connection().latency_stats(lane));
+#endif  // TAS_PRIORITY_TCP_PORT
+  return stats;
+}
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+
+#if TAS_ENABLE_METRICS
+void ServerSocketsAndConnections::PrintMetrics(
+    mcucore::OPrintStream& strm) const {
+#if TAS_ENABLE_CONNECTION_DEADLINES
+  strm << MCU_PSD("# TYPE tas_connection_timeouts_total counter\n")
+       << MCU_PSD("tas_connection_timeouts_total{deadline=\"idle\"} ")
+       << num_idle_timeouts() << '\n'
+       << MCU_PSD("tas_connection_timeouts_total{deadline=\"request\"} ")
+       << num_request_timeouts() << '\n';
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+#if TAS_ENABLE_PRIORITY_LANES
+  const struct {
+    ERequestLane lane;
+    const __FlashStringHelper* name;
+  } lanes[] = {
+      {ERequestLane::kNormal, MCU_FLASHSTR("normal")},
+      {ERequestLane::kPriority, MCU_FLASHSTR("priority")},
+      {ERequestLane::kLow, MCU_FLASHSTR("low")},
+  };
+  static_assert(sizeof lanes / sizeof lanes[0] == kNumRequestLanes);
+  strm << MCU_PSD("# TYPE tas_lane_requests_total counter\n");
+  for (const auto& lane : lanes) {
+    strm << MCU_PSD("tas_lane_requests_total{lane=\"") << lane.name
+         << MCU_PSD("\"} ") << latency_stats(lane.lane).num_requests << '\n';
+  }
+  strm << MCU_PSD("# TYPE tas_lane_latency_micros gauge\n");
+  for (const auto& lane : lanes) {
+    const RequestLatencyStats stats = latency_stats(lane.lane);
+    strm << MCU_PSD("tas_lane_latency_micros{lane=\"") << lane.name
+         << MCU_PSD("\",stat=\"mean\"} ") << stats.mean_micros() << '\n'
+         << MCU_PSD("tas_lane_latency_micros{lane=\"") << lane.name
+         << MCU_PSD("\",stat=\"max\"} ") << stats.max_micros << '\n';
+  }
+#endif  // TAS_ENABLE_PRIORITY_LANES
+  strm << MCU_PSD("# TYPE tas_connection_services_total counter\n");
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    strm << MCU_PSD("tas_connection_services_total{connection=\"") << ndx
+         << MCU_PSD("\"} ") << service_stats(ndx).num_services << '\n';
+  }
+  strm << MCU_PSD("# TYPE tas_connection_deferrals_total counter\n");
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    strm << MCU_PSD("tas_connection_deferrals_total{connection=\"") << ndx
+         << MCU_PSD("\"} ") << service_stats(ndx).num_deferrals << '\n';
+  }
+  strm << MCU_PSD("# TYPE tas_connection_service_micros gauge\n");
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    const ConnectionServiceStats& stats = service_stats(ndx);
+    strm << MCU_PSD("tas_connection_service_micros{connection=\"") << ndx
+         << MCU_PSD("\",stat=\"mean\"} ") << stats.mean_micros() << '\n'
+         << MCU_PSD("tas_connection_service_micros{connection=\"") << ndx
+         << MCU_PSD("\",stat=\"max\"} ") << stats.max_micros << '\n';
+  }
+}
+#endif  // TAS_ENABLE_METRICS
+
+uint8_t ServerSocketsAndConnections::num_leased_sockets() const {
+  uint8_t count = 0;
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    if (GetServerSocketAndConnection(ndx)->has_socket()) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+SocketPoolState ServerSocketsAndConnections::GetSocketPoolState() const {
+  SocketPoolState state = {};
+  for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+    const auto* ssac = GetServerSocketAndConnection(ndx);
+    if (!ssac->has_socket()) {
+      ++state.num_unleased;
+    } else if (ssac->is_listening()) {
+      ++state.num_listening;
+    } else {
+      ++state.num_connected;
+    }
+  }
+  return state;
+}
+
+void ServerSocketsAndConnections::MaintainSocketPool() {
+  const ESocketPoolAction action = lease_policy_.Decide(GetSocketPoolState());
+  if (action == ESocketPoolAction::kLease) {
+    for (size_t ndx = 0; ndx < kNumConnections; ++ndx) {
+      auto* ssac = GetServerSocketAndConnection(ndx);
+      if (!ssac->has_socket()) {
+        if (!ssac->LeaseSocket()) {
+          MCU_VLOG(2) << MCU_PSD("Unable to lease a socket");
+        }
+        return;
+      }
+    }
+  }
+}
+
 ServerSocketAndConnection*
 ServerSocketsAndConnections::GetServerSocketAndConnection(size_t ndx) {
   return reinterpret_cast<ServerSocketAndConnection*>(sockets_storage_) + ndx;
 }
 
+const ServerSocketAndConnection*
+ServerSocketsAndConnections::GetServerSocketAndConnection(size_t ndx) const {
+  return reinterpret_cast<const ServerSocketAndConnection*>(sockets_storage_) +
+         ndx;
+}
+
 }  // namespace alpaca
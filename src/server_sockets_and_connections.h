@@ -2,15 +2,19 @@
 #define TINY_ALPACA_SERVER_SRC_SERVER_SOCKETS_AND_CONNECTIONS_H_
 
 // ServerSocketsAndConnections owns the set of ServerConnection objects used to
-// implement the HTTP server feature of Tiny Alpaca Server.
+// implement the HTTP server feature of Tiny Alpaca Server, and leases hardware
+// sockets for them as directed by a SocketLeasePolicy.
 //
 // Author: james.synge@gmail.com
 
 #include <McuCore.h>
 
 #include "config.h"
+#include "connection_scheduler.h"
+#include "request_lanes.h"
 #include "request_listener.h"
 #include "server_socket_and_connection.h"
+#include "socket_lease_policy.h"
 
 namespace alpaca {
 
@@ -21,29 +25,76 @@ class ServerSocketsAndConnections {
   ServerSocketsAndConnections(uint16_t tcp_port,
                               RequestListener& request_listener);
 
-  // Prepares the ServerSocketAndConnection instances to receive TCP
-  // connections. Returns true if able to do so, false otherwise.
+  // Leases hardware sockets for the ServerSocketAndConnection instances to
+  // receive TCP connections. Returns true if able to lease at least one, false
+  // otherwise.
   bool Initialize();
 
-  // Performs network IO as appropriate.
+  // Performs network IO as appropriate, servicing the connections in the order
+  // chosen by a ConnectionScheduler, then leases a hardware socket if needed.
   void PerformIO();
 
+  // The number of connections that can be handled at once. Hardware sockets are
+  // leased only as needed, leaving the rest for other uses, such as the Alpaca
+  // Discovery protocol, DHCP renewal, and maybe outbound connections to a time
+  // server.
+  static constexpr uint8_t kNumConnections = TAS_NUM_SERVER_CONNECTIONS;
+
+  // Returns the number of connections with a leased hardware socket.
+  uint8_t num_leased_sockets() const;
+
+  // Returns the statistics about the time taken to service connection 'ndx',
+  // where 'ndx' is in the range [0, kNumConnections-1]. Exported at /metrics
+  // when TAS_ENABLE_METRICS is set.
+  const ConnectionServiceStats& service_stats(uint8_t ndx) const {
+    return scheduler_.service_stats(ndx);
+  }
+
+#if TAS_ENABLE_CONNECTION_DEADLINES
+  // Returns the number of connections closed because the client was idle for
+  // too long, or took too long to send a request.
+  uint32_t num_idle_timeouts() const;
+  uint32_t num_request_timeouts() const;
+#endif  // TAS_ENABLE_CONNECTION_DEADLINES
+
+#if TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+  // Returns the latency statistics of the requests in the specified lane,
+  // across all connections.
+  RequestLatencyStats latency_stats(ERequestLane lane) const;
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_ENABLE_METRICS
+
+#if TAS_ENABLE_METRICS
+  // Prints the above statistics in the Prometheus text format, for /metrics.
+  void PrintMetrics(mcucore::OPrintStream& strm) const;
+#endif  // TAS_ENABLE_METRICS
+
  private:
-  // Not using all of the ports, need to reserve one for the Alpaca Discovery
-  // protocols, one for DHCP renewal, and maybe one for outbound connections to
-  // a time server.
-  static constexpr uint8_t kNumSockets = TAS_NUM_SERVER_CONNECTIONS;
+  // Computes the state of the pool of sockets, for the SocketLeasePolicy.
+  SocketPoolState GetSocketPoolState() const;
+
+  // Leases a hardware socket, if the SocketLeasePolicy says to.
+  void MaintainSocketPool();
 
-  using ServerSocketAndConnectionArray = ServerSocketAndConnection[kNumSockets];
+  using ServerSocketAndConnectionArray =
+      ServerSocketAndConnection[kNumConnections];
   static constexpr size_t kServerSocketAndConnectionStorage =
       sizeof(ServerSocketAndConnectionArray);
 
   // Returns a pointer to the ServerSocketAndConnection with index 'ndx', where
-  // 'ndx' is in the range [0, kNumSockets-1].
+  // 'ndx' is in the range [0, kNumConnections-1].
   ServerSocketAndConnection* GetServerSocketAndConnection(size_t ndx);
+  const ServerSocketAndConnection* GetServerSocketAndConnection(
+      size_t ndx) const;
 
+#if TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
+  // Not part of the pool of connections: it always has a hardware socket
+  // listening on TAS_PRIORITY_TCP_PORT, and is serviced first in each pass.
+  ServerSocketAndConnection priority_connection_;
+#endif  // TAS_ENABLE_PRIORITY_LANES && TAS_PRIORITY_TCP_PORT
   alignas(ServerSocketAndConnection) uint8_t
       sockets_storage_[kServerSocketAndConnectionStorage];
+  ConnectionScheduler<kNumConnections> scheduler_;
+  const SocketLeasePolicy lease_policy_;
 };
 
 }  // namespace alpaca
@@ -0,0 +1,395 @@
+#include "settings_journal.h"
+
+#include <McuCore.h>
+
+#include "ascom_error_codes.h"
+#include "eeprom_ids.h"
+
+MCU_DEFINE_NAMED_DOMAIN(TinyAlpacaServerSettings, 10);
+
+namespace alpaca {
+namespace {
+
+static_assert(SettingsJournal::kNumRecords <= kSettingsJournalMaxRecords,
+              "TAS_SETTINGS_JOURNAL_RECORDS is too large");
+
+// The number of chunks needed for a snapshot of the full cache.
+constexpr uint16_t kMaxSnapshotChunks =
+    (SettingsJournal::kCapacity + SettingsJournal::kSnapshotChunkSize - 1) /
+    SettingsJournal::kSnapshotChunkSize;
+static_assert(kMaxSnapshotChunks <= kSettingsSnapshotMaxChunks,
+              "TAS_SETTINGS_SNAPSHOT_CHUNK_SIZE is too small");
+
+// A record is the sequence number (2 bytes), the domain and id of the tag, the
+// length of the value (zero if the setting has been removed), and the value.
+constexpr uint8_t kRecordHeaderSize = 5;
+
+uint16_t ReadUint16(const uint8_t* data) {
+  return data[0] | (static_cast<uint16_t>(data[1]) << 8);
+}
+
+void WriteUint16(uint16_t value, uint8_t* data) {
+  data[0] = value & 0xFF;
+  data[1] = value >> 8;
+}
+
+}  // namespace
+
+SettingsJournal::SettingsJournal()
+    : base_sequence_(0),
+      next_sequence_(0),
+      last_change_millis_(0),
+      snapshot_offset_(0),
+      snapshot_bank_(0),
+      changed_(false),
+      snapshot_needed_(false) {
+  Clear();
+}
+
+void SettingsJournal::Clear() { size_ = 0; }
+
+mcucore::Status SettingsJournal::Load(mcucore::EepromTlv& tlv) {
+  Clear();
+  base_sequence_ = next_sequence_ = 0;
+  snapshot_offset_ = snapshot_bank_ = 0;
+  changed_ = snapshot_needed_ = false;
+
+  // Each bank holds a snapshot, unless none has been written to it yet, or it
+  // was only partially written (e.g. the sketch was reset part way through),
+  // in which case the other bank holds the last complete snapshot, if any.
+  constexpr uint8_t kNoBank = 2;
+  uint8_t newest_bank = kNoBank;
+  uint16_t newest_sequence = 0;
+  mcucore::Status error;
+  for (uint8_t bank = 0; bank < 2; ++bank) {
+    uint16_t sequence;
+    bool complete;
+    auto status = ReadSnapshot(tlv, bank, sequence, complete);
+    if (!status.ok()) {
+      error = status;
+    } else if (complete &&
+               (newest_bank == kNoBank ||
+                static_cast<int16_t>(sequence - newest_sequence) > 0)) {
+      newest_bank = bank;
+      newest_sequence = sequence;
+    }
+  }
+  if (newest_bank == kNoBank) {
+    Clear();
+    if (!error.ok()) {
+      return error;
+    }
+  } else {
+    if (newest_bank == 0) {
+      // The entries in RAM are those of the last bank read.
+      bool complete;
+      MCU_RETURN_IF_ERROR(
+          ReadSnapshot(tlv, newest_bank, newest_sequence, complete));
+    }
+    snapshot_bank_ = newest_bank;
+    base_sequence_ = next_sequence_ = newest_sequence;
+  }
+  return LoadRecords(tlv);
+}
+
+mcucore::Status SettingsJournal::ReadSnapshot(mcucore::EepromTlv& tlv,
+                                              uint8_t bank, uint16_t& sequence,
+                                              bool& complete) {
+  uint8_t chunk[kChunkHeaderSize + kSnapshotChunkSize];
+  uint16_t snapshot_size = 0;
+  uint16_t offset = 0;
+  uint8_t chunk_number = 0;
+  complete = false;
+  size_ = 0;
+  do {
+    auto status_or_size =
+        tlv.ReadEntry(SnapshotTag(bank, chunk_number), chunk, sizeof chunk);
+    if (!status_or_size.ok()) {
+      if (mcucore::IsNotFound(status_or_size.status())) {
+        return mcucore::OkStatus();
+      }
+      return status_or_size.status();
+    }
+    const uint16_t chunk_size = status_or_size.value();
+    if (chunk_size < kChunkHeaderSize) {
+      return mcucore::OkStatus();
+    }
+    if (chunk_number == 0) {
+      sequence = ReadUint16(chunk);
+      snapshot_size = ReadUint16(chunk + 2);
+      if (snapshot_size > kCapacity) {
+        return mcucore::OkStatus();
+      }
+    } else if (ReadUint16(chunk) != sequence ||
+               ReadUint16(chunk + 2) != snapshot_size) {
+      // Left from an earlier snapshot.
+      return mcucore::OkStatus();
+    }
+    uint16_t length = snapshot_size - offset;
+    if (length > kSnapshotChunkSize) {
+      length = kSnapshotChunkSize;
+    }
+    if (chunk_size != kChunkHeaderSize + length) {
+      return mcucore::OkStatus();
+    }
+    memcpy(entries_ + offset, chunk + kChunkHeaderSize, length);
+    offset += length;
+    ++chunk_number;
+  } while (offset < snapshot_size);
+
+  // All of the chunks are present, so the entries should be well formed.
+  bool well_formed = true;
+  offset = 0;
+  while (well_formed && offset < snapshot_size) {
+    well_formed = snapshot_size - offset >= kEntryHeaderSize;
+    if (well_formed) {
+      const uint8_t length = entries_[offset + 2];
+      well_formed = length > 0 && length <= kMaxValueLength;
+      offset += kEntryHeaderSize + length;
+    }
+  }
+  if (!well_formed || offset != snapshot_size) {
+    MCU_VLOG(1) << MCU_PSD("Discarding malformed settings snapshot in bank ")
+                << bank;
+    return ErrorCodes::SettingsProviderError();
+  }
+  size_ = snapshot_size;
+  complete = true;
+  return mcucore::OkStatus();
+}
+
+mcucore::Status SettingsJournal::LoadRecords(mcucore::EepromTlv& tlv) {
+  uint8_t record[kRecordHeaderSize + kMaxValueLength];
+  for (uint8_t count = 0; count < kNumRecords; ++count) {
+    auto status_or_size =
+        tlv.ReadEntry(RecordTag(next_sequence_), record, sizeof record);
+    if (!status_or_size.ok()) {
+      if (mcucore::IsNotFound(status_or_size.status())) {
+        break;
+      }
+      return status_or_size.status();
+    }
+    // A record with a different sequence number was appended before the
+    // snapshot was written, so it marks the end of the journal.
+    const uint8_t length = record[4];
+    if (status_or_size.value() != kRecordHeaderSize + length ||
+        ReadUint16(record) != next_sequence_) {
+      break;
+    }
+    if (!Store(record[2], record[3], record + kRecordHeaderSize, length,
+               /*dirty=*/false)) {
+      MCU_VLOG(1) << MCU_PSD("No room for setting ") << record[2] << '/'
+                  << record[3];
+    }
+    ++next_sequence_;
+  }
+  return mcucore::OkStatus();
+}
+
+mcucore::StringView SettingsJournal::Get(const mcucore::EepromTag& tag) const {
+  const uint16_t offset = FindEntry(tag.domain.value(), tag.id);
+  if (offset >= size_) {
+    return mcucore::StringView();
+  }
+  const uint8_t* entry = entries_ + offset;
+  return mcucore::StringView(
+      reinterpret_cast<const char*>(entry + kEntryHeaderSize),
+      entry[2] & ~kDirtyBit);
+}
+
+bool SettingsJournal::Set(const mcucore::EepromTag& tag,
+                          const mcucore::StringView& value) {
+  if (value.size() > kMaxValueLength) {
+    return false;
+  }
+  const uint8_t domain = tag.domain.value();
+  const uint16_t offset = FindEntry(domain, tag.id);
+  if (offset >= size_ ? value.empty() : Get(tag) == value) {
+    return true;
+  }
+  if (!Store(domain, tag.id, reinterpret_cast<const uint8_t*>(value.data()),
+             value.size(), /*dirty=*/true)) {
+    MCU_VLOG(2) << MCU_PSD("No room for setting ") << domain << '/' << tag.id;
+    return false;
+  }
+  changed_ = true;
+  return true;
+}
+
+void SettingsJournal::Maintain(mcucore::EepromTlv& tlv, uint32_t now_millis) {
+  if (changed_) {
+    // Wait for the changes to stop.
+    changed_ = false;
+    last_change_millis_ = now_millis;
+    if (snapshot_offset_ > 0) {
+      // The chunks already written are out of date, so start the snapshot
+      // again. A new sequence number ensures that those chunks can't be
+      // mistaken for part of the new snapshot.
+      snapshot_offset_ = 0;
+      ++next_sequence_;
+    }
+    return;
+  } else if (!pending() ||
+             now_millis - last_change_millis_ <
+                 TAS_SETTINGS_WRITE_DELAY_MILLIS) {
+    return;
+  }
+  mcucore::Status status;
+  if (snapshot_needed_ ||
+      static_cast<uint16_t>(next_sequence_ - base_sequence_) >= kNumRecords) {
+    status = WriteSnapshotChunk(tlv);
+  } else {
+    status = AppendRecord(tlv, FindDirtyEntry());
+  }
+  if (!status.ok()) {
+    MCU_VLOG(1) << MCU_PSD("Failed to write settings: ") << status;
+    // Try again after another delay.
+    last_change_millis_ = now_millis;
+  }
+}
+
+bool SettingsJournal::pending() const {
+  return snapshot_needed_ || FindDirtyEntry() < size_;
+}
+
+mcucore::EepromDomain SettingsJournal::ServerDomain() {
+  return MCU_DOMAIN(TinyAlpacaServerSettings);
+}
+
+mcucore::EepromTag SettingsJournal::SnapshotTag(uint8_t bank,
+                                                uint8_t chunk) {
+  const uint8_t first_id =
+      kSettingsSnapshotFirstId + bank * kSettingsSnapshotMaxChunks;
+  return {.domain = ServerDomain(),
+          .id = static_cast<uint8_t>(first_id + chunk)};
+}
+
+mcucore::EepromTag SettingsJournal::RecordTag(uint16_t sequence) {
+  return {.domain = ServerDomain(),
+          .id = static_cast<uint8_t>(kSettingsJournalFirstId +
+                                     (sequence & (kNumRecords - 1)))};
+}
+
+uint16_t SettingsJournal::FindEntry(uint8_t domain, uint8_t id) const {
+  uint16_t offset = 0;
+  while (offset < size_) {
+    const uint8_t* entry = entries_ + offset;
+    if (entry[0] == domain && entry[1] == id) {
+      return offset;
+    }
+    offset += kEntryHeaderSize + (entry[2] & ~kDirtyBit);
+  }
+  return size_;
+}
+
+bool SettingsJournal::Store(uint8_t domain, uint8_t id, const uint8_t* value,
+                            uint8_t length, bool dirty) {
+  const uint16_t offset = FindEntry(domain, id);
+  uint16_t old_entry_size = 0;
+  if (offset < size_) {
+    old_entry_size = kEntryHeaderSize + (entries_[offset + 2] & ~kDirtyBit);
+  }
+  if (length == 0 && !dirty) {
+    // A removal which has been written, so no entry is needed.
+    if (old_entry_size > 0) {
+      RemoveEntry(offset);
+    }
+    return true;
+  }
+  const uint16_t new_entry_size = kEntryHeaderSize + length;
+  if (size_ - old_entry_size + new_entry_size > kCapacity) {
+    return false;
+  }
+  if (old_entry_size > 0) {
+    RemoveEntry(offset);
+  }
+  uint8_t* entry = entries_ + size_;
+  entry[0] = domain;
+  entry[1] = id;
+  entry[2] = length | (dirty ? kDirtyBit : 0);
+  memcpy(entry + kEntryHeaderSize, value, length);
+  size_ += new_entry_size;
+  return true;
+}
+
+void SettingsJournal::RemoveEntry(uint16_t offset) {
+  const uint16_t entry_size =
+      kEntryHeaderSize + (entries_[offset + 2] & ~kDirtyBit);
+  memmove(entries_ + offset, entries_ + offset + entry_size,
+          size_ - offset - entry_size);
+  size_ -= entry_size;
+}
+
+uint16_t SettingsJournal::FindDirtyEntry() const {
+  uint16_t offset = 0;
+  while (offset < size_) {
+    const uint8_t length = entries_[offset + 2];
+    if (length & kDirtyBit) {
+      return offset;
+    }
+    offset += kEntryHeaderSize + length;
+  }
+  return size_;
+}
+
+mcucore::Status SettingsJournal::AppendRecord(mcucore::EepromTlv& tlv,
+                                              uint16_t offset) {
+  uint8_t* const entry = entries_ + offset;
+  const uint8_t length = entry[2] & ~kDirtyBit;
+  uint8_t record[kRecordHeaderSize + kMaxValueLength];
+  WriteUint16(next_sequence_, record);
+  record[2] = entry[0];
+  record[3] = entry[1];
+  record[4] = length;
+  memcpy(record + kRecordHeaderSize, entry + kEntryHeaderSize, length);
+  MCU_RETURN_IF_ERROR(tlv.WriteEntry(RecordTag(next_sequence_), record,
+                                     kRecordHeaderSize + length));
+  ++next_sequence_;
+  if (length == 0) {
+    RemoveEntry(offset);
+  } else {
+    entry[2] = length;
+  }
+  return mcucore::OkStatus();
+}
+
+mcucore::Status SettingsJournal::WriteSnapshotChunk(mcucore::EepromTlv& tlv) {
+  if (snapshot_offset_ == 0) {
+    // The snapshot holds all of the settings, so there is nothing left to write
+    // once it has been written, and removed settings can be dropped.
+    uint16_t offset = 0;
+    while (offset < size_) {
+      const uint8_t length = entries_[offset + 2] & ~kDirtyBit;
+      if (length == 0) {
+        RemoveEntry(offset);
+      } else {
+        entries_[offset + 2] = length;
+        offset += kEntryHeaderSize + length;
+      }
+    }
+    snapshot_needed_ = true;
+  }
+  uint16_t length = size_ - snapshot_offset_;
+  if (length > kSnapshotChunkSize) {
+    length = kSnapshotChunkSize;
+  }
+  uint8_t chunk[kChunkHeaderSize + kSnapshotChunkSize];
+  WriteUint16(next_sequence_, chunk);
+  WriteUint16(size_, chunk + 2);
+  memcpy(chunk + kChunkHeaderSize, entries_ + snapshot_offset_, length);
+  const uint8_t bank = snapshot_bank_ ^ 1;
+  MCU_RETURN_IF_ERROR(
+      tlv.WriteEntry(SnapshotTag(bank, snapshot_offset_ / kSnapshotChunkSize),
+                     chunk, kChunkHeaderSize + length));
+  snapshot_offset_ += length;
+  if (snapshot_offset_ < size_) {
+    return mcucore::OkStatus();
+  }
+  snapshot_offset_ = 0;
+  snapshot_bank_ = bank;
+  snapshot_needed_ = false;
+  base_sequence_ = next_sequence_;
+  return mcucore::OkStatus();
+}
+
+}  // namespace alpaca
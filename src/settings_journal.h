@@ -0,0 +1,159 @@
+#ifndef TINY_ALPACA_SERVER_SRC_SETTINGS_JOURNAL_H_
+#define TINY_ALPACA_SERVER_SRC_SETTINGS_JOURNAL_H_
+
+// SettingsJournal holds settings which the user can change at runtime (e.g. the
+// server location, or the name of a device), which override the values compiled
+// into the sketch. Each setting is a short string identified by an EepromTag.
+// The settings are held in RAM, so reading them is cheap, and they are stored
+// in EEPROM as a log: each change is appended as a small record (using a ring
+// of TAS_SETTINGS_JOURNAL_RECORDS EEPROM entries), and when the ring is full
+// all of the settings are written as a snapshot, after which the ring is
+// reused. This avoids rewriting all of the settings for each change.
+//
+// Set only changes RAM; Maintain, which is called from the loop, performs at
+// most one EEPROM write per call, and only once there have been no changes for
+// TAS_SETTINGS_WRITE_DELAY_MILLIS, so that a burst of changes (e.g. from a
+// setup page) is coalesced, and the loop isn't stalled by many slow writes.
+// The snapshot is split into chunks of at most TAS_SETTINGS_SNAPSHOT_CHUNK_SIZE
+// bytes, one written per call, so no call writes more than a record or a chunk.
+// The chunks are written to the bank (of two) not holding the last complete
+// snapshot, so if the sketch is reset part way through, Load uses the previous
+// snapshot and the records appended after it.
+//
+// The server reads the settings (see TinyAlpacaDeviceServer::Location and
+// DeviceImplBase::Name), but nothing in the library calls Set yet; a sketch can
+// do so, e.g. from its own setup page handler.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "config.h"
+
+namespace alpaca {
+
+class SettingsJournal {
+ public:
+  // The maximum length of the value of a setting.
+  static constexpr uint8_t kMaxValueLength = 32;
+
+  // The number of bytes of RAM available for settings.
+  static constexpr uint16_t kCapacity = TAS_SETTINGS_JOURNAL_CACHE_SIZE;
+
+  // The number of records appended before the journal is compacted.
+  static constexpr uint8_t kNumRecords = TAS_SETTINGS_JOURNAL_RECORDS;
+
+  // The maximum number of bytes of settings in each chunk of the snapshot.
+  static constexpr uint8_t kSnapshotChunkSize =
+      TAS_SETTINGS_SNAPSHOT_CHUNK_SIZE;
+
+  SettingsJournal();
+
+  // Removes all of the settings from RAM (not from EEPROM).
+  void Clear();
+
+  // Replaces the settings in RAM with those stored in EEPROM, i.e. the newest
+  // complete snapshot followed by the records appended after it was written.
+  // Returns an error if there is no complete and well formed snapshot but
+  // there is a malformed one, or if EEPROM can't be read.
+  mcucore::Status Load(mcucore::EepromTlv& tlv);
+
+  // Returns the value of the specified setting, or an empty view if it isn't
+  // set, in which case the caller should use its default value.
+  mcucore::StringView Get(const mcucore::EepromTag& tag) const;
+
+  // Sets the value of the specified setting; an empty value removes the
+  // setting. Returns false if the value is too long or there isn't room for
+  // it, in which case the settings are unchanged.
+  bool Set(const mcucore::EepromTag& tag, const mcucore::StringView& value);
+
+  // Writes the next pending change (or the next chunk of the snapshot) to
+  // EEPROM, if there is one and it is time to do so.
+  void Maintain(mcucore::EepromTlv& tlv, uint32_t now_millis);
+
+  // True if there are changes which haven't been written to EEPROM.
+  bool pending() const;
+
+  // The number of bytes of RAM used by the settings.
+  uint16_t size() const { return size_; }
+
+  // The domain of the server-wide settings (e.g. kServerLocationId), and of
+  // the EEPROM entries used to store the journal.
+  static mcucore::EepromDomain ServerDomain();
+
+ private:
+  // Each setting is stored as the domain and id of its tag, the length of the
+  // value, and the characters of the value. The high bit of the length is set
+  // if the setting hasn't yet been written to EEPROM. A removed setting which
+  // hasn't yet been written has a length of zero.
+  static constexpr uint8_t kEntryHeaderSize = 3;
+  static constexpr uint8_t kDirtyBit = 0x80;
+
+  // Each chunk of the snapshot starts with the sequence number of the first
+  // record appended after the snapshot, and with the size of the snapshot,
+  // followed by up to kSnapshotChunkSize bytes of the entries.
+  static constexpr uint8_t kChunkHeaderSize = 4;
+
+  static mcucore::EepromTag SnapshotTag(uint8_t bank, uint8_t chunk);
+  static mcucore::EepromTag RecordTag(uint16_t sequence);
+
+  // Returns the offset of the entry for the tag, or size_ if there is none.
+  uint16_t FindEntry(uint8_t domain, uint8_t id) const;
+
+  // Replaces the entry for the tag with one holding the value. Returns false if
+  // there isn't room.
+  bool Store(uint8_t domain, uint8_t id, const uint8_t* value, uint8_t length,
+             bool dirty);
+
+  // Removes the entry at offset.
+  void RemoveEntry(uint16_t offset);
+
+  // Returns the offset of the first entry not yet written, or size_ if none.
+  uint16_t FindDirtyEntry() const;
+
+  // Reads the snapshot in the bank into RAM, and its sequence number into
+  // sequence. Sets complete to false if there is no snapshot in the bank, or
+  // if it was only partially written. Returns an error if EEPROM can't be read
+  // or the snapshot is malformed.
+  mcucore::Status ReadSnapshot(mcucore::EepromTlv& tlv, uint8_t bank,
+                               uint16_t& sequence, bool& complete);
+
+  // Applies the records appended after the snapshot.
+  mcucore::Status LoadRecords(mcucore::EepromTlv& tlv);
+
+  mcucore::Status AppendRecord(mcucore::EepromTlv& tlv, uint16_t offset);
+
+  // Writes the chunk of the snapshot at snapshot_offset_, starting a snapshot
+  // if one isn't in progress.
+  mcucore::Status WriteSnapshotChunk(mcucore::EepromTlv& tlv);
+
+  uint8_t entries_[kCapacity];
+  uint16_t size_;
+
+  // The sequence number of the first record after the snapshot, and of the
+  // next record to be appended.
+  uint16_t base_sequence_;
+  uint16_t next_sequence_;
+
+  uint32_t last_change_millis_;
+
+  // The offset in entries_ of the next chunk of the snapshot to be written,
+  // i.e. where to resume writing the snapshot.
+  uint16_t snapshot_offset_;
+
+  // The bank holding the last complete snapshot; the next is written to the
+  // other bank.
+  uint8_t snapshot_bank_;
+
+  bool changed_;
+  bool snapshot_needed_;
+
+  static_assert((kNumRecords & (kNumRecords - 1)) == 0 && kNumRecords > 0,
+                "TAS_SETTINGS_JOURNAL_RECORDS must be a power of two");
+  static_assert(kSnapshotChunkSize > 0,
+                "TAS_SETTINGS_SNAPSHOT_CHUNK_SIZE must be positive");
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_SETTINGS_JOURNAL_H_
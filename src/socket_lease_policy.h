@@ -0,0 +1,71 @@
+#ifndef TINY_ALPACA_SERVER_SRC_SOCKET_LEASE_POLICY_H_
+#define TINY_ALPACA_SERVER_SRC_SOCKET_LEASE_POLICY_H_
+
+// SocketLeasePolicy decides when ServerSocketsAndConnections should lease
+// another hardware socket for listening for TCP connections. Rather than
+// requiring a hardware socket for each connection when the server starts, we
+// lease sockets until enough of them are listening, and lease another when a
+// client connects to one of them, so long as that leaves some sockets for other
+// uses (e.g. DHCP renewal). Connections which couldn't be leased a socket at
+// startup (e.g. because the sockets were in use) can be leased one later.
+//
+// The policy only counts the sockets leased by the pool; it doesn't read the
+// state of the hardware sockets. Whether a closed socket is available is
+// discovered by trying to lease one.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+// The state of the connections and of the hardware sockets.
+struct SocketPoolState {
+  // Number of connections with a hardware socket that is listening for a
+  // client to connect.
+  uint8_t num_listening;
+
+  // Number of connections with a hardware socket that is connected to a
+  // client, or that is being closed.
+  uint8_t num_connected;
+
+  // Number of connections without a hardware socket.
+  uint8_t num_unleased;
+};
+
+enum class ESocketPoolAction : uint8_t {
+  kNone,
+  kLease,  // Lease a hardware socket for an unleased connection.
+};
+
+class SocketLeasePolicy {
+ public:
+  // min_listening is the number of sockets to keep listening (if possible), and
+  // must be at least one. max_leased is the number of hardware sockets that the
+  // pool may hold, leaving the rest for other uses, except that we'll lease one
+  // more if there would otherwise be no listening socket.
+  SocketLeasePolicy(uint8_t min_listening, uint8_t max_leased)
+      : min_listening_(min_listening), max_leased_(max_leased) {
+    MCU_DCHECK_GT(min_listening_, 0);
+  }
+
+  // Returns the action to be taken given the current state. At most one socket
+  // should be leased at a time, after which the state should be computed again.
+  ESocketPoolAction Decide(const SocketPoolState& state) const {
+    if (state.num_listening < min_listening_ && state.num_unleased > 0) {
+      const uint8_t num_leased = state.num_listening + state.num_connected;
+      if (state.num_listening == 0 || num_leased < max_leased_) {
+        return ESocketPoolAction::kLease;
+      }
+    }
+    return ESocketPoolAction::kNone;
+  }
+
+ private:
+  const uint8_t min_listening_;
+  const uint8_t max_leased_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_SOCKET_LEASE_POLICY_H_
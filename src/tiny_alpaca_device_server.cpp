@@ -4,10 +4,62 @@
 
 #include "alpaca_response.h"
 #include "constants.h"
+#include "eeprom_ids.h"
 #include "http_response_header.h"
 #include "literals.h"
+#include "server_sockets_and_connections.h"
 
 namespace alpaca {
+namespace {
+
+// Adds the properties of the server description, with the location provided
+// by the caller.
+class ServerDescriptionSource : public mcucore::JsonPropertySource {
+ public:
+  ServerDescriptionSource(const ServerDescription& description,
+                          const mcucore::AnyPrintable& location)
+      : description_(description), location_(location) {}
+
+  void AddTo(mcucore::JsonObjectEncoder& object_encoder) const override {
+    description_.AddTo(object_encoder, location_);
+  }
+
+ private:
+  const ServerDescription& description_;
+  const mcucore::AnyPrintable& location_;
+};
+
+// The parts of the status page, in the order in which they're written. Those
+// with a section per device are written one device at a time, with
+// ResponseCursor::item as the index of the device.
+enum EStatusPagePart : uint8_t {
+  kStatusPageHeader = 0,
+  kStatusPageDeviceHeads,
+  kStatusPageServer,
+  kStatusPageLoopProfile,
+  kStatusPageMemoryUsage,
+  kStatusPageDevicesStart,
+  kStatusPageDeviceBodies,
+  kStatusPageDevicesEnd,
+  kStatusPageDeviceTrailers,
+  kStatusPageEnd,
+};
+
+// Adds the specified section of the status page for the device whose index is
+// cursor.item, then advances cursor.item. Returns true if there are more
+// devices to be added.
+bool AddDeviceToHomePageHtml(mcucore::ArrayView<DeviceInterface*> devices,
+                             const AlpacaRequest& request,
+                             EHtmlPageSection section, ResponseCursor& cursor,
+                             mcucore::OPrintStream& strm) {
+  if (cursor.item >= devices.size()) {
+    return false;
+  }
+  devices[cursor.item]->AddToHomePageHtml(request, section, strm);
+  return ++cursor.item < devices.size();
+}
+
+}  // namespace
 
 TinyAlpacaDeviceServer::TinyAlpacaDeviceServer(
     ServerContext& server_context, const ServerDescription& server_description,
@@ -15,7 +67,15 @@ TinyAlpacaDeviceServer::TinyAlpacaDeviceServer(
     : alpaca_devices_(server_context, devices),
       server_context_(server_context),
       server_description_(server_description),
-      server_transaction_id_(0) {}
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+      overload_detector_(TAS_OVERLOAD_LOOP_MICROS,
+                         TAS_OVERLOAD_EXIT_LOOP_MICROS),
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+#if TAS_ENABLE_METRICS
+      sockets_(nullptr),
+#endif  // TAS_ENABLE_METRICS
+      server_transaction_id_(0) {
+}
 
 void TinyAlpacaDeviceServer::ValidateAndReset() {
   MCU_CHECK_OK(server_context_.Initialize());
@@ -28,15 +88,51 @@ void TinyAlpacaDeviceServer::InitializeForServing() {
 }
 
 void TinyAlpacaDeviceServer::MaintainDevices() {
+#if TAS_ENABLE_OVERLOAD_SHEDDING || TAS_ENABLE_LOOP_PROFILER
+  const uint32_t now_micros = micros();
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING || TAS_ENABLE_LOOP_PROFILER
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+  overload_detector_.RecordLoopStart(now_micros);
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+#if TAS_ENABLE_LOOP_PROFILER
+  loop_profiler_.RecordLoopStart(now_micros);
+  alpaca_devices_.MaintainDevices(loop_profiler_);
+#else   // !TAS_ENABLE_LOOP_PROFILER
   alpaca_devices_.MaintainDevices();
+#endif  // TAS_ENABLE_LOOP_PROFILER
+#if TAS_ENABLE_MEMORY_USAGE
+  memory_usage_.MaybeSample(millis());
+#endif  // TAS_ENABLE_MEMORY_USAGE
+#if TAS_ENABLE_SETTINGS_JOURNAL
+  server_context_.settings().Maintain(server_context_.eeprom_tlv(), millis());
+#endif  // TAS_ENABLE_SETTINGS_JOURNAL
 }
 
 void TinyAlpacaDeviceServer::OnStartDecoding(AlpacaRequest& request) {
   request.set_server_transaction_id(++server_transaction_id_);
 }
 
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+bool TinyAlpacaDeviceServer::ShouldShedRequest(const AlpacaRequest& request) {
+  if (!overload_detector_.is_overloaded()) {
+    return false;
+  }
+  MCU_VLOG(3) << MCU_PSD("Overloaded, shedding request; mean loop micros=")
+              << overload_detector_.mean_loop_micros();
+  overload_detector_.RecordShedRequest();
+#if TAS_ENABLE_REQUEST_JOURNAL
+  // ServerConnection writes the 503 response, which records its outcome.
+  ResponseOutcome::Reset();
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
+  return true;
+}
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+
 bool TinyAlpacaDeviceServer::OnRequestDecoded(AlpacaRequest& request,
                                               Print& out) {
+#if TAS_ENABLE_REQUEST_JOURNAL
+  ResponseOutcome::Reset();
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
   switch (request.api) {
     case EAlpacaApi::kUnknown:
       break;
@@ -55,6 +151,9 @@ bool TinyAlpacaDeviceServer::OnRequestDecoded(AlpacaRequest& request,
     case EAlpacaApi::kManagementConfiguredDevices:
       return alpaca_devices_.HandleManagementConfiguredDevices(request, out);
 
+    case EAlpacaApi::kManagementRequestJournal:
+      return HandleManagementRequestJournal(request, out);
+
     case EAlpacaApi::kServerSetup:
       return HandleServerSetup(request, out);
 
@@ -63,6 +162,9 @@ bool TinyAlpacaDeviceServer::OnRequestDecoded(AlpacaRequest& request,
 
     case EAlpacaApi::kAsset:
       return HandleAsset(request, out);
+
+    case EAlpacaApi::kServerMetrics:
+      return HandleServerMetrics(request, out);
   }
 
   auto msg = MCU_PSV("OnRequestDecoded: unknown request.api=");
@@ -76,6 +178,9 @@ void TinyAlpacaDeviceServer::OnRequestDecodingError(AlpacaRequest& request,
                                                     EHttpStatusCode status,
                                                     Print& out) {
   MCU_VLOG(3) << MCU_PSD("OnRequestDecodingError ") << MCU_NAME_VAL(status);
+#if TAS_ENABLE_REQUEST_JOURNAL
+  ResponseOutcome::Reset();
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
   WriteResponse::HttpErrorResponse(status, mcucore::AnyPrintable(), out);
 }
 
@@ -83,6 +188,63 @@ void TinyAlpacaDeviceServer::OnRequestAborted(AlpacaRequest& request) {
   MCU_VLOG(3) << MCU_PSD("OnRequestAborted ");
 }
 
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+void TinyAlpacaDeviceServer::OnRequestCompleted(const AlpacaRequest& request,
+                                                EHttpStatusCode status,
+                                                const RequestTimings& timings) {
+#if TAS_ENABLE_METRICS
+  if (status == EHttpStatusCode::kHttpOk) {
+    metrics_.RecordRequest(request, timings);
+  } else {
+    metrics_.RecordDecodingError(status, timings);
+  }
+#endif  // TAS_ENABLE_METRICS
+#if TAS_ENABLE_REQUEST_JOURNAL
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  if (request.has_resumable_response) {
+    // Other requests may have been handled while the response was written in
+    // parts, so ResponseOutcome may not describe it. The only resumable
+    // response, the status page, is always successful.
+    request_journal_.Record(request, EHttpStatusCode::kHttpOk, 0, timings);
+    return;
+  }
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+  // ResponseOutcome still describes this request's response, because it was
+  // written just before this call.
+  request_journal_.Record(request, ResponseOutcome::http_status(),
+                          ResponseOutcome::error_number(), timings);
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
+}
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+
+#if TAS_ENABLE_EVENT_STREAMS
+bool TinyAlpacaDeviceServer::OnEventStreamCanWrite(const AlpacaRequest& request,
+                                                   EventStreamState& state,
+                                                   Print& out) {
+  return alpaca_devices_.WriteEventStream(request, state, out);
+}
+
+void TinyAlpacaDeviceServer::OnEventStreamClosed(const AlpacaRequest& request) {
+  MCU_VLOG(3) << MCU_PSD("OnEventStreamClosed ");
+  alpaca_devices_.OnEventStreamClosed(request);
+}
+#endif  // TAS_ENABLE_EVENT_STREAMS
+
+#if TAS_ENABLE_LONG_POLL
+bool TinyAlpacaDeviceServer::OnParkedRequestCanWrite(AlpacaRequest& request,
+                                                     Print& out) {
+  return alpaca_devices_.WriteParkedRequest(request, out);
+}
+#endif  // TAS_ENABLE_LONG_POLL
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+void TinyAlpacaDeviceServer::OnResumableResponseCanWrite(
+    const AlpacaRequest& request, ResponseCursor& cursor, Print& out) {
+  MCU_DCHECK_EQ(request.api, EAlpacaApi::kServerStatus);
+  WriteServerStatusPart(request, cursor, out);
+}
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+
 bool TinyAlpacaDeviceServer::HandleManagementApiVersions(AlpacaRequest& request,
                                                          Print& out) {
   MCU_VLOG(3) << MCU_PSD("HandleManagementApiVersions");
@@ -96,11 +258,34 @@ bool TinyAlpacaDeviceServer::HandleManagementApiVersions(AlpacaRequest& request,
 bool TinyAlpacaDeviceServer::HandleManagementDescription(AlpacaRequest& request,
                                                          Print& out) {
   MCU_VLOG(3) << MCU_PSD("TinyAlpacaDeviceServer::HandleManagementDescription");
-  mcucore::JsonPropertySourceAdapter<ServerDescription> description(
-      server_description_);
+  const mcucore::AnyPrintable location = Location();
+  ServerDescriptionSource description(server_description_, location);
   return WriteResponse::ObjectResponse(request, description, out);
 }
 
+mcucore::AnyPrintable TinyAlpacaDeviceServer::Location() const {
+#if TAS_ENABLE_SETTINGS_JOURNAL
+  const mcucore::StringView location = server_context_.settings().Get(
+      {.domain = SettingsJournal::ServerDomain(), .id = kServerLocationId});
+  if (!location.empty()) {
+    return mcucore::AnyPrintable(location);
+  }
+#endif  // TAS_ENABLE_SETTINGS_JOURNAL
+  return mcucore::AnyPrintable(server_description_.location);
+}
+
+bool TinyAlpacaDeviceServer::HandleManagementRequestJournal(
+    AlpacaRequest& request, Print& out) {
+  MCU_VLOG(3) << MCU_PSD("HandleManagementRequestJournal");
+#if TAS_ENABLE_REQUEST_JOURNAL
+  RequestJournalResponse response(request, request_journal_);
+  return WriteResponse::OkJsonResponse(request, response, out);
+#else   // !TAS_ENABLE_REQUEST_JOURNAL
+  return WriteResponse::HttpErrorResponse(EHttpStatusCode::kHttpNotFound,
+                                          mcucore::AnyPrintable(), out);
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
+}
+
 bool TinyAlpacaDeviceServer::HandleServerSetup(AlpacaRequest& request,
                                                Print& out) {
   MCU_VLOG(3) << MCU_PSD("HandleServerSetup");
@@ -126,44 +311,161 @@ bool TinyAlpacaDeviceServer::HandleServerStatus(AlpacaRequest& request,
     return false;
   }
 
+#if TAS_ENABLE_LOOP_PROFILER || TAS_ENABLE_MEMORY_USAGE
+  // The page shows these snapshots, taken once per request, so that all of the
+  // parts of the page describe the same moment.
+  if (request.http_method == EHttpMethod::GET) {
+#if TAS_ENABLE_LOOP_PROFILER
+    loop_profiler_.TakeSnapshot();
+#endif  // TAS_ENABLE_LOOP_PROFILER
+#if TAS_ENABLE_MEMORY_USAGE
+    memory_usage_.TakeSnapshot();
+#endif  // TAS_ENABLE_MEMORY_USAGE
+  }
+#endif  // TAS_ENABLE_LOOP_PROFILER || TAS_ENABLE_MEMORY_USAGE
+
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  if (request.http_method == EHttpMethod::GET) {
+    // ServerConnection will call OnResumableResponseCanWrite to write the page,
+    // a part at a time, then close the connection.
+    request.has_resumable_response = true;
+    return true;
+  }
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
+
+  ResponseCursor cursor;
+  cursor.Reset();
+  do {
+    WriteServerStatusPart(request, cursor, out);
+  } while (!cursor.is_complete);
+
+  return false;  // There is no Content-Length in the header, so we can't
+                 // continue the connection after this.
+}
+
+void TinyAlpacaDeviceServer::WriteServerStatusPart(const AlpacaRequest& request,
+                                                   ResponseCursor& cursor,
+                                                   Print& out) {
+  const auto devices = alpaca_devices_.devices();
+  mcucore::OPrintStream strm(out);
+  switch (cursor.section) {
+    case kStatusPageHeader: {
+      HttpResponseHeader hrh;
+      hrh.status_code = EHttpStatusCode::kHttpOk;
+      hrh.reason_phrase = ProgmemStrings::OK();
+      hrh.content_type = EContentType::kTextHtml;
+      hrh.do_close = true;
+      hrh.printTo(out);
+      if (request.http_method != EHttpMethod::GET) {
+        cursor.is_complete = true;
+        return;
+      }
+      // Start html, start head, then give each device a chance to add to head.
+      strm << MCU_PSD("<html><head><title>") << server_description_.server_name
+           << MCU_PSD(" (Tiny Alpaca Server)</title>\n");
+      break;
+    }
+
+    case kStatusPageDeviceHeads:
+      if (AddDeviceToHomePageHtml(devices, request, EHtmlPageSection::kHead,
+                                  cursor, strm)) {
+        return;
+      }
+      break;
+
+    case kStatusPageServer:
+      strm << MCU_PSD("</head><body>\n<div class=s><h1 id=sn>")
+           << server_description_.server_name << MCU_PSD("</h1>\n<table>\n")
+           << MCU_PSD("<tr id=ss><td>Server Software:</td><td class=ss>")
+           << MCU_PSD("<a href='")
+           << MCU_PSD("https://github/jamessynge/TinyAlpacaServer")
+           << MCU_PSD("'>") << MCU_PSD("Tiny Alpaca Server") << MCU_PSD("</a>")
+           << MCU_PSD("</td></tr>\n")
+           << MCU_PSD("<tr id=sl><td>Location:</td><td class=sl>")
+           << Location() << MCU_PSD("</td></tr>\n")
+           << MCU_PSD("<tr id=sm><td>Manufacturer:</td><td class=sm>")
+           << server_description_.manufacturer << MCU_PSD("</td></tr>\n")
+           << MCU_PSD("<tr id=smv><td>Version:</td><td class=smv>")
+           << server_description_.manufacturer_version
+           << MCU_PSD("</td></tr>\n") << MCU_PSD("</table>\n</div>\n");
+      break;
+
+    case kStatusPageLoopProfile:
+#if TAS_ENABLE_LOOP_PROFILER
+      loop_profiler_.PrintHtml(devices, strm);
+#endif  // TAS_ENABLE_LOOP_PROFILER
+      break;
+
+    case kStatusPageMemoryUsage:
+#if TAS_ENABLE_MEMORY_USAGE
+      memory_usage_.PrintHtml(strm);
+#endif  // TAS_ENABLE_MEMORY_USAGE
+      break;
+
+    case kStatusPageDevicesStart:
+      strm << MCU_PSD("<div class=d>\n<h2 id=dsl>Configured Devices<h2>\n");
+      break;
+
+    case kStatusPageDeviceBodies:
+      if (AddDeviceToHomePageHtml(devices, request, EHtmlPageSection::kBody,
+                                  cursor, strm)) {
+        return;
+      }
+      break;
+
+    case kStatusPageDevicesEnd:
+      strm << MCU_PSD("\n</div>");
+      break;
+
+    case kStatusPageDeviceTrailers:
+      if (AddDeviceToHomePageHtml(devices, request,
+                                  EHtmlPageSection::kTrailer, cursor, strm)) {
+        return;
+      }
+      break;
+
+    case kStatusPageEnd:
+      strm << MCU_PSD("\n</body></html>");
+      cursor.is_complete = true;
+      return;
+  }
+  cursor.item = 0;
+  ++cursor.section;
+}
+
+bool TinyAlpacaDeviceServer::HandleServerMetrics(AlpacaRequest& request,
+                                                 Print& out) {
+  MCU_VLOG(3) << MCU_PSD("HandleServerMetrics");
+#if TAS_ENABLE_METRICS
   HttpResponseHeader hrh;
   hrh.status_code = EHttpStatusCode::kHttpOk;
   hrh.reason_phrase = ProgmemStrings::OK();
-  hrh.content_type = EContentType::kTextHtml;
+  hrh.content_type = EContentType::kTextPlain;
   hrh.do_close = true;
   hrh.printTo(out);
 
   if (request.http_method == EHttpMethod::GET) {
-    // Start html, start head, then give each device a chance to add to head.
+    metrics_.printTo(out);
     mcucore::OPrintStream strm(out);
-    strm << MCU_PSD("<html><head><title>") << server_description_.server_name
-         << MCU_PSD(" (Tiny Alpaca Server)</title>\n");
-    alpaca_devices_.AddToHomePageHtml(request, EHtmlPageSection::kHead, strm);
-    strm << MCU_PSD("</head><body>\n<div class=s><h1 id=sn>")
-         << server_description_.server_name << MCU_PSD("</h1>\n<table>\n")
-         << MCU_PSD("<tr id=ss><td>Server Software:</td><td class=ss>")
-         << MCU_PSD("<a href='")
-         << MCU_PSD("https://github/jamessynge/TinyAlpacaServer")
-         << MCU_PSD("'>") << MCU_PSD("Tiny Alpaca Server") << MCU_PSD("</a>")
-         << MCU_PSD("</td></tr>\n")
-         << MCU_PSD("<tr id=sl><td>Location:</td><td class=sl>")
-         << server_description_.location << MCU_PSD("</td></tr>\n")
-         << MCU_PSD("<tr id=sm><td>Manufacturer:</td><td class=sm>")
-         << server_description_.manufacturer << MCU_PSD("</td></tr>\n")
-         << MCU_PSD("<tr id=smv><td>Version:</td><td class=smv>")
-         << server_description_.manufacturer_version << MCU_PSD("</td></tr>\n")
-         << MCU_PSD(
-                "</table>\n</div>\n<div class=d>\n<h2 id=dsl>Configured "
-                "Devices<h2>\n");
-    alpaca_devices_.AddToHomePageHtml(request, EHtmlPageSection::kBody, strm);
-    strm << MCU_PSD("\n</div>");
-    alpaca_devices_.AddToHomePageHtml(request, EHtmlPageSection::kTrailer,
-                                      strm);
-    strm << MCU_PSD("\n</body></html>");
+    if (sockets_ != nullptr) {
+      sockets_->PrintMetrics(strm);
+    }
+#if TAS_ENABLE_LOOP_PROFILER
+    loop_profiler_.TakeSnapshot();
+    loop_profiler_.PrintMetrics(alpaca_devices_.devices(), strm);
+#endif  // TAS_ENABLE_LOOP_PROFILER
+#if TAS_ENABLE_MEMORY_USAGE
+    memory_usage_.TakeSnapshot();
+    memory_usage_.PrintMetrics(strm);
+#endif  // TAS_ENABLE_MEMORY_USAGE
   }
 
   return false;  // There is no Content-Length in the header, so we can't
                  // continue the connection after this.
+#else   // !TAS_ENABLE_METRICS
+  return WriteResponse::HttpErrorResponse(EHttpStatusCode::kHttpNotFound,
+                                          mcucore::AnyPrintable(), out);
+#endif  // TAS_ENABLE_METRICS
 }
 
 bool TinyAlpacaDeviceServer::HandleAsset(AlpacaRequest& request, Print& out) {
@@ -22,13 +22,23 @@
 #include <McuCore.h>
 
 #include "alpaca_devices.h"
+#include "config.h"
 #include "device_interface.h"
+#include "event_stream_state.h"
+#include "loop_profiler.h"
+#include "memory_usage.h"
+#include "overload_detector.h"
+#include "request_journal.h"
 #include "request_listener.h"
+#include "response_cursor.h"
 #include "server_context.h"
 #include "server_description.h"
+#include "server_metrics.h"
 
 namespace alpaca {
 
+class ServerSocketsAndConnections;
+
 class TinyAlpacaDeviceServer : public RequestListener {
  public:
   TinyAlpacaDeviceServer(ServerContext& server_context,
@@ -64,24 +74,104 @@ class TinyAlpacaDeviceServer : public RequestListener {
     return server_description_;
   }
 
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+  const OverloadDetector& overload_detector() const {
+    return overload_detector_;
+  }
+  // Exposed for testing.
+  OverloadDetector& overload_detector() { return overload_detector_; }
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+
+#if TAS_ENABLE_METRICS
+  const ServerMetrics& metrics() const { return metrics_; }
+
+  // TinyAlpacaNetworkServer provides its connections, so that their statistics
+  // (e.g. the latency of each request lane) are included at /metrics.
+  void set_sockets(const ServerSocketsAndConnections* sockets) {
+    sockets_ = sockets;
+  }
+#endif  // TAS_ENABLE_METRICS
+
+#if TAS_ENABLE_REQUEST_JOURNAL
+  const RequestJournal& request_journal() const { return request_journal_; }
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
+
+#if TAS_ENABLE_LOOP_PROFILER
+  // TinyAlpacaNetworkServer records the time taken by PerformIO here.
+  LoopProfiler& loop_profiler() { return loop_profiler_; }
+  const LoopProfiler& loop_profiler() const { return loop_profiler_; }
+#endif  // TAS_ENABLE_LOOP_PROFILER
+
+#if TAS_ENABLE_MEMORY_USAGE
+  MemoryUsage& memory_usage() { return memory_usage_; }
+#endif  // TAS_ENABLE_MEMORY_USAGE
+
   // RequestListener method overrides...
   void OnStartDecoding(AlpacaRequest& request) override;
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+  bool ShouldShedRequest(const AlpacaRequest& request) override;
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
   bool OnRequestDecoded(AlpacaRequest& request, Print& out) override;
   void OnRequestDecodingError(AlpacaRequest& request, EHttpStatusCode status,
                               Print& out) override;
   void OnRequestAborted(AlpacaRequest& request) override;
+#if TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+  void OnRequestCompleted(const AlpacaRequest& request, EHttpStatusCode status,
+                          const RequestTimings& timings) override;
+#endif  // TAS_ENABLE_METRICS || TAS_ENABLE_REQUEST_JOURNAL
+#if TAS_ENABLE_EVENT_STREAMS
+  bool OnEventStreamCanWrite(const AlpacaRequest& request,
+                             EventStreamState& state, Print& out) override;
+  void OnEventStreamClosed(const AlpacaRequest& request) override;
+#endif  // TAS_ENABLE_EVENT_STREAMS
+#if TAS_ENABLE_LONG_POLL
+  bool OnParkedRequestCanWrite(AlpacaRequest& request, Print& out) override;
+#endif  // TAS_ENABLE_LONG_POLL
+#if TAS_ENABLE_RESUMABLE_RESPONSES
+  void OnResumableResponseCanWrite(const AlpacaRequest& request,
+                                   ResponseCursor& cursor, Print& out) override;
+#endif  // TAS_ENABLE_RESUMABLE_RESPONSES
 
  private:
   bool HandleManagementApiVersions(AlpacaRequest& request, Print& out);
   bool HandleManagementDescription(AlpacaRequest& request, Print& out);
+  bool HandleManagementRequestJournal(AlpacaRequest& request, Print& out);
   bool HandleServerSetup(AlpacaRequest& request, Print& out);
   bool HandleServerStatus(AlpacaRequest& request, Print& out);
+  bool HandleServerMetrics(AlpacaRequest& request, Print& out);
   bool HandleAsset(AlpacaRequest& request, Print& out);
 
+  // Writes the part of the status page identified by cursor, then advances
+  // cursor to the next part. The page is written in parts so that it needn't
+  // all fit in the socket's transmit buffer (see
+  // TAS_ENABLE_RESUMABLE_RESPONSES).
+  void WriteServerStatusPart(const AlpacaRequest& request,
+                             ResponseCursor& cursor, Print& out);
+
+  // Returns the location set by the user, if there is one, else the location
+  // in the ServerDescription.
+  mcucore::AnyPrintable Location() const;
+
   AlpacaDevices alpaca_devices_;
   ServerContext& server_context_;
   // Maybe move the following into ServerContext?
   const ServerDescription& server_description_;
+#if TAS_ENABLE_OVERLOAD_SHEDDING
+  OverloadDetector overload_detector_;
+#endif  // TAS_ENABLE_OVERLOAD_SHEDDING
+#if TAS_ENABLE_METRICS
+  ServerMetrics metrics_;
+  const ServerSocketsAndConnections* sockets_;
+#endif  // TAS_ENABLE_METRICS
+#if TAS_ENABLE_REQUEST_JOURNAL
+  RequestJournal request_journal_;
+#endif  // TAS_ENABLE_REQUEST_JOURNAL
+#if TAS_ENABLE_LOOP_PROFILER
+  LoopProfiler loop_profiler_;
+#endif  // TAS_ENABLE_LOOP_PROFILER
+#if TAS_ENABLE_MEMORY_USAGE
+  MemoryUsage memory_usage_;
+#endif  // TAS_ENABLE_MEMORY_USAGE
   uint32_t server_transaction_id_;
 };
 
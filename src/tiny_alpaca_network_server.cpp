@@ -12,7 +12,16 @@ namespace alpaca {
 
 TinyAlpacaNetworkServer::TinyAlpacaNetworkServer(
     TinyAlpacaDeviceServer& device_server, uint16_t tcp_port)
-    : sockets_(tcp_port, device_server), discovery_server_(tcp_port) {}
+    :
+#if TAS_ENABLE_LOOP_PROFILER
+      device_server_(device_server),
+#endif  // TAS_ENABLE_LOOP_PROFILER
+      sockets_(tcp_port, device_server),
+      discovery_server_(tcp_port) {
+#if TAS_ENABLE_METRICS
+  device_server.set_sockets(&sockets_);
+#endif  // TAS_ENABLE_METRICS
+}
 
 bool TinyAlpacaNetworkServer::Initialize() {
   // Give everything a chance to initialize so that logs will contain relevant
@@ -26,8 +35,14 @@ bool TinyAlpacaNetworkServer::Initialize() {
 }
 
 void TinyAlpacaNetworkServer::PerformIO() {
+#if TAS_ENABLE_LOOP_PROFILER
+  const uint32_t start_micros = micros();
+#endif  // TAS_ENABLE_LOOP_PROFILER
   discovery_server_.PerformIO();
   sockets_.PerformIO();
+#if TAS_ENABLE_LOOP_PROFILER
+  device_server_.loop_profiler().RecordNetworkIO(micros() - start_micros);
+#endif  // TAS_ENABLE_LOOP_PROFILER
 }
 
 }  // namespace alpaca
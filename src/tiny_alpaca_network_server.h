@@ -16,6 +16,7 @@
 
 #include "alpaca_devices.h"
 #include "alpaca_discovery_server.h"
+#include "config.h"
 #include "device_interface.h"
 #include "server_context.h"
 #include "server_description.h"
@@ -38,7 +39,12 @@ class TinyAlpacaNetworkServer {
   // to perform periodic work.
   void PerformIO();
 
+  const ServerSocketsAndConnections& sockets() const { return sockets_; }
+
  private:
+#if TAS_ENABLE_LOOP_PROFILER
+  TinyAlpacaDeviceServer& device_server_;
+#endif  // TAS_ENABLE_LOOP_PROFILER
   ServerSocketsAndConnections sockets_;
   TinyAlpacaDiscoveryServer discovery_server_;
 };
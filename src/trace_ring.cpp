@@ -0,0 +1,71 @@
+#include "trace_ring.h"
+
+#include <McuCore.h>
+
+namespace alpaca {
+namespace {
+
+// Prints the low num_digits hex digits of value, with leading zeros.
+void PrintHexDigits(uint32_t value, uint8_t num_digits, Print& out) {
+  while (num_digits > 0) {
+    --num_digits;
+    const uint8_t nibble = (value >> (num_digits * 4)) & 0xF;
+    const char c = nibble < 10 ? '0' + nibble : 'A' + (nibble - 10);
+    out.print(c);
+  }
+}
+
+}  // namespace
+
+#if TAS_ENABLE_TRACE_RING
+TraceRing& TraceRing::Global() {
+  static TraceRing trace_ring;  // NOLINT
+  return trace_ring;
+}
+#endif  // TAS_ENABLE_TRACE_RING
+
+const TraceRecord& TraceRing::record(uint16_t ndx) const {
+  MCU_DCHECK_LT(ndx, size());
+  if (num_recorded_ <= kSize) {
+    return records_[ndx];
+  }
+  // The buffer is full, so the oldest record is the next to be overwritten.
+  ndx += next_ndx_;
+  if (ndx >= kSize) {
+    ndx -= kSize;
+  }
+  return records_[ndx];
+}
+
+// The dump starts with a line giving the number of events recorded, from which
+// the number lost can be determined, and the number of records that follow.
+// Each record is on a line of its own, with the fields in hex:
+//
+//     event arg0 arg1 micros
+//
+// For example:
+//
+//     TAS_TRACE 70 64
+//     06 00 0003 0012D687
+//     ...
+//     TAS_TRACE_END
+void TraceRing::DumpTo(Print& out) const {
+  out.print(MCU_FLASHSTR("TAS_TRACE "));
+  out.print(num_recorded_);
+  out.print(' ');
+  out.println(size());
+  for (uint16_t ndx = 0; ndx < size(); ++ndx) {
+    const TraceRecord& r = record(ndx);
+    PrintHexDigits(static_cast<uint8_t>(r.event), 2, out);
+    out.print(' ');
+    PrintHexDigits(r.arg0, 2, out);
+    out.print(' ');
+    PrintHexDigits(r.arg1, 4, out);
+    out.print(' ');
+    PrintHexDigits(r.micros, 8, out);
+    out.println();
+  }
+  out.println(MCU_FLASHSTR("TAS_TRACE_END"));
+}
+
+}  // namespace alpaca
@@ -0,0 +1,142 @@
+#ifndef TINY_ALPACA_SERVER_SRC_TRACE_RING_H_
+#define TINY_ALPACA_SERVER_SRC_TRACE_RING_H_
+
+// TraceRing is a RAM ring buffer of fixed size binary trace records, each of
+// which holds an event id, a timestamp and two small integer arguments. It is
+// intended for tracing the hot paths of the server (e.g. the request decoder),
+// where enabling MCU_VLOG changes the timing so much that the bug being
+// investigated is no longer reproducible: recording an event takes a handful of
+// instructions, and all formatting is deferred until the buffer is dumped,
+// which is typically done after the problem has been observed, e.g. in response
+// to a command received on the serial port:
+//
+//     TraceRing::Global().DumpTo(Serial);
+//
+// The dump is a series of lines of hex digits, which are turned into readable
+// text (event names, decode function names, etc.) by
+// extras/dev_tools/decode_trace.py.
+//
+// Trace points are added with the TAS_TRACE macro, which expands to nothing
+// unless TAS_ENABLE_TRACE_RING is non-zero.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "config.h"
+
+namespace alpaca {
+
+// Identifies the event recorded by a trace record. The meaning of the two
+// arguments is given for each event. The values are part of the dump format, so
+// add new events at the end; decode_trace.py reads the names from this file.
+enum class ETraceEvent : uint8_t {
+  kNone = 0,
+
+  // arg0: socket number.
+  kConnect = 1,
+  kDisconnect = 2,
+
+  // arg0: socket number; arg1: EHttpStatusCode of the last request.
+  kCloseConnection = 3,
+
+  // arg0: socket number; arg1: EConnectionDeadline.
+  kDeadlineExpired = 4,
+
+  // The request decoder has been reset to decode a new request.
+  kDecoderReset = 5,
+
+  // arg1: id of the new decode function (see DecodeFunctionTraceId in
+  // request_decoder.cpp).
+  kDecodeFunction = 6,
+
+  // arg0: socket number; arg1: final EHttpStatusCode returned by DecodeBuffer.
+  kDecoded = 7,
+
+  // arg0: EAlpacaApi; arg1: EDeviceMethod.
+  kDispatch = 8,
+
+  // arg0: socket number; arg1: number of bytes of the response written by the
+  // latest pass.
+  kResponseIncomplete = 9,
+  kResponseComplete = 10,
+
+  // arg0: socket number.
+  kEventStreamStart = 11,
+  kRequestParked = 12,
+};
+
+// A single trace record; 8 bytes on the AVR microcontrollers.
+struct TraceRecord {
+  uint32_t micros;
+  uint16_t arg1;
+  uint8_t arg0;
+  ETraceEvent event;
+};
+
+class TraceRing {
+ public:
+  static constexpr uint16_t kSize = TAS_TRACE_RING_SIZE;
+
+  TraceRing() { Reset(); }
+
+#if TAS_ENABLE_TRACE_RING
+  // Returns the ring buffer used by the TAS_TRACE macro.
+  static TraceRing& Global();
+#endif  // TAS_ENABLE_TRACE_RING
+
+  void Reset() {
+    next_ndx_ = 0;
+    num_recorded_ = 0;
+  }
+
+  // Records an event, overwriting the oldest record if the buffer is full.
+  void Record(ETraceEvent event, uint32_t micros, uint8_t arg0, uint16_t arg1) {
+    TraceRecord& record = records_[next_ndx_];
+    record.micros = micros;
+    record.arg1 = arg1;
+    record.arg0 = arg0;
+    record.event = event;
+    if (++next_ndx_ == kSize) {
+      next_ndx_ = 0;
+    }
+    ++num_recorded_;
+  }
+
+  // Returns the number of records in the buffer.
+  uint16_t size() const {
+    return num_recorded_ < kSize ? num_recorded_ : kSize;
+  }
+
+  // Returns the total number of events recorded since Reset, including those
+  // that have been overwritten.
+  uint32_t num_recorded() const { return num_recorded_; }
+
+  // Returns the ndx-th oldest record in the buffer; ndx must be less than
+  // size().
+  const TraceRecord& record(uint16_t ndx) const;
+
+  // Writes the records, oldest first, to out in the format expected by
+  // decode_trace.py. This is slow, so shouldn't be called from a hot path.
+  void DumpTo(Print& out) const;
+
+ private:
+  TraceRecord records_[kSize];
+  uint32_t num_recorded_;
+  uint16_t next_ndx_;
+};
+
+}  // namespace alpaca
+
+#if TAS_ENABLE_TRACE_RING
+#define TAS_TRACE(event, arg0, arg1)                                         \
+  ::alpaca::TraceRing::Global().Record(::alpaca::ETraceEvent::event,        \
+                                       micros(), static_cast<uint8_t>(arg0), \
+                                       static_cast<uint16_t>(arg1))
+#else  // !TAS_ENABLE_TRACE_RING
+#define TAS_TRACE(event, arg0, arg1) \
+  do {                               \
+  } while (false)
+#endif  // TAS_ENABLE_TRACE_RING
+
+#endif  // TINY_ALPACA_SERVER_SRC_TRACE_RING_H_
@@ -0,0 +1,61 @@
+#include "utils/fixed_point.h"
+
+#include <McuCore.h>
+
+namespace alpaca {
+namespace {
+
+uint32_t PowerOfTen(uint8_t n) {
+  uint32_t result = 1;
+  while (n-- > 0) {
+    result *= 10;
+  }
+  return result;
+}
+
+}  // namespace
+
+double FixedPoint::ToDouble() const {
+  return mantissa_ / static_cast<double>(PowerOfTen(-exponent_));
+}
+
+size_t FixedPoint::PrintTo(Print& out) const {
+  MCU_DCHECK_LE(kMinExponent, exponent_);
+  MCU_DCHECK_LE(exponent_, kMaxExponent);
+  size_t count = 0;
+  uint32_t magnitude = static_cast<uint32_t>(mantissa_);
+  if (mantissa_ < 0) {
+    count += out.print('-');
+    magnitude = 0u - magnitude;
+  }
+
+  // Split the magnitude into the whole part and the fraction (in units of
+  // 10^-kPrintedFractionDigits), rounding if there are more fraction digits
+  // than will be printed.
+  const uint32_t kFractionScale = PowerOfTen(kPrintedFractionDigits);
+  uint32_t whole, fraction;
+  if (exponent_ + kPrintedFractionDigits >= 0) {
+    const uint32_t divisor = PowerOfTen(-exponent_);
+    whole = magnitude / divisor;
+    fraction = (magnitude % divisor) *
+               PowerOfTen(exponent_ + kPrintedFractionDigits);
+  } else {
+    const uint32_t divisor = PowerOfTen(-(exponent_ + kPrintedFractionDigits));
+    uint32_t scaled = magnitude / divisor;
+    if (magnitude % divisor >= divisor / 2) {
+      ++scaled;
+    }
+    whole = scaled / kFractionScale;
+    fraction = scaled % kFractionScale;
+  }
+
+  count += out.print(whole);
+  count += out.print('.');
+  // Print the fraction with leading zeroes.
+  for (uint32_t scale = kFractionScale / 10; scale > 0; scale /= 10) {
+    count += out.print(static_cast<char>('0' + (fraction / scale) % 10));
+  }
+  return count;
+}
+
+}  // namespace alpaca
@@ -0,0 +1,53 @@
+#ifndef TINY_ALPACA_SERVER_SRC_UTILS_FIXED_POINT_H_
+#define TINY_ALPACA_SERVER_SRC_UTILS_FIXED_POINT_H_
+
+// FixedPoint represents a decimal number as an integer mantissa and a power of
+// ten exponent, i.e. the value is mantissa * 10^exponent, so 12.5 can be
+// represented as FixedPoint(125, -1) or FixedPoint(1250, -2). On AVR, double
+// is a 32-bit float emulated in software, and both arithmetic on it and the
+// printing of it are slow. A device whose values are naturally integers in some
+// unit (e.g. a temperature sensor reporting hundredths of a degree) can instead
+// provide a FixedPoint, which is printed using only integer arithmetic.
+//
+// PrintTo produces the same text as Print::print(double), i.e. with exactly two
+// digits after the decimal point, so responses are the same whichever type the
+// device provides. Where more digits must be dropped, PrintTo rounds half away
+// from zero; Print::print(double) can round such values differently because it
+// does the rounding in floating point (e.g. it prints 124.375 as 124.37).
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+class FixedPoint {
+ public:
+  static constexpr int8_t kMinExponent = -9;
+  static constexpr int8_t kMaxExponent = 0;
+
+  // The number of digits printed after the decimal point, matching the default
+  // of Print::print(double).
+  static constexpr uint8_t kPrintedFractionDigits = 2;
+
+  constexpr FixedPoint(int32_t mantissa, int8_t exponent)
+      : mantissa_(mantissa), exponent_(exponent) {}
+
+  int32_t mantissa() const { return mantissa_; }
+  int8_t exponent() const { return exponent_; }
+
+  // Returns the value as a double, e.g. for use in arithmetic or comparisons
+  // where performance is not important.
+  double ToDouble() const;
+
+  // Prints the value, as described above. Returns the number of bytes printed.
+  size_t PrintTo(Print& out) const;
+
+ private:
+  int32_t mantissa_;
+  int8_t exponent_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_UTILS_FIXED_POINT_H_
@@ -0,0 +1,73 @@
+#include "utils/hashing_print.h"
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+HashingPrint::HashingPrint() : hash_(2166136261UL) {}
+
+size_t HashingPrint::write(uint8_t b) {
+  hash_ = (hash_ ^ b) * 16777619UL;
+  return 1;
+}
+
+JsonPropertyHashingPrint::JsonPropertyHashingPrint()
+    : depth_(0),
+      started_(false),
+      done_(false),
+      in_string_(false),
+      escaped_(false) {}
+
+size_t JsonPropertyHashingPrint::write(uint8_t b) {
+  if (done_) {
+    return 1;
+  } else if (!started_) {
+    // Skip the opening brace of the object.
+    started_ = b == '{';
+    return 1;
+  }
+  if (in_string_) {
+    if (escaped_) {
+      escaped_ = false;
+    } else if (b == '\\') {
+      escaped_ = true;
+    } else if (b == '"') {
+      in_string_ = false;
+      if (depth_ == 0) {
+        return 1;
+      }
+    }
+    return hasher_.write(b);
+  }
+  switch (b) {
+    case '"':
+      in_string_ = true;
+      if (depth_ == 0) {
+        return 1;
+      }
+      break;
+    case '[':
+    case '{':
+      ++depth_;
+      break;
+    case ']':
+    case '}':
+      if (depth_ == 0) {
+        // The end of the object.
+        done_ = true;
+        return 1;
+      }
+      --depth_;
+      break;
+    case ',':
+      if (depth_ == 0) {
+        // The end of the first property.
+        done_ = true;
+        return 1;
+      }
+      break;
+  }
+  return hasher_.write(b);
+}
+
+}  // namespace alpaca
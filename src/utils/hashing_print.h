@@ -0,0 +1,53 @@
+#ifndef TINY_ALPACA_SERVER_SRC_UTILS_HASHING_PRINT_H_
+#define TINY_ALPACA_SERVER_SRC_UTILS_HASHING_PRINT_H_
+
+// HashingPrint computes a hash (FNV-1a) of the bytes written to it, which
+// allows for detecting a change in some output without storing the output.
+//
+// JsonPropertyHashingPrint computes the hash of just the first property of the
+// JSON object written to it, which for an Alpaca response is the Value (when
+// the request succeeded). Quotes outside of any nested array or object are not
+// included in the hash, so {"Value": "abc"} and {"Value": abc} have the same
+// hash; this allows a value provided by a client as a (unquoted) parameter to
+// be compared with the value in a response.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+class HashingPrint : public Print {
+ public:
+  HashingPrint();
+
+  size_t write(uint8_t b) override;
+  using Print::write;
+
+  uint32_t hash() const { return hash_; }
+
+ private:
+  uint32_t hash_;
+};
+
+class JsonPropertyHashingPrint : public Print {
+ public:
+  JsonPropertyHashingPrint();
+
+  size_t write(uint8_t b) override;
+  using Print::write;
+
+  uint32_t hash() const { return hasher_.hash(); }
+
+ private:
+  HashingPrint hasher_;
+  uint8_t depth_;
+  bool started_ : 1;
+  bool done_ : 1;
+  bool in_string_ : 1;
+  bool escaped_ : 1;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_UTILS_HASHING_PRINT_H_
@@ -6,6 +6,9 @@
 // for the time and duration variables, though the duration between time 0 and
 // time 1 must be 1 (i.e. they have the same step size).
 //
+// The result is only an approximation of the mean over the average period; see
+// TimeBucketedAverage for an exact mean.
+//
 // Author: james.synge@gmail.com
 
 #include <McuCore.h>
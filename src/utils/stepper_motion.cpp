@@ -0,0 +1,58 @@
+#include "utils/stepper_motion.h"
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+StepperMotion::StepperMotion(StepperHardware& hardware)
+    : hardware_(hardware), allowed_steps_(0), moving_(false) {}
+
+void StepperMotion::Configure(uint32_t ticks_per_second, uint16_t start_speed,
+                              uint16_t max_speed, uint32_t acceleration) {
+  ramp_.Configure(ticks_per_second, start_speed, max_speed, acceleration);
+}
+
+bool StepperMotion::Start(uint32_t allowed_steps, uint32_t expected_steps) {
+  Stop();
+  if (hardware_.IsAtLimit()) {
+    return false;
+  }
+  allowed_steps_ = allowed_steps;
+  const uint16_t first_interval = ramp_.Start(expected_steps);
+  moving_ = true;
+  hardware_.StartTimer(first_interval);
+  return true;
+}
+
+StepperMotion::EResult StepperMotion::HandleInterrupt() {
+  if (!moving_) {
+    hardware_.StopTimer();
+    return kNotMoving;
+  }
+  // The limit switch is checked before stepping so that we never drive the
+  // motor against a closed switch. Note that we don't debounce the switch.
+  if (hardware_.IsAtLimit()) {
+    Stop();
+    return kReachedLimit;
+  }
+  if (ramp_.steps() >= allowed_steps_) {
+    Stop();
+    return kExceededAllowedSteps;
+  }
+  hardware_.Step();
+  hardware_.SetTimerInterval(ramp_.NextInterval());
+  return kStepped;
+}
+
+void StepperMotion::Restart(uint32_t allowed_steps, uint32_t expected_steps) {
+  MCU_DCHECK(moving_);
+  allowed_steps_ = allowed_steps;
+  hardware_.SetTimerInterval(ramp_.Start(expected_steps));
+}
+
+void StepperMotion::Stop() {
+  moving_ = false;
+  hardware_.StopTimer();
+}
+
+}  // namespace alpaca
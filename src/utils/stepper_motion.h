@@ -0,0 +1,100 @@
+#ifndef TINY_ALPACA_SERVER_SRC_UTILS_STEPPER_MOTION_H_
+#define TINY_ALPACA_SERVER_SRC_UTILS_STEPPER_MOTION_H_
+
+// StepperMotion moves a stepper motor from a timer interrupt, following the
+// speed profile computed by a StepperRamp, until a limit switch is closed or
+// the maximum number of steps has been taken. The hardware (the step pin, the
+// limit switch and the timer) is accessed via the StepperHardware interface,
+// so that the motion can be tested on a host with an emulated timer.
+//
+// The owner of the StepperMotion is expected to select the direction of motion
+// and enable the motor driver before calling Start, and to call HandleInterrupt
+// from the ISR of the timer which the StepperHardware programs.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+#include "utils/stepper_ramp.h"
+
+namespace alpaca {
+
+class StepperHardware {
+ public:
+  virtual ~StepperHardware() {}
+
+  // Pulses the step pin once.
+  virtual void Step() = 0;
+
+  // Returns true if the limit switch in the direction of motion is closed.
+  virtual bool IsAtLimit() = 0;
+
+  // Starts the timer such that the next interrupt occurs after the specified
+  // number of ticks; called from Start with interrupts enabled.
+  virtual void StartTimer(uint16_t ticks) = 0;
+
+  // Sets the number of ticks between the current interrupt and the next one;
+  // called from HandleInterrupt.
+  virtual void SetTimerInterval(uint16_t ticks) = 0;
+
+  // Stops the timer, so that there are no more interrupts.
+  virtual void StopTimer() = 0;
+};
+
+class StepperMotion {
+ public:
+  enum EResult : uint8_t {
+    // A step has been taken, and another will be.
+    kStepped,
+    // The limit switch was found to be closed; no further steps will be taken.
+    kReachedLimit,
+    // The allowed number of steps has been taken without reaching the limit.
+    kExceededAllowedSteps,
+    // Not moving, so no step was taken.
+    kNotMoving,
+  };
+
+  explicit StepperMotion(StepperHardware& hardware);
+
+  // See StepperRamp::Configure.
+  void Configure(uint32_t ticks_per_second, uint16_t start_speed,
+                 uint16_t max_speed, uint32_t acceleration);
+
+  // Starts moving, taking at most allowed_steps steps, and decelerating as the
+  // expected_steps'th step approaches (if not zero). If the limit switch is
+  // already closed, returns false without starting.
+  bool Start(uint32_t allowed_steps, uint32_t expected_steps);
+
+  // Takes a step (unless the limit switch is closed), and schedules the next,
+  // or stops the timer if the movement is complete.
+  EResult HandleInterrupt();
+
+  // Stops moving immediately.
+  void Stop();
+
+  // Starts the ramp again from the start speed, as Start does, but without
+  // restarting the timer; the step counter is reset. For use when the owner has
+  // reversed the direction while moving at the start speed; may be called from
+  // the ISR, after HandleInterrupt has returned kStepped.
+  void Restart(uint32_t allowed_steps, uint32_t expected_steps);
+
+  // Decelerate to the start speed, then continue at that speed.
+  void Decelerate() { ramp_.Decelerate(); }
+
+  bool IsMoving() const { return moving_; }
+
+  // The number of steps taken during the current or most recent movement.
+  uint32_t steps() const { return ramp_.steps(); }
+
+  const StepperRamp& ramp() const { return ramp_; }
+
+ private:
+  StepperHardware& hardware_;
+  StepperRamp ramp_;
+  uint32_t allowed_steps_;
+  volatile bool moving_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_UTILS_STEPPER_MOTION_H_
@@ -0,0 +1,128 @@
+#include "utils/stepper_ramp.h"
+
+#include <McuCore.h>
+#include <math.h>
+
+namespace alpaca {
+namespace {
+
+// The longest period which can be returned by NextInterval.
+constexpr float kMaxTicks = 65535;
+
+uint32_t TicksToPeriod(float ticks) {
+  if (ticks < 1) {
+    ticks = 1;
+  } else if (ticks > kMaxTicks) {
+    ticks = kMaxTicks;
+  }
+  return static_cast<uint32_t>(ticks * 65536.0f);
+}
+
+}  // namespace
+
+StepperRamp::StepperRamp()
+    : start_period_(0),
+      min_period_(0),
+      period_(0),
+      ramp_factor_(0),
+      ramp_shift_(0),
+      remainder_(0),
+      phase_(EPhase::kCreeping),
+      steps_(0),
+      expected_steps_(0),
+      ramp_steps_(0) {}
+
+void StepperRamp::Configure(uint32_t ticks_per_second, uint16_t start_speed,
+                            uint16_t max_speed, uint32_t acceleration) {
+  const float ticks = ticks_per_second;
+
+  // The first interval is chosen so that the speed at the end of it is that
+  // reached by accelerating for one step from the start speed.
+  const float start_squared = static_cast<float>(start_speed) * start_speed;
+  float start_ticks = kMaxTicks;
+  if (start_squared + acceleration > 0) {
+    start_ticks = ticks / sqrtf(start_squared + 2.0f * acceleration);
+  }
+  float min_ticks = ticks / (max_speed > 0 ? max_speed : 1);
+  if (min_ticks > start_ticks) {
+    min_ticks = start_ticks;
+  }
+  start_period_ = TicksToPeriod(start_ticks);
+  min_period_ = TicksToPeriod(min_ticks);
+
+  // Note that sqrt(a) / F * p < 1/sqrt(2) for all p <= start_ticks, which
+  // ensures that PeriodDelta doesn't overflow.
+  float factor = sqrtf(static_cast<float>(acceleration)) / ticks * 65536.0f;
+  ramp_shift_ = 0;
+  while (factor * 2 < 65535 && ramp_shift_ < 16) {
+    factor *= 2;
+    ++ramp_shift_;
+  }
+  ramp_factor_ = factor < 65535 ? static_cast<uint16_t>(factor + 0.5f) : 65535;
+
+  MCU_VLOG(3) << MCU_PSD("StepperRamp start_interval=") << start_interval()
+              << MCU_PSD(", min_interval=") << min_interval()
+              << MCU_PSD(", ramp_factor=") << ramp_factor_
+              << MCU_PSD(", ramp_shift=") << ramp_shift_;
+}
+
+uint16_t StepperRamp::Start(uint32_t expected_steps) {
+  steps_ = 0;
+  ramp_steps_ = 0;
+  remainder_ = 0;
+  expected_steps_ = expected_steps;
+  period_ = start_period_;
+  if (ramp_factor_ == 0 || start_period_ <= min_period_) {
+    phase_ = EPhase::kCreeping;
+  } else {
+    phase_ = EPhase::kAccelerating;
+  }
+  return start_interval();
+}
+
+uint16_t StepperRamp::NextInterval() {
+  ++steps_;
+  if (expected_steps_ != 0 && phase_ < EPhase::kDecelerating &&
+      steps_ + ramp_steps_ >= expected_steps_) {
+    phase_ = EPhase::kDecelerating;
+  }
+  if (phase_ == EPhase::kAccelerating) {
+    ++ramp_steps_;
+    const uint32_t delta = PeriodDelta();
+    if (period_ - min_period_ <= delta) {
+      period_ = min_period_;
+      phase_ = EPhase::kCruising;
+    } else {
+      period_ -= delta;
+    }
+  } else if (phase_ == EPhase::kDecelerating) {
+    const uint32_t delta = PeriodDelta();
+    if (start_period_ - period_ <= delta) {
+      period_ = start_period_;
+      phase_ = EPhase::kCreeping;
+    } else {
+      period_ += delta;
+    }
+  }
+  const uint32_t fraction = (period_ & 0xFFFF) + remainder_;
+  remainder_ = fraction & 0xFFFF;
+  return (period_ >> kFractionBits) + (fraction >> kFractionBits);
+}
+
+void StepperRamp::Decelerate() {
+  if (phase_ < EPhase::kDecelerating) {
+    phase_ = EPhase::kDecelerating;
+  }
+}
+
+uint32_t StepperRamp::PeriodDelta() const {
+  // r = p * sqrt(a) / F, with 16 fractional bits, and at most 1/sqrt(2).
+  const uint32_t ticks = period_ >> kFractionBits;
+  const uint32_t r = (ticks * ramp_factor_) >> ramp_shift_;
+  // q = r^2 = p^2 * a / F^2, with 24 fractional bits, and at most 1/2.
+  const uint32_t q = (r * r) >> 8;
+  // p * q, with 16 fractional bits, computed in two parts to avoid overflow.
+  return ticks * (q >> 8) + ((ticks * (q & 0xFF)) >> 8);
+}
+
+}  // namespace alpaca
@@ -0,0 +1,103 @@
+#ifndef TINY_ALPACA_SERVER_SRC_UTILS_STEPPER_RAMP_H_
+#define TINY_ALPACA_SERVER_SRC_UTILS_STEPPER_RAMP_H_
+
+// StepperRamp computes the intervals between the steps of a stepper motor so
+// that it follows a trapezoidal speed profile: it accelerates from a start
+// speed to a maximum speed, cruises, then decelerates back to the start speed
+// as it approaches the expected end of the movement, after which it creeps
+// along at the start speed until stopped (e.g. by a limit switch).
+//
+// The intervals are measured in ticks of the timer used to time the steps, and
+// are computed incrementally, once per step, using the approximation described
+// by Aryeh Eiderman in "Real Time Stepper Motor Linear Ramping Just by Addition
+// and Multiplication":
+//
+//     p' = p * (1 + m * p * p)
+//
+// where p is the current interval, and m is -a/F^2 while accelerating and a/F^2
+// while decelerating (a is the acceleration in steps/second^2, and F is the
+// rate of the timer in ticks/second). This needs only a few 32-bit multiplies
+// and shifts per step, no division or floating point, so NextInterval is cheap
+// enough to call from a timer interrupt service routine. Configure does use
+// floating point, so should be called before starting to move.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+class StepperRamp {
+ public:
+  enum class EPhase : uint8_t {
+    kAccelerating,
+    kCruising,
+    kDecelerating,
+    kCreeping,
+  };
+
+  StepperRamp();
+
+  // Computes the parameters of the ramp. ticks_per_second is the rate of the
+  // timer; start_speed and max_speed are in steps per second, and acceleration
+  // is in steps per second per second. An acceleration of zero means that the
+  // motor always moves at the start speed.
+  void Configure(uint32_t ticks_per_second, uint16_t start_speed,
+                 uint16_t max_speed, uint32_t acceleration);
+
+  // Prepares to start a movement, returning the number of ticks to wait before
+  // the first step. If expected_steps is non-zero, the motor will decelerate so
+  // that it reaches the start speed at (roughly) that step; else the motor
+  // will continue at the maximum speed until stopped.
+  uint16_t Start(uint32_t expected_steps);
+
+  // Records that a step has been taken, and returns the number of ticks to wait
+  // before the next step. The fractional part of each interval is carried over
+  // to the next one, so that the timing doesn't drift.
+  uint16_t NextInterval();
+
+  // Starts decelerating now, regardless of the number of expected steps.
+  void Decelerate();
+
+  // The number of steps taken since Start.
+  uint32_t steps() const { return steps_; }
+
+  EPhase phase() const { return phase_; }
+
+  // The intervals, in ticks, at the start speed and at the maximum speed.
+  uint16_t start_interval() const { return start_period_ >> kFractionBits; }
+  uint16_t min_interval() const { return min_period_ >> kFractionBits; }
+
+ private:
+  // Periods are in ticks, with 16 fractional bits.
+  static constexpr uint8_t kFractionBits = 16;
+
+  // Returns the amount by which the period changes at this step, i.e.
+  // p^3 * |m|.
+  uint32_t PeriodDelta() const;
+
+  // The periods at the start speed, at the maximum speed, and of the next step.
+  uint32_t start_period_;
+  uint32_t min_period_;
+  uint32_t period_;
+
+  // sqrt(a) / F, shifted left by 16 + ramp_shift_ bits so that it has as much
+  // precision as possible in 16 bits.
+  uint16_t ramp_factor_;
+  uint8_t ramp_shift_;
+
+  // The fraction of a tick not yet included in an interval.
+  uint16_t remainder_;
+
+  EPhase phase_;
+  uint32_t steps_;
+  uint32_t expected_steps_;
+
+  // The number of steps taken while accelerating, which is approximately the
+  // number needed to decelerate back to the start speed.
+  uint32_t ramp_steps_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_UTILS_STEPPER_RAMP_H_
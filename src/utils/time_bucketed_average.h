@@ -0,0 +1,187 @@
+#ifndef TINY_ALPACA_SERVER_SRC_UTILS_TIME_BUCKETED_AVERAGE_H_
+#define TINY_ALPACA_SERVER_SRC_UTILS_TIME_BUCKETED_AVERAGE_H_
+
+// TimeBucketedAverage computes the exact mean of the readings of a sensor over
+// a recent period of time, using a fixed amount of memory and only integer
+// arithmetic. It is an alternative to MovingAverage, whose result is only an
+// approximation of the mean over the average period.
+//
+// Time is divided into buckets of bucket_duration, and the running totals (the
+// sum of the values and their count) are saved at the end of each bucket, in a
+// ring of the most recent kNumBuckets + 1 bucket boundaries. The mean over the
+// most recent N complete buckets is then the difference between the totals at
+// two boundaries, divided by the difference between the counts, which takes
+// the same (small) amount of time for any N up to kNumBuckets. Hence
+// MaxAveragePeriod() is kNumBuckets * bucket_duration, and the average period
+// is rounded up to a whole number of buckets.
+//
+// Values are integers, so sensors with fractional readings should record them
+// in fixed-point form, e.g. a temperature in hundredths of a degree. The totals
+// are maintained modulo 2^32, so the only limit on the number of readings is
+// that the sum of the values recorded during MaxAveragePeriod() must fit in an
+// int32_t.
+//
+// As with MovingAverage, there is no implied unit for time; when the times are
+// from millis() (or micros()), the wrap around of the clock is handled.
+//
+// Author: james.synge@gmail.com
+
+#include <McuCore.h>
+
+namespace alpaca {
+
+template <uint8_t kNumBuckets>
+class TimeBucketedAverage {
+  static_assert(kNumBuckets > 0 && kNumBuckets < 255,
+                "kNumBuckets must be in the range [1, 254]");
+
+ public:
+  explicit TimeBucketedAverage(uint32_t bucket_duration)
+      : bucket_duration_(bucket_duration) {
+    MCU_DCHECK_NE(bucket_duration, 0);
+    Reset();
+  }
+
+  // Discards all of the recorded values.
+  void Reset() {
+    total_sum_ = 0;
+    total_count_ = 0;
+    bucket_start_time_ = 0;
+    last_value_ = 0;
+    newest_ndx_ = 0;
+    num_boundaries_ = 0;
+    started_ = false;
+  }
+
+  // Records a reading taken at time now, which must not be earlier than the
+  // time passed to the previous call to this or AdvanceTo.
+  void RecordValue(int32_t value, uint32_t now) {
+    AdvanceTo(now);
+    total_sum_ += static_cast<uint32_t>(value);
+    ++total_count_;
+    last_value_ = value;
+  }
+
+  // Closes any buckets that have ended by time now. RecordValue does this, so
+  // this only needs to be called if there are gaps in the readings which are
+  // longer than a bucket, and it is important that the gap be reflected by
+  // GetAverage before the next reading.
+  void AdvanceTo(uint32_t now) {
+    if (!started_) {
+      // The first bucket starts with the first reading.
+      bucket_start_time_ = now;
+      started_ = true;
+      AddBoundary();
+      return;
+    }
+    // Unsigned subtraction handles the wrap around of the clock.
+    const uint32_t num_ended = (now - bucket_start_time_) / bucket_duration_;
+    if (num_ended == 0) {
+      return;
+    }
+    bucket_start_time_ += num_ended * bucket_duration_;
+    // If the gap was longer than the whole ring, then all of the boundaries
+    // will be the same, and there is no need to add the rest.
+    const uint32_t num_to_add =
+        num_ended < kNumBuckets + 1u ? num_ended : kNumBuckets + 1u;
+    for (uint32_t i = 0; i < num_to_add; ++i) {
+      AddBoundary();
+    }
+  }
+
+  // Returns the longest period over which GetAverage can compute the mean.
+  uint32_t MaxAveragePeriod() const { return kNumBuckets * bucket_duration_; }
+
+  uint32_t bucket_duration() const { return bucket_duration_; }
+
+  // Returns the number of complete buckets, at most kNumBuckets.
+  uint8_t num_complete_buckets() const {
+    return num_boundaries_ == 0 ? 0 : num_boundaries_ - 1;
+  }
+
+  // Computes the mean of the values recorded during the most recent complete
+  // buckets spanning average_period (rounded up to a whole number of buckets,
+  // and limited to MaxAveragePeriod()), rounded to the nearest integer. If
+  // fewer buckets have been completed, the mean is over those buckets. As per
+  // the ASCOM ObservingConditions specification, an average_period of zero
+  // requests the most recent value. Returns false, without modifying average,
+  // if there is no value in the requested period.
+  bool GetAverage(uint32_t average_period, int32_t& average) const {
+    if (average_period == 0) {
+      if (total_count_ == 0) {
+        return false;
+      }
+      average = last_value_;
+      return true;
+    }
+    uint32_t num_buckets = average_period / bucket_duration_;
+    if (num_buckets * bucket_duration_ < average_period) {
+      ++num_buckets;
+    }
+    if (num_buckets > num_complete_buckets()) {
+      num_buckets = num_complete_buckets();
+    }
+    if (num_buckets == 0) {
+      return false;
+    }
+    const Boundary& end = boundaries_[newest_ndx_];
+    const Boundary& start = boundaries_[BoundaryIndex(num_buckets)];
+    const uint32_t count = end.count - start.count;
+    if (count == 0) {
+      return false;
+    }
+    const int32_t sum = static_cast<int32_t>(end.sum - start.sum);
+    average = RoundedQuotient(sum, count);
+    return true;
+  }
+
+  // Returns the quotient of sum / count, rounded to the nearest integer, with
+  // halves rounded away from zero.
+  static int32_t RoundedQuotient(int32_t sum, uint32_t count) {
+    if (sum >= 0) {
+      return static_cast<int32_t>((static_cast<uint32_t>(sum) + count / 2) /
+                                  count);
+    }
+    const uint32_t magnitude = 0u - static_cast<uint32_t>(sum);
+    return -static_cast<int32_t>((magnitude + count / 2) / count);
+  }
+
+ private:
+  // The running totals at the end of a bucket.
+  struct Boundary {
+    uint32_t sum;  // Modulo 2^32, so may appear negative.
+    uint32_t count;
+  };
+
+  static constexpr uint8_t kNumBoundaries = kNumBuckets + 1;
+
+  void AddBoundary() {
+    if (num_boundaries_ != 0) {
+      newest_ndx_ = newest_ndx_ + 1 == kNumBoundaries ? 0 : newest_ndx_ + 1;
+    }
+    boundaries_[newest_ndx_] = {total_sum_, total_count_};
+    if (num_boundaries_ < kNumBoundaries) {
+      ++num_boundaries_;
+    }
+  }
+
+  // Returns the index of the boundary num_back boundaries before the newest.
+  uint8_t BoundaryIndex(uint8_t num_back) const {
+    return newest_ndx_ >= num_back ? newest_ndx_ - num_back
+                                   : newest_ndx_ + kNumBoundaries - num_back;
+  }
+
+  Boundary boundaries_[kNumBoundaries];
+  uint32_t total_sum_;
+  uint32_t total_count_;
+  const uint32_t bucket_duration_;
+  uint32_t bucket_start_time_;
+  int32_t last_value_;
+  uint8_t newest_ndx_;
+  uint8_t num_boundaries_;
+  bool started_;
+};
+
+}  // namespace alpaca
+
+#endif  // TINY_ALPACA_SERVER_SRC_UTILS_TIME_BUCKETED_AVERAGE_H_